@@ -40,38 +40,34 @@ CloudTile::~CloudTile ()
 void CloudTile::PreLoad()
 {
 	assert(tex == nullptr);
+	assert(pPreSrf == nullptr);
 
 	// Configure microtexture range for "Water texture" and "Cloud microtexture".
 	GetParentMicroTexRange(&microrange);
 	
-	LPDIRECT3DDEVICE9  pDev = mgr->Dev();
-	LPDIRECT3DTEXTURE9 pSysSrf = nullptr;
-
 	if (cmgr->DoLoadIndividualFiles(0)) { // try loading from individual tile file
 		char path[MAX_PATH];
 		sprintf_s (path, MAX_PATH, "%s\\Cloud\\%02d\\%06d\\%06d.dds", mgr->DataRootDir().c_str(), lvl+4, ilat, ilng);
-		LoadTextureFile(path, &pSysSrf);
+		LoadTextureFile(path, &pPreSrf);
 	}
-	if (!pSysSrf && cmgr->ZTreeManager(0)) { // try loading from compressed archive
+	if (!pPreSrf && cmgr->ZTreeManager(0)) { // try loading from compressed archive
 		BYTE *buf;
 		DWORD ndata = cmgr->ZTreeManager(0)->ReadData(lvl+4, ilat, ilng, &buf);
 		if (ndata) {
-			LoadTextureFromMemory(buf, ndata, &pSysSrf);
+			LoadTextureFromMemory(buf, ndata, &pPreSrf);
 			cmgr->ZTreeManager(0)->ReleaseData(buf);
 		}
 	}
 
 	owntex = true;
 
-	if (CreateTexture(pDev, pSysSrf, &tex) != true) {
+	if (!pPreSrf) { // the texture is uploaded by Tile::Upload
 		if (GetParentSubTexRange(&texrange)) {
 			tex = getParent()->Tex();
 			owntex = false;
 		}
 		else tex = nullptr;
 	}
-	
-	SAFE_RELEASE(pSysSrf);
 }
 
 
@@ -223,6 +219,9 @@ void TileManager2<CloudTile>::Render (MATRIX4 &dwmat, bool use_zbuf, const vPlan
 
 	loader->WaitForMutex();
 
+	// make the tiles loaded since the last frame available
+	loader->UploadTiles (MAXUPLOAD2);
+
 	// update the tree
 	for (i = 0; i < 2; i++)
 		ProcessNode (tiletree+i);
@@ -39,6 +39,7 @@ void D3D9Config::Reset ()
 	OrbitalShadowMult   = 0.85;
 	PlanetPreloadMode	= 0;
 	PlanetLoadFrequency	= 40;
+	PlanetLoadThreads	= 2;
 	Anisotrophy			= 4;
 	SceneAntialias		= 4;
 	DebugLvl			= 1;
@@ -137,6 +138,7 @@ bool D3D9Config::ReadParams ()
 	if (oapiReadItem_int   (hFile, (char*)"CustomCamMode", i))			CustomCamMode = max(0, min(1, i));
 	if (oapiReadItem_int   (hFile, (char*)"PlanetPreloadMode", i))		PlanetPreloadMode = max(0, min(1, i));
 	if (oapiReadItem_int   (hFile, (char*)"PlanetTexLoadFreq", i))		PlanetLoadFrequency = max(1, min(1000, i));
+	if (oapiReadItem_int   (hFile, (char*)"PlanetLoadThreads", i))	PlanetLoadThreads = max(1, min(8, i));
 	if (oapiReadItem_int   (hFile, (char*)"Anisotrophy", i))			Anisotrophy = max(1, min(16, i));
 	if (oapiReadItem_int   (hFile, (char*)"SceneAntialias", i))		SceneAntialias = i;
 	if (oapiReadItem_int   (hFile, (char*)"SketchpadFont", i))			SketchpadFont = max(0, min(2, i));
@@ -229,6 +231,7 @@ void D3D9Config::WriteParams ()
 	oapiWriteItem_int   (hFile, (char*)"CustomCamMode", CustomCamMode);
 	oapiWriteItem_int   (hFile, (char*)"PlanetPreloadMode", PlanetPreloadMode);
 	oapiWriteItem_int   (hFile, (char*)"PlanetTexLoadFreq", PlanetLoadFrequency);
+	oapiWriteItem_int   (hFile, (char*)"PlanetLoadThreads", PlanetLoadThreads);
 	oapiWriteItem_int   (hFile, (char*)"Anisotrophy", Anisotrophy);
 	oapiWriteItem_int   (hFile, (char*)"SceneAntialias", SceneAntialias);
 	oapiWriteItem_int   (hFile, (char*)"SketchpadFont", SketchpadFont);
@@ -36,6 +36,7 @@ public:
 	int Enable9On12;				///< Enable DX9 through DX12
 	int PlanetPreloadMode;			///< Planet preload mode setting (0=load on demand, 1=preload)
 	int PlanetLoadFrequency;		///< Load frequency for on-demand textures \[Hz\] (1...1000)
+	int PlanetLoadThreads;			///< Number of worker threads for on-demand planet tiles (1...8)
 	int Anisotrophy;				///< Anisotropic filtering setting \[factor\] (1...16)
 	int SceneAntialias;				///< Antialiasing setting \[factor\] (0...)
 	int DisableDriverManagement;	///< Disable the D3D9 driver management \[sets the D3DCREATE_DISABLE_DRIVER_MANAGEMENT behavior flag\]  (0=default, 1:disabled)
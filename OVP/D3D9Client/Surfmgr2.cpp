@@ -69,6 +69,7 @@ SurfTile::SurfTile (TileManager2Base *_mgr, int _lvl, int _ilat, int _ilng)
 	ggelev = NULL;
 	elev_file = NULL;
 	ltex = NULL;
+	pPreMask = NULL;
 	has_elevfile = false;
 	label = NULL;
 	imicrolvl = 14;	// Water resolution level
@@ -88,6 +89,7 @@ SurfTile::~SurfTile ()
 	if (elev_file) g_pMemgr_i->Free(elev_file);	
 	if (tex && owntex) g_pTexmgr_tt->Free(tex);
 	if (ltex && owntex) g_pTexmgr_tt->Free(ltex);
+	SAFE_RELEASE(pPreMask);
 		
 	DeleteLabels();
 }
@@ -103,9 +105,7 @@ void SurfTile::PreLoad()
 
 	assert(tex == nullptr);
 	assert(ltex == nullptr);
-
-	LPDIRECT3DDEVICE9  pDev = mgr->Dev();
-	LPDIRECT3DTEXTURE9 pSysSrf = nullptr;
+	assert(pPreSrf == nullptr);
 	
 	// Configure microtexture range for "Water texture" and "Cloud microtexture".
 	GetParentMicroTexRange(&microrange);
@@ -115,52 +115,57 @@ void SurfTile::PreLoad()
 
 	if (smgr->DoLoadIndividualFiles(0)) { // try loading from individual tile file
 		sprintf_s(path, MAX_PATH, "%s\\Surf\\%02d\\%06d\\%06d.dds", mgr->DataRootDir().c_str(), lvl + 4, ilat, ilng);
-		LoadTextureFile(path, &pSysSrf);
+		LoadTextureFile(path, &pPreSrf);
 	}
-	if (!pSysSrf && smgr->ZTreeManager(0)) { // try loading from compressed archive
+	if (!pPreSrf && smgr->ZTreeManager(0)) { // try loading from compressed archive
 		BYTE *buf;
 		DWORD ndata = smgr->ZTreeManager(0)->ReadData(lvl+4, ilat, ilng, &buf);
 		if (ndata) {
-			LoadTextureFromMemory(buf, ndata, &pSysSrf);
+			LoadTextureFromMemory(buf, ndata, &pPreSrf);
 			smgr->ZTreeManager(0)->ReleaseData(buf);
 		}
 	}
 	
-	if (CreateTexture(pDev, pSysSrf, &tex) != true) {
+	if (!pPreSrf) {
 		if (GetParentSubTexRange(&texrange)) {
 			tex = getSurfParent()->Tex();
 			owntex = false;
 		}
 	}
-	
-	SAFE_RELEASE(pSysSrf);
 
 
 	// Load mask texture
 
-	if (tex && (mgr->Cprm().bSpecular || mgr->Cprm().bLights))
+	if ((pPreSrf || tex) && (mgr->Cprm().bSpecular || mgr->Cprm().bLights))
 	{
-		if (smgr->DoLoadIndividualFiles(1)) { // try loading from individual tile file
-			sprintf_s(path, MAX_PATH, "%s\\Mask\\%02d\\%06d\\%06d.dds", mgr->DataRootDir().c_str(), lvl + 4, ilat, ilng);
-			LoadTextureFile(path, &pSysSrf);
-		}
-		if (!pSysSrf && smgr->ZTreeManager(1)) { // try loading from compressed archive
-			BYTE* buf;
-			DWORD ndata = smgr->ZTreeManager(1)->ReadData(lvl + 4, ilat, ilng, &buf);
-			if (ndata) {
-				LoadTextureFromMemory(buf, ndata, &pSysSrf);
-				smgr->ZTreeManager(1)->ReleaseData(buf);
-			}
-		}
-		
 		if (owntex) {
-			CreateTexture(pDev, pSysSrf, &ltex);			
+			if (smgr->DoLoadIndividualFiles(1)) { // try loading from individual tile file
+				sprintf_s(path, MAX_PATH, "%s\\Mask\\%02d\\%06d\\%06d.dds", mgr->DataRootDir().c_str(), lvl + 4, ilat, ilng);
+				LoadTextureFile(path, &pPreMask);
+			}
+			if (!pPreMask && smgr->ZTreeManager(1)) { // try loading from compressed archive
+				BYTE* buf;
+				DWORD ndata = smgr->ZTreeManager(1)->ReadData(lvl + 4, ilat, ilng, &buf);
+				if (ndata) {
+					LoadTextureFromMemory(buf, ndata, &pPreMask);
+					smgr->ZTreeManager(1)->ReleaseData(buf);
+				}
+			}
 		}
 		else if (node && node->Parent()) {
 			ltex = getSurfParent()->ltex;
-		}		
-		
-		SAFE_RELEASE(pSysSrf);
+		}
+	}
+}
+
+// -----------------------------------------------------------------------
+
+void SurfTile::Upload ()
+{
+	Tile::Upload();
+	if (pPreMask) {
+		CreateTexture(mgr->Dev(), pPreMask, &ltex);
+		SAFE_RELEASE(pPreMask);
 	}
 }
 
@@ -1461,6 +1466,9 @@ void TileManager2<SurfTile>::Render (MATRIX4 &dwmat, bool use_zbuf, const vPlane
 
 	loader->WaitForMutex();
 
+	// make the tiles loaded since the last frame available
+	loader->UploadTiles (MAXUPLOAD2);
+
 	// update the tree
 	for (i = 0; i < 2; i++)
 		ProcessNode (tiletree+i);
@@ -52,6 +52,7 @@ protected:
 
 	void Load ();
 	void PreLoad ();
+	void Upload ();
 	INT16 *ReadElevationFile (const char *name, int lvl, int ilat, int ilng);
 	bool LoadElevationData ();
 	void Render ();
@@ -88,6 +89,7 @@ private:
 	D3DXVECTOR2 MicroRep[3];
 	DWORD MaxRep;
 	LPDIRECT3DTEXTURE9 ltex;	///< landmask/nightlight texture, if applicable
+	LPDIRECT3DTEXTURE9 pPreMask; ///< preloaded landmask/nightlight texture in system memory, until uploaded
 	INT16 *elev_file;			///< elevation data [m]
 	float *elev;				///< elevation data [m] (8x subsampled)
 	mutable float *ggelev;		///< pointer to my elevation data in the great-grandparent
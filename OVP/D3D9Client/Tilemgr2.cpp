@@ -16,6 +16,7 @@
 #include "Scene.h"
 #include "OapiExtension.h"
 
+#include <algorithm>
 #include <stack>
 #include <io.h>
 #include <filesystem>
@@ -45,7 +46,7 @@ Tile::Tile (TileManager2Base *_mgr, int _lvl, int _ilat, int _ilng)
 : mgr(_mgr), lvl(_lvl), ilat(_ilat), ilng(_ilng),
   lngnbr_lvl(_lvl), latnbr_lvl(_lvl), dianbr_lvl(_lvl),
   texrange(fullrange), microrange(fullrange), overlayrange(fullrange), cnt(Centre()),
-  mesh(NULL), tex(NULL), overlay(NULL),
+  mesh(NULL), tex(NULL), overlay(NULL), pPreSrf(NULL),
   last_used(0.0),
   state(Invalid),
   edgeok(false), owntex (true), ownoverlay(false)
@@ -68,6 +69,7 @@ Tile::~Tile ()
 	D3D9Stats.TilesAllocated--;
 	mgr->TilesLoaded--;
 	state = Invalid;
+	SAFE_RELEASE(pPreSrf);
 	if (mesh) delete mesh;
 }
 
@@ -122,13 +124,25 @@ bool Tile::CreateTexture(LPDIRECT3DDEVICE9 pDev, LPDIRECT3DTEXTURE9 pPre, LPDIRE
 
 // -----------------------------------------------------------------------
 
+void Tile::Upload ()
+{
+	if (pPreSrf) {
+		CreateTexture(mgr->Dev(), pPreSrf, &tex);
+		SAFE_RELEASE(pPreSrf);
+	}
+	if (mesh) mesh->MapVertices(mgr->Dev());
+}
+
+// -----------------------------------------------------------------------
+
 bool Tile::PreDelete ()
 {
 	switch (state) {
 	case Loading:
 		return false;                // locked
 	case InQueue:
-		mgr->loader->Unqueue (this); // remove from load queue
+	case Loaded:
+		mgr->loader->Unqueue (this); // remove from load queue or upload list
 		// fall through
 	default:
 		return true;
@@ -640,7 +654,7 @@ VBMESH *Tile::CreateMesh_quadpatch (int grdlat, int grdlng, float *elev, double
 	mesh->Box[7] = _V(tmul (R, _V(tpmax.x, tpmax.y, tpmax.z)) + pref);
 
 	mesh->ComputeSphere();
-	mesh->MapVertices(TileManager2Base::pDev);
+	// the vertex buffer is filled by Tile::Upload
 
 	return mesh;
 }
@@ -803,37 +817,32 @@ VBMESH *Tile::CreateMesh_hemisphere (int grd, float *elev, double globelev)
 	mesh->nv  = nVtx;
 	mesh->idx = Idx;
 	mesh->nf  = nIdx/3;
-	mesh->MapVertices (TileManager2Base::pDev);
+	// the vertex buffer is filled by Tile::Upload
 	return mesh;
 }
 
 // =======================================================================
 // =======================================================================
 
-int TileLoader::nqueue = 0;
-int TileLoader::queue_in = 0;
-int TileLoader::queue_out = 0;
 HANDLE TileLoader::hLoadMutex = 0;
-struct TileLoader::QUEUEDESC TileLoader::queue[MAXQUEUE2] = {0};
 
 TileLoader::TileLoader (const oapi::D3D9Client *gclient)
 	: gc(gclient)
-	, hStopThread(CreateEvent(NULL, FALSE, FALSE, NULL))
-	, load_frequency(Config->PlanetLoadFrequency)
+	, frame(0)
+	, bTerminate(false)
 {
-	DWORD id;
-
-	// Initialize statics
-	nqueue = queue_in = queue_out = 0;
 	hLoadMutex = CreateMutex (0, FALSE, NULL);
-	hLoadThread = CreateThread (NULL, 32768, Load_ThreadProc, this, 0, &id);
+	int nthread = Config->PlanetLoadThreads;
+	for (int i = 0; i < nthread; i++)
+		worker.emplace_back (&TileLoader::Load_ThreadProc, this);
+	LogAlw("TileLoader: %d load threads started", nthread);
 }
 
 // -----------------------------------------------------------------------
 
 TileLoader::~TileLoader ()
 {
-	if (hLoadThread) LogErr("TileLoader() Not Yet ShutDown()");
+	if (worker.size()) LogErr("TileLoader() Not Yet ShutDown()");
 	TerminateLoadThread();
 	CloseHandle (hLoadMutex);
 	hLoadMutex = NULL;
@@ -843,7 +852,7 @@ TileLoader::~TileLoader ()
 
 bool TileLoader::ShutDown()
 {
-	if (hLoadThread) {
+	if (worker.size()) {
 		TerminateLoadThread();
 		return true;
 	}
@@ -854,201 +863,184 @@ bool TileLoader::ShutDown()
 
 void TileLoader::TerminateLoadThread()
 {
-	if (hLoadThread) {
-		// Signal thread to stop and wait for it to happen
-		SetEvent(hStopThread);
-		WaitForSingleObject(hLoadThread, INFINITE); //4000);
+	if (worker.size()) {
+		// Signal the threads to stop and wait for it to happen
+		{
+			std::lock_guard<std::mutex> lock(qmtx);
+			bTerminate = true;
+		}
+		cv_queue.notify_all();
+		for (auto &t : worker) t.join();
+		worker.clear();
 		// Clean up for next run
-		ResetEvent(hStopThread);
-		CloseHandle(hLoadThread);
-		hLoadThread = NULL;
+		bTerminate = false;
+		LogAlw("TileLoader: load threads terminated");
 	}
 }
 
 // -----------------------------------------------------------------------
 
-bool TileLoader::LoadTileAsync (Tile *tile)
+bool TileLoader::LoadTileAsync (Tile *tile, float prio, DWORD _frame)
 {
-	// Note: the queue should probably be sorted according to tile level
-
-	int i, j;
-
-	// Check if request is already present
-	for (i = 0; i < nqueue; i++) {
-		j = (i+queue_out) % MAXQUEUE2;
-		if (queue[j].tile == tile)
+	std::unique_lock<std::mutex> lock(qmtx);
+	frame = _frame;
+
+	// Update the request if it is already present
+	for (auto &q : queue) {
+		if (q.tile == tile) {
+			q.prio = prio;
+			q.frame = _frame;
 			return false;
+		}
 	}
 
-	if (nqueue == MAXQUEUE2) { // queue full
-		int maxlvl, maxlvl_idx = 0;
-		for (i = 1, maxlvl = queue[0].tile->lvl; i < nqueue; i++)
-			if (queue[i].tile->lvl > maxlvl)
-				maxlvl = queue[i].tile->lvl, maxlvl_idx = i;
-		if (maxlvl > tile->lvl) { // replace the highest level queued tile (load from lowest to highest)
-			queue[maxlvl_idx].tile->state = Tile::Invalid;
-			queue[maxlvl_idx].tile = tile;
-			tile->state = Tile::InQueue;
-		} else {
+	if (queue.size() == MAXQUEUE2) { // queue full: replace the lowest priority request
+		auto low = std::min_element(queue.begin(), queue.end(), [](const QUEUEDESC &a, const QUEUEDESC &b) { return a.prio < b.prio; });
+		if (low->prio >= prio) {
 			tile->state = Tile::Invalid;
+			return false;
 		}
-		return false;
+		low->tile->state = Tile::Invalid;
+		queue.erase(low);
 	}
 
 	// add tile to load queue
-	QUEUEDESC *qd = queue+queue_in;
-	qd->tile = tile;
+	queue.push_back({ tile, prio, _frame });
 	tile->state = Tile::InQueue;
-	nqueue++;
-	queue_in = (queue_in+1) % MAXQUEUE2;
+	lock.unlock();
+	cv_queue.notify_one();
 	return true;
 }
 
 // -----------------------------------------------------------------------
 
-void TileLoader::Unqueue (TileManager2Base *mgr)
+Tile *TileLoader::NextTile ()
 {
-	bool locked = false; // whether a mutex semaphore was taken
-
-	bool found;
-	do {
-		int i, j;
-		found = false;
-		for (i = 0; i < nqueue; ++i) {
-			j = (queue_out+i) % MAXQUEUE2;
-			if (queue[j].tile->mgr == mgr) {
-				if (!locked) {
-					WaitForMutex();
-					locked = true;
-				}
-				if (i) {
-					queue[j].tile = queue[queue_out].tile;
-				}
-				queue_out = (queue_out+1) % MAXQUEUE2;
-				nqueue--;
-				found = true;
-				break;
-			}
+	// Requests not renewed since the previous frame are no longer needed.
+	// A linear search is used because the priorities change every frame.
+	size_t i, j, best = queue.size();
+	for (i = j = 0; i < queue.size(); i++) {
+		if (frame - queue[i].frame > 1 || queue[i].tile->state != Tile::InQueue) {
+			if (queue[i].tile->state == Tile::InQueue) queue[i].tile->state = Tile::Invalid;
+			continue;
 		}
-	} while (found);
-
-	if (locked) {
-		ReleaseMutex(); // ...if mutex was taken
+		queue[j] = queue[i];
+		if (best == queue.size() || queue[j].prio > queue[best].prio) best = j;
+		j++;
 	}
+	Tile *tile = (best < j ? queue[best].tile : NULL);
+	if (tile) queue[best] = queue[--j];
+	queue.resize(j);
+	return tile;
 }
 
 // -----------------------------------------------------------------------
 
-bool TileLoader::Unqueue (Tile *tile)
+void TileLoader::UploadTiles (int maxtiles)
 {
-	if (tile->state != Tile::InQueue) return false;
-
-	int i, j;
-	for (i = 0; i < nqueue; i++) {
-		j = (queue_out+i) % MAXQUEUE2;
-		if (queue[j].tile == tile) {
-			WaitForMutex ();
-			if (i) {
-				queue[j].tile = queue[queue_out].tile;
-			}
-			queue_out = (queue_out+1) % MAXQUEUE2;
-			nqueue--;
-			ReleaseMutex ();
-			return true;
-		}
+	std::vector<Tile*> upload;
+	{
+		std::lock_guard<std::mutex> lock(qmtx);
+		size_t n = min(loaded.size(), (size_t)maxtiles);
+		upload.assign(loaded.begin(), loaded.begin() + n);
+		loaded.erase(loaded.begin(), loaded.begin() + n);
+	}
+	for (auto tile : upload) {
+		tile->Upload();
+		tile->state = Tile::Inactive; // unlock tile
 	}
-	return false;
 }
 
 // -----------------------------------------------------------------------
-#ifdef UNDEF
-DWORD WINAPI TileLoader::Load_ThreadProc (void *data)
-{
-	TileLoader *loader = (TileLoader*)data;
-	DWORD idle = 1000/loader->load_frequency;
-	Tile *tile;
-	bool load;
-
-	while (WAIT_OBJECT_0 != WaitForSingleObject(loader->hStopThread, idle)) {
-
-		WaitForMutex();
 
-		if (load = (nqueue > 0)) {
-			tile = queue[queue_out].tile;
-			_ASSERT(TILE_STATE_OK(tile));			// THIS IS TRIGGERED OFTEN
-			if (tile->state == Tile::InQueue) {
-				tile->state = Tile::Loading; // lock tile and its ancestor tree
-			} else {
-				load = false;
-			}
-			queue_out = (queue_out+1) % MAXQUEUE2; // remove from queue
-			nqueue--;
-		}
+void TileLoader::Unqueue (TileManager2Base *mgr)
+{
+	auto of_mgr = [mgr](const Tile *tile) { return tile->mgr == mgr; };
+
+	WaitForMutex();
+	std::unique_lock<std::mutex> lock(qmtx);
+	for (auto it = queue.begin(); it != queue.end();) {
+		if (of_mgr(it->tile)) {
+			it->tile->state = Tile::Invalid;
+			it = queue.erase(it);
+		} else ++it;
+	}
+	ReleaseMutex();
 
-		ReleaseMutex();
+	// the workers need hLoadMutex to finish a tile
+	cv_done.wait(lock, [&] { return std::none_of(busy.begin(), busy.end(), of_mgr); });
 
-		if (load) {
-			tile->PreLoad(); // Preload data from harddrive to system memory without a Mutex
+	for (auto it = loaded.begin(); it != loaded.end();) {
+		if (of_mgr(*it)) {
+			(*it)->state = Tile::Invalid; // the preloaded data are released with the tile
+			it = loaded.erase(it);
+		} else ++it;
+	}
+}
 
-			WaitForMutex();
-			tile->Load(); // Create the actual tile texture from a pre-loaded data
-			tile->state = Tile::Inactive; // unlock tile
-			ReleaseMutex();
+// -----------------------------------------------------------------------
 
+bool TileLoader::Unqueue (Tile *tile)
+{
+	std::lock_guard<std::mutex> lock(qmtx);
+	if (tile->state == Tile::InQueue) {
+		for (auto it = queue.begin(); it != queue.end(); ++it) {
+			if (it->tile == tile) {
+				queue.erase(it);
+				return true;
+			}
 		}
-		else {
-			Sleep(1);
+	} else if (tile->state == Tile::Loaded) {
+		auto it = std::find(loaded.begin(), loaded.end(), tile);
+		if (it != loaded.end()) {
+			loaded.erase(it);
+			return true;
 		}
 	}
-	return 0;
+	return false;
 }
-#endif
 
 // -----------------------------------------------------------------------
 
-DWORD WINAPI TileLoader::Load_ThreadProc (void *data)
+void TileLoader::Load_ThreadProc ()
 {
-	const int tile_packet_size = 8; // max number of tiles to process from queue
-	TileLoader *loader = (TileLoader*)data;
-	DWORD idle = 1000/loader->load_frequency;
-	Tile *tile[tile_packet_size];
-	int nload, i;
-
-	LogAlw("TileLoader::Load thread started");
-
-	bool bFirstRun = true;
-	while (bFirstRun || WAIT_OBJECT_0 != WaitForSingleObject(loader->hStopThread, idle))
-	{
-		bFirstRun = false;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(qmtx);
+			cv_queue.wait(lock, [this] { return bTerminate || !queue.empty(); });
+			if (bTerminate) break;
+		}
 
+		// tile states are protected by hLoadMutex, which the render thread
+		// holds while it updates the tile trees
 		WaitForMutex ();
-		for (nload = 0; nqueue > 0 && nload < tile_packet_size; nload++) {
-			tile[nload] = queue[queue_out].tile;
-			tile[nload]->state = Tile::Loading; // lock tile and its ancestor tree
-			queue_out = (queue_out+1) % MAXQUEUE2; // remove from queue
-			nqueue--;
+		Tile *tile;
+		{
+			std::lock_guard<std::mutex> lock(qmtx);
+			if (tile = NextTile()) {
+				tile->state = Tile::Loading; // lock tile and its ancestor tree
+				busy.push_back(tile);
+			}
 		}
 		ReleaseMutex ();
+		if (!tile) continue;
 
-		if (nload) {
-			
-			for (i = 0; i < nload; i++) {
-				tile[i]->PreLoad(); // load/create the tile
-				tile[i]->Load();
-			}
+		tile->PreLoad(); // read and decompress the tile data into system memory
+		{
+			std::lock_guard<std::mutex> lock(buildmtx);
+			tile->Load();
+		}
 
-			WaitForMutex();
-			for (i = 0; i < nload; i++) {	
-				tile[i]->state = Tile::Inactive; // unlock tile
-			}
-			ReleaseMutex ();
-		} else {
-			Sleep (idle);
+		WaitForMutex ();
+		{
+			std::lock_guard<std::mutex> lock(qmtx);
+			tile->state = Tile::Loaded;
+			loaded.push_back(tile);
+			busy.erase(std::find(busy.begin(), busy.end(), tile));
 		}
+		ReleaseMutex ();
+		cv_done.notify_all();
 	}
-
-	LogAlw("TileLoader::Load thread terminated");
-	return 0;
 }
 
 // =======================================================================
@@ -23,9 +23,13 @@
 #include <stack>
 #include <vector>
 #include <list>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 #define NPOOLS 32
-#define MAXQUEUE2 20
+#define MAXQUEUE2 256 // max. number of pending tile load requests
+#define MAXUPLOAD2 16 // max. number of tiles uploaded per render call
 
 #define TILE_VALID  0x0001
 #define TILE_ACTIVE 0x0002
@@ -38,6 +42,7 @@
 #define TILE_STATE_OK(t) (t->state == Tile::Invalid \
                        || t->state == Tile::InQueue  \
                        || t->state == Tile::Loading   \
+                       || t->state == Tile::Loaded    \
                        || t->state == Tile::Inactive   \
                        || t->state == Tile::Active      \
                        || t->state == Tile::Invisible    \
@@ -146,6 +151,7 @@ public:
 		Invalid   = 0x0000,                            // tile data have not been loaded/created yet
 		InQueue   = 0x0004,                            // queued for asynchronous load
 		Loading   = 0x0008,                            // in the process of being loaded
+		Loaded    = 0x0010,                            // loaded, waiting for upload to the device
 		Inactive  = TILE_VALID,                        // valid data, but not in active part of quadtree (cached)
 		Active    = TILE_VALID | TILE_ACTIVE,          // active, but not rendered itself (ancestor of rendered tiles)
 		Invisible = TILE_VALID | TILE_ACTIVE | 0x0004, // active, but outside field of view
@@ -171,10 +177,15 @@ protected:
 	virtual void PreLoad() = 0;
 
 	/**
-	 * \brief Construct a surface tile textures from a preloaded data /see virtual bool PreLoad()
+	 * \brief Construct the tile mesh from a preloaded data /see virtual bool PreLoad()
 	 */
 	virtual void Load () = 0;
 
+	/**
+	 * \brief Copy the preloaded textures and the mesh to the device. Called from the render thread.
+	 */
+	virtual void Upload ();
+
 	bool	CreateTexture(LPDIRECT3DDEVICE9 pDev, LPDIRECT3DTEXTURE9 pPre, LPDIRECT3DTEXTURE9 *pTex);
 	bool	LoadTextureFile(const char *path, LPDIRECT3DTEXTURE9 *pPre);
 	bool	LoadTextureFromMemory(void *data, DWORD ndata, LPDIRECT3DTEXTURE9 *pPre);
@@ -192,6 +203,7 @@ protected:
 	int ilng;                  // longitude index
 	int imicrolvl;			   // Micro texture level
 	LPDIRECT3DTEXTURE9 tex;	   // diffuse surface texture
+	LPDIRECT3DTEXTURE9 pPreSrf; // preloaded diffuse texture in system memory, until uploaded
 	LPDIRECT3DTEXTURE9 overlay;
 	bool bMipmaps;			   // create mipmaps for the tile
 	bool owntex;               // true: tile owns the texture, false: tile uses ancestor subtexture
@@ -220,9 +232,16 @@ public:
 // =======================================================================
 
 /**
- * \brief Planetary surface tile loader template.
+ * \brief Planetary surface tile loader.
  *
- * Planetary surface tile loader template class.
+ * Tiles requested by the tile managers are loaded by a pool of worker threads.
+ * Pending requests are ordered by priority (the screen-space error of the tile
+ * they refine). The managers renew their requests every frame with the current
+ * priority, and requests that were not renewed in the previous frame are dropped,
+ * so tiles that have left the view don't hold up the visible ones.
+ * Workers read and decompress the tile data into system memory (Tile::PreLoad)
+ * and build the mesh (Tile::Load). The device upload (Tile::Upload) is done on
+ * the render thread by UploadTiles.
  */
 class TileLoader {
 	template<class T> friend class TileManager2;
@@ -230,32 +249,50 @@ class TileLoader {
 public:
 	explicit TileLoader (const oapi::D3D9Client *gclient);
 	~TileLoader ();
-	bool LoadTileAsync (Tile *tile);
+	bool LoadTileAsync (Tile *tile, float prio, DWORD frame);
+	// queue a tile for loading, or update the priority of a queued tile. Tiles
+	// with higher prio are loaded first. frame is the current frame id.
+	// (caller must own hLoadMutex)
+
+	void UploadTiles (int maxtiles);
+	// upload up to maxtiles loaded tiles to the device and make them valid
+	// (render thread only, caller must own hLoadMutex)
+
 	bool ShutDown ();
 
 	bool Unqueue (Tile *tile);
-	// remove a tile from the load queue (caller must own hLoadMutex)
+	// remove a tile from the load queue or the upload list (caller must own hLoadMutex)
 
 	void Unqueue (TileManager2Base *mgr);
-	// removes all tiles of a manager from the load queue (caller must own hLoadMutex)
+	// removes all tiles of a manager from the load queue and the upload list, and
+	// waits for the tiles of the manager that are being loaded (caller must not own hLoadMutex)
 
 	inline static DWORD WaitForMutex() { return ::WaitForSingleObject (hLoadMutex, INFINITE); }
 	inline static BOOL ReleaseMutex() { return ::ReleaseMutex (hLoadMutex); }
 
 private:
-	void TerminateLoadThread(); // Terminates the Load thread
+	void TerminateLoadThread(); // Terminates the load threads
+	Tile *NextTile ();          // remove the next tile to load from the queue (caller must own hLoadMutex and qmtx)
 
-	static struct QUEUEDESC {
+	struct QUEUEDESC {
 		Tile *tile;
-	} queue[MAXQUEUE2];
+		float prio;  // load priority
+		DWORD frame; // frame id of the last request
+	};
+	std::vector<QUEUEDESC> queue; // pending requests
+	std::vector<Tile*> busy;      // tiles being loaded by the workers
+	std::vector<Tile*> loaded;    // tiles waiting for upload
 
 	const oapi::D3D9Client *gc; // the client
-	static int nqueue, queue_in, queue_out;
-	HANDLE hLoadThread; // Load ThreadProc handle
-	HANDLE hStopThread; // Thread kill signal handle
+	std::vector<std::thread> worker; // load threads
+	std::mutex qmtx;            // protects queue, busy, loaded, frame and bTerminate
+	std::condition_variable cv_queue; // signalled when requests are added, or on shutdown
+	std::condition_variable cv_done;  // signalled when a worker finishes a tile
+	std::mutex buildmtx;        // serialises Tile::Load (tiles share ancestor elevation data)
+	DWORD frame;                // frame id of the latest request
+	bool bTerminate;
 	static HANDLE hLoadMutex;
-	static DWORD WINAPI Load_ThreadProc (void*);
-	int load_frequency;
+	void Load_ThreadProc ();
 };
 
 // =======================================================================
@@ -397,8 +434,8 @@ protected:
 	MATRIX4 WorldMatrix(Tile *tile);
 
 	template<class TileType>
-	QuadTreeNode<TileType> *LoadChildNode (QuadTreeNode<TileType> *node, int idx);
-	// loads one of the four subnodes of 'node', given by 'idx'
+	QuadTreeNode<TileType> *LoadChildNode (QuadTreeNode<TileType> *node, int idx, float prio);
+	// loads one of the four subnodes of 'node', given by 'idx', with load priority 'prio'
 
 	double obj_size;                 // planet radius
 	static TileLoader *loader;
@@ -48,7 +48,7 @@ QuadTreeNode<TileType> *TileManager2Base::FindNode (QuadTreeNode<TileType> root[
 // -----------------------------------------------------------------------
 
 template<class TileType>
-QuadTreeNode<TileType> *TileManager2Base::LoadChildNode (QuadTreeNode<TileType> *node, int idx)
+QuadTreeNode<TileType> *TileManager2Base::LoadChildNode (QuadTreeNode<TileType> *node, int idx, float prio)
 {
 	TileType *parent = node->Entry();
 	int lvl = parent->lvl+1;
@@ -57,10 +57,11 @@ QuadTreeNode<TileType> *TileManager2Base::LoadChildNode (QuadTreeNode<TileType>
 	TileType *tile = new TileType (this, lvl, ilat, ilng);
 	QuadTreeNode<TileType> *child = node->AddChild (idx, tile);
 	if (bTileLoadThread)
-		loader->LoadTileAsync (tile);
+		loader->LoadTileAsync (tile, prio, GetScene()->GetFrameId());
 	else {
 		tile->PreLoad();
 		tile->Load();
+		tile->Upload();
 		tile->state = Tile::Inactive;
 	}
 	return child;
@@ -174,6 +175,7 @@ void TileManager2Base::ProcessNode (QuadTreeNode<TileType> *node)
 	}
 
 	int tgtres = -1;
+	float prio = 0.0f; // load priority of the subtiles: resolution deficit [levels]
 
 	// Compute target resolution level based on tile distance
 	if (bstepdown) {
@@ -203,6 +205,8 @@ void TileManager2Base::ProcessNode (QuadTreeNode<TileType> *node)
 		// This doesn't work with narrow FOV, added max() to set low limit
 		double apr = tdist * fc * max(0.12, scene->GetTanAp()) * resolutionScale;
 		tgtres = (apr < 1e-6 ? maxlvl : max(0, min(maxlvl, (int)(bias - log(apr)*res_scale))));
+		prio = (apr < 1e-6 ? float(maxlvl - lvl) : float(bias - log(apr)*res_scale - lvl));
+		if (tile->state == Tile::Invisible) prio -= 2.0f; // outside the viewport
 		bstepdown = (lvl < tgtres);
 		tile->tgtscale = pow(2.0f, float(tgtres - lvl));
 	}
@@ -234,9 +238,9 @@ void TileManager2Base::ProcessNode (QuadTreeNode<TileType> *node)
 		for (idx = 0; idx < 4; idx++) {
 			QuadTreeNode<TileType>* child = node->Child(idx);
 			if (!child)
-				child = LoadChildNode(node, idx);
-			else if (child->Entry()->state == Tile::Invalid)
-				loader->LoadTileAsync(child->Entry());
+				child = LoadChildNode(node, idx, prio);
+			else if (child->Entry()->state == Tile::Invalid || child->Entry()->state == Tile::InQueue)
+				loader->LoadTileAsync(child->Entry(), prio, scene->GetFrameId()); // (re)queue with the current priority
 			Tile::TileState state = child->Entry()->state;
 			if (!(state & TILE_VALID))
 				subcomplete = false;
@@ -336,6 +340,7 @@ TileManager2<TileType>::TileManager2 (vPlanet *vplanet, int _maxres, int _gridre
 		globtile[i] = new TileType(this, i - 3, 0, 0);
 		globtile[i]->PreLoad();
 		globtile[i]->Load();
+		globtile[i]->Upload();
 	}
 
 	// Set the root tiles for level 0
@@ -343,6 +348,7 @@ TileManager2<TileType>::TileManager2 (vPlanet *vplanet, int _maxres, int _gridre
 		tiletree[i].SetEntry (new TileType (this, 0, 0, i));
 		tiletree[i].Entry()->PreLoad();
 		tiletree[i].Entry()->Load();
+		tiletree[i].Entry()->Upload();
 	}
 }
 
@@ -355,6 +361,8 @@ TileManager2<TileType>::~TileManager2 ()
 	//for (int i = 0; i < 2; i++)
 	//  DebugDump(&tiletree[i]);
 
+	if (loader) loader->Unqueue(this); // wait for tiles being loaded
+
 	for (int i = 0; i < 2; i++)
 		tiletree[i].DelChildren();
 	for (int i = 0; i < 3; i++)
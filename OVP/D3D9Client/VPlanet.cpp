@@ -18,6 +18,7 @@
 #define D3D_OVERLOADS
 
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <unordered_map>
 
@@ -93,6 +94,7 @@ struct TilePixelPosition
 std::unordered_map<OBJHANDLE, std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, std::vector<FlatShape*>>>>> g_ElevationFlatteningShapes;
 std::unordered_map<OBJHANDLE, std::vector<FlatShape*>> g_ShapeStore;
 std::unordered_map<OBJHANDLE, bool> g_ShapesLoaded;
+std::mutex g_ShapesMutex; // protects the shape maps: the physics filter runs on the core's loader threads
 
 std::vector<std::string> EnumerateDirectory(std::string directory, std::string filter)
 {
@@ -245,6 +247,7 @@ template <typename Type>
 bool FilterElevation(OBJHANDLE hPlanet, int lvl, int ilat, int ilng, double elev_res, Type* elev)
 {
 	if (!elev) return false;
+	std::lock_guard<std::mutex> lock(g_ShapesMutex);
 	if (g_ShapesLoaded.find(hPlanet) == g_ShapesLoaded.end()) ProcessPlanetFlats(hPlanet);
 	if (g_ElevationFlatteningShapes.find(hPlanet) == g_ElevationFlatteningShapes.end()) return false; // Nothing for planet
 	auto planetShapes = g_ElevationFlatteningShapes[hPlanet];
@@ -331,6 +334,7 @@ void vPlanet::GlobalExit()
 {
 	// Face's Cleanup ShapeStore -----------------------
 	//
+	std::unique_lock<std::mutex> lock(g_ShapesMutex);
 	for (auto store : g_ShapeStore)
 	{
 		for (auto shape : store.second)
@@ -341,6 +345,7 @@ void vPlanet::GlobalExit()
 	g_ShapeStore.clear();
 	g_ElevationFlatteningShapes.clear();
 	g_ShapesLoaded.clear();
+	lock.unlock();
 
 	SAFE_DELETE(pIP);
 	SAFE_RELEASE(ptEclipse);
@@ -14,6 +14,9 @@
 #include "GraphicsAPI.h"
 #include <array>
 
+class StarCatalogue;
+struct StarCatRec;
+
 namespace oapi {
 
 	/**
@@ -34,7 +37,7 @@ namespace oapi {
 		virtual ~CelestialSphere();
 
 		/**
-		 * \brief Star database record structure, as used by \ref LoadStarData.
+		 * \brief Star database record structure (star.bin format, unpacked).
 		 * \note The spectral class index is a linear encoding of the star's
 		 *    spectral class, from O0 (0) to M9 (69) for classes OBANGKM. Since
 		 *    the spectral information is only used for modifying the render
@@ -110,6 +113,22 @@ namespace oapi {
 		 */
 		const std::vector<StarRenderRec> LoadStars() const;
 
+		/**
+		 * \brief Load the stars within a view cone and pre-process them
+		 *    according to user-defined display parameters.
+		 * \param dir cone axis (unit vector in the ecliptic frame)
+		 * \param radius angular cone radius [rad]
+		 * \param maxAppMag apparent magnitude limit
+		 * \return Vector of \ref StarRenderRec records for the stars brighter
+		 *    than \a maxAppMag within the cone, ordered by decreasing brightness
+		 *    to within 0.5 magnitudes.
+		 * \note The star catalogue is indexed by magnitude and sky region, so
+		 *    the cost of the query is proportional to the number of returned
+		 *    records. This allows to extract fainter stars for a narrow field of
+		 *    view than would be practical for the whole sky.
+		 */
+		const std::vector<StarRenderRec> LoadStars(const VECTOR3& dir, double radius, double maxAppMag) const;
+
 		/**
 		 * \brief Load constellation line data from the database file and pre-process
 		 *    them for use by graphics clients.
@@ -184,33 +203,31 @@ namespace oapi {
 
 	private:
 		/**
-		 * \brief Load star data from Orbiter's data base file.
+		 * \brief Open Orbiter's star catalogue.
 		 *
-		 * Load database records up to apparent magnitude \a maxAppMag (database
-		 * is assumed to be sorted in decreasing brightness). The Hipparcos
-		 * catalog contains ~118000 entries up to magnitude ~9, although some
-		 * entries with higher magnitudes are present.
-		 * \param maxAppMag apparent magnitude limit. The returned records are
-		 *    truncated at this magnitude.
-		 * \return Vector of database records.
+		 * Maps the indexed catalogue file (star.cat) if present. Otherwise the
+		 * records of the star database file (star.bin) are read and indexed in
+		 * memory. The catalogue is opened on first use and kept until the
+		 * celestial sphere is destroyed. It is held in a table private to the
+		 * implementation, so that the class layout doesn't depend on it.
+		 * \return Star catalogue, or NULL if no star data are available.
 		 */
-		const std::vector<StarDataRec> LoadStarData(double maxAppMag) const;
+		const StarCatalogue* StarCat() const;
 
 		/**
-		 * \brief Map star data to a list that can be used for rendering.
+		 * \brief Map star catalogue records to a list that can be used for rendering.
 		 *
-		 * This function maps the star data read by \ref LoadStarData into a form
-		 * that makes it easier to build a vertex list for rendering onto the celestial
-		 * sphere. The ecliptic coordinates (longitude, latitude) are converted to
-		 * Cartesian coordinates (x,y,z) on the unit sphere (radius 1).
+		 * This function maps the star records returned by a catalogue query into a
+		 * form that makes it easier to build a vertex list for rendering onto the
+		 * celestial sphere. The positions are copied from the unit direction vectors.
 		 * The apparent magnitude is mapped into a brightness value (0-1), using the user
 		 * settings for star brightness. In addition, the spectral class information
 		 * is mapped into red, green and blue components (0-1).
-		 * \param starDataRec star data list as provided by \ref LoadStarData
+		 * \param starCatRec star records as provided by a catalogue query
 		 * \param prm user choice for star render parameters
 		 * \return List of transformed star data
 		 */
-		const std::vector<StarRenderRec> StarData2RenderData(const std::vector<StarDataRec>& starDataRec, const StarRenderPrm& prm) const;
+		const std::vector<StarRenderRec> StarData2RenderData(const std::vector<const StarCatRec*>& starCatRec, const StarRenderPrm& prm) const;
 
 		/**
 		 * \brief Load an array of line segment definitions on the celestial sphere from file.
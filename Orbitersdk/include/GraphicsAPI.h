@@ -1477,6 +1477,10 @@ public:
 	 *   features) for visuals should overload this method in order to manipulate the
 	 *   terrain collision data in the same way. As soon as the internal collision tile
 	 *   is loaded in the core, the callback is invoked.
+	 * \note The callback may be invoked from the core's tile prefetch and vessel
+	 *   update threads rather than the main thread. The core never runs two
+	 *   invocations at the same time, but implementations must synchronise
+	 *   any data they share with the render thread.
 	 */
 	virtual bool clbkFilterElevation(OBJHANDLE hPlanet, int ilat, int ilng, int lvl, double elev_res, INT16* elev) { return false; }
 	// @}
@@ -572,6 +572,52 @@ public:
 	 * \sa GetGravityGradientDamping, SetEmptyMass, SetPMI
 	 */
 	bool SetGravityGradientDamping (double damp) const;
+
+	/**
+	 * \brief Returns the vessel-specific error tolerance of the adaptive
+	 *   state propagator.
+	 * \return Relative error tolerance, or 0 if the vessel uses the
+	 *   propagator settings of the physics engine options.
+	 * \sa SetPropagatorTolerance
+	 */
+	double GetPropagatorTolerance () const;
+
+	/**
+	 * \brief Propagates the vessel state with the adaptive embedded
+	 *   Runge-Kutta method (Dormand-Prince 5(4)).
+	 * \param tol Relative error tolerance per substep (> 0), or 0 to
+	 *   revert to the propagator settings of the physics engine options.
+	 * \note The adaptive propagator divides each time step into substeps
+	 *   whose length is controlled by a local error estimate. The position
+	 *   and velocity errors are measured relative to the vessel's distance
+	 *   from and velocity with respect to its orbit reference body.
+	 * \note This allows accurate propagation of individual vessels during
+	 *   close flybys or aerobraking passes, without using high-order
+	 *   propagators for all vessels.
+	 * \note The tolerance can also be set in the vessel configuration file
+	 *   with the PropTolerance tag.
+	 * \note During surface contact the fixed-step propagators are used.
+	 * \sa GetPropagatorTolerance
+	 */
+	void SetPropagatorTolerance (double tol) const;
+
+	/**
+	 * \brief Returns the vessel's state at an intermediate time of the
+	 *   last time step.
+	 * \param simt simulation time [s]
+	 * \param pos vector receiving position in the global frame [<b>m</b>]
+	 * \param vel vector receiving velocity in the global frame [<b>m/s</b>]
+	 * \return true if the state could be interpolated, false otherwise.
+	 * \note The state is evaluated from the dense output of the adaptive
+	 *   propagator, which has the same order of accuracy as the propagated
+	 *   states at the step boundaries.
+	 * \note simt must lie within the last time step. The function returns
+	 *   false and leaves pos and vel unchanged if simt is outside this
+	 *   interval, or if the last step was not propagated with the adaptive
+	 *   propagator (see \ref SetPropagatorTolerance).
+	 * \sa SetPropagatorTolerance, GetGlobalPos, GetGlobalVel
+	 */
+	bool GetIntermediateState (double simt, VECTOR3 &pos, VECTOR3 &vel) const;
 	//@}
 
 	/// \name Vessel state
@@ -826,6 +872,22 @@ public:
 	 */
 	bool OrbitStabilised () const;
 
+	/**
+	 * \brief Flag indicating whether the vessel is propagated on rails at
+	 *   the current time step.
+	 * \return true indicates that the vessel's state is currently updated
+	 *   analytically along its osculating orbit around the reference body,
+	 *   with secular corrections for the body's J2 coefficient.
+	 * \note On-rails propagation is used only if the user has enabled it
+	 *   (OnRails option), and only for vessels without active forces that
+	 *   are neither the focus object nor the camera target, and are far
+	 *   from the camera and from other vessels.
+	 * \note The vessel returns to numerical propagation as soon as any of
+	 *   these conditions fails.
+	 * \sa OrbitStabilised
+	 */
+	bool OnRails () const;
+
 	/**
 	 * \brief Flag for nonspherical gravity perturbations.
 	 *
@@ -0,0 +1,165 @@
+-- Checks the adaptive Dormand-Prince 5(4) propagator on the eccentric
+-- heliocentric orbit of the AdaptivePropagator scenario. Must be run with a
+-- fixed time step (see the Scenario.AdaptivePropagator test).
+--
+-- Step size control: the vessels are propagated with different error
+-- tolerances. After one orbit, their deviation from RK-REF, which uses a much
+-- tighter tolerance, must decrease with the tolerance and stay below the sum
+-- of the local error bounds of all steps.
+--
+-- Dense output: the intermediate states of RK-REF during the perihelion
+-- passage are compared with a Kepler orbit around the Sun, propagated from
+-- the state at the start of each step. The planetary perturbations are
+-- accounted for by a cubic correction that vanishes at the start of the step
+-- and matches the propagated state at its end. The intermediate states of
+-- the other vessels are compared with those of RK-REF, after removing the
+-- deviation between the orbits, interpolated from the step boundaries.
+
+local G = 6.67259e-11         -- gravitational constant used by Orbiter
+local tdense = 4e6            -- end of the perihelion passage [s]
+local theta = {0.1, 0.25, 0.5, 0.75, 0.9}
+
+local tol = {["RK-1"] = 1e-10, ["RK-2"] = 1e-12, ["RK-REF"] = 1e-14}
+local kepler_tol = 1e-10     -- accuracy limit of the reference orbit
+
+local function check(cond, msg)
+	if not cond then
+		oapi.write_log("AdaptivePropagator: FAILED: "..msg)
+		oapi.exit(1)
+	end
+end
+
+-- Stumpff functions c2(z), c3(z)
+local function stumpff(z)
+	if z > 1e-6 then
+		local s = math.sqrt(z)
+		return (1-math.cos(s))/z, (s-math.sin(s))/(s*s*s)
+	elseif z < -1e-6 then
+		local s = math.sqrt(-z)
+		return (math.cosh(s)-1)/(-z), (math.sinh(s)-s)/(s*s*s)
+	else
+		return 0.5-z/24, 1/6-z/120
+	end
+end
+
+-- Cubic Hermite interpolation between states (p0,v0) and (p1,v1) at step
+-- fraction th of step length h
+local function hermite(p0, v0, p1, v1, th, h)
+	local th2, th3 = th*th, th*th*th
+	return p0*(1-3*th2+2*th3) + v0*(h*(th-2*th2+th3)) + p1*(3*th2-2*th3) + v1*(h*(th3-th2)),
+		(p1-p0)*((6*th-6*th2)/h) + v0*(1-4*th+3*th2) + v1*(3*th2-2*th)
+end
+
+-- Two-body propagation of relative state r0, v0 over dt (universal variables)
+local function kepler(r0, v0, dt, mu)
+	local r = vec.length(r0)
+	local sigma = vec.dotp(r0, v0)/math.sqrt(mu)
+	local alpha = 2/r - vec.dotp(v0, v0)/mu
+	local smu = math.sqrt(mu)
+	local x = smu*alpha*dt
+	local c2, c3
+	for i = 1, 50 do
+		local z = alpha*x*x
+		c2, c3 = stumpff(z)
+		local f = sigma*x*x*c2 + (1-alpha*r)*x*x*x*c3 + r*x - smu*dt
+		local df = sigma*x*(1-z*c3) + (1-alpha*r)*x*x*c2 + r
+		local dx = f/df
+		x = x - dx
+		if math.abs(dx) <= 1e-14*math.abs(x) then break end
+	end
+	c2, c3 = stumpff(alpha*x*x)
+	local f = 1 - x*x/r*c2
+	local g = dt - x*x*x/smu*c3
+	local rt = r0*f + v0*g
+	local rn = vec.length(rt)
+	local fd = smu/(rn*r)*(alpha*x*x*x*c3 - x)
+	local gd = 1 - x*x/rn*c2
+	return rt, r0*fd + v0*gd
+end
+
+local hsun = oapi.get_objhandle("Sun")
+local mu = G*oapi.get_mass(hsun)
+
+local ves = {}
+for name, t in pairs(tol) do
+	local v = vessel.get_interface(name)
+	check(v ~= nil, "vessel "..name.." not found")
+	v:set_propagatortolerance(t)
+	check(v:get_propagatortolerance() == t, "tolerance of "..name.." not applied")
+	ves[name] = {v = v, tol = t, derr = 0, rsum = 0}
+end
+local ref = ves["RK-REF"]
+
+-- start from a step propagated with the new tolerances
+proc.skip()
+local t0 = oapi.get_simtime()
+local r, v = ref.v:get_relativepos(hsun), ref.v:get_relativevel(hsun)
+local a = 1/(2/vec.length(r) - vec.dotp(v, v)/mu)
+local period = 2*math.pi*math.sqrt(a*a*a/mu)
+
+local ts, sp, sv = t0, oapi.get_globalpos(hsun), oapi.get_globalvel(hsun)
+for _, e in pairs(ves) do
+	e.p1, e.q1 = e.v:get_globalpos(), e.v:get_globalvel()
+end
+
+while oapi.get_simtime() < t0 + period do
+	proc.skip()
+	local t = oapi.get_simtime()
+	local h = t - ts
+	local sp1, sv1 = oapi.get_globalpos(hsun), oapi.get_globalvel(hsun)
+	for name, e in pairs(ves) do
+		e.p0, e.q0 = e.p1, e.q1
+		e.p1, e.q1 = e.v:get_globalpos(), e.v:get_globalvel()
+		e.rsum = e.rsum + vec.length(e.p1 - sp1)
+		check(e.v:get_intermediatestate(t + 0.5*h) == nil, name..": state returned outside the last step")
+	end
+
+	if t <= tdense then
+		-- deviation of RK-REF from the Kepler orbit at the end of the step,
+		-- and coefficients of the correction c2*th^2 + c3*th^3
+		local r0, v0 = ref.p0 - sp, ref.q0 - sv
+		local rk, vk = kepler(r0, v0, h, mu)
+		local dr, dv = ref.p1 - sp1 - rk, (ref.q1 - sv1 - vk)*h
+		local c2, c3 = dr*3 - dv, dv - dr*2
+
+		for _, th in ipairs(theta) do
+			local tq = ts + th*h
+			local pr, qr = ref.v:get_intermediatestate(tq)
+			check(pr ~= nil, "RK-REF: no intermediate state at t="..tq)
+			local spt, svt = hermite(sp, sv, sp1, sv1, th, h)
+			rk, vk = kepler(r0, v0, th*h, mu)
+			local ep = vec.length(pr - spt - rk - c2*(th*th) - c3*(th*th*th))
+			local ev = vec.length(qr - svt - vk - (c2*(2*th) + c3*(3*th*th))*(1/h))
+			ref.derr = math.max(ref.derr, ep/vec.length(rk), ev/vec.length(vk))
+
+			for name, e in pairs(ves) do
+				if e ~= ref then
+					local pd, qd = e.v:get_intermediatestate(tq)
+					check(pd ~= nil, name..": no intermediate state at t="..tq)
+					local dp, dq = hermite(e.p0-ref.p0, e.q0-ref.q0, e.p1-ref.p1, e.q1-ref.q1, th, h)
+					ep = vec.length(pd - pr - dp)
+					ev = vec.length(qd - qr - dq)
+					e.derr = math.max(e.derr, ep/vec.length(pr - spt), ev/vec.length(qr - svt))
+				end
+			end
+		end
+	end
+	ts, sp, sv = t, sp1, sv1
+end
+
+-- dense output error relative to the distance from and velocity with
+-- respect to the Sun
+for name, e in pairs(ves) do
+	oapi.write_log(string.format("AdaptivePropagator: %s tol=%g dense output error %.3g", name, e.tol, e.derr))
+	check(e.derr < (e == ref and kepler_tol or 10*e.tol), name..": dense output error exceeds tolerance")
+end
+
+-- global error with respect to the reference vessel
+local e1, e2 = ves["RK-1"], ves["RK-2"]
+local err1, err2 = vec.length(e1.p1 - ref.p1), vec.length(e2.p1 - ref.p1)
+oapi.write_log(string.format("AdaptivePropagator: deviation after one orbit: %.3g m (tol=%g), %.3g m (tol=%g)", err1, e1.tol, err2, e2.tol))
+check(err1 < e1.tol*e1.rsum, "RK-1: global error exceeds accumulated tolerance")
+check(err2 < e2.tol*e2.rsum, "RK-2: global error exceeds accumulated tolerance")
+check(err2 < 0.1*err1, "global error does not decrease with the tolerance")
+
+oapi.exit(0)
@@ -0,0 +1,119 @@
+-- Switches vessel RAILS of the OnRails scenario between on-rails and
+-- numerical propagation, by moving the focus to it and back. Run twice by
+-- the Scenario.OnRails test (see Tests/OnRails.cmake):
+-- 1. Without on-rails propagation: writes the states at the end of each
+--    phase to OnRails.ref as the free-flight reference.
+-- 2. With on-rails propagation: checks that the vessel enters and leaves
+--    the rails as expected, that position and velocity are continuous
+--    across each switch, and that the drift from the free-flight reference
+--    stays within the limits expected from the perturbations neglected on
+--    rails.
+
+local G = 6.67259e-11         -- gravitational constant used by Orbiter
+local refname = "OnRails.ref"
+
+-- on rails (focus elsewhere) or numerical (focus on RAILS), and duration [s]
+local phase = {
+	{rails = true,  dt = 3600},
+	{rails = false, dt = 1800},
+	{rails = true,  dt = 3600}
+}
+
+-- Limit of the jump of the position update residual across a switch [m].
+-- The residual is the deviation of the position update over a time step from
+-- the one given by the velocities and point mass accelerations at both ends.
+-- On rails it is dominated by the secular rates of the orbital elements, which
+-- are not reflected in the velocity, but it varies only slowly along the
+-- orbit. A jump of dp in position or dv in velocity at a switch shows up as a
+-- deviation of dp or dv*h/2 from the residual extrapolated back from the two
+-- following steps.
+local max_jump = 0.1
+-- Limits of the drift from the free-flight orbit, dominated by the short
+-- period J2 terms neglected on rails: position relative to the distance
+-- from Earth, and angle between the orbit planes [rad]
+local max_drift = 0.02
+local max_tilt = 1e-3
+
+local function check(cond, msg)
+	if not cond then
+		oapi.write_log("OnRails: FAILED: "..msg)
+		oapi.exit(1)
+	end
+end
+
+local function angle(a, b)
+	return math.acos(math.min(1, vec.dotp(a, b)/(vec.length(a)*vec.length(b))))
+end
+
+local hearth = oapi.get_objhandle("Earth")
+local mu = G*oapi.get_mass(hearth)
+local v = vessel.get_interface("RAILS")
+check(v ~= nil, "vessel RAILS not found")
+
+-- the reference file selects the mode
+local ref = nil
+local f = io.open(refname, "r")
+if f ~= nil then
+	ref = {}
+	for i = 1, #phase do
+		local x = {}
+		for j = 1, 6 do x[j] = f:read("*n") end
+		check(x[6] ~= nil, "incomplete reference file")
+		ref[i] = {p = vec.set(x[1], x[2], x[3]), q = vec.set(x[4], x[5], x[6])}
+	end
+	f:close()
+else
+	f = io.open(refname, "w")
+	check(f ~= nil, "cannot write reference file")
+end
+
+local function state()
+	local p, q = v:get_relativepos(hearth), v:get_relativevel(hearth)
+	local r = vec.length(p)
+	return p, q, p*(-mu/(r*r*r))
+end
+
+local t = oapi.get_simtime()
+local p, q, a = state()
+local jump = 0
+
+for i, ph in ipairs(phase) do
+	oapi.set_focusobject(ph.rails and "FOCUS" or "RAILS")
+	local t1 = t + ph.dt
+	local n, res1, res2 = 0, nil, nil
+	while t < t1 - 1e-6 do
+		proc.skip()
+		local tn = oapi.get_simtime()
+		local pn, qn, an = state()
+		local h = tn - t
+		local res = pn - p - (q + qn)*(h/2) + (an - a)*(h*h/12)
+		n = n + 1
+		if n == 1 then
+			res1 = res
+		elseif n == 2 then
+			res2 = res
+		elseif n == 3 then
+			jump = math.max(jump, vec.length(res1 - res2*2 + res))
+		end
+		check(v:is_onrails() == (ph.rails and ref ~= nil), string.format("unexpected propagation mode at t=%.0f", tn))
+		t, p, q, a = tn, pn, qn, an
+	end
+
+	if ref == nil then
+		f:write(string.format("%.17g %.17g %.17g %.17g %.17g %.17g\n", p.x, p.y, p.z, q.x, q.y, q.z))
+	else
+		local drift = vec.length(p - ref[i].p)
+		local tilt = angle(vec.crossp(p, q), vec.crossp(ref[i].p, ref[i].q))
+		oapi.write_log(string.format("OnRails: phase %d: drift %.1f m, orbit plane tilt %.3g", i, drift, tilt))
+		check(drift < max_drift*vec.length(p), "drift from free flight exceeds limit in phase "..i)
+		check(tilt < max_tilt, "orbit plane tilt from free flight exceeds limit in phase "..i)
+	end
+end
+
+oapi.write_log(string.format("OnRails: max. residual jump across a switch %.3g m", jump))
+check(jump < max_jump, "state discontinuity at a switch")
+
+if ref == nil then
+	f:close()
+end
+oapi.exit(0)
@@ -0,0 +1,26 @@
+-- Propagates the vessels of the ParallelUpdate scenario over a fixed
+-- simulation interval and writes their state vectors to ParallelUpdate.out.
+-- Values are written with 17 significant digits, so that runs which differ
+-- in any bit of the final states produce different files.
+
+proc.wait_simdt(600)
+
+local f = io.open("ParallelUpdate.out", "w")
+if f == nil then
+	oapi.exit(1)
+end
+for i = 0, vessel.get_count()-1 do
+	local v = vessel.get_interface(i)
+	local p = v:get_globalpos()
+	local q = v:get_globalvel()
+	local r = v:get_globalorientation()
+	local w = v:get_angvel()
+	f:write(v:get_name())
+	for _, u in ipairs({p, q, r, w}) do
+		f:write(string.format(" %.17g %.17g %.17g", u.x, u.y, u.z))
+	end
+	f:write("\n")
+end
+f:close()
+
+oapi.exit(0)
@@ -0,0 +1,95 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+#include "EphemCache.h"
+#include "EphemFile.h"
+#include <math.h>
+
+static const double PI = 3.14159265358979323846;
+
+// ===========================================================
+// class EphemCache
+// ===========================================================
+
+EphemCache::EphemCache (EphemFunc _func, double _seglen, int _order)
+{
+	func = _func;
+	file = 0;
+	seglen = _seglen;
+	order = (_order < 2 ? 2 : _order > EPHEMCACHE_MAXORDER ? EPHEMCACHE_MAXORDER : _order);
+	last = 0;
+	lastidx = 0;
+
+	// Chebyshev transform for the order+1 nodes of T_(order+1)
+	int j, k, n = order+1;
+	for (j = 0; j < n; j++)
+		for (k = 0; k < n; k++)
+			cosTab[j][k] = (j ? 2.0 : 1.0)/n * cos (PI*j*(k+0.5)/n);
+}
+
+void EphemCache::Eval (double mjd, double *ret)
+{
+	if (file && file->Eval (mjd, ret)) return;
+
+	long long idx = (long long)floor (mjd/seglen);
+	if (!last || idx != lastidx) {
+		auto it = segment.find (idx);
+		if (it == segment.end()) {
+			if (segment.size() >= MAXSEG) segment.clear();
+			it = segment.emplace (idx, Segment()).first;
+			Fit (idx, it->second);
+		}
+		last = &it->second;
+		lastidx = idx;
+	}
+	Eval (*last, 2.0*(mjd - idx*seglen)/seglen - 1.0, ret);
+}
+
+void EphemCache::Fit (long long idx, Segment &seg) const
+{
+	int i, j, k, n = order+1;
+	double f[EPHEMCACHE_MAXORDER+1][6];
+	double t0 = idx*seglen;
+
+	for (k = 0; k < n; k++)
+		func (t0 + 0.5*seglen*(1.0 + cos (PI*(k+0.5)/n)), f[k]);
+
+	for (i = 0; i < 3; i++) {
+		for (j = 0; j < n; j++) {
+			double c = 0.0;
+			for (k = 0; k < n; k++) c += cosTab[j][k]*f[k][i];
+			seg.c[i][j] = c;
+		}
+		// derivative coefficients, scaled from normalised time to seconds
+		double dscale = 2.0/(seglen*86400.0);
+		double d1 = 0.0, d2 = 0.0, dj;
+		for (j = order; j > 0; j--) {
+			dj = d2 + 2.0*j*seg.c[i][j];
+			d2 = d1; d1 = dj;
+			seg.d[i][j-1] = dj;
+		}
+		seg.d[i][0] *= 0.5;
+		for (j = 0; j < order; j++) seg.d[i][j] *= dscale;
+	}
+}
+
+void EphemCache::EvalSegment (const Segment &seg, int order, double x, double *ret)
+{
+	// Clenshaw summation
+	for (int i = 0; i < 3; i++) {
+		double b0, b1 = 0.0, b2 = 0.0, x2 = 2.0*x;
+		int j;
+		for (j = order; j > 0; j--) {
+			b0 = x2*b1 - b2 + seg.c[i][j];
+			b2 = b1; b1 = b0;
+		}
+		ret[i] = x*b1 - b2 + seg.c[i][0];
+
+		b1 = b2 = 0.0;
+		for (j = order-1; j > 0; j--) {
+			b0 = x2*b1 - b2 + seg.d[i][j];
+			b2 = b1; b1 = b0;
+		}
+		ret[i+3] = x*b1 - b2 + seg.d[i][0];
+	}
+}
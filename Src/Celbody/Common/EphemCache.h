@@ -0,0 +1,78 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Chebyshev segment cache for ephemeris solutions
+// Replaces the evaluation of a full perturbation series (VSOP87, ELP82,
+// TASS17, Lieske) for interpolated ephemerides. Time is divided into
+// segments of fixed length. When a time in a segment is first requested,
+// the position is fitted with a Chebyshev polynomial over the segment.
+// Subsequent requests in the segment, in any order, are evaluated from
+// the polynomial with a few multiply-adds. Velocities are the derivative
+// of the position polynomial, so position and velocity are consistent.
+// Segments can also be read from a precomputed ephemeris file (EphemFile).
+// This module has no dependencies on the Orbiter API.
+// =======================================================================
+
+#ifndef __EPHEMCACHE_H
+#define __EPHEMCACHE_H
+
+#include <functional>
+#include <unordered_map>
+
+#define EPHEMCACHE_MAXORDER 16
+
+class EphemFile;
+
+class EphemCache {
+public:
+	typedef std::function<void(double mjd, double *ret)> EphemFunc;
+	// Full ephemeris solution at time mjd. Must return positions in
+	// ret[0..2] and their rates of change per second in ret[3..5].
+
+	EphemCache (EphemFunc func, double seglen, int order = 12);
+	// seglen: segment length [days]
+	// order: polynomial order (<= EPHEMCACHE_MAXORDER)
+
+	void Eval (double mjd, double *ret);
+	// Interpolated position (ret[0..2]) and rate (ret[3..5]) at time mjd
+
+	void Clear () { segment.clear(); last = 0; }
+	// Discard all cached segments
+
+	void SetFile (const EphemFile *f) { file = f; }
+	// Precomputed ephemeris file used for all times it covers (0: none).
+	// The file is not owned by the cache.
+
+	inline double SegmentLength () const { return seglen; }
+	inline int Order () const { return order; }
+
+	static const size_t MAXSEG = 256;
+	// Maximum number of cached segments. The cache is cleared when it is full.
+
+	struct Segment {
+		double c[3][EPHEMCACHE_MAXORDER+1];  // position coefficients
+		double d[3][EPHEMCACHE_MAXORDER];    // rate coefficients [1/s]
+	};
+
+	void Fit (long long idx, Segment &seg) const;
+	// Fit segment idx, covering times idx*seglen to (idx+1)*seglen [MJD]
+
+	void Eval (const Segment &seg, double x, double *ret) const { EvalSegment (seg, order, x, ret); }
+	// Evaluate segment seg at normalised time x (-1..1)
+
+	static void EvalSegment (const Segment &seg, int order, double x, double *ret);
+	// Evaluate segment seg of polynomial order 'order' at normalised time x
+
+private:
+	EphemFunc func;
+	const EphemFile *file; // precomputed segments, if available
+	double seglen;
+	int order;
+	double cosTab[EPHEMCACHE_MAXORDER+1][EPHEMCACHE_MAXORDER+1]; // fit matrix
+	std::unordered_map<long long, Segment> segment;
+	const Segment *last;   // most recently used segment
+	long long lastidx;     // and its index
+};
+
+#endif // !__EPHEMCACHE_H
@@ -0,0 +1,151 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+#include "EphemFile.h"
+#include <cstdio>
+#include <cstring>
+#include <math.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char EPHEMFILE_MAGIC[8] = "ORBEPHM";
+static const uint32_t EPHEMFILE_VERSION = 1;
+
+// ===========================================================
+// class EphemFile
+// ===========================================================
+
+EphemFile::EphemFile ()
+: hdr(0), seg(0), mjd0(0.0), mjd1(0.0), size(0), hFile(0), hMap(0)
+{}
+
+EphemFile::~EphemFile ()
+{
+	Close();
+}
+
+bool EphemFile::Open (const char *fname)
+{
+	Close();
+
+	const char *data;
+#ifdef _WIN32
+	HANDLE hf = CreateFileA (fname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hf == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER fsize;
+	if (!GetFileSizeEx (hf, &fsize) || (size_t)fsize.QuadPart < sizeof(EphemFileHeader)) {
+		CloseHandle (hf);
+		return false;
+	}
+	HANDLE hm = CreateFileMappingA (hf, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!hm) {
+		CloseHandle (hf);
+		return false;
+	}
+	data = (const char*)MapViewOfFile (hm, FILE_MAP_READ, 0, 0, 0);
+	if (!data) {
+		CloseHandle (hm);
+		CloseHandle (hf);
+		return false;
+	}
+	hFile = hf;
+	hMap = hm;
+	size = (size_t)fsize.QuadPart;
+#else
+	int fd = open (fname, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat (fd, &st) || (size_t)st.st_size < sizeof(EphemFileHeader)) {
+		close (fd);
+		return false;
+	}
+	void *p = mmap (0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd);
+	if (p == MAP_FAILED) return false;
+	data = (const char*)p;
+	size = (size_t)st.st_size;
+#endif
+	hdr = (const EphemFileHeader*)data;
+	seg = (const EphemCache::Segment*)(data + sizeof(EphemFileHeader));
+
+	// check format
+	if (memcmp (hdr->magic, EPHEMFILE_MAGIC, 8) || hdr->version != EPHEMFILE_VERSION ||
+		hdr->maxorder != EPHEMCACHE_MAXORDER || hdr->order < 2 || hdr->order > EPHEMCACHE_MAXORDER ||
+		!(hdr->seglen > 0.0) || hdr->nseg <= 0 ||
+		(uint64_t)hdr->nseg > (size - sizeof(EphemFileHeader)) / sizeof(EphemCache::Segment)) {
+		Close();
+		return false;
+	}
+	mjd0 = hdr->firstseg * hdr->seglen;
+	mjd1 = (hdr->firstseg + hdr->nseg) * hdr->seglen;
+	return true;
+}
+
+void EphemFile::Close ()
+{
+	if (hdr) {
+#ifdef _WIN32
+		UnmapViewOfFile (hdr);
+		CloseHandle ((HANDLE)hMap);
+		CloseHandle ((HANDLE)hFile);
+#else
+		munmap ((void*)hdr, size);
+#endif
+		hdr = 0;
+		seg = 0;
+		hFile = hMap = 0;
+		size = 0;
+	}
+	mjd0 = mjd1 = 0.0;
+}
+
+bool EphemFile::Eval (double mjd, double *ret) const
+{
+	if (!Covers (mjd)) return false;
+	long long idx = (long long)floor (mjd/hdr->seglen);
+	long long i = idx - hdr->firstseg;
+	if (i < 0 || i >= hdr->nseg) return false; // rounding at the range limits
+	EphemCache::EvalSegment (seg[i], hdr->order, 2.0*(mjd - idx*hdr->seglen)/hdr->seglen - 1.0, ret);
+	return true;
+}
+
+bool EphemFile::Write (const char *fname, const char *body, const EphemCache &cache,
+	double mjd0, double mjd1, uint32_t flags)
+{
+	double seglen = cache.SegmentLength();
+	long long i0 = (long long)floor (mjd0/seglen);
+	long long i1 = (long long)floor (mjd1/seglen);
+	if (i1 < i0) return false;
+
+	FILE *f = fopen (fname, "wb");
+	if (!f) return false;
+
+	EphemFileHeader h;
+	memset (&h, 0, sizeof(EphemFileHeader));
+	memcpy (h.magic, EPHEMFILE_MAGIC, 8);
+	h.version = EPHEMFILE_VERSION;
+	h.order = (uint32_t)cache.Order();
+	h.maxorder = EPHEMCACHE_MAXORDER;
+	h.flags = flags;
+	h.seglen = seglen;
+	h.firstseg = i0;
+	h.nseg = i1-i0+1;
+	strncpy (h.body, body, sizeof(h.body)-1);
+	bool ok = (fwrite (&h, sizeof(EphemFileHeader), 1, f) == 1);
+
+	EphemCache::Segment s;
+	for (long long i = i0; ok && i <= i1; i++) {
+		memset (&s, 0, sizeof(EphemCache::Segment));
+		cache.Fit (i, s);
+		ok = (fwrite (&s, sizeof(EphemCache::Segment), 1, f) == 1);
+	}
+	if (fclose (f)) ok = false;
+	if (!ok) remove (fname);
+	return ok;
+}
@@ -0,0 +1,73 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Precomputed ephemeris files
+// A binary container of Chebyshev segments (EphemCache::Segment) for one
+// body, covering a contiguous range of segments of fixed length. The file
+// is generated offline from the full perturbation series (Utils/ephemgen)
+// and memory-mapped at runtime, so that evaluating the ephemeris requires
+// neither parsing the series data files nor summing the series. Segment
+// lookup is a direct index computation.
+// This module has no dependencies on the Orbiter API.
+// =======================================================================
+
+#ifndef __EPHEMFILE_H
+#define __EPHEMFILE_H
+
+#include "EphemCache.h"
+#include <cstdint>
+
+struct EphemFileHeader {
+	char     magic[8];     // "ORBEPHM"
+	uint32_t version;      // file format version
+	uint32_t order;        // polynomial order of the segments
+	uint32_t maxorder;     // EPHEMCACHE_MAXORDER of the writer (segment record layout)
+	uint32_t flags;        // data format flags of the generating module (e.g. EPHEM_POLAR)
+	double   seglen;       // segment length [days]
+	int64_t  firstseg;     // index of the first segment; segment i covers MJD i*seglen to (i+1)*seglen
+	int64_t  nseg;         // number of segments
+	char     body[32];     // body name (informative)
+};
+// The header is followed by nseg EphemCache::Segment records.
+
+class EphemFile {
+public:
+	EphemFile ();
+	~EphemFile ();
+
+	bool Open (const char *fname);
+	// Map ephemeris file fname. Returns false if the file can't be opened,
+	// is not an ephemeris file or is inconsistent.
+
+	void Close ();
+
+	inline bool IsOpen () const { return hdr != 0; }
+
+	inline bool Covers (double mjd) const
+	{ return hdr && mjd >= mjd0 && mjd < mjd1; }
+	// True if the file contains the segment for time mjd
+
+	bool Eval (double mjd, double *ret) const;
+	// Position (ret[0..2]) and rate (ret[3..5]) at time mjd. Returns false
+	// (ret unchanged) if mjd is not covered by the file.
+
+	inline double StartMJD () const { return mjd0; }
+	inline double EndMJD () const { return mjd1; }
+	inline uint32_t Flags () const { return hdr ? hdr->flags : 0; }
+	inline const EphemFileHeader *Header () const { return hdr; }
+
+	static bool Write (const char *fname, const char *body, const EphemCache &cache,
+		double mjd0, double mjd1, uint32_t flags);
+	// Fit the segments of cache covering mjd0 to mjd1 and write them to
+	// file fname. The segment length and order are those of the cache.
+
+private:
+	const EphemFileHeader *hdr;        // start of the mapped view
+	const EphemCache::Segment *seg;    // segment records
+	double mjd0, mjd1;                 // time range covered
+	size_t size;                       // mapped file size
+	void *hFile, *hMap;                // Windows file and mapping handles
+};
+
+#endif // !__EPHEMFILE_H
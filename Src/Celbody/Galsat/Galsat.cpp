@@ -3,6 +3,8 @@
 
 #define ORBITER_MODULE
 #include "Galsat.h"
+#include "EphemCache.h"
+#include "EphemFile.h"
 
 #include <stdio.h> // temp
 
@@ -26,6 +28,14 @@ GALOBJ::GALOBJ (OBJHANDLE hObj): CELBODY2 (hObj)
 	for (int i = 0; i < 6; i++)
 		sp[0].param[i] = sp[1].param[i] = 0.0;
 	interval = 100.0;          // default sampling interval [s]
+	cache = 0;
+	ephfile = 0;
+}
+
+GALOBJ::~GALOBJ ()
+{
+	if (cache) delete cache;
+	if (ephfile) delete ephfile;
 }
 
 bool GALOBJ::bEphemeris () const
@@ -35,14 +45,16 @@ bool GALOBJ::bEphemeris () const
 
 int GALOBJ::clbkEphemeris (double mjd, int req, double *ret)
 {
-	GalEphem (ksat, mjd, ret);
+	if (!ephfile || !ephfile->Eval (mjd, ret))
+		GalEphem (ksat, mjd, ret);
 	for (int i = 0; i < 6; i++) ret[i+6] = ret[i];
 	return 0x1F;
 }
 
 int GALOBJ::clbkFastEphemeris (double simt, int req, double *ret)
 {
-	SampleEphem (ksat, simt, interval, ret, sp);
+	if (cache) cache->Eval (oapiTime2MJD (simt), ret);
+	else       SampleEphem (ksat, simt, interval, ret, sp);
 	for (int i = 0; i < 6; i++) ret[i+6] = ret[i];
 	return 0x1F;
 	
@@ -50,6 +62,18 @@ int GALOBJ::clbkFastEphemeris (double simt, int req, double *ret)
 
 void GALOBJ::clbkInit (FILEHANDLE cfg)
 {
+	// precomputed ephemeris, if available
+	static const char *satname[5] = {"Jupiter", "Io", "Europa", "Ganymede", "Callisto"};
+	char cbuf[256];
+	sprintf (cbuf, "Config\\%s\\Data\\Ephemeris.eph", satname[ksat]);
+	ephfile = new EphemFile;
+	if (ephfile->Open (cbuf)) {
+		oapiWriteLogV("GALSAT %s: Ephemeris file %s, MJD %0.0f-%0.0f", satname[ksat], cbuf, ephfile->StartMJD(), ephfile->EndMJD());
+	} else {
+		delete ephfile;
+		ephfile = 0;
+	}
+
 	// Initialise the sampling points
 	sp[0].t = 0;
 	sp[1].t = interval;
@@ -57,6 +81,11 @@ void GALOBJ::clbkInit (FILEHANDLE cfg)
 	GalEphem (ksat, oapiTime2MJD(sp[1].t), sp[1].param);
 	sp[0].rad = Radius (sp[0].param);
 	sp[1].rad = Radius (sp[1].param);	
+
+	// Chebyshev segments spanning 128 sampling intervals
+	int k = ksat;
+	cache = new EphemCache ([k](double mjd, double *ret) { GalEphem (k, mjd, ret); }, 128.0*interval/86400.0);
+	cache->SetFile (ephfile);
 }
 
 // ===========================================================
@@ -13,6 +13,9 @@
 #define GAL_GANYMEDE   3
 #define GAL_CALLISTO   4
 
+class EphemCache;
+class EphemFile;
+
 // ===========================================================
 // class GALOBJ
 // Base class for Galilean Jupiter moons controlled by
@@ -22,6 +25,7 @@
 class DLLEXPORT GALOBJ: public CELBODY2 {
 public:
 	GALOBJ (OBJHANDLE hObj);
+	~GALOBJ ();
 	bool bEphemeris() const;
 	int  clbkEphemeris (double mjd, int req, double *ret);
 	int  clbkFastEphemeris (double simt, int req, double *ret);
@@ -31,6 +35,8 @@ protected:
 	int ksat;        // object id
 	double interval; // sample interval
 	Sample sp[2];    // interpolation samples
+	EphemCache *cache; // Chebyshev segment cache for fast ephemeris
+	EphemFile *ephfile; // precomputed ephemeris file (0: not available)
 };
 
 // ===========================================================
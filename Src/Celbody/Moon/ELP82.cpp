@@ -1,8 +1,6 @@
 #include <math.h>
 #include <fstream>
 
-#include "OrbiterAPI.h"
-
 using namespace std;
 
 // #define INCLUDE_TIDAL_PERT
@@ -36,6 +34,7 @@ static const double precess = 5029.0966/rad;
 static       bool need_terms = true; // need to read terms?
 static const double def_prec = 1e-5; // default precision
 static       double cur_prec = -1.0; // current precision
+static       int cur_nused = 0, cur_ntotal = 0; // current number of used/available terms
 
 static double delnu, dele, delg, delnp, delep;
 static double p1, p2, p3, p4, p5, q1, q2, q3, q4, q5;
@@ -44,6 +43,8 @@ static int    nterm[3][12], nrang[3][12];    // current length of term sequences
 static SEQ6 *pc[3]  = {0,0,0};               // main term sequences
 static SEQ3 *per[3] = {0,0,0};               // perturbation term sequences
 
+int ELP82_read (double prec, int *nused = 0, int *ntotal = 0);
+
 // ===========================================================
 // ELP82_init ()
 // Set up invariant global parameters for ELP82 solver
@@ -153,9 +154,11 @@ void ELP82_exit ()
 // ELP82_read ()
 // Read the perturbation terms from file and store in global
 // parameters. The number of terms read depends on requested precision.
+// Returns -1 if the data file can't be opened. On success, nused and
+// ntotal receive the number of used and available terms.
 // ===========================================================
 
-int ELP82_read (double prec)
+int ELP82_read (double prec, int *nused, int *ntotal)
 {
 	// Term structure interfaces
 	typedef struct {
@@ -176,7 +179,11 @@ int ELP82_read (double prec)
 
 	// Check for existing terms
 	if (cur_prec >= 0.0) {
-		if (prec == cur_prec) return 0;   // nothing to do
+		if (prec == cur_prec) {           // nothing to do
+			if (nused) *nused = cur_nused;
+			if (ntotal) *ntotal = cur_ntotal;
+			return 0;
+		}
 		for (int i = 0; i < 3; i++) {
 			if (pc[i])  { delete []pc[i];  pc[i]  = 0; }  // remove existing terms
 			if (per[i]) { delete []per[i]; per[i] = 0; }
@@ -193,10 +200,7 @@ int ELP82_read (double prec)
 
 	const char *datf = "Config\\Moon\\Data\\ELP82.dat";
 	ifstream ifs (datf);  // term data stream
-	if (!ifs) {
-		oapiWriteLogError("ELP82: Data file not found: %s", datf);
-		return -1;
-	}
+	if (!ifs) return -1;
 
 	// Read terms for main problem
 	for (ific = 0; ific < 3; ific++) {
@@ -289,10 +293,12 @@ int ELP82_read (double prec)
 	// Add: PlanetaryPerturbations
 	// Add: FiguresTides
 
-	oapiWriteLogV("ELP82: Precision %0.1le, Terms %d/%d", prec, ntot, mtot);
-
 	need_terms = false;
 	cur_prec   = prec;
+	cur_nused  = ntot;
+	cur_ntotal = mtot;
+	if (nused) *nused = ntot;
+	if (ntotal) *ntotal = mtot;
 
 	return 0;
 }
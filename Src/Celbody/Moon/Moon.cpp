@@ -5,6 +5,8 @@
 
 #include "OrbiterAPI.h"
 #include "CelbodyAPI.h"
+#include "EphemCache.h"
+#include "EphemFile.h"
 
 // ===========================================================
 // Local prototypes
@@ -12,7 +14,7 @@
 
 void ELP82_init ();
 void ELP82_exit ();
-int  ELP82_read (double prec);
+int  ELP82_read (double prec, int *nused = 0, int *ntotal = 0);
 int  ELP82 (double mjd, double *r);
 void Interpolate (double t, double *data, const Sample *s0, const Sample *s1);
 inline double Radius (double *data)
@@ -26,14 +28,25 @@ inline double Radius (double *data)
 class Moon: public CELBODY2 {
 public:
 	Moon (OBJHANDLE hObj);
+	~Moon ();
 	void clbkInit (FILEHANDLE cfg);
 	bool bEphemeris () const { return true; }
 	int clbkEphemeris (double mjd, int req, double *ret);
 	int clbkFastEphemeris (double simt, int req, double *ret);
 
 private:
+	void Ephem (double mjd, double *ret);
+	// Evaluate the ephemeris file if it covers mjd, otherwise the ELP82
+	// series. The series are read on first use.
+
+	bool ReadTerms ();
+
 	double prec;      // tolerance limit
 	double interval;  // sampling interval for fast ephemeris calculation
+	double cacheseg;  // ephemeris cache segment length [days] (0: no cache)
+	EphemCache *cache;
+	EphemFile *ephfile; // precomputed ephemeris file (0: not available)
+	bool bTerms;      // ELP82 terms have been read
 	Sample sp[2];
 };
 
@@ -46,26 +59,70 @@ Moon::Moon (OBJHANDLE hObj): CELBODY2 (hObj)
 	prec = 1e-6;
 	interval = 71.0;     // sample interval [s] => interpolation error ~0.1m
 	sp[0].t = sp[1].t = -1e20; // invalidate
+	cacheseg = 0.5;
+	cache = 0;
+	ephfile = 0;
+	bTerms = false;
+}
+
+Moon::~Moon ()
+{
+	if (cache) delete cache;
+	if (ephfile) delete ephfile;
 }
 
 void Moon::clbkInit (FILEHANDLE cfg)
 {
 	oapiReadItem_float (cfg, (char*)"ErrorLimit", prec);
-	ELP82_read (prec);
+	oapiReadItem_float (cfg, (char*)"EphemCacheSegment", cacheseg);
+
+	const char *ephf = "Config\\Moon\\Data\\Ephemeris.eph";
+	ephfile = new EphemFile;
+	if (ephfile->Open (ephf)) {
+		oapiWriteLogV("ELP82: Ephemeris file %s, MJD %0.0f-%0.0f", ephf, ephfile->StartMJD(), ephfile->EndMJD());
+	} else {
+		delete ephfile;
+		ephfile = 0;
+		ReadTerms ();
+	}
+
 	CELBODY2::clbkInit (cfg);
+	if (cacheseg > 0.0) {
+		cache = new EphemCache ([this](double mjd, double *ret) { Ephem (mjd, ret); }, cacheseg);
+		cache->SetFile (ephfile);
+	}
 
 	// Initialise the sampling points
 	sp[0].t = 0;
 	sp[1].t = interval;
-	ELP82 (oapiTime2MJD(sp[0].t), sp[0].param);
-	ELP82 (oapiTime2MJD(sp[1].t), sp[1].param);
+	Ephem (oapiTime2MJD(sp[0].t), sp[0].param);
+	Ephem (oapiTime2MJD(sp[1].t), sp[1].param);
 	sp[0].rad = Radius (sp[0].param);
 	sp[1].rad = Radius (sp[1].param);	
 }
 
-int Moon::clbkEphemeris (double mjd, int req, double *ret)
+void Moon::Ephem (double mjd, double *ret)
 {
+	if (ephfile && ephfile->Eval (mjd, ret)) return;
+	if (!bTerms) ReadTerms ();
 	ELP82 (mjd, ret);
+}
+
+bool Moon::ReadTerms ()
+{
+	int nused, ntotal;
+	bTerms = true;
+	if (ELP82_read (prec, &nused, &ntotal) < 0) {
+		oapiWriteLogError("ELP82: Data file not found: Config\\Moon\\Data\\ELP82.dat");
+		return false;
+	}
+	oapiWriteLogV("ELP82: Precision %0.1le, Terms %d/%d", prec, nused, ntotal);
+	return true;
+}
+
+int Moon::clbkEphemeris (double mjd, int req, double *ret)
+{
+	Ephem (mjd, ret);
 	if (req & (EPHEM_BARYPOS | EPHEM_BARYVEL))
 		for (int i = 6; i < 12; i++) ret[i] = ret[i-6];
 	return req | (EPHEM_TRUEPOS | EPHEM_TRUEVEL | EPHEM_BARYISTRUE);
@@ -75,6 +132,13 @@ int Moon::clbkFastEphemeris (double simt, int req, double *ret)
 {
 	Sample *s0, *s1;
 	
+	if (cache) {
+		cache->Eval (oapiTime2MJD (simt), ret);
+		if (req & (EPHEM_BARYPOS | EPHEM_BARYVEL))
+			for (int i = 6; i < 12; i++) ret[i] = ret[i-6];
+		return req | (EPHEM_TRUEPOS | EPHEM_TRUEVEL | EPHEM_BARYISTRUE);
+	}
+
 	if (sp[0].t < sp[1].t) s0 = sp+0, s1 = sp+1;
 	else                   s0 = sp+1, s1 = sp+0;
 
@@ -83,27 +147,27 @@ int Moon::clbkFastEphemeris (double simt, int req, double *ret)
 	} else if (simt > s1->t) {
 		if (simt <= s1->t + interval) {
 			s0->t = s1->t + interval;
-			ELP82 (oapiTime2MJD (s0->t), s0->param);
+			Ephem (oapiTime2MJD (s0->t), s0->param);
 			s0->rad = Radius (s0->param);
 			Interpolate (simt, ret, s1, s0);
 		} else {
 			s0->t = simt;
-			ELP82 (oapiTime2MJD (s0->t), s0->param);
+			Ephem (oapiTime2MJD (s0->t), s0->param);
 			s0->rad = Radius (s0->param);
 			for (int i = 0; i < 6; i++) ret[i] = s0->param[i];
 		}
 	} else {
 		if (simt >= s0->t - interval) {
 			s1->t = s0->t - interval;
-			ELP82 (oapiTime2MJD (s1->t), s1->param);
+			Ephem (oapiTime2MJD (s1->t), s1->param);
 			s1->rad = Radius (s1->param);
 			Interpolate (simt, ret, s1, s0);
 		} else {
 			s1->t = simt;
-			ELP82 (oapiTime2MJD (s1->t), s1->param);
+			Ephem (oapiTime2MJD (s1->t), s1->param);
 			s1->rad = Radius (s1->param);
 			s0->t = simt + interval;
-			ELP82 (oapiTime2MJD (s0->t), s0->param);
+			Ephem (oapiTime2MJD (s0->t), s0->param);
 			s0->rad = Radius (s0->param);
 			for (int i = 0; i < 6; i++) ret[i] = s1->param[i];
 		}
@@ -3,6 +3,8 @@
 
 #define ORBITER_MODULE
 #include "Satsat.h"
+#include "EphemCache.h"
+#include "EphemFile.h"
 
 #include <stdio.h> // temp
 #define NSAT 8
@@ -26,6 +28,8 @@ static double pEphemT[NSAT];     // time of last full solution
 static double pEphemP[NSAT][6];  // last full solution
 static double pInterpT[NSAT];    // time of last interpolated solution
 static double pInterpP[NSAT][6]; // last interpolated solution
+static EphemCache *cache[NSAT];  // Chebyshev segment caches of the loaded moons
+static EphemFile *ephfile[NSAT]; // precomputed ephemeris files of the loaded moons
 
 // ===========================================================
 // class SATOBJ
@@ -40,10 +44,33 @@ SATOBJ::SATOBJ (OBJHANDLE hObj, int is, double dt): CELBODY2 (hObj)
 	sample[ksat][0].t = sample[ksat][1].t = -1e20; // invalidate
 	pInterpT[ksat] = -1;                           // invalidate
 
+	// precomputed ephemeris, if available
+	char cbuf[256];
+	sprintf (cbuf, "Config\\%s\\Data\\Ephemeris.eph", satname[ksat]);
+	ephfile[ksat] = new EphemFile;
+	if (ephfile[ksat]->Open (cbuf)) {
+		oapiWriteLogV("SATSAT %s: Ephemeris file %s, MJD %0.0f-%0.0f", satname[ksat], cbuf, ephfile[ksat]->StartMJD(), ephfile[ksat]->EndMJD());
+	} else {
+		delete ephfile[ksat];
+		ephfile[ksat] = 0;
+	}
+
+	// Chebyshev segments spanning 128 sampling intervals
+	cache[ksat] = new EphemCache ([is](double mjd, double *ret) { SatEphem (is, mjd, ret); }, 128.0*dt/86400.0);
+	cache[ksat]->SetFile (ephfile[ksat]);
+
 	// write some statistics to the orbiter log
 	oapiWriteLogV("SATSAT %s: Terms %d", satname[ksat], nterm(ksat));
 }
 
+SATOBJ::~SATOBJ ()
+{
+	delete cache[ksat];
+	cache[ksat] = 0;
+	delete ephfile[ksat];
+	ephfile[ksat] = 0;
+}
+
 bool SATOBJ::bEphemeris () const
 {
 	return true;
@@ -83,14 +110,19 @@ int SATOBJ::clbkFastEphemeris (double simt, int req, double *ret)
 // -----------------------------------------------------------
 // SatEphem:
 // Interface to TASS1.7 function posired. Maps results to Orbiter
-// coordinates and units
+// coordinates and units. Times covered by the ephemeris file
+// are evaluated from the file.
 // -----------------------------------------------------------
 
 void SatEphem (int ksat, double mjd, double *ret)
 {
 	int i;
 
-	if (mjd == pEphemT[ksat]) {
+	if (ephfile[ksat] && ephfile[ksat]->Eval (mjd, ret)) {
+
+		return;
+
+	} else if (mjd == pEphemT[ksat]) {
 
 		for (i = 0; i < 6; i++) ret[i] = pEphemP[ksat][i];
 
@@ -148,6 +180,12 @@ void SampleEphem (int ksat, double simt, double *ret)
 
 		for (i = 0; i < 6; i++) ret[i] = pInterpP[ksat][i];
 
+	} else if (cache[ksat]) {
+
+		cache[ksat]->Eval (oapiTime2MJD (simt), ret);
+		pInterpT[ksat] = simt;
+		for (i = 0; i < 6; i++) pInterpP[ksat][i] = ret[i];
+
 	} else {
 
 		Sample *s0, *s1;
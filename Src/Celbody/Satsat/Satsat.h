@@ -26,6 +26,7 @@
 class DLLEXPORT SATOBJ: public CELBODY2 {
 public:
 	SATOBJ (OBJHANDLE hObj, int is, double dt);
+	~SATOBJ ();
 	bool bEphemeris() const;
 	int  clbkEphemeris (double mjd, int req, double *ret);
 	int  clbkFastEphemeris (double simt, int req, double *ret);
@@ -10,6 +10,8 @@
 #include "EarthAtmNRLMSISE00.h"
 #include "nrlmsise-00.h"
 
+std::mutex EarthAtmosphere_NRLMSISE00::mtx;
+
 EarthAtmosphere_NRLMSISE00::EarthAtmosphere_NRLMSISE00 (CELBODY2 *body): ATMOSPHERE (body)
 {
 	pmjd = -1000000;  // invalidate
@@ -33,8 +35,10 @@ bool EarthAtmosphere_NRLMSISE00::clbkConstants (ATMCONST *atmc) const
 
 bool EarthAtmosphere_NRLMSISE00::clbkParams (const PRM_IN *prm_in, PRM_OUT *prm)
 {
-	static struct nrlmsise_output output = {0};
-	static struct nrlmsise_input input = {
+	// Model inputs and outputs are local, so that concurrent calls (e.g. from
+	// the atmosphere table and from vessels) don't overwrite each other.
+	struct nrlmsise_output output = {0};
+	struct nrlmsise_input input = {
 		0,    // year, currently ignored
 		172,  // day of year
 		29000,// second in day
@@ -47,7 +51,7 @@ bool EarthAtmosphere_NRLMSISE00::clbkParams (const PRM_IN *prm_in, PRM_OUT *prm)
 		3.0,  // magnetic index(daily)
 		NULL  // pointer to detailed magnetic values
 	};
-	static struct nrlmsise_flags flags = {0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1};
+	struct nrlmsise_flags flags = {0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1};
 
 	double mjd = oapiGetSimMJD();
 
@@ -55,6 +59,9 @@ bool EarthAtmosphere_NRLMSISE00::clbkParams (const PRM_IN *prm_in, PRM_OUT *prm)
 	double h, ijd;
 	h = 24.0 * modf (mjd, &ijd); // hour in the day
 	
+	// the model code keeps intermediate results in static variables
+	std::lock_guard<std::mutex> lock (mtx);
+
 	// day in year calculation
 	if ((int)mjd != pmjd) { // do this only when the day number changes
 		double c, e, mjd2;
@@ -91,7 +98,7 @@ bool EarthAtmosphere_NRLMSISE00::clbkParams (const PRM_IN *prm_in, PRM_OUT *prm)
 
 	gtd7 (&input, &flags, &output);
 	double n = output.d[0]+output.d[1]+output.d[2]+output.d[3]+output.d[4]+output.d[6]+output.d[7]; // total number density [1/cm^3]
-	static double k = 1.38066e-23*1e6; // Boltzmann constant and scale from cm^-3 to m^-3
+	const double k = 1.38066e-23*1e6; // Boltzmann constant and scale from cm^-3 to m^-3
 	prm->T = output.t[1];
 	prm->p = n*k*prm->T;
 	prm->rho = output.d[5]*1e3;
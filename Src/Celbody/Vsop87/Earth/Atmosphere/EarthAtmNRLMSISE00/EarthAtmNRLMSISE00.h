@@ -6,6 +6,7 @@
 
 #include "OrbiterAPI.h"
 #include "CelbodyAPI.h"
+#include <mutex>
 
 // ======================================================================
 // class EarthAtmosphere_NRLMSISE00
@@ -22,6 +23,7 @@ public:
 private:
 	int pmjd; // date of previous day-of-year calculation
 	int doy;  // current day-of-year value
+	static std::mutex mtx; // serialises model evaluations (shared by all instances)
 };
 
 #endif // !__EARTHATMNRLMSISE00
\ No newline at end of file
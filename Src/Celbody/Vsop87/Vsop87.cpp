@@ -2,7 +2,10 @@
 // Licensed under the MIT License
 
 #include "Vsop87.h"
+#include "EphemCache.h"
+#include "EphemFile.h"
 #include <stdio.h>
+#include <vector>
 
 #define DLLCLBK extern "C" __declspec(dllexport)
 
@@ -23,18 +26,22 @@ VSOPOBJ::VSOPOBJ (OBJHANDLE hCBody): CELBODY2 (hCBody)
 	a0 = 1.0;               // should be overwritten by derived class
 	double interval = 10.0; // default sampling interval
 	prec = 1e-6;            // default precision
-	termidx = 0;
-	termlen = 0;
-	term = 0;
+	cacheseg = 8.0;         // default cache segment length [days]
+	cache = 0;
+	ephfile = 0;
+	nalpha = 0;
+	series = 0;
+	name[0] = '\0';
+	simd = VsopSimdSupported();
 	sp[0].t = sp[1].t = -1e20; // invalidate
 	SetSeries ('B');        // default series: spherical, J2000
 }
 
 VSOPOBJ::~VSOPOBJ ()
 {
-	if (termidx) delete []termidx;
-	if (termlen) delete []termlen;
-	if (term) delete []term;
+	if (series) delete []series;
+	if (cache) delete cache;
+	if (ephfile) delete ephfile;
 }
 
 bool VSOPOBJ::bEphemeris () const
@@ -47,6 +54,10 @@ void VSOPOBJ::clbkInit (FILEHANDLE cfg)
 	CELBODY2::clbkInit (cfg);
 	oapiReadItem_float (cfg, (char*)"ErrorLimit", prec); // read custom precision from config file
 	oapiReadItem_float (cfg, (char*)"SamplingInterval", interval);
+	oapiReadItem_float (cfg, (char*)"EphemCacheSegment", cacheseg);
+	int level;
+	if (oapiReadItem_int (cfg, (char*)"SimdLevel", level)) // restrict summation kernel (0=scalar, 1=SSE2, 2=AVX2)
+		if (level >= 0 && level < simd) simd = (VsopSimdLevel)level;
 }
 
 void VSOPOBJ::SetSeries (char series)
@@ -57,11 +68,36 @@ void VSOPOBJ::SetSeries (char series)
 	if (sid == 'E')               fmtflag |= EPHEM_PARENTBARY;
 }
 
-bool VSOPOBJ::ReadData (const char *name)
+bool VSOPOBJ::ReadData (const char *_name)
 {
-	int nterm, cooidx, alpha, i, iused, nused = 0, ntot = 0;
-	double a, b, c, tfac, err;
-	TERM3 **ppterm, *pterm;
+	strncpy (name, _name, sizeof(name)-1);
+	name[sizeof(name)-1] = '\0';
+
+	char cbuf[256];
+	sprintf (cbuf, "Config\\%s\\Data\\Ephemeris.eph", name);
+	ephfile = new EphemFile;
+	if (ephfile->Open (cbuf)) {
+		if (ephfile->Flags() == (uint32_t)(fmtflag & EPHEM_POLAR)) {
+			oapiWriteLogV("VSOP87(%c) %s: Ephemeris file %s, MJD %0.0f-%0.0f", sid, name, cbuf, ephfile->StartMJD(), ephfile->EndMJD());
+		} else {
+			oapiWriteLogError("VSOP87 %s: Ephemeris file format mismatch: %s", name, cbuf);
+			ephfile->Close();
+		}
+	}
+	if (!ephfile->IsOpen()) {
+		delete ephfile;
+		ephfile = 0;
+		if (!LoadSeries()) return false;
+	}
+
+	Init();
+	return true;
+}
+
+bool VSOPOBJ::LoadSeries ()
+{
+	int nused, ntot;
+	std::vector<VsopSeries> s;
 
 	char cbuf[256];
 	sprintf (cbuf, "Config\\%s\\Data\\Vsop87%c.dat", name, sid);
@@ -70,53 +106,25 @@ bool VSOPOBJ::ReadData (const char *name)
 		oapiWriteLogError("VSOP87 %s: Data file not found: %s", name, cbuf);
 		return false;
 	}
-
-	ifs >> nalpha;
-
-	ppterm  = new TERM3*[(nalpha+1)*3];
-	termidx = new IDX3[nalpha+1];
-	termlen = new IDX3[nalpha+2];
-
-	for (cooidx = 0; cooidx < 3; cooidx++) {
-		tfac = 1.0;
-		for (alpha = 0; alpha <= nalpha; alpha++) {
-			ifs >> nterm;
-			pterm = ppterm[cooidx*(nalpha+1)+alpha] = new TERM3[nterm];
-			for (i = 0, iused = nterm; i < nterm; i++) {
-				ifs >> a >> b >> c;
-				if (iused == nterm) {
-					pterm[i][0] = a, pterm[i][1] = b, pterm[i][2] = c;
-					if (cooidx == 2) a /= a0; // radius in terms of mean SMa
-					err = 2.0*sqrt (i+1.0)*a*tfac;
-					if (err < prec) iused = i;
-				}
-			}
-			termlen[alpha][cooidx] = iused;
-			termidx[alpha][cooidx] = nused;
-			nused += iused;
-			ntot  += nterm;
-			tfac *= 5.0; // don't ask
-		}
-		termlen[alpha][cooidx] = 0;
-	}
-	// now copy everything into a single array
-	term = new TERM3[nused];
-	for (cooidx = 0; cooidx < 3; cooidx++) {
-		for (alpha = 0; alpha <= nalpha; alpha++) {
-			memcpy (term+termidx[alpha][cooidx], ppterm[cooidx*(nalpha+1)+alpha], termlen[alpha][cooidx]*sizeof(TERM3));
-			delete []ppterm[cooidx*(nalpha+1)+alpha];
-		}
+	if (!VsopReadSeries (ifs, prec, a0, s, nalpha, &nused, &ntot)) {
+		oapiWriteLogError("VSOP87 %s: Invalid data file: %s", name, cbuf);
+		return false;
 	}
-	delete []ppterm;
+	series = new VsopSeries[s.size()];
+	for (size_t i = 0; i < s.size(); i++)
+		series[i] = std::move (s[i]);
 
-	Init();
-
-	oapiWriteLogV("VSOP87(%c) %s: Precision %0.1le, Terms %d/%d", sid, name, prec, nused, ntot);
+	oapiWriteLogV("VSOP87(%c) %s: Precision %0.1le, Terms %d/%d, Kernel %s", sid, name, prec, nused, ntot, VsopSimdName (simd));
 	return true;
 }
 
 void VSOPOBJ::Init ()
 {
+	if (cacheseg > 0.0) {
+		if (cache) delete cache;
+		cache = new EphemCache ([this](double mjd, double *ret) { VsopEphem (mjd, ret); }, cacheseg);
+		cache->SetFile (ephfile);
+	}
 	sp[0].t = 0;
 	sp[1].t = interval;
 	VsopEphem (oapiTime2MJD(sp[0].t), sp[0].param);
@@ -137,67 +145,18 @@ void VSOPOBJ::Init ()
 //       ret[3] = velocity in longitude [rad/s]
 //       ret[4] = velocity in latitude  [rad/s]
 //       ret[5] = radial velocity [AU/s]
+//       Times covered by the ephemeris file are evaluated from
+//       the file; the series are only loaded for other times.
 // ===========================================================
 void VSOPOBJ::VsopEphem (double mjd, double *ret)
 {
-	static const double mjd2000 = 51544.5;  // MJD date of epoch J2000
-	static const double a1000   = 365250.0; // days per millenium
-	static const double rsec    = 1.0/(a1000*86400.0); // 1/seconds per millenium
-
-	static const double c0   = 299792458;     // speed of light [m/s]
-	static const double tauA = 499.004783806; // light time for 1 AU [s]
-	static const double AU   = c0*tauA;       // 1 AU in meters
-	static const double pscl = AU;            // convert AU -> m
-	static const double vscl = AU*rsec;       // convert AU/millenium -> m/s
-
-	TERM3 *pterm;
-
-	double a, b, c, arg, tm, termdot;
-	int i, cooidx, alpha;
-
-	// zero result array
-	for (i = 0; i < 6; i++) ret[i] = 0.0;
+	if (ephfile && ephfile->Eval (mjd, ret)) return;
 
-	// set time and powers
-	double t[VSOP_MAXALPHA+1];
-	t[0] = 1.0;
-	t[1] = (mjd-mjd2000)/a1000;
-	for (i = 2; i <= VSOP_MAXALPHA; ++i) t[i] = t[i-1] * t[1];
-
-	// term summation
-	for (cooidx = 0; cooidx < 3; ++cooidx) { // loop over spatial dimensions
-
-		for (alpha = 0; termlen[alpha][cooidx]; ++alpha) { // loop over powers of time
-
-			pterm = term+termidx[alpha][cooidx];
-			tm = termdot = 0.0;
-		    for (i = 0; i < termlen[alpha][cooidx]; ++i) {
-				a        = pterm[i][0];
-				b        = pterm[i][1];
-				c        = pterm[i][2];
-				arg      = b + c * t[1];
-				tm      += a * cos(arg);
-				termdot -= c * a * sin(arg);
-			}
-			ret[cooidx] += t[alpha] * tm;
-			ret[cooidx+3] += t[alpha] * termdot +
-				(alpha > 0 ? alpha * t[alpha - 1] * tm : 0.0);
-
-		} // end loop alpha
-	} // end loop cooidx
-
-	if (fmtflag & EPHEM_POLAR) {
-		// convert millenium rate to second rate
-		for (i = 3; i < 6; i++) ret[i] *= rsec;
-		// should also convert radius from AU to m
-	} else {
-		double tmp;
-		for (i = 0; i < 3; i++) ret[i] *= pscl;
-		for (     ; i < 6; i++) ret[i] *= vscl;
-		// swap y and z to map to orbiter system
-		tmp = ret[1]; ret[1] = ret[2]; ret[2] = tmp;
-		tmp = ret[4]; ret[4] = ret[5]; ret[5] = tmp;
+	if (!series && !LoadSeries()) {
+		for (int i = 0; i < 6; i++) ret[i] = 0.0;
+		return;
 	}
+	VsopEphemeris (series, nalpha, mjd, (fmtflag & EPHEM_POLAR) != 0, ret, simd);
 }
 
 // ===========================================================
@@ -212,9 +171,17 @@ void VSOPOBJ::VsopEphem (double mjd, double *ret)
 //       Mars:    1e-2
 //       Jupiter: 7e-3
 //       Saturn:  7e-3
+//       If the ephemeris cache is enabled (EphemCacheSegment > 0),
+//       Chebyshev segments are used instead, with fit errors at
+//       the rounding level of the full series.
 // ===========================================================
 void VSOPOBJ::VsopFastEphem (double simt, double *ret)
 {
+	if (cache) {
+		cache->Eval (oapiTime2MJD (simt), ret);
+		return;
+	}
+
 	Sample *s0, *s1;
 	
 	if (sp[0].t < sp[1].t) s0 = sp+0, s1 = sp+1;
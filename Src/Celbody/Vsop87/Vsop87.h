@@ -6,11 +6,10 @@
 
 #include "OrbiterAPI.h"
 #include "CelbodyAPI.h"
+#include "Vsop87Kernel.h"
 
-#define VSOP_MAXALPHA 5		// max power of time
-
-typedef int IDX3[3];
-typedef double TERM3[3];
+class EphemCache;
+class EphemFile;
 
 // ===========================================================
 // class VSOPOBJ
@@ -29,7 +28,12 @@ protected:
 	// Set VSOP series ('A' to 'E')
 
 	bool ReadData (const char *name);
-	// Read perturbation terms up to required accuracy from data file
+	// Open the precomputed ephemeris file for the planet, if available.
+	// Otherwise read perturbation terms up to required accuracy from data file
+
+	bool LoadSeries ();
+	// Read perturbation terms from the data file. Called on demand by
+	// VsopEphem for times not covered by the ephemeris file.
 
 	void Init ();
 
@@ -37,22 +41,26 @@ protected:
 	// Calculate ephemerides
 
 	void VsopFastEphem (double simt, double *ret);
-	// Interpolated sequential ephemerides
+	// Interpolated sequential ephemerides. Uses the Chebyshev segment
+	// cache if enabled, otherwise linear interpolation between samples.
 
 	double a0;       // semi-major axis [AU]
 	double prec;     // tolerance limit (1e-3 .. 1e-8)
 	double interval; // sample interval for fast ephemeris [s]
+	double cacheseg; // ephemeris cache segment length [days] (0: no cache)
+	EphemCache *cache; // Chebyshev segment cache for fast ephemeris
+	EphemFile *ephfile; // precomputed ephemeris file (0: not available)
 	int fmtflag;     // data format flag
 	int nalpha;      // order of time polynomials
-	IDX3 *termidx;   // term index list
-	IDX3 *termlen;   // term list lengths
-	TERM3 *term;     // term list
+	VsopSeries *series;  // term lists in kernel layout, [cooidx*(nalpha+1)+alpha]
+	VsopSimdLevel simd;  // term summation kernel
 	Sample sp[2];
 
 private:
 	void Interpolate (double t, double *data, const Sample *s0, const Sample *s1);
 
 	char sid;
+	char name[32];  // planet name (data file directory)
 	int datatp;  // return data type: true pos or barycentric
 };
 
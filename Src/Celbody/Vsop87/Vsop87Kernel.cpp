@@ -0,0 +1,295 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+#include "Vsop87Kernel.h"
+#include <math.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define VSOP_X86
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// ===========================================================
+// struct VsopSeries
+// ===========================================================
+
+void VsopSeries::Set (const double (*term)[3], int nterm)
+{
+	int i, nbuf = (nterm + VSOP_SIMD_WIDTH-1) / VSOP_SIMD_WIDTH * VSOP_SIMD_WIDTH;
+	n = nterm;
+	A.assign (nbuf, 0.0);
+	B.assign (nbuf, 0.0);
+	C.assign (nbuf, 0.0);
+	for (i = 0; i < nterm; i++) {
+		A[i] = term[i][0];
+		B[i] = term[i][1];
+		C[i] = term[i][2];
+	}
+}
+
+// ===========================================================
+// Scalar reference kernel and dispatch
+// ===========================================================
+
+static void VsopSumScalar (const VsopSeries &s, double t, double &sum, double &dsum)
+{
+	const double *A = s.A.data(), *B = s.B.data(), *C = s.C.data();
+	double arg, tm = 0.0, termdot = 0.0;
+	for (int i = 0; i < s.n; i++) {
+		arg      = B[i] + C[i] * t;
+		tm      += A[i] * cos(arg);
+		termdot -= C[i] * A[i] * sin(arg);
+	}
+	sum = tm;
+	dsum = termdot;
+}
+
+void VsopSum (const VsopSeries &s, double t, double &sum, double &dsum, VsopSimdLevel level)
+{
+	switch (level) {
+	case VSOP_SIMD_AVX2: VsopSumAVX2 (s, t, sum, dsum); break;
+	case VSOP_SIMD_SSE2: VsopSumSSE2 (s, t, sum, dsum); break;
+	default:             VsopSumScalar (s, t, sum, dsum); break;
+	}
+}
+
+// ===========================================================
+// Complete VSOP87 solutions
+// ===========================================================
+
+bool VsopReadSeries (std::istream &is, double prec, double a0, std::vector<VsopSeries> &series,
+	int &nalpha, int *nused, int *ntot)
+{
+	int nterm, cooidx, alpha, i, iused, nu = 0, nt = 0;
+	double tfac, err, a;
+	std::vector<double> term;
+
+	is >> nalpha;
+	if (!is.good() || nalpha < 0 || nalpha > VSOP_MAXALPHA) return false;
+	series.assign ((nalpha+1)*3, VsopSeries());
+
+	for (cooidx = 0; cooidx < 3; cooidx++) {
+		tfac = 1.0;
+		for (alpha = 0; alpha <= nalpha; alpha++) {
+			is >> nterm;
+			if (!is.good() || nterm < 0) return false;
+			term.resize (nterm*3);
+			for (i = 0, iused = nterm; i < nterm; i++) {
+				is >> term[i*3] >> term[i*3+1] >> term[i*3+2];
+				if (iused == nterm) {
+					a = term[i*3];
+					if (cooidx == 2) a /= a0; // radius in terms of mean SMa
+					err = 2.0*sqrt (i+1.0)*a*tfac;
+					if (err < prec) iused = i;
+				}
+			}
+			series[cooidx*(nalpha+1)+alpha].Set ((const double(*)[3])term.data(), iused);
+			nu += iused;
+			nt += nterm;
+			tfac *= 5.0; // don't ask
+		}
+	}
+	if (nused) *nused = nu;
+	if (ntot) *ntot = nt;
+	return !is.fail();
+}
+
+void VsopEphemeris (const VsopSeries *series, int nalpha, double mjd, bool polar, double *ret, VsopSimdLevel level)
+{
+	static const double mjd2000 = 51544.5;  // MJD date of epoch J2000
+	static const double a1000   = 365250.0; // days per millenium
+	static const double rsec    = 1.0/(a1000*86400.0); // 1/seconds per millenium
+
+	static const double c0   = 299792458;     // speed of light [m/s]
+	static const double tauA = 499.004783806; // light time for 1 AU [s]
+	static const double AU   = c0*tauA;       // 1 AU in meters
+	static const double pscl = AU;            // convert AU -> m
+	static const double vscl = AU*rsec;       // convert AU/millenium -> m/s
+
+	double tm, termdot;
+	int i, cooidx, alpha;
+
+	// zero result array
+	for (i = 0; i < 6; i++) ret[i] = 0.0;
+
+	// set time and powers
+	double t[VSOP_MAXALPHA+1];
+	t[0] = 1.0;
+	t[1] = (mjd-mjd2000)/a1000;
+	for (i = 2; i <= VSOP_MAXALPHA; ++i) t[i] = t[i-1] * t[1];
+
+	// term summation
+	for (cooidx = 0; cooidx < 3; ++cooidx) { // loop over spatial dimensions
+
+		for (alpha = 0; alpha <= nalpha && series[cooidx*(nalpha+1)+alpha].n; ++alpha) { // loop over powers of time
+
+			VsopSum (series[cooidx*(nalpha+1)+alpha], t[1], tm, termdot, level);
+			ret[cooidx] += t[alpha] * tm;
+			ret[cooidx+3] += t[alpha] * termdot +
+				(alpha > 0 ? alpha * t[alpha - 1] * tm : 0.0);
+
+		} // end loop alpha
+	} // end loop cooidx
+
+	if (polar) {
+		// convert millenium rate to second rate
+		for (i = 3; i < 6; i++) ret[i] *= rsec;
+		// should also convert radius from AU to m
+	} else {
+		double tmp;
+		for (i = 0; i < 3; i++) ret[i] *= pscl;
+		for (     ; i < 6; i++) ret[i] *= vscl;
+		// swap y and z to map to orbiter system
+		tmp = ret[1]; ret[1] = ret[2]; ret[2] = tmp;
+		tmp = ret[4]; ret[4] = ret[5]; ret[5] = tmp;
+	}
+}
+
+const char *VsopSimdName (VsopSimdLevel level)
+{
+	static const char *name[3] = {"scalar", "SSE2", "AVX2"};
+	return name[level];
+}
+
+#ifdef VSOP_X86
+
+static void Cpuid (int leaf, int subleaf, unsigned int reg[4])
+{
+#ifdef _MSC_VER
+	__cpuidex ((int*)reg, leaf, subleaf);
+#else
+	__cpuid_count (leaf, subleaf, reg[0], reg[1], reg[2], reg[3]);
+#endif
+}
+
+static unsigned long long Xgetbv (unsigned int idx)
+{
+#ifdef _MSC_VER
+	return _xgetbv (idx);
+#else
+	unsigned int eax, edx;
+	__asm__ volatile ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(idx));
+	return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+
+VsopSimdLevel VsopSimdSupported ()
+{
+	unsigned int reg[4];
+	Cpuid (0, 0, reg);
+	int maxleaf = (int)reg[0];
+	if (maxleaf < 1) return VSOP_SIMD_SCALAR;
+	Cpuid (1, 0, reg);
+	if (!(reg[3] & (1u << 26))) return VSOP_SIMD_SCALAR; // no SSE2
+	bool osxsave = (reg[2] & (1u << 27)) != 0;
+	bool avx     = (reg[2] & (1u << 28)) != 0;
+	if (maxleaf < 7 || !osxsave || !avx) return VSOP_SIMD_SSE2;
+	if ((Xgetbv (0) & 6) != 6) return VSOP_SIMD_SSE2;    // OS doesn't save YMM registers
+	Cpuid (7, 0, reg);
+	if (!(reg[1] & (1u << 5))) return VSOP_SIMD_SSE2;    // no AVX2
+	return VSOP_SIMD_AVX2;
+}
+
+// ===========================================================
+// SSE2 kernel
+// sin and cos are evaluated together: the argument is reduced to
+// |r| <= pi/4 with a three-part Cody-Waite subtraction of the nearest
+// multiple j of pi/2, followed by minimax polynomials for sin(r) and
+// cos(r). The quadrant j mod 4 selects and negates the results.
+// ===========================================================
+
+static const double TWO_OVER_PI = 6.36619772367581382433e-01;
+static const double PIO2_1  = 1.57079632673412561417e+00; // first 33 bits of pi/2
+static const double PIO2_2  = 6.07710050630396597660e-11; // next 33 bits of pi/2
+static const double PIO2_2T = 2.02226624879595063154e-21; // pi/2 - (PIO2_1 + PIO2_2)
+static const double ROUND_MAGIC = 6755399441055744.0;     // 1.5*2^52: round to nearest integer
+
+static const double S1 = -1.66666666666666324348e-01; // sin polynomial coefficients
+static const double S2 =  8.33333333332248946124e-03;
+static const double S3 = -1.98412698298579493134e-04;
+static const double S4 =  2.75573137070700676789e-06;
+static const double S5 = -2.50507602534068634195e-08;
+static const double S6 =  1.58969099521155010221e-10;
+static const double C1 =  4.16666666666666019037e-02; // cos polynomial coefficients
+static const double C2 = -1.38888888888741095749e-03;
+static const double C3 =  2.48015872894767294178e-05;
+static const double C4 = -2.75573143513906633035e-07;
+static const double C5 =  2.08757232129817482790e-09;
+static const double C6 = -1.13596475577881948265e-11;
+
+static inline void SinCos (__m128d x, __m128d &sinx, __m128d &cosx)
+{
+	const __m128i one = _mm_set1_epi64x (1), two = _mm_set1_epi64x (2);
+
+	// range reduction. The low mantissa bits of jm contain j.
+	__m128d jm = _mm_add_pd (_mm_mul_pd (x, _mm_set1_pd (TWO_OVER_PI)), _mm_set1_pd (ROUND_MAGIC));
+	__m128d j  = _mm_sub_pd (jm, _mm_set1_pd (ROUND_MAGIC));
+	__m128i q  = _mm_castpd_si128 (jm);
+	__m128d r  = _mm_sub_pd (x, _mm_mul_pd (j, _mm_set1_pd (PIO2_1)));
+	r = _mm_sub_pd (r, _mm_mul_pd (j, _mm_set1_pd (PIO2_2)));
+	r = _mm_sub_pd (r, _mm_mul_pd (j, _mm_set1_pd (PIO2_2T)));
+
+	// polynomials
+	__m128d z = _mm_mul_pd (r, r);
+	__m128d ps = _mm_set1_pd (S6);
+	ps = _mm_add_pd (_mm_mul_pd (ps, z), _mm_set1_pd (S5));
+	ps = _mm_add_pd (_mm_mul_pd (ps, z), _mm_set1_pd (S4));
+	ps = _mm_add_pd (_mm_mul_pd (ps, z), _mm_set1_pd (S3));
+	ps = _mm_add_pd (_mm_mul_pd (ps, z), _mm_set1_pd (S2));
+	ps = _mm_add_pd (_mm_mul_pd (ps, z), _mm_set1_pd (S1));
+	ps = _mm_add_pd (r, _mm_mul_pd (_mm_mul_pd (r, z), ps));
+	__m128d pc = _mm_set1_pd (C6);
+	pc = _mm_add_pd (_mm_mul_pd (pc, z), _mm_set1_pd (C5));
+	pc = _mm_add_pd (_mm_mul_pd (pc, z), _mm_set1_pd (C4));
+	pc = _mm_add_pd (_mm_mul_pd (pc, z), _mm_set1_pd (C3));
+	pc = _mm_add_pd (_mm_mul_pd (pc, z), _mm_set1_pd (C2));
+	pc = _mm_add_pd (_mm_mul_pd (pc, z), _mm_set1_pd (C1));
+	pc = _mm_add_pd (_mm_sub_pd (_mm_set1_pd (1.0), _mm_mul_pd (_mm_set1_pd (0.5), z)), _mm_mul_pd (_mm_mul_pd (z, z), pc));
+
+	// quadrant: swap sin and cos for odd j, negate sin for j mod 4 = 2,3 and cos for j mod 4 = 1,2
+	__m128d swap = _mm_castsi128_pd (_mm_sub_epi64 (_mm_setzero_si128(), _mm_and_si128 (q, one)));
+	__m128d ssgn = _mm_castsi128_pd (_mm_slli_epi64 (_mm_and_si128 (q, two), 62));
+	__m128d csgn = _mm_castsi128_pd (_mm_slli_epi64 (_mm_and_si128 (_mm_add_epi64 (q, one), two), 62));
+	sinx = _mm_xor_pd (_mm_or_pd (_mm_and_pd (swap, pc), _mm_andnot_pd (swap, ps)), ssgn);
+	cosx = _mm_xor_pd (_mm_or_pd (_mm_and_pd (swap, ps), _mm_andnot_pd (swap, pc)), csgn);
+}
+
+void VsopSumSSE2 (const VsopSeries &s, double t, double &sum, double &dsum)
+{
+	const double *A = s.A.data(), *B = s.B.data(), *C = s.C.data();
+	const int n = (int)s.A.size();
+	__m128d vt = _mm_set1_pd (t);
+	__m128d tm = _mm_setzero_pd(), termdot = _mm_setzero_pd();
+	__m128d a, c, sinx, cosx;
+	for (int i = 0; i < n; i += 2) {
+		a = _mm_loadu_pd (A+i);
+		c = _mm_loadu_pd (C+i);
+		SinCos (_mm_add_pd (_mm_loadu_pd (B+i), _mm_mul_pd (c, vt)), sinx, cosx);
+		tm      = _mm_add_pd (tm, _mm_mul_pd (a, cosx));
+		termdot = _mm_sub_pd (termdot, _mm_mul_pd (_mm_mul_pd (c, a), sinx));
+	}
+	double res[2];
+	_mm_storeu_pd (res, tm);
+	sum = res[0] + res[1];
+	_mm_storeu_pd (res, termdot);
+	dsum = res[0] + res[1];
+}
+
+#else // !VSOP_X86
+
+VsopSimdLevel VsopSimdSupported ()
+{
+	return VSOP_SIMD_SCALAR;
+}
+
+void VsopSumSSE2 (const VsopSeries &s, double t, double &sum, double &dsum)
+{
+	VsopSumScalar (s, t, sum, dsum);
+}
+
+#endif // VSOP_X86
@@ -0,0 +1,75 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// VSOP87 term summation kernels
+// Evaluates the series sum(A cos(B + C t)) and its time derivative for
+// one coordinate and power of time. The coefficients are stored as
+// structure-of-arrays, so that packed SIMD implementations (SSE2, AVX2)
+// can evaluate several terms per instruction. The implementation is
+// selected at runtime from the instruction sets supported by the CPU.
+// This module has no dependencies on the rest of Orbiter.
+// =======================================================================
+
+#ifndef __VSOP87KERNEL_H
+#define __VSOP87KERNEL_H
+
+#include <istream>
+#include <vector>
+
+enum VsopSimdLevel {
+	VSOP_SIMD_SCALAR,  // reference implementation (C library sin/cos)
+	VSOP_SIMD_SSE2,    // 2 terms per instruction
+	VSOP_SIMD_AVX2     // 4 terms per instruction
+};
+
+// =======================================================================
+// Coefficients of one term series. The lists are padded with zero terms
+// to a multiple of VSOP_SIMD_WIDTH, so that kernels need no tail loop.
+
+#define VSOP_SIMD_WIDTH 4
+#define VSOP_MAXALPHA 5		// max power of time
+
+struct VsopSeries {
+	std::vector<double> A, B, C; // amplitude, phase, frequency
+	int n;                       // number of terms (excluding padding)
+
+	VsopSeries (): n(0) {}
+	void Set (const double (*term)[3], int nterm);
+	// Copy nterm (A,B,C) triples into the series
+};
+
+// =======================================================================
+
+void VsopSum (const VsopSeries &s, double t, double &sum, double &dsum, VsopSimdLevel level);
+// Evaluate sum = sum_i A_i cos(B_i + C_i t) and its derivative with
+// respect to t, dsum = -sum_i C_i A_i sin(B_i + C_i t).
+// The packed kernels use a polynomial sin/cos approximation with a
+// relative error below 1e-15 for |B + C t| < 1e6.
+
+VsopSimdLevel VsopSimdSupported ();
+// Highest kernel level supported by the CPU and operating system
+
+const char *VsopSimdName (VsopSimdLevel level);
+
+// =======================================================================
+// Complete VSOP87 solutions
+
+bool VsopReadSeries (std::istream &is, double prec, double a0, std::vector<VsopSeries> &series,
+	int &nalpha, int *nused = 0, int *ntot = 0);
+// Read the terms of a VSOP87 data file, truncated to tolerance prec.
+// a0 is the semi-major axis [AU], used to scale radius errors.
+// series receives 3*(nalpha+1) term series, indexed [cooidx*(nalpha+1)+alpha].
+// nused and ntot receive the number of used and available terms.
+
+void VsopEphemeris (const VsopSeries *series, int nalpha, double mjd, bool polar, double *ret, VsopSimdLevel level);
+// Evaluate the series at time mjd. For polar (spherical) series, ret
+// receives longitude, latitude [rad], radius [AU] and their rates per
+// second. Otherwise ret receives position [m] and velocity [m/s] with
+// y and z swapped to conform to the Orbiter frame.
+
+// Packed kernels (Vsop87Kernel.cpp, Vsop87KernelAvx2.cpp)
+void VsopSumSSE2 (const VsopSeries &s, double t, double &sum, double &dsum);
+void VsopSumAVX2 (const VsopSeries &s, double t, double &sum, double &dsum);
+
+#endif // !__VSOP87KERNEL_H
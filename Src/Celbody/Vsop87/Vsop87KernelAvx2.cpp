@@ -0,0 +1,97 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// AVX2 version of the VSOP87 term summation kernel. This file is compiled
+// with AVX2 code generation enabled, and is only called if the CPU
+// supports it (see VsopSimdSupported). The algorithm is identical to the
+// SSE2 kernel in Vsop87Kernel.cpp.
+
+#include "Vsop87Kernel.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+static const double TWO_OVER_PI = 6.36619772367581382433e-01;
+static const double PIO2_1  = 1.57079632673412561417e+00;
+static const double PIO2_2  = 6.07710050630396597660e-11;
+static const double PIO2_2T = 2.02226624879595063154e-21;
+static const double ROUND_MAGIC = 6755399441055744.0;
+
+static const double S1 = -1.66666666666666324348e-01;
+static const double S2 =  8.33333333332248946124e-03;
+static const double S3 = -1.98412698298579493134e-04;
+static const double S4 =  2.75573137070700676789e-06;
+static const double S5 = -2.50507602534068634195e-08;
+static const double S6 =  1.58969099521155010221e-10;
+static const double C1 =  4.16666666666666019037e-02;
+static const double C2 = -1.38888888888741095749e-03;
+static const double C3 =  2.48015872894767294178e-05;
+static const double C4 = -2.75573143513906633035e-07;
+static const double C5 =  2.08757232129817482790e-09;
+static const double C6 = -1.13596475577881948265e-11;
+
+static inline void SinCos (__m256d x, __m256d &sinx, __m256d &cosx)
+{
+	const __m256i one = _mm256_set1_epi64x (1), two = _mm256_set1_epi64x (2);
+
+	__m256d jm = _mm256_add_pd (_mm256_mul_pd (x, _mm256_set1_pd (TWO_OVER_PI)), _mm256_set1_pd (ROUND_MAGIC));
+	__m256d j  = _mm256_sub_pd (jm, _mm256_set1_pd (ROUND_MAGIC));
+	__m256i q  = _mm256_castpd_si256 (jm);
+	__m256d r  = _mm256_sub_pd (x, _mm256_mul_pd (j, _mm256_set1_pd (PIO2_1)));
+	r = _mm256_sub_pd (r, _mm256_mul_pd (j, _mm256_set1_pd (PIO2_2)));
+	r = _mm256_sub_pd (r, _mm256_mul_pd (j, _mm256_set1_pd (PIO2_2T)));
+
+	__m256d z = _mm256_mul_pd (r, r);
+	__m256d ps = _mm256_set1_pd (S6);
+	ps = _mm256_add_pd (_mm256_mul_pd (ps, z), _mm256_set1_pd (S5));
+	ps = _mm256_add_pd (_mm256_mul_pd (ps, z), _mm256_set1_pd (S4));
+	ps = _mm256_add_pd (_mm256_mul_pd (ps, z), _mm256_set1_pd (S3));
+	ps = _mm256_add_pd (_mm256_mul_pd (ps, z), _mm256_set1_pd (S2));
+	ps = _mm256_add_pd (_mm256_mul_pd (ps, z), _mm256_set1_pd (S1));
+	ps = _mm256_add_pd (r, _mm256_mul_pd (_mm256_mul_pd (r, z), ps));
+	__m256d pc = _mm256_set1_pd (C6);
+	pc = _mm256_add_pd (_mm256_mul_pd (pc, z), _mm256_set1_pd (C5));
+	pc = _mm256_add_pd (_mm256_mul_pd (pc, z), _mm256_set1_pd (C4));
+	pc = _mm256_add_pd (_mm256_mul_pd (pc, z), _mm256_set1_pd (C3));
+	pc = _mm256_add_pd (_mm256_mul_pd (pc, z), _mm256_set1_pd (C2));
+	pc = _mm256_add_pd (_mm256_mul_pd (pc, z), _mm256_set1_pd (C1));
+	pc = _mm256_add_pd (_mm256_sub_pd (_mm256_set1_pd (1.0), _mm256_mul_pd (_mm256_set1_pd (0.5), z)), _mm256_mul_pd (_mm256_mul_pd (z, z), pc));
+
+	__m256d swap = _mm256_castsi256_pd (_mm256_sub_epi64 (_mm256_setzero_si256(), _mm256_and_si256 (q, one)));
+	__m256d ssgn = _mm256_castsi256_pd (_mm256_slli_epi64 (_mm256_and_si256 (q, two), 62));
+	__m256d csgn = _mm256_castsi256_pd (_mm256_slli_epi64 (_mm256_and_si256 (_mm256_add_epi64 (q, one), two), 62));
+	sinx = _mm256_xor_pd (_mm256_blendv_pd (ps, pc, swap), ssgn);
+	cosx = _mm256_xor_pd (_mm256_blendv_pd (pc, ps, swap), csgn);
+}
+
+void VsopSumAVX2 (const VsopSeries &s, double t, double &sum, double &dsum)
+{
+	const double *A = s.A.data(), *B = s.B.data(), *C = s.C.data();
+	const int n = (int)s.A.size();
+	__m256d vt = _mm256_set1_pd (t);
+	__m256d tm = _mm256_setzero_pd(), termdot = _mm256_setzero_pd();
+	__m256d a, c, sinx, cosx;
+	for (int i = 0; i < n; i += 4) {
+		a = _mm256_loadu_pd (A+i);
+		c = _mm256_loadu_pd (C+i);
+		SinCos (_mm256_add_pd (_mm256_loadu_pd (B+i), _mm256_mul_pd (c, vt)), sinx, cosx);
+		tm      = _mm256_add_pd (tm, _mm256_mul_pd (a, cosx));
+		termdot = _mm256_sub_pd (termdot, _mm256_mul_pd (_mm256_mul_pd (c, a), sinx));
+	}
+	double res[4];
+	_mm256_storeu_pd (res, tm);
+	sum = (res[0] + res[1]) + (res[2] + res[3]);
+	_mm256_storeu_pd (res, termdot);
+	dsum = (res[0] + res[1]) + (res[2] + res[3]);
+	_mm256_zeroupper();
+}
+
+#else
+
+void VsopSumAVX2 (const VsopSeries &s, double t, double &sum, double &dsum)
+{
+	VsopSumSSE2 (s, t, sum, dsum);
+}
+
+#endif
@@ -1,5 +1,21 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
 #include "ZTreeMgr.h"
 #include "zlib.h"
+#include <string.h>
+
+// Read size bytes at file offset ofs, independent of the file pointer.
+// Can be called concurrently on the same handle.
+static bool ReadAt (HANDLE hFile, __int64 ofs, void *buf, DWORD size)
+{
+	OVERLAPPED ov;
+	memset (&ov, 0, sizeof(OVERLAPPED));
+	ov.Offset = (DWORD)(ofs & 0xFFFFFFFF);
+	ov.OffsetHigh = (DWORD)(ofs >> 32);
+	DWORD nread;
+	return ReadFile (hFile, buf, size, &nread, &ov) && nread == size;
+}
 
 // =======================================================================
 // File header for compressed tree files
@@ -27,22 +43,22 @@ size_t TreeFileHeader::fwrite(FILE *f)
 
 // -----------------------------------------------------------------------
 
-bool TreeFileHeader::fread(FILE *f)
+bool TreeFileHeader::read(const BYTE *data, size_t ndata)
 {
-	BYTE buf[4];
-	DWORD sz, flags;
-	if (::fread(buf, 1, 4, f) < 4 || memcmp(buf, magic, 4))
+	DWORD sz;
+	if (ndata < sizeof(TreeFileHeader) || memcmp(data, magic, 4))
 		return false;
-	if (::fread(&sz, sizeof(DWORD), 1, f) != 1 || sz != size)
+	memcpy(&sz, data+4, sizeof(DWORD));
+	if (sz != size)
 		return false;
-	::fread(&flags, sizeof(DWORD), 1, f);
-	::fread(&dataOfs, sizeof(DWORD), 1, f);
-	::fread(&dataLength, sizeof(__int64), 1, f);
-	::fread(&nodeCount, sizeof(DWORD), 1, f);
-	::fread(&rootPos1, sizeof(DWORD), 1, f);
-	::fread(&rootPos2, sizeof(DWORD), 1, f);
-	::fread(&rootPos3, sizeof(DWORD), 1, f);
-	::fread(rootPos4, sizeof(DWORD), 2, f);
+	memcpy(&flags, data+8, sizeof(DWORD));
+	memcpy(&dataOfs, data+12, sizeof(DWORD));
+	memcpy(&dataLength, data+16, sizeof(__int64));
+	memcpy(&nodeCount, data+24, sizeof(DWORD));
+	memcpy(&rootPos1, data+28, sizeof(DWORD));
+	memcpy(&rootPos2, data+32, sizeof(DWORD));
+	memcpy(&rootPos3, data+36, sizeof(DWORD));
+	memcpy(rootPos4, data+40, 2*sizeof(DWORD));
 	return true;
 }
 
@@ -51,33 +67,11 @@ bool TreeFileHeader::fread(FILE *f)
 
 TreeTOC::TreeTOC()
 {
-	ntree = 0;
-	ntreebuf = 0;
 	tree = NULL;
+	ntree = 0;
 	totlength = 0;
 }
 
-// -----------------------------------------------------------------------
-
-TreeTOC::~TreeTOC()
-{
-	if (ntreebuf)
-		delete []tree;
-}
-
-// -----------------------------------------------------------------------
-
-size_t TreeTOC::fread(DWORD size, FILE *f)
-{
-	if (ntreebuf != size) {
-		TreeNode *tmp = new TreeNode[size];
-		if (ntreebuf) delete []tree;
-		tree = tmp;
-		ntree = ntreebuf = size;
-	}
-	return ::fread(tree, sizeof(TreeNode), size, f);
-}
-
 // =======================================================================
 // ZTreeMgr class: manage a single layer tree for a planet
 
@@ -98,7 +92,10 @@ ZTreeMgr::ZTreeMgr(const char *PlanetPath, Layer _layer)
 	path = new char[strlen(PlanetPath)+1];
 	strcpy(path, PlanetPath);
 	layer = _layer;
-	treef = 0;
+	view = 0;
+	hFile = INVALID_HANDLE_VALUE;
+	hMap = NULL;
+	fsize = 0;
 	OpenArchive();
 }
 
@@ -106,8 +103,9 @@ ZTreeMgr::ZTreeMgr(const char *PlanetPath, Layer _layer)
 
 ZTreeMgr::~ZTreeMgr()
 {
+	CloseArchive();
 	delete []path;
-	if (treef) fclose(treef);
+	path = NULL;
 }
 
 // -----------------------------------------------------------------------
@@ -117,13 +115,30 @@ bool ZTreeMgr::OpenArchive()
 	const char *name[6] = { "Surf", "Mask", "Elev", "Elev_mod", "Label", "Cloud" };
 	char fname[256];
 	sprintf (fname, "%s\\Archive\\%s.tree", path, name[layer]);
-	treef = fopen(fname, "rb");
-	if (!treef) return false;
+	hFile = CreateFileA(fname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER sz;
+	if (!GetFileSizeEx(hFile, &sz)) {
+		CloseArchive();
+		return false;
+	}
+	fsize = sz.QuadPart;
+
+	// map the whole file; fall back to positioned reads if that fails
+	if (hMap = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL)) {
+		if (!(view = (const BYTE*)MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0))) {
+			CloseHandle(hMap);
+			hMap = NULL;
+		}
+	}
 
 	TreeFileHeader tfh;
-	if (!tfh.fread(treef)) {
-		fclose(treef);
-		treef = 0;
+	BYTE hbuf[sizeof(TreeFileHeader)];
+	const BYTE *hdata = view;
+	if (!hdata && fsize >= (__int64)sizeof(hbuf) && ReadAt(hFile, 0, hbuf, sizeof(hbuf)))
+		hdata = hbuf;
+	if (!hdata || !tfh.read(hdata, (size_t)fsize)) {
+		CloseArchive();
 		return false;
 	}
 	rootPos1 = tfh.rootPos1;
@@ -133,11 +148,23 @@ bool ZTreeMgr::OpenArchive()
 		rootPos4[i] = tfh.rootPos4[i];
 	dofs = (__int64)tfh.dataOfs;
 
-	if (!toc.fread(tfh.nodeCount, treef)) {
-		fclose(treef);
-		treef = 0;
+	// the table of contents follows the header
+	__int64 tocsize = (__int64)tfh.nodeCount * sizeof(TreeNode);
+	if (tfh.size + tocsize > fsize || dofs + tfh.dataLength > fsize) {
+		CloseArchive();
 		return false;
 	}
+	if (view) {
+		toc.tree = (const TreeNode*)(view + tfh.size);
+	} else {
+		toc.buf.resize(tfh.nodeCount);
+		if (!ReadAt(hFile, tfh.size, toc.buf.data(), (DWORD)tocsize)) {
+			CloseArchive();
+			return false;
+		}
+		toc.tree = toc.buf.data();
+	}
+	toc.ntree = tfh.nodeCount;
 	toc.totlength = tfh.dataLength;
 
 	return true;
@@ -145,6 +172,27 @@ bool ZTreeMgr::OpenArchive()
 
 // -----------------------------------------------------------------------
 
+void ZTreeMgr::CloseArchive()
+{
+	toc.tree = NULL;
+	toc.ntree = 0;
+	toc.buf.clear();
+	if (view) {
+		UnmapViewOfFile(view);
+		view = 0;
+	}
+	if (hMap) {
+		CloseHandle(hMap);
+		hMap = NULL;
+	}
+	if (hFile != INVALID_HANDLE_VALUE) {
+		CloseHandle(hFile);
+		hFile = INVALID_HANDLE_VALUE;
+	}
+}
+
+// -----------------------------------------------------------------------
+
 DWORD ZTreeMgr::Idx(int lvl, int ilat, int ilng) const
 {
 	if (lvl <= 4) {
@@ -165,24 +213,14 @@ DWORD ZTreeMgr::Idx(int lvl, int ilat, int ilng) const
 
 DWORD ZTreeMgr::ReadData(DWORD idx, BYTE **outp) const
 {
-	if (idx == (DWORD)-1) return 0; // sanity check
+	if (idx == (DWORD)-1 || idx >= toc.size()) return 0; // sanity check
 
 	DWORD esize = NodeSizeInflated(idx);
 	if (!esize) // node doesn't have data, but has descendants with data
 		return 0;
 
-	if (_fseeki64(treef, toc[idx].pos+dofs, SEEK_SET))
-		return 0;
-
-	DWORD zsize = NodeSizeDeflated(idx);
-	BYTE *zbuf = new BYTE[zsize];	
-	fread(zbuf, 1, zsize, treef);
-
 	BYTE *ebuf = new BYTE[esize];
-
-	DWORD ndata = Inflate(zbuf, zsize, ebuf, esize);
-	delete []zbuf;
-
+	DWORD ndata = ReadData(idx, ebuf, esize);
 	if (!ndata) {
 		delete []ebuf;
 		ebuf = 0;
@@ -193,12 +231,36 @@ DWORD ZTreeMgr::ReadData(DWORD idx, BYTE **outp) const
 
 // -----------------------------------------------------------------------
 
+DWORD ZTreeMgr::ReadData(DWORD idx, BYTE *buf, DWORD bufsize) const
+{
+	if (idx == (DWORD)-1 || idx >= toc.size()) return 0; // sanity check
+
+	DWORD esize = NodeSizeInflated(idx);
+	if (!esize || esize > bufsize) // node doesn't have data, but has descendants with data, or buffer too small
+		return 0;
+
+	__int64 pos = toc[idx].pos + dofs;
+	DWORD zsize = NodeSizeDeflated(idx);
+	if (pos < 0 || pos + zsize > fsize)
+		return 0;
+
+	if (view) // inflate directly from the mapped view
+		return Inflate(view + pos, zsize, buf, esize);
+
+	std::vector<BYTE> zbuf(zsize);
+	if (!ReadAt(hFile, pos, zbuf.data(), zsize))
+		return 0;
+	return Inflate(zbuf.data(), zsize, buf, esize);
+}
+
+// -----------------------------------------------------------------------
+
 DWORD ZTreeMgr::Inflate(const BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp) const
 {
-	DWORD ndata = noutp;
+	uLongf ndata = noutp;
 	if (uncompress (outp, &ndata, inp, ninp) != Z_OK)
 		return 0;
-	return ndata;
+	return (DWORD)ndata;
 }
 
 // -----------------------------------------------------------------------
@@ -206,4 +268,4 @@ DWORD ZTreeMgr::Inflate(const BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp) co
 void ZTreeMgr::ReleaseData(BYTE *data) const
 {
 	delete []data;
-}
\ No newline at end of file
+}
@@ -4,12 +4,22 @@
 // =======================================================================
 // ZTreeMgr.h
 // Manage compressed and packed tile trees for planetary surface and cloud layers.
+// Shared by the Orbiter core, the D3D9 client and tileedit.
+//
+// The tree file is memory-mapped. The table of contents is used in place,
+// and tile data are inflated directly from the mapped view, so that reads
+// don't share any file position or buffer state. All read methods can be
+// called concurrently from multiple threads.
+// If the file can't be mapped (e.g. address space exhausted in 32-bit
+// builds), the manager falls back to positioned reads, which are equally
+// thread-safe.
 // =======================================================================
 
 #ifndef __ZTREEMGR_H
 #define __ZTREEMGR_H
 
 #include <iostream>
+#include <vector>
 #include <windows.h>
 
 // =======================================================================
@@ -36,7 +46,9 @@ class TreeFileHeader {
 public:
 	TreeFileHeader();
 	size_t fwrite(FILE *f);
-	bool fread(FILE *f);
+	bool read(const BYTE *data, size_t ndata);
+	// Read the header from a memory block. Returns false if the block is
+	// too short or doesn't contain a tree file header.
 
 private:
 	BYTE magic[4];      // file ID and version
@@ -59,8 +71,6 @@ class TreeTOC {
 
 public:
 	TreeTOC();
-	~TreeTOC();
-	size_t fread(DWORD size, FILE *f);
 	inline DWORD size() const { return ntree; }
 	inline const TreeNode &operator[](int idx) const { return tree[idx]; }
 
@@ -71,10 +81,10 @@ public:
 	{ return tree[idx].size; }
 
 private:
-	TreeNode *tree;    // array containing all tree node entries
-	DWORD ntree;       // number of entries
-	DWORD ntreebuf;    // array size
-	__int64 totlength; // total data size (deflated)
+	const TreeNode *tree;      // array containing all tree node entries (mapped or in buf)
+	std::vector<TreeNode> buf; // node storage if the file is not mapped
+	DWORD ntree;               // number of entries
+	__int64 totlength;         // total data size (deflated)
 };
 
 // =======================================================================
@@ -86,35 +96,56 @@ public:
 	static ZTreeMgr *CreateFromFile(const char *PlanetPath, Layer _layer);
 	ZTreeMgr(const char *PlanetPath, Layer _layer);
 	~ZTreeMgr();
+
+	ZTreeMgr(const ZTreeMgr&) = delete;
+	ZTreeMgr &operator=(const ZTreeMgr&) = delete;
+
 	const TreeTOC &TOC() const { return toc; }
 
-	DWORD Idx(int lvl, int ilat, int ilng);
+	DWORD Idx(int lvl, int ilat, int ilng) const;
 	// return the array index of an arbitrary tile ((DWORD)-1: not present)
 
-	DWORD ReadData(DWORD idx, BYTE **outp);
+	DWORD ReadData(DWORD idx, BYTE **outp) const;
+	// Inflate the data of node idx into a new buffer, returned in outp.
+	// Returns the data size, or 0 if the node has no data. The buffer must
+	// be returned with ReleaseData.
 
-	inline DWORD ReadData(int lvl, int ilat, int ilng, BYTE **outp)
+	inline DWORD ReadData(int lvl, int ilat, int ilng, BYTE **outp) const
 	{ return (ilat < 0 || ilng < 0) ? 0 : ReadData(Idx(lvl, ilat, ilng), outp); }
 
-	void ReleaseData(BYTE *data);
+	DWORD ReadData(DWORD idx, BYTE *buf, DWORD bufsize) const;
+	// Inflate the data of node idx into the caller's buffer buf of size
+	// bufsize. Returns the data size, or 0 if the node has no data or the
+	// buffer is smaller than NodeSizeInflated(idx).
+
+	inline DWORD ReadData(int lvl, int ilat, int ilng, BYTE *buf, DWORD bufsize) const
+	{ return (ilat < 0 || ilng < 0) ? 0 : ReadData(Idx(lvl, ilat, ilng), buf, bufsize); }
+
+	void ReleaseData(BYTE *data) const;
 
 	inline DWORD NodeSizeDeflated(DWORD idx) const { return toc.NodeSizeDeflated(idx); }
 	inline DWORD NodeSizeInflated(DWORD idx) const { return toc.NodeSizeInflated(idx); }
 
+	inline bool IsMapped() const { return view != 0; }
+
 protected:
 	bool OpenArchive();
-	DWORD Inflate(const BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp);
+	void CloseArchive();
+	DWORD Inflate(const BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp) const;
 
 private:
 	char *path;
 	Layer layer;
-	FILE *treef;
 	TreeTOC toc;
 	DWORD rootPos1;    // index of level-1 tile ((DWORD)-1 for not present)
 	DWORD rootPos2;    // index of level-2 tile ((DWORD)-1 for not present)
 	DWORD rootPos3;    // index of level-3 tile ((DWORD)-1 for not present)
 	DWORD rootPos4[2]; // index of the level-4 tiles (quadtree roots; (DWORD)-1 for not present)
-	__int64 dofs;
+	__int64 dofs;      // file offset of the data block
+	__int64 fsize;     // file size
+	const BYTE *view;  // mapped file view (0 if not mapped)
+	HANDLE hFile;      // archive file handle
+	HANDLE hMap;       // file mapping handle
 };
 
 #endif // !__ZTREEMGR_H
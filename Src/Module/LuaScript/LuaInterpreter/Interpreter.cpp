@@ -8,6 +8,7 @@
 #include "MFDAPI.h"
 #include "DrawAPI.h"
 #include "gcCoreAPI.h"
+#include "transfersearch.h"
 #include <list>
 
 using std::min;
@@ -36,8 +37,40 @@ int OpenHelp (void *context);
 // ============================================================================
 // nonmember functions
 
+// ============================================================================
+// Vector and matrix types
+// Vectors and matrices are passed to scripts as userdata holding a VECTOR3 or
+// MATRIX3, with metatables for field access (v.x, m.m12) and arithmetic
+// operators. Compared with tables, this needs a single small allocation per
+// value. Arguments can also be given in the legacy table form.
+
+static const char *VECTOR_MT = "VECTOR3.vtable";
+static const char *MATRIX_MT = "MATRIX3.vtable";
+
+VECTOR3 *lua_touservector (lua_State *L, int idx)
+{
+	if (lua_type (L, idx) != LUA_TUSERDATA || !lua_getmetatable (L, idx)) return NULL;
+	luaL_getmetatable (L, VECTOR_MT);
+	bool match = (lua_rawequal (L, -1, -2) != 0);
+	lua_pop (L, 2);
+	return (match ? (VECTOR3*)lua_touserdata (L, idx) : NULL);
+}
+
+// returns the userdata matrix at stack position idx, or NULL if idx isn't one
+static MATRIX3 *lua_tousermatrix (lua_State *L, int idx)
+{
+	if (lua_type (L, idx) != LUA_TUSERDATA || !lua_getmetatable (L, idx)) return NULL;
+	luaL_getmetatable (L, MATRIX_MT);
+	bool match = (lua_rawequal (L, -1, -2) != 0);
+	lua_pop (L, 2);
+	return (match ? (MATRIX3*)lua_touserdata (L, idx) : NULL);
+}
+
 VECTOR3 lua_tovector (lua_State *L, int idx)
 {
+	const VECTOR3 *pv = lua_touservector (L, idx);
+	if (pv) return *pv;
+
 	VECTOR3 vec;
 	lua_getfield (L, idx, "x");
 	vec.x = lua_tonumber (L, -1); lua_pop (L,1);
@@ -402,17 +435,15 @@ const char *Interpreter::lua_tostringex (lua_State *L, int idx, char *cbuf)
 
 void Interpreter::lua_pushvector (lua_State *L, const VECTOR3 &vec)
 {
-	lua_createtable (L, 0, 3);
-	lua_pushnumber (L, vec.x);
-	lua_setfield (L, -2, "x");
-	lua_pushnumber (L, vec.y);
-	lua_setfield (L, -2, "y");
-	lua_pushnumber (L, vec.z);
-	lua_setfield (L, -2, "z");
+	VECTOR3 *v = (VECTOR3*)lua_newuserdata (L, sizeof(VECTOR3));
+	*v = vec;
+	luaL_getmetatable (L, VECTOR_MT);
+	lua_setmetatable (L, -2);
 }
 
 int Interpreter::lua_isvector (lua_State *L, int idx)
 {
+	if (lua_touservector (L, idx)) return 1;
 	if (!lua_istable (L, idx)) return 0;
 	static char fieldname[3] = {'x','y','z'};
 	static char field[2] = "x";
@@ -440,20 +471,17 @@ int Interpreter::lua_isvector (lua_State *L, int idx)
 
 void Interpreter::lua_pushmatrix (lua_State *L, const MATRIX3 &mat)
 {
-	lua_createtable(L,0,9);
-	lua_pushnumber(L,mat.m11);  lua_setfield(L,-2,"m11");
-	lua_pushnumber(L,mat.m12);  lua_setfield(L,-2,"m12");
-	lua_pushnumber(L,mat.m13);  lua_setfield(L,-2,"m13");
-	lua_pushnumber(L,mat.m21);  lua_setfield(L,-2,"m21");
-	lua_pushnumber(L,mat.m22);  lua_setfield(L,-2,"m22");
-	lua_pushnumber(L,mat.m23);  lua_setfield(L,-2,"m23");
-	lua_pushnumber(L,mat.m31);  lua_setfield(L,-2,"m31");
-	lua_pushnumber(L,mat.m32);  lua_setfield(L,-2,"m32");
-	lua_pushnumber(L,mat.m33);  lua_setfield(L,-2,"m33");
+	MATRIX3 *m = (MATRIX3*)lua_newuserdata (L, sizeof(MATRIX3));
+	*m = mat;
+	luaL_getmetatable (L, MATRIX_MT);
+	lua_setmetatable (L, -2);
 }
 
 MATRIX3 Interpreter::lua_tomatrix (lua_State *L, int idx)
 {
+	const MATRIX3 *pm = lua_tousermatrix (L, idx);
+	if (pm) return *pm;
+
 	MATRIX3 mat;
 	lua_getfield (L, idx, "m11");  mat.m11 = lua_tonumber (L, -1);  lua_pop (L,1);
 	lua_getfield (L, idx, "m12");  mat.m12 = lua_tonumber (L, -1);  lua_pop (L,1);
@@ -469,6 +497,7 @@ MATRIX3 Interpreter::lua_tomatrix (lua_State *L, int idx)
 
 int Interpreter::lua_ismatrix (lua_State *L, int idx)
 {
+	if (lua_tousermatrix (L, idx)) return 1;
 	if (!lua_istable (L, idx)) return 0;
 	static const char *fieldname[9] = {"m11","m12","m13","m21","m22","m23","m31","m32","m33"};
 	int i, ii, n;
@@ -788,6 +817,43 @@ void Interpreter::LoadAPI ()
 	};
 	luaL_openlib (L, "mat", matLib, 0);
 
+	// Metatables for the vector and matrix types
+	static const struct luaL_reg vecMeta[] = {
+		{"__index", vec_index},
+		{"__newindex", vec_newindex},
+		{"__add", vec_add},
+		{"__sub", vec_sub},
+		{"__mul", vec_mul},
+		{"__div", vec_div},
+		{"__unm", vec_unm},
+		{"__eq", vec_eq},
+		{"__tostring", vec_tostring},
+		{"__pairs", vec_pairs},
+		{NULL, NULL}
+	};
+	luaL_newmetatable (L, VECTOR_MT);
+	luaL_openlib (L, NULL, vecMeta, 0);
+	lua_pop (L, 1);
+
+	static const struct luaL_reg matMeta[] = {
+		{"__index", mat_index},
+		{"__newindex", mat_newindex},
+		{"__mul", mat_mulop},
+		{"__eq", mat_eq},
+		{"__tostring", vec_tostring},
+		{"__pairs", mat_pairs},
+		{NULL, NULL}
+	};
+	luaL_newmetatable (L, MATRIX_MT);
+	luaL_openlib (L, NULL, matMeta, 0);
+	lua_pop (L, 1);
+
+	// Lua 5.1 doesn't know __pairs, so wrap pairs() to let scripts iterate
+	// over vector and matrix fields as they could with the former tables
+	lua_getglobal (L, "pairs");
+	lua_pushcclosure (L, pairsex, 1);
+	lua_setglobal (L, "pairs");
+
 	// Load the process library
 	static const struct luaL_reg procLib[] = {
 		{"Frameskip", procFrameskip},
@@ -909,6 +975,9 @@ void Interpreter::LoadAPI ()
 		{"init_tilecache", oapi_init_tilecache},
 		{"release_tilecache", oapi_release_tilecache},
 
+		// transfer planning
+		{"transfer_search", oapi_transfer_search},
+
 		// vessel functions
 		{"get_propellanthandle", oapi_get_propellanthandle},
 		{"get_propellantmass", oapi_get_propellantmass},
@@ -2479,6 +2548,92 @@ int Interpreter::vec_unit (lua_State *L)
 	return 1;
 }
 
+// Vector metamethods
+
+// v.x, v.y, v.z
+int Interpreter::vec_index (lua_State *L)
+{
+	const VECTOR3 *v = (const VECTOR3*)lua_touserdata (L, 1);
+	size_t len;
+	const char *key = (lua_type (L, 2) == LUA_TSTRING ? lua_tolstring (L, 2, &len) : NULL);
+	if (key && len == 1 && key[0] >= 'x' && key[0] <= 'z')
+		lua_pushnumber (L, v->data[key[0]-'x']);
+	else
+		lua_pushnil (L);
+	return 1;
+}
+
+int Interpreter::vec_newindex (lua_State *L)
+{
+	VECTOR3 *v = (VECTOR3*)lua_touserdata (L, 1);
+	size_t len;
+	const char *key = (lua_type (L, 2) == LUA_TSTRING ? lua_tolstring (L, 2, &len) : NULL);
+	ASSERT_SYNTAX (key && len == 1 && key[0] >= 'x' && key[0] <= 'z', "invalid vector field (expected x, y or z)");
+	ASSERT_SYNTAX (lua_isnumber (L, 3), "Argument 3: expected number");
+	v->data[key[0]-'x'] = lua_tonumber (L, 3);
+	return 0;
+}
+
+// -v
+int Interpreter::vec_unm (lua_State *L)
+{
+	lua_pushvector (L, -lua_tovector (L, 1));
+	return 1;
+}
+
+// a == b (only called for two userdata vectors)
+int Interpreter::vec_eq (lua_State *L)
+{
+	VECTOR3 a = lua_tovector (L, 1), b = lua_tovector (L, 2);
+	lua_pushboolean (L, a.x == b.x && a.y == b.y && a.z == b.z);
+	return 1;
+}
+
+// tostring(v), tostring(m)
+int Interpreter::vec_tostring (lua_State *L)
+{
+	lua_pushstring (L, lua_tostringex (L, 1));
+	return 1;
+}
+
+// pairs(v): iterates over the x, y and z fields
+int Interpreter::vec_pairs (lua_State *L)
+{
+	lua_pushcfunction (L, vec_next);
+	lua_pushvalue (L, 1);
+	lua_pushnil (L);
+	return 3;
+}
+
+int Interpreter::vec_next (lua_State *L)
+{
+	const VECTOR3 *v = (const VECTOR3*)lua_touserdata (L, 1);
+	size_t len;
+	const char *key = (lua_type (L, 2) == LUA_TSTRING ? lua_tolstring (L, 2, &len) : NULL);
+	int i = 0;
+	if (key && len == 1 && key[0] >= 'x' && key[0] <= 'z') i = key[0]-'x'+1;
+	else if (!lua_isnil (L, 2)) return 0;
+	if (i == 3) return 0;
+	char field[2] = { (char)('x'+i), '\0' };
+	lua_pushstring (L, field);
+	lua_pushnumber (L, v->data[i]);
+	return 2;
+}
+
+// pairs(...) with __pairs support
+int Interpreter::pairsex (lua_State *L)
+{
+	if (luaL_getmetafield (L, 1, "__pairs")) {
+		lua_pushvalue (L, 1);
+		lua_call (L, 1, 3);
+		return 3;
+	}
+	lua_pushvalue (L, lua_upvalueindex (1)); // built-in pairs
+	lua_insert (L, 1);
+	lua_call (L, lua_gettop (L) - 1, 3);
+	return 3;
+}
+
 /***
 Matrix library functions.
 @module mat
@@ -2543,6 +2698,92 @@ int Interpreter::mat_mmul (lua_State *L)
 	lua_pushmatrix (L, mul(lua_tomatrix(L,1), lua_tomatrix(L,2)));
 	return 1;
 }
+// Matrix metamethods
+
+// index 0-8 of matrix element key "mij", or -1
+static int MatrixFieldIndex (lua_State *L, int idx)
+{
+	size_t len;
+	const char *key = (lua_type (L, idx) == LUA_TSTRING ? lua_tolstring (L, idx, &len) : NULL);
+	if (key && len == 3 && key[0] == 'm' && key[1] >= '1' && key[1] <= '3' && key[2] >= '1' && key[2] <= '3')
+		return (key[1]-'1')*3 + (key[2]-'1');
+	return -1;
+}
+
+// m.m11 ... m.m33
+int Interpreter::mat_index (lua_State *L)
+{
+	const MATRIX3 *m = (const MATRIX3*)lua_touserdata (L, 1);
+	int i = MatrixFieldIndex (L, 2);
+	if (i >= 0) lua_pushnumber (L, m->data[i]);
+	else        lua_pushnil (L);
+	return 1;
+}
+
+int Interpreter::mat_newindex (lua_State *L)
+{
+	MATRIX3 *m = (MATRIX3*)lua_touserdata (L, 1);
+	int i = MatrixFieldIndex (L, 2);
+	ASSERT_SYNTAX (i >= 0, "invalid matrix field (expected m11 ... m33)");
+	ASSERT_SYNTAX (lua_isnumber (L, 3), "Argument 3: expected number");
+	m->data[i] = lua_tonumber (L, 3);
+	return 0;
+}
+
+// pairs(m): iterates over the fields m11 ... m33
+int Interpreter::mat_pairs (lua_State *L)
+{
+	lua_pushcfunction (L, mat_next);
+	lua_pushvalue (L, 1);
+	lua_pushnil (L);
+	return 3;
+}
+
+int Interpreter::mat_next (lua_State *L)
+{
+	const MATRIX3 *m = (const MATRIX3*)lua_touserdata (L, 1);
+	int i = (lua_isnil (L, 2) ? 0 : MatrixFieldIndex (L, 2) + 1);
+	if (i == 0 && !lua_isnil (L, 2)) return 0; // not a matrix field
+	if (i == 9) return 0;
+	char field[4] = { 'm', (char)('1'+i/3), (char)('1'+i%3), '\0' };
+	lua_pushstring (L, field);
+	lua_pushnumber (L, m->data[i]);
+	return 2;
+}
+
+// A*B, M*v, M*f, f*M
+int Interpreter::mat_mulop (lua_State *L)
+{
+	if (lua_isnumber (L, 1)) {
+		ASSERT_SYNTAX (lua_ismatrix (L, 2), "Argument 2: expected matrix");
+		MATRIX3 m = lua_tomatrix (L, 2);
+		lua_pushmatrix (L, m * lua_tonumber (L, 1));
+		return 1;
+	}
+	ASSERT_SYNTAX (lua_ismatrix (L, 1), "Argument 1: expected matrix");
+	MATRIX3 m = lua_tomatrix (L, 1);
+	if (lua_ismatrix (L, 2)) {
+		lua_pushmatrix (L, mul (m, lua_tomatrix (L, 2)));
+	} else if (lua_isvector (L, 2)) {
+		lua_pushvector (L, mul (m, lua_tovector (L, 2)));
+	} else {
+		ASSERT_SYNTAX (lua_isnumber (L, 2), "Argument 2: expected matrix, vector or number");
+		lua_pushmatrix (L, m * lua_tonumber (L, 2));
+	}
+	return 1;
+}
+
+// A == B (only called for two userdata matrices)
+int Interpreter::mat_eq (lua_State *L)
+{
+	MATRIX3 a = lua_tomatrix (L, 1), b = lua_tomatrix (L, 2);
+	bool eq = true;
+	for (int i = 0; i < 9 && eq; i++)
+		eq = (a.data[i] == b.data[i]);
+	lua_pushboolean (L, eq);
+	return 1;
+}
+
 /***
 Construct a rotation matrix from an axis and an angle.
 @function rotm
@@ -6418,6 +6659,93 @@ int Interpreter::tilecache_collect(lua_State *L)
 	return 0;
 }
 
+/***
+Search for the cheapest transfer between two bodies orbiting the same
+central body.
+
+Maps the departure dates from mjd0 to mjd0+span against the times of
+flight, solving the Lambert problem for each combination, and returns the
+transfer with the smallest sum of hyperbolic excess velocities at
+departure and arrival. The central body is the parent of hDep.
+The search runs on worker threads, but the function returns only when it
+is complete (typically a fraction of a second).
+
+@function transfer_search
+@tparam handle hDep departure body handle
+@tparam handle hArr arrival body handle (a different body with the same parent)
+@tparam number mjd0 earliest departure date [MJD]
+@tparam number span range of departure dates [days]
+@tparam[opt] number tofmin shortest time of flight [days] (default: 0.3 x Hohmann transfer time)
+@tparam[opt] number tofmax longest time of flight [days] (default: 1.7 x Hohmann transfer time)
+@treturn table transfer parameters or nil if no transfer was found:
+
+- dep: number (departure date [MJD])
+- tof: number (time of flight [days])
+- dv: number (sum of departure and arrival excess velocities [m/s])
+- vdep: vector (hyperbolic excess velocity at departure [m/s])
+- varr: vector (hyperbolic excess velocity at arrival [m/s])
+@usage t = oapi.transfer_search(oapi.get_objhandle("Earth"), oapi.get_objhandle("Mars"), oapi.get_simmjd(), 780)
+*/
+int Interpreter::oapi_transfer_search(lua_State *L)
+{
+	OBJHANDLE hDep, hArr, hRef;
+	ASSERT_SYNTAX(lua_islightuserdata(L, 1), "Argument 1: invalid type (expected handle)");
+	ASSERT_SYNTAX(hDep = lua_toObject(L, 1), "Argument 1: invalid object");
+	ASSERT_SYNTAX(lua_islightuserdata(L, 2), "Argument 2: invalid type (expected handle)");
+	ASSERT_SYNTAX(hArr = lua_toObject(L, 2), "Argument 2: invalid object");
+	double mjd0 = luaL_checknumber(L, 3);
+	double span = luaL_checknumber(L, 4);
+	ASSERT_SYNTAX(span > 0.0, "Argument 4: expected positive span");
+	ASSERT_SYNTAX(hArr != hDep, "Argument 2: arrival body must differ from departure body");
+	ASSERT_SYNTAX(hRef = oapiGetGbodyParent(hDep), "Argument 1: body has no parent");
+	ASSERT_SYNTAX(oapiGetGbodyParent(hArr) == hRef, "Argument 2: body must orbit the same central body as argument 1");
+
+	VECTOR3 p1, p2;
+	oapiGetRelativePos(hDep, hRef, &p1);
+	oapiGetRelativePos(hArr, hRef, &p2);
+	double mu = GGRAV * oapiGetMass(hRef);
+	TransferSearch::Grid grid = TransferSearch::DefaultGrid(mjd0, span, mu, length(p1), length(p2));
+	double tofmin = grid.tof0;
+	double tofmax = grid.tof0 + (grid.ntof - 1) * grid.dtof;
+	if (!lua_isnoneornil(L, 5)) {
+		tofmin = luaL_checknumber(L, 5);
+		ASSERT_SYNTAX(tofmin > 0.0, "Argument 5: expected positive time of flight");
+	}
+	if (!lua_isnoneornil(L, 6))
+		tofmax = luaL_checknumber(L, 6);
+	ASSERT_SYNTAX(tofmax > tofmin, "Arguments 5, 6: invalid time of flight range");
+	grid.tof0 = tofmin;
+	grid.dtof = (tofmax - tofmin) / (grid.ntof - 1);
+	double depend = grid.dep0 + (grid.ndep - 1) * grid.ddep;
+	double arrend = depend + grid.tof0 + (grid.ntof - 1) * grid.dtof;
+	double dt = min(1.0, min(grid.ddep, grid.dtof));
+
+	TransferSearch::Ephemeris dep, arr;
+	TransferSearch::SampleBody(hDep, hRef, grid.dep0, depend, dt, &dep);
+	TransferSearch::SampleBody(hArr, hRef, grid.dep0 + grid.tof0, arrend, dt, &arr);
+	TransferSearch search;
+	search.Start(mu, grid, dep, arr);
+	search.Wait();
+
+	TransferSearch::Solution s = search.Best();
+	if (!s.valid) {
+		lua_pushnil(L);
+		return 1;
+	}
+	lua_createtable(L, 0, 5);
+	lua_pushnumber(L, s.dep);
+	lua_setfield(L, -2, "dep");
+	lua_pushnumber(L, s.tof);
+	lua_setfield(L, -2, "tof");
+	lua_pushnumber(L, s.dv);
+	lua_setfield(L, -2, "dv");
+	lua_pushvector(L, s.vinfdep);
+	lua_setfield(L, -2, "vdep");
+	lua_pushvector(L, s.vinfarr);
+	lua_setfield(L, -2, "varr");
+	return 1;
+}
+
 
 /***
 Animations.
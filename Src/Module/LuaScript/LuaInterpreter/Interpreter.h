@@ -85,6 +85,9 @@ typedef struct  {
 // converts the vector at stack position 'idx' into a VECTOR3
 INTERPRETERLIB VECTOR3 lua_tovector (lua_State *L, int idx);
 
+// returns the vector userdata at stack position 'idx', or NULL if it isn't one
+INTERPRETERLIB VECTOR3 *lua_touservector (lua_State *L, int idx);
+
 // ======================================================================
 // class Interpreter
 
@@ -276,19 +279,19 @@ protected:
 	// This also handles vector and nil entries.
 	static const char *lua_tostringex (lua_State *L, int idx, char *cbuf = 0);
 
-	// pushes vector 'vec' into a table on top of the stack
+	// pushes vector 'vec' as a vector userdata on top of the stack
 	static void lua_pushvector (lua_State *L, const VECTOR3 &vec);
 
-	// returns 1 if stack entry idx is a vector, 0 otherwise
+	// returns 1 if stack entry idx is a vector (userdata or table), 0 otherwise
 	static int lua_isvector (lua_State *L, int idx);
 
-	// pushes matrix 'mat' into a table on top of the stack
+	// pushes matrix 'mat' as a matrix userdata on top of the stack
 	static void lua_pushmatrix (lua_State *L, const MATRIX3 &mat);
 
 	// converts the matrix at stack position 'idx' into a MATRIX3
 	static MATRIX3 lua_tomatrix (lua_State *L, int idx);
 
-	// returns 1 if stack entry idx is a matrix, 0 otherwise
+	// returns 1 if stack entry idx is a matrix (userdata or table), 0 otherwise
 	static int lua_ismatrix (lua_State *L, int idx);
 
 	static COLOUR4 lua_torgba (lua_State *L, int idx);
@@ -366,6 +369,24 @@ protected:
 	static int mat_mmul (lua_State *L);
 	static int mat_rotm (lua_State *L);
 
+	// vector and matrix metamethods
+	static int vec_index (lua_State *L);
+	static int vec_newindex (lua_State *L);
+	static int vec_unm (lua_State *L);
+	static int vec_eq (lua_State *L);
+	static int vec_tostring (lua_State *L);
+	static int mat_index (lua_State *L);
+	static int mat_newindex (lua_State *L);
+	static int mat_mulop (lua_State *L);
+	static int mat_eq (lua_State *L);
+	static int vec_pairs (lua_State *L);
+	static int vec_next (lua_State *L);
+	static int mat_pairs (lua_State *L);
+	static int mat_next (lua_State *L);
+
+	// pairs() replacement which honours the __pairs metamethod
+	static int pairsex (lua_State *L);
+
 	// bit manipulations
 	static int bit_anyset(lua_State* L);
 	static int bit_allset(lua_State* L);
@@ -555,6 +576,9 @@ protected:
 	static int oapi_release_tilecache(lua_State *);
 	static int tilecache_collect(lua_State *);
 
+	// Transfer window search
+	static int oapi_transfer_search(lua_State *L);
+
 
 	// animation functions
 	static int oapi_create_animationcomponent (lua_State *L);
@@ -701,6 +725,8 @@ protected:
 	static int v_set_crosssections (lua_State *L);
 	static int v_get_gravitygradientdamping (lua_State *L);
 	static int v_set_gravitygradientdamping (lua_State *L);
+	static int v_get_propagatortolerance (lua_State *L);
+	static int v_set_propagatortolerance (lua_State *L);
 	static int v_get_touchdownpointcount (lua_State *L);
 	static int v_get_touchdownpoints (lua_State *L);
 	static int v_set_touchdownpoints (lua_State *L);
@@ -715,6 +741,7 @@ protected:
 	static int v_get_mass (lua_State *L);
 	static int v_get_globalpos (lua_State *L);
 	static int v_get_globalvel (lua_State *L);
+	static int v_get_intermediatestate (lua_State *L);
 	static int v_get_relativepos (lua_State *L);
 	static int v_get_relativevel (lua_State *L);
 	static int v_get_rotationmatrix (lua_State *L);
@@ -729,6 +756,7 @@ protected:
 	static int v_get_globalorientation (lua_State *L);
 	static int v_set_globalorientation (lua_State *L);
 	static int v_is_orbitstabilised (lua_State *L);
+	static int v_is_onrails (lua_State *L);
 	static int v_is_nonsphericalgravityenabled (lua_State *L);
 	static int v_toggle_navmode (lua_State *L);
 	static int v_get_hoverholdaltitude (lua_State *L);
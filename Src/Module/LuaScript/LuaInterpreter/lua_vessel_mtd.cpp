@@ -248,6 +248,8 @@ void Interpreter::LoadVesselAPI ()
 		{"set_crosssections", v_set_crosssections},
 		{"get_gravitygradientdamping", v_get_gravitygradientdamping},
 		{"set_gravitygradientdamping", v_set_gravitygradientdamping},
+		{"get_propagatortolerance", v_get_propagatortolerance},
+		{"set_propagatortolerance", v_set_propagatortolerance},
 		{"get_touchdownpointcount", v_get_touchdownpointcount},
 		{"get_touchdownpoints", v_get_touchdownpoints},
 		{"set_touchdownpoints", v_set_touchdownpoints},
@@ -261,6 +263,7 @@ void Interpreter::LoadVesselAPI ()
 		{"get_mass", v_get_mass},
 		{"get_globalpos", v_get_globalpos},
 		{"get_globalvel", v_get_globalvel},
+		{"get_intermediatestate", v_get_intermediatestate},
 		{"get_relativepos", v_get_relativepos},
 		{"get_relativevel", v_get_relativevel},
 		{"get_rotationmatrix", v_get_rotationmatrix},
@@ -542,6 +545,7 @@ void Interpreter::LoadVesselAPI ()
         {"create_variabledragelement", v_create_variabledragelement },
         {"clear_variabledragelements", v_clear_variabledragelements },
         {"is_orbitstabilised", v_is_orbitstabilised},
+        {"is_onrails", v_is_onrails},
         {"is_nonsphericalgravityenabled", v_is_nonsphericalgravityenabled},
         {"toggle_navmode", v_toggle_navmode},
         {"get_hoverholdaltitude", v_get_hoverholdaltitude},
@@ -1305,6 +1309,51 @@ int Interpreter::v_set_gravitygradientdamping (lua_State *L)
 	return 1;
 }
 
+/***
+Get adaptive propagator tolerance.
+
+Returns the vessel-specific error tolerance of the adaptive state propagator.
+
+@function get_propagatortolerance
+@treturn number Relative error tolerance, or 0 if the vessel uses the propagator
+   settings of the physics engine options.
+@see vessel:set_propagatortolerance
+*/
+int Interpreter::v_get_propagatortolerance (lua_State *L)
+{
+	static const char *funcname = "get_propagatortolerance";
+	AssertMtdMinPrmCount(L, 1, funcname);
+	VESSEL *v = lua_tovessel_safe(L, 1, funcname);
+	lua_pushnumber (L, v->GetPropagatorTolerance());
+	return 1;
+}
+
+/***
+Set adaptive propagator tolerance.
+
+Propagates the vessel state with the adaptive embedded Runge-Kutta method
+(Dormand-Prince 5(4)). Each time step is divided into substeps whose length is
+controlled by a local error estimate. Position and velocity errors are measured
+relative to the vessel's distance from and velocity with respect to its orbit
+reference body.
+
+During surface contact the fixed-step propagators are used.
+
+@function set_propagatortolerance
+@tparam number tol Relative error tolerance per substep (&gt; 0), or 0 to revert
+   to the propagator settings of the physics engine options.
+@see vessel:get_propagatortolerance, vessel:get_intermediatestate
+*/
+int Interpreter::v_set_propagatortolerance (lua_State *L)
+{
+	static const char *funcname = "set_propagatortolerance";
+	AssertMtdMinPrmCount(L, 2, funcname);
+	VESSEL *v = lua_tovessel_safe(L, 1, funcname);
+	double tol = luamtd_tonumber_safe(L, 2, funcname);
+	v->SetPropagatorTolerance (tol);
+	return 0;
+}
+
 /***
 Get number of touchdown points.
 
@@ -1725,6 +1774,37 @@ int Interpreter::v_get_globalvel (lua_State *L)
 	return 1;
 }
 
+/***
+Get state vectors at an intermediate time of the last time step.
+
+The state is evaluated from the dense output of the adaptive propagator (see
+@{set_propagatortolerance}), with the same order of accuracy as the states at
+the step boundaries.
+
+@function get_intermediatestate
+@tparam number simt simulation time [s]. Must lie within the last time step.
+@return (<i><b>@{types.vector|vector}</b></i>) global position [<b>m</b>], or nil if
+   simt is outside the last time step, or the step was not propagated with the
+   adaptive propagator.
+@return (<i><b>@{types.vector|vector}</b></i>) global velocity [<b>m/s</b>]
+@see vessel:get_globalpos, vessel:get_globalvel, vessel:set_propagatortolerance
+*/
+int Interpreter::v_get_intermediatestate (lua_State *L)
+{
+	static const char *funcname = "get_intermediatestate";
+	AssertMtdMinPrmCount(L, 2, funcname);
+	VESSEL *v = lua_tovessel_safe(L, 1, funcname);
+	double simt = luamtd_tonumber_safe(L, 2, funcname);
+	VECTOR3 pos, vel;
+	if (!v->GetIntermediateState (simt, pos, vel)) {
+		lua_pushnil (L);
+		return 1;
+	}
+	lua_pushvector (L, pos);
+	lua_pushvector (L, vel);
+	return 2;
+}
+
 /***
 Get current position with respect to another object.
 
@@ -2533,6 +2613,31 @@ int Interpreter::v_is_orbitstabilised (lua_State *L)
 	return 1;
 }
 
+/***
+On-rails propagation.
+
+Returns whether the vessel is propagated on rails at the current time step.
+
+On-rails propagation is used only if the user has enabled it (OnRails
+   option), and only for vessels without active forces that are neither
+   the focus object nor the camera target, and are far from the camera and
+   from other vessels.
+
+@function is_onrails
+@treturn bool _true_ indicates that the vessel's state is currently updated
+   analytically along its osculating orbit around the reference body, with
+   secular corrections for the body's J2 coefficient.
+@see is_orbitstabilised
+*/
+int Interpreter::v_is_onrails (lua_State *L)
+{
+	static const char *funcname = "is_onrails";
+	AssertMtdMinPrmCount(L, 1, funcname);
+	VESSEL *v = lua_tovessel_safe(L, 1, funcname);
+	lua_pushboolean(L, v->OnRails());
+	return 1;
+}
+
 /***
 Nonspherical gravity perturbations.
 
@@ -7,13 +7,23 @@
 --- A 3D cartesian vector.
 --
 -- Any 3-D vectors passed into or returned from Orbiter API script functions conform to the following convention:
--- A vector is defined as a table containing three numerical fields with keys "x", "y" and "z". (Vectors passed as arguments to API functions can have additional fields, which are ignored by the interpreter).
--- Vectors can be defined and initialised by normal Lua syntax, or with the _V(x, y, z) function to mimic C++ syntax.
+-- Vectors returned from API functions are userdata objects with read/write fields "x", "y" and "z". They support the operators
+-- +, - (binary and unary), * and / (with a number or elementwise with another vector), == and tostring.
+-- Vectors passed as arguments to API functions can be either such objects, or tables containing three numerical fields with keys
+-- "x", "y" and "z" (tables can have additional fields, which are ignored by the interpreter).
+-- Vectors can be defined and initialised with vec.set(x, y, z), by normal Lua table syntax, or with the _V(x, y, z) function to mimic C++ syntax.
+--
+-- Migration note: API functions used to return vectors as tables. For the returned objects, type(v) is now "userdata",
+-- and fields other than x, y and z can't be added. pairs(v) still iterates over the x, y and z fields.
+-- Scripts that test type(v) == "table" or store extra fields in a returned vector should copy it into a table
+-- first, e.g. t = _V(v.x, v.y, v.z).
 -- @usage
 -- V1 = {x=1,y=0,z=-1}
 -- V2 = {}; V2.x=0; V2.y=1.1; V2.z=-16
 -- V3 = {}; V3["x"]=15; V3["y"]=-3.145; V3["z"]=1e3
 -- V4 = _V(1, 0, -1)
+-- V5 = vec.set(1, 0, -1)
+-- V6 = 2*V5 + V1 -- userdata operators accept tables as operands
 -- @field x x-component [m]
 -- @field y y-component [m]
 -- @field z z-component [m]
@@ -27,10 +37,13 @@
 --	m31 m32 m33
 --
 -- Any 3x3 matrices passed into or returned from Orbiter API script functions conform to the following convention:
--- A matrix is defined as a table containing nine numerical fields with keys "m11", "m12", "m13",
--- "m21", "m22", "m23", "m31", "m32", "m33".
--- (Matrices passed as arguments to API functions can have additional fields, which are ignored by the interpreter).
+-- Matrices returned from API functions are userdata objects with read/write fields "m11", "m12", "m13",
+-- "m21", "m22", "m23", "m31", "m32", "m33". They support matrix*matrix, matrix*vector and matrix*number products, == and tostring.
+-- Matrices passed as arguments to API functions can be either such objects, or tables containing nine numerical fields with
+-- the same keys (tables can have additional fields, which are ignored by the interpreter).
 -- Matrices can be defined and initialised by normal Lua syntax, or with the _M(...) function to mimic C++ syntax.
+--
+-- Migration note: as for vectors, type(m) is "userdata" for returned matrices, and pairs(m) iterates over the fields m11 ... m33.
 -- @usage
 -- M1 = {m11=1,m12=0,m13=0,m21=0,m22=1,m23=0,m31=0,m32=0,m33=1}
 -- M2 = {}
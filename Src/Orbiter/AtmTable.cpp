@@ -0,0 +1,197 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+#include "AtmTable.h"
+#include <algorithm>
+#include <cmath>
+
+static const double PI = 3.14159265358979323846;
+static const double VMIN = 1e-300; // floor for logarithms of p and rho
+
+// relative deviation of a from b
+static double RelErr (double a, double b)
+{
+	double d = fabs (a-b);
+	return (d ? d / std::max (fabs (b), VMIN) : 0.0);
+}
+
+static double RelErr (const AtmTable::Prm &a, const AtmTable::Prm &b)
+{
+	return std::max (RelErr (a.T, b.T), std::max (RelErr (a.p, b.p), RelErr (a.rho, b.rho)));
+}
+
+// =======================================================================
+// class AtmTable
+
+AtmTable::AtmTable (EvalFunc _func, double _altmin, double _altmax, double _tol, int _nlat, int _nlst)
+: func(_func), altmin(_altmin), altmax(_altmax), tol(_tol), next(0), epoch(0), nbuild(0), nreject(0)
+{
+	if (altmax <= altmin) altmax = altmin + 1.0;
+	nlat = std::max (_nlat, 3);
+	nlst = std::max (_nlst, 4);
+	dlat = PI/(nlat-1);
+	dlst = 24.0/nlst;
+}
+
+// =======================================================================
+
+bool AtmTable::Eval (double a, double lat, double lst, Prm &prm)
+{
+	std::call_once (initFlag, &AtmTable::Init, this);
+	if (a < altmin || a > altmax) return false;
+
+	size_t k = std::upper_bound (alt.begin(), alt.end(), a) - alt.begin();
+	k = std::min (std::max (k, (size_t)1), alt.size()-1) - 1;
+	for (size_t kk = k; kk <= k+1; kk++) {
+		Slice &s = slice[kk];
+		int state = s.state.load (std::memory_order_acquire);
+		if (state == EMPTY && s.state.compare_exchange_strong (state, BUILDING, std::memory_order_acquire)) {
+			Build (kk);
+			s.state.store (BUILT, std::memory_order_release);
+			state = BUILT;
+		}
+		if (state != BUILT) return false; // another thread is building it
+		if (!s.used.load (std::memory_order_relaxed))
+			s.used.store (true, std::memory_order_relaxed);
+	}
+	if (slice[k].exact || slice[k+1].exact) {
+		nreject.fetch_add (1, std::memory_order_relaxed);
+		return false;
+	}
+
+	double fr = (a - alt[k]) / (alt[k+1] - alt[k]);
+	double flat = (lat + 0.5*PI)/dlat;
+	int i = std::min (std::max ((int)flat, 0), nlat-2);
+	flat = std::min (std::max (flat-i, 0.0), 1.0);
+	double flst = fmod (lst, 24.0);
+	if (flst < 0.0) flst += 24.0;
+	flst /= dlst;
+	int j = std::min ((int)flst, nlst-1);
+	int j1 = (j+1) % nlst; // local time wrap
+	flst = std::min (flst-j, 1.0);
+
+	// trilinear interpolation
+	const double *v[8] = {
+		Node (k, i, j),   Node (k, i, j1),   Node (k, i+1, j),   Node (k, i+1, j1),
+		Node (k+1, i, j), Node (k+1, i, j1), Node (k+1, i+1, j), Node (k+1, i+1, j1)
+	};
+	double w[8] = {
+		(1-fr)*(1-flat)*(1-flst), (1-fr)*(1-flat)*flst, (1-fr)*flat*(1-flst), (1-fr)*flat*flst,
+		fr*(1-flat)*(1-flst),     fr*(1-flat)*flst,     fr*flat*(1-flst),     fr*flat*flst
+	};
+	double r[3] = {0,0,0};
+	for (int n = 0; n < 8; n++)
+		for (int c = 0; c < 3; c++)
+			r[c] += w[n]*v[n][c];
+	prm.T   = r[0];
+	prm.p   = exp (r[1]);
+	prm.rho = exp (r[2]);
+	return true;
+}
+
+// =======================================================================
+
+bool AtmTable::SetEpoch (int64_t e)
+{
+	if (e == epoch) return false;
+	epoch = e;
+	return true;
+}
+
+// =======================================================================
+
+int AtmTable::Refresh (int maxslice)
+{
+	// continue where the last call stopped, so that all stale slices get
+	// their turn
+	size_t nslice = alt.size();
+	int n = 0;
+	for (size_t i = 0; i < nslice && n < maxslice; i++, next = (next+1) % nslice) {
+		Slice &s = slice[next];
+		if (s.state.load (std::memory_order_relaxed) == BUILT && s.epoch != epoch &&
+			s.used.load (std::memory_order_relaxed)) {
+			Build (next);
+			n++;
+		}
+	}
+	return n;
+}
+
+// =======================================================================
+
+void AtmTable::Init ()
+{
+	// Reference profiles at a few latitudes and local times. The step is
+	// halved while the interpolation error at the interval centre exceeds
+	// tol/2, and doubled while it is below tol/8.
+	static const int ncol = 6;
+	static const double clat[ncol] = {-1.0, -1.0, 0.0, 0.0, 1.0, 1.0};
+	static const double clst[ncol] = { 3.0, 15.0, 3.0, 15.0, 3.0, 15.0};
+	const double hmin = 100.0, hmax = 50e3; // step limits [m]
+	Prm p0[ncol], p1[ncol], pm, pi;
+	double a = altmin, h = 1e3;
+	int c;
+
+	for (c = 0; c < ncol; c++)
+		func (a, clat[c], clst[c], p0[c]);
+	alt.push_back (a);
+	while (a < altmax) {
+		h = std::min (h, altmax-a);
+		double err = 0.0;
+		for (c = 0; c < ncol; c++) {
+			func (a+h, clat[c], clst[c], p1[c]);
+			func (a+0.5*h, clat[c], clst[c], pm);
+			pi.T   = 0.5*(p0[c].T + p1[c].T);
+			pi.p   = sqrt (p0[c].p * p1[c].p);
+			pi.rho = sqrt (p0[c].rho * p1[c].rho);
+			err = std::max (err, RelErr (pi, pm));
+		}
+		if (err > 0.5*tol && h > hmin) {
+			h *= 0.5;
+			continue;
+		}
+		a = (h < altmax-a ? a+h : altmax);
+		alt.push_back (a);
+		for (c = 0; c < ncol; c++) p0[c] = p1[c];
+		if (err < 0.125*tol && h < hmax) h *= 2.0;
+	}
+	slice.reset (new Slice[alt.size()]);
+}
+
+// =======================================================================
+
+void AtmTable::Build (size_t k)
+{
+	Slice &s = slice[k];
+	Prm prm;
+	int i, j;
+
+	s.v.resize (3*nlat*nlst);
+	for (i = 0; i < nlat; i++) {
+		double lat = -0.5*PI + i*dlat;
+		for (j = 0; j < nlst; j++) {
+			func (alt[k], lat, j*dlst, prm);
+			double *v = Node (k, i, j);
+			v[0] = prm.T;
+			v[1] = log (std::max (prm.p, VMIN));
+			v[2] = log (std::max (prm.rho, VMIN));
+		}
+	}
+
+	// check the interpolation error at the cell centres along a diagonal
+	double err = 0.0;
+	for (j = 0; j < nlst; j++) {
+		i = j % (nlat-1);
+		func (alt[k], -0.5*PI + (i+0.5)*dlat, (j+0.5)*dlst, prm);
+		const double *v[4] = { Node (k, i, j), Node (k, i, (j+1)%nlst), Node (k, i+1, j), Node (k, i+1, (j+1)%nlst) };
+		Prm pi;
+		pi.T   = 0.25*(v[0][0] + v[1][0] + v[2][0] + v[3][0]);
+		pi.p   = exp (0.25*(v[0][1] + v[1][1] + v[2][1] + v[3][1]));
+		pi.rho = exp (0.25*(v[0][2] + v[1][2] + v[2][2] + v[3][2]));
+		err = std::max (err, RelErr (pi, prm));
+	}
+	s.exact = (err > 0.5*tol);
+	s.epoch = epoch;
+	s.used.store (false, std::memory_order_relaxed);
+	nbuild.fetch_add (1, std::memory_order_relaxed);
+}
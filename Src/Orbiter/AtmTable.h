@@ -0,0 +1,126 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// AtmTable:
+// Cache of the atmospheric parameters of an atmosphere model on a grid of
+// altitude x latitude x local solar time. Lookups interpolate trilinearly
+// between the 8 grid nodes surrounding the point (linearly in temperature
+// and in the logarithms of pressure and density), instead of evaluating
+// the model.
+//
+// Altitude nodes are placed adaptively when the table is first used, so
+// that the interpolation error at the centre of each altitude interval
+// stays below half the tolerance. Latitude and local time nodes are
+// evenly spaced. When a slice (one altitude node) is built, the error is
+// checked at a sample of latitude/local time cell centres. If it exceeds
+// the tolerance, lookups next to the slice fail and the caller must
+// evaluate the model directly.
+//
+// The model inputs that aren't grid axes (date, solar and geomagnetic
+// indices, and the residual dependence on universal time) are represented
+// by an epoch number. When the epoch changes, all slices are marked stale.
+// Stale slices remain in use until Refresh rebuilds them, so the cost of
+// an epoch change is spread over several calls. Slices that were never
+// built are built on first use.
+//
+// Lookups don't lock and may be called concurrently from any thread. A
+// lookup next to a slice that another thread is building fails, rather
+// than waiting for it. SetEpoch and Refresh modify the table and must not
+// overlap with lookups (the planet calls them in its update, before the
+// vessels are updated).
+// =======================================================================
+
+#ifndef __ATMTABLE_H
+#define __ATMTABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class AtmTable {
+public:
+	struct Prm {
+		double T;   // temperature [K]
+		double p;   // pressure [Pa]
+		double rho; // density [kg/m^3]
+	};
+
+	typedef std::function<void(double alt, double lat, double lst, Prm &prm)> EvalFunc;
+	// Exact model evaluation at altitude alt [m], latitude lat [rad]
+	// and local solar time lst [h]
+
+	AtmTable (EvalFunc func, double altmin, double altmax, double tol, int nlat = 37, int nlst = 48);
+	// func: model evaluation (must stay valid for the lifetime of the table)
+	// altmin, altmax: altitude range [m]
+	// tol: relative error bound for T, p and rho
+	// nlat: number of latitude nodes, from pole to pole
+	// nlst: number of local solar time nodes over 24 hours
+
+	bool Eval (double alt, double lat, double lst, Prm &prm);
+	// Interpolated parameters at altitude alt [m], latitude lat [rad] and
+	// local solar time lst [h]. Builds the required slices if necessary.
+	// Returns false if the point is outside the altitude range, in a cell
+	// that exceeds the error bound, or next to a slice that is being built
+	// by another thread.
+
+	bool SetEpoch (int64_t epoch);
+	// Set the current epoch number. Returns true if it has changed, in
+	// which case all slices become stale. Must not overlap with lookups.
+
+	int Refresh (int maxslice);
+	// Rebuild up to maxslice stale slices which have been used since the
+	// epoch changed. Returns the number of slices rebuilt. Must not overlap
+	// with lookups.
+
+	inline double Tolerance () const { return tol; }
+	// Relative error bound
+
+	inline size_t nAltNodes () const { return alt.size(); }
+	// Number of altitude nodes (0 before the first lookup)
+
+	inline size_t nBuilt () const { return nbuild; }
+	// Number of slice builds since construction
+
+	inline size_t nRejected () const { return nreject; }
+	// Number of lookups that failed the error bound
+
+private:
+	enum SliceState { EMPTY, BUILDING, BUILT };
+
+	struct Slice {
+		std::vector<double> v; // T, ln p and ln rho at each latitude/local time node
+		int64_t epoch;         // epoch the slice was built for
+		bool exact;            // interpolation error exceeds tol; don't use
+		std::atomic<int> state; // SliceState; v, epoch and exact are valid once BUILT
+		std::atomic<bool> used; // used since it was last built
+		Slice (): epoch(0), exact(false), state(EMPTY), used(false) {}
+	};
+
+	void Init ();
+	// Place the altitude nodes (once, on the first lookup)
+
+	void Build (size_t k);
+	// Build slice k for the current epoch
+
+	inline double *Node (size_t k, int i, int j)
+	{ return slice[k].v.data() + 3*(i*nlst + j); }
+
+	EvalFunc func;
+	double altmin, altmax;  // altitude range [m]
+	double tol;             // relative error bound
+	int nlat, nlst;         // number of latitude and local time nodes
+	double dlat, dlst;      // node spacing in latitude [rad] and local time [h]
+	std::vector<double> alt; // altitude nodes [m]
+	std::unique_ptr<Slice[]> slice; // one slice per altitude node
+	std::once_flag initFlag; // altitude nodes have been placed
+	size_t next;            // slice at which Refresh continues its search
+	int64_t epoch;          // current epoch
+	std::atomic<size_t> nbuild;  // slice builds
+	std::atomic<size_t> nreject; // lookups rejected by the error bound
+};
+
+#endif // !__ATMTABLE_H
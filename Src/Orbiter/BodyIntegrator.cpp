@@ -46,6 +46,10 @@
 #include "Log.h"
 #include <stdio.h>
 
+using std::min;
+using std::max;
+
+extern Orbiter *g_pOrbiter;
 extern TimeData td;
 extern char DBG_MSG[256];
 
@@ -146,6 +150,126 @@ static const double RK8_gamma[RK8_n] = {
 	0, 0, 0, 0, 0, 34.0/105.0, 9.0/35.0, 9.0/35.0, 9.0/280.0, 9.0/280.0, 0, 41.0/840.0, 41.0/840.0
 };
 
+// ---------------------------------------------------------------------------
+// Dormand-Prince 5(4) 7-stage embedded pair (adaptive propagator)
+// The first 6 stages and the 5th order weights are those of RK5. The 7th
+// stage is evaluated at the end of the step and is reused as the first
+// stage of the next step (FSAL).
+// ---------------------------------------------------------------------------
+
+static const int DP45_n = 7;
+static const double DP45_alpha[DP45_n-1] = {
+	1.0/5.0, 3.0/10.0, 4.0/5.0, 8.0/9.0, 1.0, 1.0
+};
+static const double DP45_beta[(DP45_n-1)*(DP45_n-1)] = {
+	1.0/5.0, 0, 0, 0, 0, 0,
+	3.0/40.0, 9.0/40.0, 0, 0, 0, 0,
+	44.0/45.0, -56.0/15.0, 32.0/9.0, 0, 0, 0,
+	19372.0/6561.0, -25360.0/2187.0, 64448.0/6561.0, -212.0/729.0, 0, 0,
+	9017.0/3168.0, -355.0/33.0, 46732.0/5247.0, 49.0/176.0, -5103.0/18656.0, 0,
+	35.0/384.0, 0, 500.0/1113.0, 125.0/192.0, -2187.0/6784.0, 11.0/84.0
+};
+static const double DP45_gamma[DP45_n] = {
+	35.0/384.0, 0, 500.0/1113.0, 125.0/192.0, -2187.0/6784.0, 11.0/84.0, 0
+};
+static const double DP45_err[DP45_n] = { // difference between 5th and 4th order weights
+	71.0/57600.0, 0, -71.0/16695.0, 71.0/1920.0, -17253.0/339200.0, 22.0/525.0, -1.0/40.0
+};
+static const double DP45_dense[DP45_n] = { // 4th order continuous extension (Hairer & Wanner)
+	-12715105075.0/11282082432.0, 0, 87487479700.0/32700410799.0, -10690763975.0/1880347072.0,
+	701980252875.0/199316789632.0, -1453857185.0/822651844.0, 69997945.0/29380423.0
+};
+
+// ===========================================================================
+// Symplectic integration parameters (SY4-SY8)
+// c: position drift fractions, d: velocity kick fractions
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+// SY4 parameters
+// ---------------------------------------------------------------------------
+
+static const double SY4_b  = 1.25992104989487319066654436028;      // 2^1/3
+static const double SY4_a  = 2 - SY4_b;
+static const double SY4_x0 = -SY4_b / SY4_a;
+static const double SY4_x1 = 1. / SY4_a;
+static const double SY4_d[3] = {SY4_x1, SY4_x0, SY4_x1};
+static const double SY4_c[4] = {SY4_x1/2, (SY4_x0+SY4_x1)/2, (SY4_x0+SY4_x1)/2, SY4_x1/2};
+
+// ---------------------------------------------------------------------------
+// SY6 parameters
+// ---------------------------------------------------------------------------
+
+static const double SY6_w1 = -0.117767998417887E1;
+static const double SY6_w2 = 0.235573213359357E0;
+static const double SY6_w3 = 0.784513610477560E0;
+static const double SY6_w0 = (1-2*(SY6_w1+SY6_w2+SY6_w3));
+static const double SY6_d[7] = { SY6_w3, SY6_w2, SY6_w1, SY6_w0, SY6_w1, SY6_w2, SY6_w3 };
+static const double SY6_c[8] = { SY6_w3/2, (SY6_w3+SY6_w2)/2, (SY6_w2+SY6_w1)/2, (SY6_w1+SY6_w0)/2,
+                                 (SY6_w1+SY6_w0)/2, (SY6_w2+SY6_w1)/2, (SY6_w3+SY6_w2)/2, SY6_w3/2 };
+
+// ---------------------------------------------------------------------------
+// SY8 parameters: set 3 from Yoshida's Table 2
+// ---------------------------------------------------------------------------
+
+static const double SY8_W1 =  0.311790812418427e0;
+static const double SY8_W2 = -0.155946803821447e1;
+static const double SY8_W3 = -0.167896928259640e1;
+static const double SY8_W4 =  0.166335809963315e1;
+static const double SY8_W5 = -0.106458714789183e1;
+static const double SY8_W6 =  0.136934946416871e1;
+static const double SY8_W7 =  0.629030650210433e0;
+static const double SY8_W0 = (1-2*(SY8_W1+SY8_W2+SY8_W3+SY8_W4+SY8_W5+SY8_W6+SY8_W7));
+static const double SY8_d[15] = { SY8_W7, SY8_W6, SY8_W5, SY8_W4, SY8_W3, SY8_W2, SY8_W1, SY8_W0,
+                                  SY8_W1, SY8_W2, SY8_W3, SY8_W4, SY8_W5, SY8_W6, SY8_W7 };
+static const double SY8_c[16] = { SY8_W7/2, (SY8_W7+SY8_W6)/2, (SY8_W6+SY8_W5)/2, (SY8_W5+SY8_W4)/2,
+                                  (SY8_W4+SY8_W3)/2, (SY8_W3+SY8_W2)/2, (SY8_W2+SY8_W1)/2, (SY8_W1+SY8_W0)/2,
+                                  (SY8_W1+SY8_W0)/2, (SY8_W2+SY8_W1)/2, (SY8_W3+SY8_W2)/2, (SY8_W4+SY8_W3)/2,
+                                  (SY8_W5+SY8_W4)/2, (SY8_W6+SY8_W5)/2, (SY8_W7+SY8_W6)/2,  SY8_W7/2 };
+
+// ===========================================================================
+// Stage sample times of the fixed-step propagators
+// ===========================================================================
+
+static void RKStageFractions (int n, const double *alpha, int nsub, int isub, std::vector<double> &frac)
+{
+	for (int i = 1; i < n; i++)
+		frac.push_back ((isub+alpha[i-1])/nsub);
+}
+
+static void SYStageFractions (int n, const double *c, int nsub, int isub, std::vector<double> &frac)
+{
+	double sec = 0.0;
+	for (int i = 0; i < n-1; i++) {
+		sec += c[i];
+		frac.push_back ((isub+sec)/nsub);
+	}
+}
+
+void RigidBody::StageFractions_LinAng (int propidx, int nsub, std::vector<double> &frac)
+{
+	// Note: the fractions must be computed with the same expressions as the
+	// time arguments of GetIntermediateMoments in the propagators, so that
+	// cached intermediate states are matched exactly
+	for (int isub = 0; isub < nsub; isub++) {
+		switch (propidx) {
+		case PROP_RK2:
+		case PROP_RK4:
+		case PROP_SY2:
+			frac.push_back ((isub+0.5)/nsub);
+			break;
+		case PROP_RK5: RKStageFractions (RK5_n, RK5_alpha, nsub, isub, frac); break;
+		case PROP_RK6: RKStageFractions (RK6_n, RK6_alpha, nsub, isub, frac); break;
+		case PROP_RK7: RKStageFractions (RK7_n, RK7_alpha, nsub, isub, frac); break;
+		case PROP_RK8: RKStageFractions (RK8_n, RK8_alpha, nsub, isub, frac); break;
+		case PROP_SY4: SYStageFractions (4, SY4_c, nsub, isub, frac); break;
+		case PROP_SY6: SYStageFractions (8, SY6_c, nsub, isub, frac); break;
+		case PROP_SY8: SYStageFractions (16, SY8_c, nsub, isub, frac); break;
+		}
+		frac.push_back ((isub+1.0)/nsub); // end of substep (IntegrateUpdate)
+	}
+}
+
 // ===========================================================================
 // Propagators for linear and angular state vectors combined
 // ===========================================================================
@@ -213,27 +337,18 @@ void RigidBody::RK4_LinAng (double h, int nsub, int isub)
 
 // ---------------------------------------------------------------------------
 // Driver routine for Runge-Kutta solvers RK5-RK8 (linear+angular)
-// Note: NOT THREADSAFE
+// Stage buffers are local, so vessels can be propagated concurrently.
 // ---------------------------------------------------------------------------
 
 void RigidBody::RKdrv_LinAng (double h, int nsub, int isub, int n, const double *alpha, const double *beta, const double *gamma)
 {
 	int i, j;
 	double bh;
-	static int nbuf = 8;
-	static StateVectors *s = new StateVectors[nbuf]; TRACENEW
-	static Vector *a       = new Vector[nbuf]; TRACENEW  // linear acceleration
-	static Vector *d       = new Vector[nbuf]; TRACENEW  // angular acceleration
+	StateVectors s[RK8_n];
+	Vector a[RK8_n];  // linear acceleration
+	Vector d[RK8_n];  // angular acceleration
 	Vector tau;
-	if (n > nbuf) { // grow buffers
-		delete []s;
-		delete []a;
-		delete []d;
-		s = new StateVectors[n]; TRACENEW
-		a = new Vector[n]; TRACENEW
-		d = new Vector[n]; TRACENEW
-		nbuf = n;
-	}
+	dASSERT(n <= RK8_n, "RKdrv_LinAng: too many stages");
 
 	s[0].Set (s1->vel, s1->pos, s1->omega, s1->Q);
 	a[0].Set (acc);
@@ -293,6 +408,110 @@ void RigidBody::RK8_LinAng (double h, int nsub, int isub)
 }
 
 
+// ---------------------------------------------------------------------------
+// Adaptive Dormand-Prince 5(4) Runge-Kutta (linear+angular)
+// Divides the step into substeps whose length is controlled by the local
+// error estimate of the embedded 4th order solution. The error of position
+// and velocity is measured relative to the state with respect to the
+// reference body. The substep length is carried over to the next step.
+// Dense output coefficients of the accepted substeps are stored for
+// intermediate state queries (see DenseState).
+// ---------------------------------------------------------------------------
+
+void RigidBody::RK45_LinAng (double h, int nsub, int isub)
+{
+	const int nmax = 1000;    // substep limit per step
+	const double hmin = h*1e-6;
+	int i, j, nrej = 0;
+	double t = 0.0, bh;
+	StateVectors s[DP45_n];
+	Vector a[DP45_n];  // linear acceleration
+	Vector d[DP45_n];  // angular acceleration
+	Vector tau, ep, ev;
+
+	double tol = (propTol > 0.0 ? propTol : g_pOrbiter->Cfg()->CfgPhysicsPrm.PropTol);
+	double ptol = tol * max (cpos.length(), 1.0);
+	double vtol = tol * max (cvel.length(), 1.0);
+	double hs = (hAdapt > 0.0 ? min (hAdapt, h) : h/PropSubMax);
+	double t0 = td.SimT0 + isub*h;
+
+	dense.clear();
+	a[0].Set (acc);
+	d[0].Set (arot);
+
+	while (t < h) {
+		bool last = (t + hs >= h*(1.0-1e-10));
+		double hstep = (last ? h-t : hs);
+		const double *beta = DP45_beta;
+
+		s[0].Set (s1->vel, s1->pos, s1->omega, s1->Q);
+		for (i = 1; i < DP45_n; i++) {
+			s[i].Set (s1->vel, s1->pos, s1->omega, s1->Q);
+			for (j = 0; j < i; j++)
+				s[i].Advance (beta[j]*hstep, a[j], s[j].vel, d[j], s[j].omega);
+			GetIntermediateMoments (a[i], tau, s[i], (isub+(t+DP45_alpha[i-1]*hstep)/h)/nsub, hstep);
+			d[i].Set (EulerInv_full (tau, s[i].omega));
+			beta += DP45_n-1;
+		}
+
+		// local error estimate
+		ep.Set (0,0,0);
+		ev.Set (0,0,0);
+		for (i = 0; i < DP45_n; i++) {
+			bh = DP45_err[i]*hstep;
+			ep += s[i].vel * bh;
+			ev += a[i]     * bh;
+		}
+		double err = max (ep.length()/ptol, ev.length()/vtol);
+		double fac = (err > 1e-10 ? 0.9*pow (err, -0.2) : 5.0);
+		fac = max (0.2, min (5.0, fac));
+
+		if (err > 1.0 && hstep > hmin && (int)dense.size() + nrej < nmax) {
+			hs = hstep*fac; // reject and retry with a shorter substep
+			nrej++;
+			continue;
+		}
+
+		// dense output
+		DenseSeg seg;
+		seg.t0 = t0 + t;
+		seg.h = hstep;
+		seg.rp[0] = s[0].pos,  seg.rv[0] = s[0].vel;
+		seg.rp[1] = s[DP45_n-1].pos - s[0].pos;
+		seg.rv[1] = s[DP45_n-1].vel - s[0].vel;
+		seg.rp[2] = s[0].vel*hstep - seg.rp[1];
+		seg.rv[2] = a[0]*hstep - seg.rv[1];
+		seg.rp[3] = seg.rp[1] - s[DP45_n-1].vel*hstep - seg.rp[2];
+		seg.rv[3] = seg.rv[1] - a[DP45_n-1]*hstep - seg.rv[2];
+		seg.rp[4].Set (0,0,0);
+		seg.rv[4].Set (0,0,0);
+		for (i = 0; i < DP45_n; i++) {
+			bh = DP45_dense[i]*hstep;
+			seg.rp[4] += s[i].vel * bh;
+			seg.rv[4] += a[i]     * bh;
+		}
+		dense.push_back (seg);
+
+		// accept the substep
+		for (i = 0; i < DP45_n; i++) {
+			bh = DP45_gamma[i]*hstep;
+			rvel_add += a[i]       * bh;
+			rpos_add += s[i].vel   * bh;
+			s1->Q.Rotate (s[i].omega * bh);
+			s1->omega += d[i]      * bh;
+		}
+		s1->pos = rpos_base + rpos_add;
+		s1->vel = rvel_base + rvel_add;
+		a[0].Set (a[DP45_n-1]);
+		d[0].Set (d[DP45_n-1]);
+		t += hstep;
+
+		if (!last || hstep >= hs) hs = hstep*fac;
+		if (last) break;
+	}
+	hAdapt = hs;
+}
+
 // ---------------------------------------------------------------------------
 // 2nd order symplectic propagator (linear+angular)
 // Note: the propagation of angular state is guesswork ...
@@ -323,12 +542,7 @@ void RigidBody::SY4_LinAng (double h, int nsub, int isub)
 {
 	int i;
 	double sec = 0.0;
-	static const double b = 1.25992104989487319066654436028;      // 2^1/3
-	static const double a = 2 - b;
-	static const double x0 = -b / a;
-	static const double x1 = 1. / a;
-	static const double d4[3] = {x1, x0, x1};
-	static const double c4[4] = {x1/2, (x0+x1)/2, (x0+x1)/2, x1/2};
+	const double *c4 = SY4_c, *d4 = SY4_d;
 	StateVectors s;
 	Vector tau;
 
@@ -356,13 +570,7 @@ void RigidBody::SY6_LinAng (double h, int nsub, int isub)
 {
 	int i;
 	double sec = 0.0;
-	static const double w1 = -0.117767998417887E1;
-	static const double w2 = 0.235573213359357E0;
-	static const double w3 = 0.784513610477560E0;
-	static const double w0 = (1-2*(w1+w2+w3));
-	static const double d6[7] = { w3, w2, w1, w0, w1, w2, w3 };
-	static const double c6[8] = { w3/2, (w3+w2)/2, (w2+w1)/2, (w1+w0)/2,
-                         (w1+w0)/2, (w2+w1)/2, (w3+w2)/2, w3/2 };
+	const double *c6 = SY6_c, *d6 = SY6_d;
 	StateVectors s;
 	Vector tau;
 
@@ -390,22 +598,7 @@ void RigidBody::SY8_LinAng (double h, int nsub, int isub)
 {
 	int i;
 	double sec = 0.0;
-	// set 3 from Yoshida's Table 2
-	const double W1 =  0.311790812418427e0;
-	const double W2 = -0.155946803821447e1;
-	const double W3 = -0.167896928259640e1;
-	const double W4 =  0.166335809963315e1;
-	const double W5 = -0.106458714789183e1;
-	const double W6 =  0.136934946416871e1;
-	const double W7 =  0.629030650210433e0;
-	const double W0 = (1-2*(W1+W2+W3+W4+W5+W6+W7));
-
-	const static double d8[15] = {W7, W6, W5, W4, W3, W2, W1, W0,
-		                          W1, W2, W3, W4, W5, W6, W7};
-	const static double c8[16] = { W7/2, (W7+W6)/2, (W6+W5)/2, (W5+W4)/2,
-                         (W4+W3)/2, (W3+W2)/2, (W2+W1)/2, (W1+W0)/2,
-                         (W1+W0)/2, (W2+W1)/2, (W3+W2)/2, (W4+W3)/2,
-                         (W5+W4)/2, (W6+W5)/2, (W7+W6)/2,  W7/2 };
+	const double *c8 = SY8_c, *d8 = SY8_d;
 	StateVectors s;
 	Vector tau;
 
@@ -490,23 +683,15 @@ void RigidBody::RK4_Pert (const PertIntData &data)
 
 // ---------------------------------------------------------------------------
 // Driver routine for Runge-Kutta solvers RK5-RK8 (perturbation)
-// Note: NOT THREADSAFE
+// Stage buffers are local, so vessels can be propagated concurrently.
 // ---------------------------------------------------------------------------
 
 void RigidBody::RKdrv_Pert (const PertIntData &data, int n, const double *alpha, const double *beta, const double *gamma)
 {
 	int i, j;
-	static int nbuf = 8;
-
-	static Vector *v = new Vector[nbuf];
-	static Vector *a = new Vector[nbuf];
-	if (n > nbuf) { // grow buffers
-		delete []v;
-		delete []a;
-		v = new Vector[n]; TRACENEW
-		a = new Vector[n]; TRACENEW
-		nbuf = n;
-	}
+	Vector v[RK8_n];
+	Vector a[RK8_n];
+	dASSERT(n <= RK8_n, "RKdrv_Pert: too many stages");
 	Vector pos, vtmp;
 	v[0] = data.dv;
 	a[0] = GetPertAcc (data, data.p0, 0.0);
@@ -5,10 +5,14 @@
 #define OAPI_IMPLEMENTATION
 
 #include "CelSphereAPI.h"
+#include "StarCatalogue.h"
 #include "Orbiter.h"
 #include "Psys.h"
 #include "Mesh.h"
 #include "Log.h"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 using std::min;
 using std::max;
@@ -16,6 +20,11 @@ using std::max;
 extern Orbiter* g_pOrbiter;
 extern PlanetarySystem* g_psys;
 
+// Star catalogues of the celestial sphere instances. Kept outside the class,
+// whose layout is part of the graphics client ABI.
+static std::unordered_map<const oapi::CelestialSphere*, std::unique_ptr<StarCatalogue>> g_starCat;
+static std::mutex g_starCatMutex;
+
 // ==============================================================
 
 oapi::CelestialSphere::CelestialSphere(oapi::GraphicsClient* gc)
@@ -47,6 +56,9 @@ oapi::CelestialSphere::~CelestialSphere()
 
 	if (m_meshGridLabel)
 		delete (Mesh*)m_meshGridLabel;
+
+	std::lock_guard<std::mutex> lock(g_starCatMutex);
+	g_starCat.erase(this);
 }
 
 // --------------------------------------------------------------
@@ -56,8 +68,23 @@ const std::vector<oapi::CelestialSphere::StarRenderRec> oapi::CelestialSphere::L
 	// User settings for star rendering
 	StarRenderPrm* prm = (StarRenderPrm*)m_gc->GetConfigParam(CFGPRM_STARRENDERPRM);
 
-	// Read the star database and convert to render parameters
-	return StarData2RenderData(LoadStarData(prm->mag_lo), *prm);
+	// Extract the stars up to the magnitude limit and convert to render parameters
+	std::vector<const StarCatRec*> rec;
+	if (const StarCatalogue* cat = StarCat())
+		cat->Query(prm->mag_lo, rec);
+	return StarData2RenderData(rec, *prm);
+}
+
+// --------------------------------------------------------------
+
+const std::vector<oapi::CelestialSphere::StarRenderRec> oapi::CelestialSphere::LoadStars(const VECTOR3& dir, double radius, double maxAppMag) const
+{
+	StarRenderPrm* prm = (StarRenderPrm*)m_gc->GetConfigParam(CFGPRM_STARRENDERPRM);
+
+	std::vector<const StarCatRec*> rec;
+	if (const StarCatalogue* cat = StarCat())
+		cat->Query(&dir.x, radius, maxAppMag, rec);
+	return StarData2RenderData(rec, *prm);
 }
 
 // --------------------------------------------------------------
@@ -162,54 +189,36 @@ oapi::FVECTOR4 oapi::CelestialSphere::MarkerColorFloat(DWORD idx) const
 
 // --------------------------------------------------------------
 
-const std::vector<oapi::CelestialSphere::StarDataRec> oapi::CelestialSphere::LoadStarData(double maxAppMag) const
+const StarCatalogue* oapi::CelestialSphere::StarCat() const
 {
-#pragma pack(push,1)
-	struct StarDataRecPacked { // packed version for reading from binary file
-		float lng;
-		float lat;
-		float mag;
-		WORD specidx;
-	};
-#pragma pack(pop)
+	std::lock_guard<std::mutex> lock(g_starCatMutex);
+	std::unique_ptr<StarCatalogue>& cat = g_starCat[this];
+	if (!cat) {
+		cat.reset(new StarCatalogue);
 
-	std::vector<StarDataRec> rec;
+		// indexed catalogue file
+		std::string fname = m_dataDir + std::string("star.cat");
+		if (cat->Open(fname.c_str())) {
+			LOGOUT("Mapped %d records from star catalogue", cat->Count());
+			return cat.get();
+		}
 
-	std::string fname = m_dataDir + std::string("star.bin");
-	FILE* f = fopen(fname.c_str(), "rb");
-	if (f) {
-		const int chunksize = 0x1000;
-		StarDataRecPacked* packBuf = new StarDataRecPacked[chunksize + 1]; // "+1": padding for avoiding reading out of bounds on packed data
-		int i, s, n = 0;
-		rec.resize(0x20000); // should be large enough to hold the entire Hipparcos list
-		while (s = fread(packBuf, sizeof(StarDataRecPacked), chunksize, f)) {
-			for (i = 0; i < s && packBuf[i].mag < maxAppMag; i++, n++) {
-				rec[n].lng = (double)packBuf[i].lng;
-				rec[n].lat = (double)packBuf[i].lat;
-				rec[n].mag = (double)packBuf[i].mag;
-				rec[n].specidx = packBuf[i].specidx;
-			}
-			if (i < s)
-				break;
-			if (rec.size() < n + chunksize) // should not happen, but just in case we are reading a larger dataset
-				rec.resize(n + chunksize);
+		// otherwise index the star database in memory
+		std::vector<StarBinRec> src;
+		fname = m_dataDir + std::string("star.bin");
+		if (StarCatalogue::ReadStarBin(fname.c_str(), src) && cat->Create(src)) {
+			LOGOUT("Loaded %d records from star database", cat->Count());
+		}
+		else {
+			LOGOUT_WARN("Star data base for celestial sphere (%s) not found. Disabling background stars.", fname.c_str());
 		}
-		delete[]packBuf;
-		fclose(f);
-		rec.resize(n);
-		rec.shrink_to_fit();
-		LOGOUT("Loaded %d records from star database", n);
-	}
-	else {
-		LOGOUT_WARN("Star data base for celestial sphere (%s) not found. Disabling background stars.", fname.c_str());
 	}
-	return rec;
-
+	return (cat->IsOpen() ? cat.get() : 0);
 }
 
 // --------------------------------------------------------------
 
-const std::vector<oapi::CelestialSphere::StarRenderRec> oapi::CelestialSphere::StarData2RenderData(const std::vector<oapi::CelestialSphere::StarDataRec>& starDataRec, const StarRenderPrm& prm) const
+const std::vector<oapi::CelestialSphere::StarRenderRec> oapi::CelestialSphere::StarData2RenderData(const std::vector<const StarCatRec*>& starCatRec, const StarRenderPrm& prm) const
 {
 	std::vector<StarRenderRec> starRenderRec;
 	double a, b, c;
@@ -227,16 +236,12 @@ const std::vector<oapi::CelestialSphere::StarRenderRec> oapi::CelestialSphere::S
 		b = prm.brt_min - prm.mag_lo * a;
 	}
 
-	starRenderRec.resize(starDataRec.size());
-	for (size_t i = 0; i < starDataRec.size(); i++) {
-		const StarDataRec& rec = starDataRec[i];
+	starRenderRec.resize(starCatRec.size());
+	for (size_t i = 0; i < starCatRec.size(); i++) {
+		const StarCatRec& rec = *starCatRec[i];
 
 		// position
-		double rlat = rec.lat, rlng = rec.lng;
-		double xz = cos(rlat);
-		starRenderRec[i].pos.x = xz * cos(rlng);
-		starRenderRec[i].pos.z = xz * sin(rlng);
-		starRenderRec[i].pos.y = sin(rlat);
+		starRenderRec[i].pos = _V(rec.x, rec.y, rec.z);
 
 		// brightness from apparent magnitude
 		if (prm.map_log)
@@ -16,6 +16,7 @@
 #include "Log.h"
 #include "Orbitersdk.h"
 #include "PinesGrav.h"
+#include <algorithm>
 
 using namespace std;
 
@@ -36,6 +37,8 @@ CelestialBody::CelestialBody (double _mass, double _size)
 	el = new Elements; TRACENEW
 	ClearModule();
 	usePinesGravity = false;
+	gravgrid = NULL;
+	gravgridfile[0] = '\0';
 }
 
 CelestialBody::CelestialBody (char *fname)
@@ -44,6 +47,8 @@ CelestialBody::CelestialBody (char *fname)
 	char cbuf[256];
 	int gravcoeff = 0;
 	usePinesGravity = false;
+	gravgrid = NULL;
+	gravgridfile[0] = '\0';
 
 	DefaultParam ();
 	ClearModule ();
@@ -53,6 +58,7 @@ CelestialBody::CelestialBody (char *fname)
 		LOGOUT_ERR_FILENOTFOUND_MSG(g_pOrbiter->ConfigPath (fname), "while initialising celestial body");
 		g_pOrbiter->TerminateOnError();
 	}
+	IndexItems (ifs);
 
 	if (GetItemString (ifs, "Module", cbuf))
 		RegisterModule (cbuf);
@@ -103,6 +109,23 @@ CelestialBody::CelestialBody (char *fname)
 
 		if (readResult == 0) {
 			usePinesGravity = true;
+
+			// optional cache of the perturbation field
+			int samples = 0;
+			double maxalt = 500e3, maxmem = 512.0;
+			if (GetItemInt(ifs, "GravGridSamples", samples) && samples > 0) {
+				GetItemReal(ifs, "GravGridMaxAlt", maxalt);
+				GetItemReal(ifs, "GravGridMaxMem", maxmem);
+				gravgrid = new GravGrid(&pinesgrav, samples, maxalt*1e-3, (size_t)(maxmem*1024.0*1024.0)); TRACENEW
+				if (GetItemString(ifs, "GravGridFile", cbuf)) {
+					sprintf(gravgridfile, "GravityModels\\%s", cbuf);
+					gravgrid->Load(gravgridfile);
+				}
+				char logbuff[512];
+				sprintf(logbuff, "GRAVITY MODEL: Perturbation grid enabled, node spacing %0.2f km, interpolation error < %0.1e of the degree %d perturbation",
+					gravgrid->NodeSpacing(), gravgrid->ErrorBound(), gravgrid->Degree());
+				LOGOUT(logbuff);
+			}
 		}
 	}
 
@@ -157,6 +180,11 @@ CelestialBody::CelestialBody (char *fname)
 CelestialBody::~CelestialBody ()
 {
 	ClearModule();
+	if (gravgrid) {
+		if (gravgridfile[0] && gravgrid->nBuilt())
+			gravgrid->Save(gravgridfile);
+		delete gravgrid;
+	}
 	if (nsecondary) {
 		delete []secondary;
 		secondary = NULL;
@@ -165,10 +193,17 @@ CelestialBody::~CelestialBody ()
 		delete []jcoeff;
 		jcoeff = NULL;
 	}
+	if (nstagereq) {
+		LOGOUT_FINE("Intermediate states [%s]: %llu requests, %llu from stage cache, %llu interpolated", Name(),
+			(unsigned long long)nstagereq, (unsigned long long)nstagehit, (unsigned long long)nstagedirect);
+	}
 }
 
 void CelestialBody::DefaultParam ()
 {
+	stagefrac         = 0;     // no cached intermediate states
+	nstageslot        = 0;
+	nstagereq = nstagehit = nstagedirect = 0;
 	eps_ref           = 0.0;   // precession reference is ecliptic normal
 	lan_ref           = 0.0;
 	eps_rel           = 0.0;   // obliquity of axis against reference
@@ -642,11 +677,20 @@ bool CelestialBody::PosVelAtTime (double t, Vector *p, Vector *v) const
 
 Vector CelestialBody::InterpolatePosition (double n) const
 {
-	// Interpolate global position of body by iterative bisection
-
 	if      (n == 0)   return s0->pos;
 	else if (n == 1.0) return s1->pos;
 
+	nstagereq.fetch_add (1, std::memory_order_relaxed);
+	if (const StateVectors *sv = StageState (n))
+		return sv->pos;
+	return InterpolatePositionDirect (n);
+}
+
+Vector CelestialBody::InterpolatePositionDirect (double n) const
+{
+	// Interpolate global position of body by iterative bisection
+	nstagedirect.fetch_add (1, std::memory_order_relaxed);
+
 	Vector refp0, refp1, refpm;
 	const CelestialBody *ref = ElRef();
 	if (ref) {
@@ -701,9 +745,16 @@ StateVectors CelestialBody::InterpolateState (double n) const
 	if (!n) return *s0;
 	dCHECK(s1, "Update state not available")
 	if (n == 1.0) return *s1;
+	nstagereq.fetch_add (1, std::memory_order_relaxed);
+	if (const StateVectors *cached = StageState (n))
+		return *cached;
+	return InterpolateStateDirect (n);
+}
 
+StateVectors CelestialBody::InterpolateStateDirect (double n) const
+{
 	StateVectors sv;
-	sv.pos = InterpolatePosition (n);
+	sv.pos = InterpolatePositionDirect (n);
 	sv.vel = s0->vel*(1.0-n) + s1->vel*n; // may need a better interpolation
 	GetRotation (td.SimT0 + td.SimDT*n, sv.R);
 	sv.Q.Set (sv.R);
@@ -711,6 +762,40 @@ StateVectors CelestialBody::InterpolateState (double n) const
 	return sv;
 }
 
+void CelestialBody::SetStageCache (const std::vector<double> *frac)
+{
+	// The states are computed on demand, so that only those of the bodies
+	// and stage times actually used by the vessel propagators are evaluated
+	stagefrac = frac;
+	if (frac) {
+		size_t n = frac->size();
+		if (n > nstageslot) {
+			stagestate.reset (new StageSlot[n]);
+			nstageslot = n;
+		}
+		for (size_t i = 0; i < n; i++)
+			stagestate[i].state.store (STAGE_EMPTY, std::memory_order_relaxed);
+	}
+}
+
+const StateVectors *CelestialBody::StageState (double n) const
+{
+	if (!stagefrac) return 0;
+	auto it = std::lower_bound (stagefrac->begin(), stagefrac->end(), n);
+	if (it == stagefrac->end() || *it != n) return 0;
+
+	StageSlot &slot = stagestate[it - stagefrac->begin()];
+	int state = slot.state.load (std::memory_order_acquire);
+	if (state == STAGE_EMPTY && slot.state.compare_exchange_strong (state, STAGE_BUSY, std::memory_order_acquire)) {
+		slot.sv = InterpolateStateDirect (n);
+		slot.state.store (STAGE_VALID, std::memory_order_release);
+		return &slot.sv;
+	}
+	if (state != STAGE_VALID) return 0;
+	nstagehit.fetch_add (1, std::memory_order_relaxed);
+	return &slot.sv;
+}
+
 void CelestialBody::RegisterModule (char *dllname)
 {
 	char cbuf[256];
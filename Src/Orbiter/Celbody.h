@@ -12,6 +12,10 @@
 #include "RigidBody.h"
 #include "OrbiterAPI.h"
 #include "PinesGrav.h"
+#include "GravGrid.h"
+#include <atomic>
+#include <memory>
+#include <vector>
 
 // Module interface methods - OBSOLETE
 typedef void   (*OPLANET_SetPrecision)(double prec);
@@ -112,6 +116,14 @@ public:
 	// Note: This function can only be called during the state calculation phase, after
 	// s1 has been evaluated, but before it is copied back to s0
 
+	void SetStageCache (const std::vector<double> *frac);
+	// Cache the intermediate states at the sorted fractional step times *frac
+	// for InterpolatePosition and InterpolateState. Each state is computed on
+	// its first request and reused afterwards; a request for a state that
+	// another thread is computing interpolates directly. frac must remain
+	// valid until the cache is released with SetStageCache(0) before the end
+	// of the update phase.
+
 	const Vector &Barycentre () const { return bpos; }
 	// Returns position of barycentre (planet + secondaries)
 
@@ -123,9 +135,19 @@ public:
 
 	// returns true if the body uses Pines Algorithm to calculate gravitational acceleration from spherical harmonics
 	inline bool usePines() const { return usePinesGravity; }
-	inline Vector pinesAccel(const Vector rposmax, const int maxDegree, const int maxOrder){
+	inline Vector pinesAccel(const Vector rposmax, const int maxDegree, const int maxOrder) const {
+		Vector acc;
+		if (gravgrid && maxDegree == gravgrid->Degree() && maxOrder == maxDegree && gravgrid->Eval(rposmax, acc))
+			return acc;
 		return pinesgrav.GetPinesGrav(rposmax, maxDegree, maxOrder);
 	}
+	// Perturbation acceleration at rposmax (planet frame, right-handed, km). Uses the
+	// cached perturbation grid if enabled and rposmax is covered, otherwise the model.
+	inline void pinesAccelBatch(const Vector *rpos, Vector *acc, int npos, const int maxDegree, const int maxOrder, PinesGravProp::Workspace &ws) const {
+		pinesgrav.GetPinesGravBatch(rpos, acc, npos, maxDegree, maxOrder, ws);
+	}
+	// Perturbation accelerations for npos positions (planet frame, right-handed, km) in one pass.
+	// Each caller provides its own workspace, so evaluations can run concurrently.
 	inline unsigned int GetPinesCutoff() const {
 		return pinesgrav.GetCoeffCutoff(); 
 	}
@@ -223,10 +245,33 @@ private:
 
 	PinesGravProp pinesgrav; // coefficients and methods for calculating non-spherical gravity vectors using Pines Algorithm
 	bool usePinesGravity;    // use Pines Algorithm if true, if false use the older jcoeff method
+	GravGrid *gravgrid;      // cached perturbation grid for the Pines model, or NULL if disabled
+	char gravgridfile[256];  // file for storing the grid tiles between sessions (empty: none)
 
 	Vector bpos, bvel;       // object's barycentre state (the barycentre of the set of bodies including *this and its children) with respect to the true position of the parent of *this
 	Vector bposofs, bvelofs; // body barycentre state - true state
 	bool ephem_parentbary;   // true if body calculates its state with respect to the parent barycentre, false if with respect to parent's true position
+
+	Vector InterpolatePositionDirect (double n) const;
+	StateVectors InterpolateStateDirect (double n) const;
+	// InterpolatePosition and InterpolateState without the stage cache
+
+	const StateVectors *StageState (double n) const;
+	// cached intermediate state at fractional step time n, computed on first
+	// request, or NULL if n is not cached or the state is being computed by
+	// another thread
+
+	enum { STAGE_EMPTY, STAGE_BUSY, STAGE_VALID };
+	struct StageSlot {
+		StateVectors sv;         // intermediate state
+		std::atomic<int> state;  // STAGE_xxx; sv is valid once STAGE_VALID
+	};
+	const std::vector<double> *stagefrac;  // fractional step times of the cached intermediate states (NULL: no cache)
+	std::unique_ptr<StageSlot[]> stagestate; // cached intermediate states
+	size_t nstageslot;                     // allocated length of stagestate
+	mutable std::atomic<size_t> nstagereq, nstagehit, nstagedirect;
+	// intermediate state requests, those served from the stage cache, and
+	// interpolations actually computed (including those filling the cache)
 };
 
 #endif
\ No newline at end of file
@@ -59,8 +59,13 @@ CFG_PHYSICSPRM CfgPhysicsPrm_default = {
 	{1.0*RAD, 4.0*RAD, 10.0*RAD, 1e10, 1e10},		// PropALimit (angle limits for angular propagation levels)
 	20.0*RAD,	// APropSubLimit (angle step limit for angular subsampling)
 	10, 		// PropSubMax (max number of subsampling steps)
+	1e-9,		// PropTol (relative error tolerance for adaptive propagation)
 	30.0*RAD,	// APropCouplingLimit (angle step limit for cross term suppresion)
-	3600.0*RAD	// APropTorqueLimit (angle step limit for torque suppression)
+	3600.0*RAD,	// APropTorqueLimit (angle step limit for torque suppression)
+	0,			// nUpdateThreads (propagate vessels on the main thread)
+	false,		// bOnRails (always integrate vessel states numerically)
+	1e5,		// OnRailsDist (min. distance to other vessels for on-rails propagation)
+	1e4			// OnRailsAlt (min. periapsis altitude for on-rails propagation)
 };
 
 CFG_LOGICPRM CfgLogicPrm_default = {
@@ -158,7 +163,9 @@ CFG_PLANETRENDERPRM CfgPRenderPrm_default = {
 	5,          // patch mesh resolution power
 	50,			// load frequency (Hz)
 	3,			// aniso mode (1=none)
-	0x0003      // TileLoadFlags (load from individual tile files + compressed archives)
+	0x0003,     // TileLoadFlags (load from individual tile files + compressed archives)
+	64,         // ElevCacheSize (64 MB, about 480 elevation tiles)
+	10.0        // ElevPrefetchTime (prefetch tiles needed within the next 10 seconds)
 };
 
 CFG_MAPPRM CfgMapPrm_default = {
@@ -174,7 +181,9 @@ CFG_RECPLAYPRM CfgRecPlayPrm_default = {
 	true,		// bReplayFocus (replay focus events?)
 	true,		// bReplayCam (replay camera events?)
 	true,		// bSysInterval (use system time for sampling intervals?)
-	true		// bShowNotes (show playback onscreen annotations?)
+	true,		// bShowNotes (show playback onscreen annotations?)
+	false,		// bRecordBinary (write binary position/attitude streams?)
+	true		// bMappedPlayback (play back from memory-mapped streams?)
 };
 
 CFG_DEVPRM CfgDevPrm_default = {
@@ -250,6 +259,8 @@ CFG_CMDLINEPRM CfgCmdlinePrm_default = {
 	0.0,                // fixed time step length (0 = disabled)
 	0.0,                // Max sys time (0 = unlimited)
 	0.0,                // Max sim time (0 = unlimited)
+	-1,                 // vessel update threads (-1 = use physics parameter)
+	-1,                 // on-rails propagation (-1 = use physics parameter)
 	std::string(),      // launch scenario (empty: open Launchpad dialog)
 	std::list<std::string>() // list of plugins to load
 };
@@ -287,168 +298,6 @@ const char *BoolStr (bool cond)
 	return (cond ? Tstr : Fstr);
 }
 
-char *trim_string (char *cbuf)
-{
-	char *c;
-
-	// strip comments starting with ';'
-	for (c = cbuf; *c; c++) {
-		if (*c == ';') {
-			*c = '\0';
-			break;
-		}
-	}
-	// strip trailing white space
-	for (--c; c >= cbuf; c--) {
-		if (*c == ' ' || *c == '\t') *c = '\0';
-		else break;
-	}
-	// skip leading white space
-	for (c = cbuf; *c; c++)
-		if (*c != ' ' && *c != '\t') return c;
-
-	// should never get here
-	return c;
-}
-
-char *readline (istream &is)
-{
-	const int inc = 256;
-	static int len = 256;
-	static char *cbuf = new char[len];
-
-	char *c = cbuf;
-	cbuf[0] = '\0';
-	int chunk = len;
-	for (;;) {
-		if (is.getline (c, chunk)) return cbuf;
-		else if (is.eof()) return 0;
-		else { // buffer too small
-			char *tmp = new char[len+inc];
-			memcpy (tmp, cbuf, len-1);
-			delete []cbuf;
-			cbuf = tmp;
-			c = cbuf+len-1;
-			len += inc;
-			chunk = inc+1;
-		}
-		is.clear();
-	}
-	return 0; // never gets here
-}
-
-bool GetItemString (istream &is, const char *label, char *val)
-{
-	char cbuf[512], *cl, *cv;
-	int i;
-
-	is.clear();
-	is.seekg (0, ios::beg);
-
-	while (is.getline (cbuf, 512)) {
-		cl = trim_string(cbuf);
-		if (!_stricmp(cl, "END_PARSE")) return false;
-		
-		for (i = 0; cl[i] && cl[i] != '='; i++);
-		cv = (cl[i] ? cl+(i+1) : cl+i);
-		for (cl[i--] = '\0'; i >= 0 && (cl[i] == ' ' || cl[i] == '\t'); i--)
-			cl[i] = '\0';
-		if (!_stricmp (cl, label)) {
-			while (*cv == ' ' || *cv == '\t') cv++;
-			if (*cv) {
-				strcpy (val, cv);
-				return true;
-			} else {
-				return false;
-			}
-		}
-	}
-
-	is.clear();
-	return false;
-}
-
-bool GetItemReal (istream &is, const char *label, double &val)
-{
-	if (!GetItemString (is, label, g_cbuf)) return false;
-	return (sscanf (g_cbuf, "%lf", &val) == 1);
-}
-
-bool GetItemInt (istream &is, const char *label, int &val)
-{
-	if (!GetItemString (is, label, g_cbuf)) return false;
-	return (sscanf (g_cbuf, "%d", &val) == 1);
-}
-
-bool GetItemSize(istream& is, const char* label, size_t& val)
-{
-	if (!GetItemString(is, label, g_cbuf)) return false;
-	return (sscanf(g_cbuf, "%zu", &val) == 1);
-}
-
-bool GetItemHex (istream &is, const char *label, int &val)
-{
-	if (!GetItemString (is, label, g_cbuf)) return false;
-	return (sscanf (g_cbuf, "%x", &val) == 1);
-}
-
-bool GetItemBool (istream &is, const char *label, bool &val)
-{
-	if (!GetItemString (is, label, g_cbuf)) return false;
-	if (!_strnicmp (g_cbuf, "true", 4)) { val = true; return true; }
-	else if (!_strnicmp (g_cbuf, "false", 5)) { val = false; return true; }
-	return false;
-}
-
-bool GetItemVector (istream &is, const char *label, Vector &val)
-{
-	double x, y, z;
-	if (!GetItemString (is, label, g_cbuf)) return false;
-	if (sscanf (g_cbuf, "%lf%lf%lf", &x, &y, &z) != 3) return false;
-	val.Set (x,y,z);
-	return true;
-}
-
-bool GetItemVECTOR (istream &is, const char *label, VECTOR3 &val)
-{
-	double x, y, z;
-	if (!GetItemString (is, label, g_cbuf)) return false;
-	if (sscanf (g_cbuf, "%lf%lf%lf", &x, &y, &z) != 3) return false;
-	val.x = x; val.y = y; val.z = z;
-	return true;
-}
-
-bool FindLine (istream &is, const char *line)
-{
-	bool ok = false;
-	is.seekg (0); // rewind stream
-	if (is.good()) {
-		int len = strlen(line);
-		for (;;) {
-			if (!is.getline (g_cbuf, g_buflen)) {
-				if (is.eof()) break;               // EOF
-				else is.clear();                   // heal stream to continue after truncation error
-			}
-			if (!_strnicmp (g_cbuf, line, len)) {  // found string
-				ok = true;
-				break;
-			}
-		}
-	}
-	if (!ok) { // reset stream
-		is.clear();
-		is.seekg(0);
-	}
-	return ok;
-}
-
-int ListIndex (int listlen, char **list, char *label)
-{
-	for (int i = 0; i < listlen; i++)
-		if (!_stricmp (label, list[i])) return i;
-	return -1;
-}
-
 // =============================================================
 
 Config::Config()
@@ -565,6 +414,10 @@ bool Config::Load(const char *fname)
 		CfgPRenderPrm.ResolutionBias = max (-2.0, min (2.0, d));
 	if (GetInt (ifs, "TileLoadFlags", i))
 		CfgPRenderPrm.TileLoadFlags = max (min(i, 3), 1);
+	if (GetInt (ifs, "ElevTileCacheSize", i))
+		CfgPRenderPrm.ElevCacheSize = max (1, i);
+	if (GetReal (ifs, "ElevPrefetchTime", d))
+		CfgPRenderPrm.ElevPrefetchTime = max (0.0, min (120.0, d));
 
 	// map dialog parameters
 	if (GetInt (ifs, "MapDlgFlag", i))
@@ -612,6 +465,11 @@ bool Config::Load(const char *fname)
 	CfgPhysicsPrm.PropTLim[CfgPhysicsPrm.nLPropLevel-1] = 1e10;
 	CfgPhysicsPrm.PropALim[CfgPhysicsPrm.nLPropLevel-1] = 1e10;
 	GetInt (ifs, "PropSubsampling", CfgPhysicsPrm.PropSubMax);
+	GetReal (ifs, "PropTolerance", CfgPhysicsPrm.PropTol);
+	GetInt (ifs, "VesselUpdateThreads", CfgPhysicsPrm.nUpdateThreads);
+	GetBool (ifs, "OnRails", CfgPhysicsPrm.bOnRails);
+	GetReal (ifs, "OnRailsDistance", CfgPhysicsPrm.OnRailsDist);
+	GetReal (ifs, "OnRailsAltitude", CfgPhysicsPrm.OnRailsAlt);
 
 #ifdef UNDEF
 	// BEGIN OBSOLETE
@@ -760,6 +618,8 @@ bool Config::Load(const char *fname)
 	GetBool (ifs, "ReplayCameraEvent", CfgRecPlayPrm.bReplayCam);
 	GetBool (ifs, "SystimeSampling", CfgRecPlayPrm.bSysInterval);
 	GetBool (ifs, "PlaybackNotes", CfgRecPlayPrm.bShowNotes);
+	GetBool (ifs, "RecordBinary", CfgRecPlayPrm.bRecordBinary);
+	GetBool (ifs, "PlaybackMapped", CfgRecPlayPrm.bMappedPlayback);
 
 	// font characteristics
 	if (GetReal (ifs, "DialogFont_Scale", d)) CfgFontPrm.dlgFont_Scale = (float)d;
@@ -1188,6 +1048,16 @@ BOOL Config::Write (const char *fname) const
 #endif
 		if (CfgPhysicsPrm.PropSubMax != CfgPhysicsPrm_default.PropSubMax || bEchoAll)
 			ofs << "PropSubsampling = " << CfgPhysicsPrm.PropSubMax << '\n';
+		if (CfgPhysicsPrm.PropTol != CfgPhysicsPrm_default.PropTol || bEchoAll)
+			ofs << "PropTolerance = " << CfgPhysicsPrm.PropTol << '\n';
+		if (CfgPhysicsPrm.nUpdateThreads != CfgPhysicsPrm_default.nUpdateThreads || bEchoAll)
+			ofs << "VesselUpdateThreads = " << CfgPhysicsPrm.nUpdateThreads << '\n';
+		if (CfgPhysicsPrm.bOnRails != CfgPhysicsPrm_default.bOnRails || bEchoAll)
+			ofs << "OnRails = " << BoolStr (CfgPhysicsPrm.bOnRails) << '\n';
+		if (CfgPhysicsPrm.OnRailsDist != CfgPhysicsPrm_default.OnRailsDist || bEchoAll)
+			ofs << "OnRailsDistance = " << CfgPhysicsPrm.OnRailsDist << '\n';
+		if (CfgPhysicsPrm.OnRailsAlt != CfgPhysicsPrm_default.OnRailsAlt || bEchoAll)
+			ofs << "OnRailsAltitude = " << CfgPhysicsPrm.OnRailsAlt << '\n';
 	}
 
 	if (memcmp (&CfgPRenderPrm, &CfgPRenderPrm_default, sizeof(CFG_PLANETRENDERPRM)) || bEchoAll) {
@@ -1212,6 +1082,10 @@ BOOL Config::Write (const char *fname) const
 			ofs << "PlanetResolutionBias = " << CfgPRenderPrm.ResolutionBias << '\n';
 		if (CfgPRenderPrm.TileLoadFlags != CfgPRenderPrm_default.TileLoadFlags || bEchoAll)
 			ofs << "TileLoadFlags = " << CfgPRenderPrm.TileLoadFlags << '\n';
+		if (CfgPRenderPrm.ElevCacheSize != CfgPRenderPrm_default.ElevCacheSize || bEchoAll)
+			ofs << "ElevTileCacheSize = " << CfgPRenderPrm.ElevCacheSize << '\n';
+		if (CfgPRenderPrm.ElevPrefetchTime != CfgPRenderPrm_default.ElevPrefetchTime || bEchoAll)
+			ofs << "ElevPrefetchTime = " << CfgPRenderPrm.ElevPrefetchTime << '\n';
 	}
 
 	if (memcmp (&CfgMapPrm, &CfgMapPrm_default, sizeof (CFG_MAPPRM)) || bEchoAll) {
@@ -1337,6 +1211,10 @@ BOOL Config::Write (const char *fname) const
 			ofs << "SystimeSampling = " << BoolStr (CfgRecPlayPrm.bSysInterval) << '\n';
 		if (CfgRecPlayPrm.bShowNotes != CfgRecPlayPrm_default.bShowNotes || bEchoAll)
 			ofs << "PlaybackNotes = " << BoolStr (CfgRecPlayPrm.bShowNotes) << '\n';
+		if (CfgRecPlayPrm.bRecordBinary != CfgRecPlayPrm_default.bRecordBinary || bEchoAll)
+			ofs << "RecordBinary = " << BoolStr (CfgRecPlayPrm.bRecordBinary) << '\n';
+		if (CfgRecPlayPrm.bMappedPlayback != CfgRecPlayPrm_default.bMappedPlayback || bEchoAll)
+			ofs << "PlaybackMapped = " << BoolStr (CfgRecPlayPrm.bMappedPlayback) << '\n';
 	}
 
 	if (memcmp (&CfgFontPrm, &CfgFontPrm_default, sizeof(CFG_FONTPRM)) || bEchoAll) {
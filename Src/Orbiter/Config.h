@@ -21,7 +21,7 @@
 // dynamic state propagation methods
 #define MAX_PROP_LEVEL  5
 #define MAX_APROP_LEVEL 5
-#define NPROP_METHOD   10
+#define NPROP_METHOD   11
 #define NAPROP_METHOD   6
 #define PROP_RK2        0
 #define PROP_RK4        1
@@ -33,6 +33,7 @@
 #define PROP_SY4        7
 #define PROP_SY6        8
 #define PROP_SY8        9
+#define PROP_RK45      10
 
 #define SURF_MAX_PATCHLEVEL 14
 #define SURF_MAX_PATCHLEVEL2 21
@@ -76,8 +77,13 @@ struct CFG_PHYSICSPRM {
 	double PropALim[MAX_PROP_LEVEL];  // angle step limits for the propagation levels
 	double APropSubLimit;		// angle step limit for subsampling
 	int    PropSubMax;			// max number of subsampling steps
+	double PropTol;				// relative error tolerance for the adaptive propagator (RK45)
 	double APropCouplingLimit;	// angle step limit for cross term suppresion
 	double APropTorqueLimit;	// angle step limit for torque suppression
+	int    nUpdateThreads;		// worker threads for free-flight vessel propagation (0=serial)
+	bool   bOnRails;			// propagate idle distant vessels analytically on Kepler orbits
+	double OnRailsDist;			// min. distance to other vessels for on-rails propagation [m]
+	double OnRailsAlt;			// min. periapsis altitude above atmosphere or surface for on-rails propagation [m]
 };
 
 struct CFG_LOGICPRM {
@@ -184,6 +190,8 @@ struct CFG_PLANETRENDERPRM {
 	int    LoadFrequency;       // tile load frequency
 	int    AnisoMode;
 	DWORD  TileLoadFlags;       // flags for planetary tile load mechanism
+	int    ElevCacheSize;       // size limit of the shared elevation tile cache [MB]
+	double ElevPrefetchTime;    // look-ahead time for elevation tile prefetching [s] (0=off)
 };
 
 struct CFG_MAPPRM {
@@ -200,6 +208,8 @@ struct CFG_RECPLAYPRM {
 	bool   bReplayCam;			// use recorded camera events during playback?
 	bool   bSysInterval;		// sample in system time intervals?
 	bool   bShowNotes;			// show inflight notes during playback?
+	bool   bRecordBinary;		// write position/attitude streams in binary format?
+	bool   bMappedPlayback;		// play back position/attitude streams from memory-mapped files?
 };
 
 struct CFG_DEVPRM {
@@ -288,6 +298,8 @@ struct CFG_CMDLINEPRM {
 	double FixedStep;           // fixed time step length (0 = disabled). If != 0, overrides CFG_DEBUGPRM::FixedStep
 	double MaxSysTime;          // Max session runtime (sys time). 0 = unlimited
 	double MaxSimTime;          // Max session runtime (sim time). 0 = unlimited
+	int    UpdateThreads;       // number of vessel update threads (0 = serial). < 0: use CFG_PHYSICSPRM::nUpdateThreads
+	int    OnRails;             // on-rails propagation of idle vessels (0 = off, 1 = on). < 0: use CFG_PHYSICSPRM::bOnRails
 	std::string LaunchScenario; // if not empty, start scenario instantly without opening Launchpad
 	std::list<std::string> LoadPlugins; // list of plugins to load
 };
@@ -305,6 +317,15 @@ char *readline (std::istream &is);
 // buffer containing the line. The buffer is grown dynamically to
 // hold a string of arbitrary length.
 
+void IndexItems (std::istream &is);
+// Enable a key/value index for stream 'is'. The first GetItem* call on the
+// stream parses it once (up to END_PARSE) into a case-insensitive table,
+// and all further lookups are served from the table instead of rescanning
+// the stream. Only use for streams whose contents don't change while open.
+// Indexed lookups leave the stream at the same position as the scan: after
+// the line of the requested item, or at the end of the parsed section if
+// the item doesn't exist.
+
 bool GetItemString (std::istream &is, const char *label, char *val);
 bool GetItemReal   (std::istream &is, const char *label, double &val);
 bool GetItemInt    (std::istream &is, const char *label, int &val);
@@ -0,0 +1,296 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =============================================================
+// ConfigItems.cpp
+// Parsing of "label = value" items in configuration files
+// =============================================================
+
+#include <string>
+#include <unordered_map>
+#include <string.h>
+#include <stdio.h>
+#include "Config.h"
+#include "Log.h"
+
+using namespace std;
+
+static char g_cbuf[1024];
+static int g_buflen = 1024;
+
+// =============================================================
+
+char *trim_string (char *cbuf)
+{
+	char *c;
+
+	// strip comments starting with ';'
+	for (c = cbuf; *c; c++) {
+		if (*c == ';') {
+			*c = '\0';
+			break;
+		}
+	}
+	// strip trailing white space
+	for (--c; c >= cbuf; c--) {
+		if (*c == ' ' || *c == '\t') *c = '\0';
+		else break;
+	}
+	// skip leading white space
+	for (c = cbuf; *c; c++)
+		if (*c != ' ' && *c != '\t') return c;
+
+	// should never get here
+	return c;
+}
+
+char *readline (istream &is)
+{
+	const int inc = 256;
+	static int len = 256;
+	static char *cbuf = new char[len];
+
+	char *c = cbuf;
+	cbuf[0] = '\0';
+	int chunk = len;
+	for (;;) {
+		if (is.getline (c, chunk)) return cbuf;
+		else if (is.eof()) return 0;
+		else { // buffer too small
+			char *tmp = new char[len+inc];
+			memcpy (tmp, cbuf, len-1);
+			delete []cbuf;
+			cbuf = tmp;
+			c = cbuf+len-1;
+			len += inc;
+			chunk = inc+1;
+		}
+		is.clear();
+	}
+	return 0; // never gets here
+}
+
+// =============================================================
+// Key/value index for GetItem* lookups, attached to a stream via
+// its pword storage and released together with the stream
+
+class ItemIndex {
+public:
+	ItemIndex (): built(false), endpos(0) {}
+
+	bool Get (istream &is, const char *label, char *val);
+
+	static int Slot ();
+	// stream pword index for the item index pointer
+
+	static void StreamEvent (ios_base::event ev, ios_base &ios, int slot);
+
+private:
+	void Build (istream &is);
+	static void ToLower (std::string &s);
+
+	struct Item {
+		std::string val;     // item value
+		streampos pos;       // stream position after the item line
+	};
+	std::unordered_map<std::string, Item> item; // lower-case label -> item
+	bool built;          // stream has been parsed
+	streampos endpos;    // stream position at the end of the parsed section
+	std::string key;     // lookup buffer
+};
+
+int ItemIndex::Slot ()
+{
+	static const int slot = ios_base::xalloc();
+	return slot;
+}
+
+void ItemIndex::StreamEvent (ios_base::event ev, ios_base &ios, int slot)
+{
+	void *&p = ios.pword (slot);
+	if (ev == ios_base::erase_event) {
+		delete (ItemIndex*)p;
+		p = 0;
+	} else if (ev == ios_base::copyfmt_event) {
+		p = 0; // the index belongs to the source stream only
+	}
+}
+
+void ItemIndex::ToLower (std::string &s)
+{
+	for (auto &c : s)
+		if (c >= 'A' && c <= 'Z') c += 'a'-'A';
+}
+
+void ItemIndex::Build (istream &is)
+{
+	// same parsing rules as the linear scan in GetItemString
+	char cbuf[512], *cl, *cv;
+	int i;
+
+	is.clear();
+	is.seekg (0, ios::beg);
+
+	while (is.getline (cbuf, 512)) {
+		cl = trim_string(cbuf);
+		if (!_stricmp(cl, "END_PARSE")) break;
+
+		for (i = 0; cl[i] && cl[i] != '='; i++);
+		cv = (cl[i] ? cl+(i+1) : cl+i);
+		for (cl[i--] = '\0'; i >= 0 && (cl[i] == ' ' || cl[i] == '\t'); i--)
+			cl[i] = '\0';
+		while (*cv == ' ' || *cv == '\t') cv++;
+		key = cl;
+		ToLower (key);
+		if (item.find (key) == item.end()) // first occurrence wins
+			item.emplace (key, Item{cv, is.tellg()});
+	}
+	is.clear();
+	endpos = is.tellg();
+	built = true;
+}
+
+bool ItemIndex::Get (istream &is, const char *label, char *val)
+{
+	if (!built) Build (is);
+	key = label;
+	ToLower (key);
+	auto it = item.find (key);
+	is.clear();
+	if (it == item.end()) {
+		is.seekg (endpos);
+		return false;
+	}
+	// leave the stream where the linear scan would have stopped
+	is.seekg (it->second.pos);
+	if (it->second.val.empty()) return false;
+	strcpy (val, it->second.val.c_str());
+	return true;
+}
+
+void IndexItems (istream &is)
+{
+	int slot = ItemIndex::Slot();
+	void *&p = is.pword (slot);
+	if (!p) {
+		p = new ItemIndex; TRACENEW
+		is.register_callback (ItemIndex::StreamEvent, slot);
+	}
+}
+
+// =============================================================
+
+bool GetItemString (istream &is, const char *label, char *val)
+{
+	ItemIndex *index = (ItemIndex*)is.pword (ItemIndex::Slot());
+	if (index) return index->Get (is, label, val);
+
+	char cbuf[512], *cl, *cv;
+	int i;
+
+	is.clear();
+	is.seekg (0, ios::beg);
+
+	while (is.getline (cbuf, 512)) {
+		cl = trim_string(cbuf);
+		if (!_stricmp(cl, "END_PARSE")) return false;
+		
+		for (i = 0; cl[i] && cl[i] != '='; i++);
+		cv = (cl[i] ? cl+(i+1) : cl+i);
+		for (cl[i--] = '\0'; i >= 0 && (cl[i] == ' ' || cl[i] == '\t'); i--)
+			cl[i] = '\0';
+		if (!_stricmp (cl, label)) {
+			while (*cv == ' ' || *cv == '\t') cv++;
+			if (*cv) {
+				strcpy (val, cv);
+				return true;
+			} else {
+				return false;
+			}
+		}
+	}
+
+	is.clear();
+	return false;
+}
+
+bool GetItemReal (istream &is, const char *label, double &val)
+{
+	if (!GetItemString (is, label, g_cbuf)) return false;
+	return (sscanf (g_cbuf, "%lf", &val) == 1);
+}
+
+bool GetItemInt (istream &is, const char *label, int &val)
+{
+	if (!GetItemString (is, label, g_cbuf)) return false;
+	return (sscanf (g_cbuf, "%d", &val) == 1);
+}
+
+bool GetItemSize(istream& is, const char* label, size_t& val)
+{
+	if (!GetItemString(is, label, g_cbuf)) return false;
+	return (sscanf(g_cbuf, "%zu", &val) == 1);
+}
+
+bool GetItemHex (istream &is, const char *label, int &val)
+{
+	if (!GetItemString (is, label, g_cbuf)) return false;
+	return (sscanf (g_cbuf, "%x", &val) == 1);
+}
+
+bool GetItemBool (istream &is, const char *label, bool &val)
+{
+	if (!GetItemString (is, label, g_cbuf)) return false;
+	if (!_strnicmp (g_cbuf, "true", 4)) { val = true; return true; }
+	else if (!_strnicmp (g_cbuf, "false", 5)) { val = false; return true; }
+	return false;
+}
+
+bool GetItemVector (istream &is, const char *label, Vector &val)
+{
+	double x, y, z;
+	if (!GetItemString (is, label, g_cbuf)) return false;
+	if (sscanf (g_cbuf, "%lf%lf%lf", &x, &y, &z) != 3) return false;
+	val.Set (x,y,z);
+	return true;
+}
+
+bool GetItemVECTOR (istream &is, const char *label, VECTOR3 &val)
+{
+	double x, y, z;
+	if (!GetItemString (is, label, g_cbuf)) return false;
+	if (sscanf (g_cbuf, "%lf%lf%lf", &x, &y, &z) != 3) return false;
+	val.x = x; val.y = y; val.z = z;
+	return true;
+}
+
+bool FindLine (istream &is, const char *line)
+{
+	bool ok = false;
+	is.seekg (0); // rewind stream
+	if (is.good()) {
+		int len = strlen(line);
+		for (;;) {
+			if (!is.getline (g_cbuf, g_buflen)) {
+				if (is.eof()) break;               // EOF
+				else is.clear();                   // heal stream to continue after truncation error
+			}
+			if (!_strnicmp (g_cbuf, line, len)) {  // found string
+				ok = true;
+				break;
+			}
+		}
+	}
+	if (!ok) { // reset stream
+		is.clear();
+		is.seekg(0);
+	}
+	return ok;
+}
+
+int ListIndex (int listlen, char **list, char *label)
+{
+	for (int i = 0; i < listlen; i++)
+		if (!_stricmp (label, list[i])) return i;
+	return -1;
+}
@@ -0,0 +1,105 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// Implementation of class ElevPrefetcher
+
+#include "ElevPrefetch.h"
+
+ElevPrefetcher::ElevPrefetcher ()
+: current(0), bTerminate(false), nload(0)
+{}
+
+// ==============================================================
+
+ElevPrefetcher::~ElevPrefetcher ()
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		bTerminate = true;
+	}
+	cv.notify_one();
+	if (thread.joinable())
+		thread.join();
+}
+
+// ==============================================================
+
+void ElevPrefetcher::Attach (const void *b, LoadFunc load)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	body[b] = load;
+	if (!thread.joinable()) {
+		bTerminate = false;
+		thread = std::thread (&ElevPrefetcher::ThreadProc, this);
+	}
+}
+
+// ==============================================================
+
+void ElevPrefetcher::Detach (const void *b)
+{
+	std::thread stopped;
+	{
+		std::unique_lock<std::mutex> lock(mtx);
+		body.erase (b);
+		for (auto it = queue.begin(); it != queue.end();) {
+			if (it->body == b) {
+				queued.erase (*it);
+				it = queue.erase (it);
+			} else it++;
+		}
+		cv_done.wait (lock, [this, b]{ return current != b; });
+		if (body.empty()) {
+			bTerminate = true;
+			stopped.swap (thread);
+		}
+	}
+	if (stopped.joinable()) {
+		cv.notify_one();
+		stopped.join();
+	}
+}
+
+// ==============================================================
+
+bool ElevPrefetcher::Request (const ElevTileKey &key)
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		if (queue.size() >= MAXQUEUE || !body.count (key.body)) return false;
+		if (!queued.insert (key).second) return false;
+		queue.push_back (key);
+	}
+	cv.notify_one();
+	return true;
+}
+
+// ==============================================================
+
+void ElevPrefetcher::WaitIdle ()
+{
+	std::unique_lock<std::mutex> lock(mtx);
+	cv_done.wait (lock, [this]{ return queue.empty() && !current; });
+}
+
+// ==============================================================
+
+void ElevPrefetcher::ThreadProc ()
+{
+	std::unique_lock<std::mutex> lock(mtx);
+	for (;;) {
+		cv.wait (lock, [this]{ return bTerminate || !queue.empty(); });
+		if (bTerminate) break;
+		ElevTileKey key = queue.front();
+		queue.pop_front();
+		queued.erase (key);
+		LoadFunc load = body[key.body];
+		current = key.body;
+		lock.unlock();
+		load (key.lvl, key.ilat, key.ilng);
+		lock.lock();
+		current = 0;
+		nload++;
+		cv_done.notify_all();
+	}
+}
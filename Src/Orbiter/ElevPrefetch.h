@@ -0,0 +1,67 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// Background loading of elevation tiles ahead of their use
+
+#ifndef __ELEVPREFETCH_H
+#define __ELEVPREFETCH_H
+
+#include "ElevTileCache.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+// =======================================================================
+// class ElevPrefetcher
+// Queue of elevation tile load requests, served by a single background
+// thread. Each body registers a load function which decodes a tile into
+// the shared ElevTileCache. Requests are served in the order they were
+// made, and duplicate requests for queued tiles are ignored.
+// The thread runs while at least one body is registered.
+
+class ElevPrefetcher {
+public:
+	typedef std::function<void(int lvl, int ilat, int ilng)> LoadFunc;
+
+	ElevPrefetcher ();
+	~ElevPrefetcher ();
+
+	void Attach (const void *body, LoadFunc load);
+	// Register the tile load function for body
+
+	void Detach (const void *body);
+	// Unregister body. Discards its queued requests and waits for a load
+	// in progress to complete.
+
+	bool Request (const ElevTileKey &key);
+	// Queue tile key for loading. Returns false if the tile is already
+	// queued, the body is not registered, or the queue is full.
+
+	void WaitIdle ();
+	// Wait until all queued requests have been served
+
+	inline size_t nLoaded () const { return nload; }
+	// Number of tiles loaded by the background thread
+
+	static const size_t MAXQUEUE = 256; // max. number of queued requests
+
+private:
+	void ThreadProc ();
+
+	std::unordered_map<const void*, LoadFunc> body; // registered bodies
+	std::deque<ElevTileKey> queue;                  // pending requests
+	std::unordered_set<ElevTileKey, ElevTileKeyHash> queued; // lookup for duplicates
+	const void *current;   // body of the load in progress
+	std::thread thread;
+	std::mutex mtx;        // protects all members
+	std::condition_variable cv, cv_done;
+	bool bTerminate;
+	std::atomic<size_t> nload;
+};
+
+#endif // !__ELEVPREFETCH_H
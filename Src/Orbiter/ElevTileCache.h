@@ -0,0 +1,183 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// Process-wide cache of decoded elevation tiles, shared by all users of
+// the elevation managers (vessels, camera, API calls)
+
+#ifndef __ELEVTILECACHE_H
+#define __ELEVTILECACHE_H
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+// =======================================================================
+// Decoded elevation tile, including elevation modifications and graphics
+// client filtering. A tile without elevation data records that the tile
+// doesn't exist, so that repeated lookups don't hit the file system.
+
+struct ElevTileData {
+	std::unique_ptr<int16_t[]> elev; // elevation grid incl. padding, or 0 if the tile doesn't exist
+	size_t ndat = 0;                 // number of grid points
+	double latmin = 0, latmax = 0;   // latitude range [rad]
+	double lngmin = 0, lngmax = 0;   // longitude range [rad]
+	int quadrants = 0;               // bit mask of quadrants with higher-level data (see ElevationManager::Elevation)
+
+	inline size_t Size () const { return sizeof(ElevTileData) + ndat*sizeof(int16_t); }
+	// Memory footprint [bytes]
+};
+
+struct ElevTileKey {
+	const void *body; // owning body
+	int lvl;          // tile level
+	int ilat, ilng;   // tile indices
+
+	inline bool operator== (const ElevTileKey &k) const
+	{ return body == k.body && lvl == k.lvl && ilat == k.ilat && ilng == k.ilng; }
+};
+
+struct ElevTileKeyHash {
+	inline size_t operator() (const ElevTileKey &k) const
+	{
+		uint64_t h = (uint64_t)std::hash<const void*>() (k.body);
+		h ^= ((uint64_t)k.lvl << 48) ^ ((uint64_t)(uint32_t)k.ilat << 24) ^ (uint64_t)(uint32_t)k.ilng;
+		return (size_t)((h * 0x9E3779B97F4A7C15ull) >> 16);
+	}
+};
+
+// =======================================================================
+// class ElevTileCache
+// Size-bounded map of decoded tiles with least-recently-used eviction.
+// Lookup, insertion and promotion are O(1). Tiles are handed out as shared
+// references, so evicting a tile doesn't invalidate the per-caller tile
+// lists still using it. All methods are thread-safe.
+
+class ElevTileCache {
+public:
+	typedef std::shared_ptr<const ElevTileData> TilePtr;
+
+	struct Stats {
+		size_t nhit;   // successful lookups
+		size_t nmiss;  // failed lookups
+		size_t nevict; // tiles evicted to make room
+	};
+
+	explicit ElevTileCache (size_t _maxsize): maxsize(_maxsize), size(0), stats{0,0,0} {}
+
+	TilePtr Find (const ElevTileKey &key);
+	// Return the tile for key and mark it as most recently used, or return 0
+	// if the tile isn't cached.
+
+	TilePtr Peek (const ElevTileKey &key) const;
+	// Return the tile for key, or 0 if the tile isn't cached. Unlike Find,
+	// doesn't count as an access for the statistics and the LRU order.
+
+	TilePtr Insert (const ElevTileKey &key, TilePtr tile);
+	// Add tile under key and evict the least recently used tiles until the
+	// cache is within its size limit. If key was inserted concurrently by
+	// another caller, that tile is kept and returned instead.
+
+	size_t Remove (const void *body);
+	// Remove all tiles of body. Returns the number of tiles removed.
+
+	void SetMaxSize (size_t maxsize);
+	// Set the size limit [bytes]
+
+	inline size_t MaxSize () const { std::lock_guard<std::mutex> lock(mtx); return maxsize; }
+	inline size_t Size () const { std::lock_guard<std::mutex> lock(mtx); return size; }
+	inline size_t Count () const { std::lock_guard<std::mutex> lock(mtx); return lru.size(); }
+	inline Stats GetStats () const { std::lock_guard<std::mutex> lock(mtx); return stats; }
+	inline void ResetStats () { std::lock_guard<std::mutex> lock(mtx); stats = Stats{0,0,0}; }
+
+private:
+	struct Entry {
+		ElevTileKey key;
+		TilePtr tile;
+	};
+
+	void Shrink ();
+	// Evict tiles until the size limit is met (under mtx)
+
+	std::list<Entry> lru; // most recently used first
+	std::unordered_map<ElevTileKey, std::list<Entry>::iterator, ElevTileKeyHash> index;
+	size_t maxsize;       // size limit [bytes]
+	size_t size;          // current size [bytes]
+	Stats stats;
+	mutable std::mutex mtx;
+};
+
+// =======================================================================
+
+inline ElevTileCache::TilePtr ElevTileCache::Find (const ElevTileKey &key)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	auto it = index.find (key);
+	if (it == index.end()) {
+		stats.nmiss++;
+		return TilePtr();
+	}
+	lru.splice (lru.begin(), lru, it->second);
+	stats.nhit++;
+	return it->second->tile;
+}
+
+inline ElevTileCache::TilePtr ElevTileCache::Peek (const ElevTileKey &key) const
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	auto it = index.find (key);
+	return (it == index.end() ? TilePtr() : it->second->tile);
+}
+
+inline ElevTileCache::TilePtr ElevTileCache::Insert (const ElevTileKey &key, TilePtr tile)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	auto it = index.find (key);
+	if (it != index.end()) {
+		lru.splice (lru.begin(), lru, it->second);
+		return it->second->tile;
+	}
+	lru.push_front (Entry{key, tile});
+	index[key] = lru.begin();
+	size += tile->Size();
+	Shrink();
+	return tile;
+}
+
+inline size_t ElevTileCache::Remove (const void *body)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	size_t n = 0;
+	for (auto it = lru.begin(); it != lru.end();) {
+		if (it->key.body == body) {
+			size -= it->tile->Size();
+			index.erase (it->key);
+			it = lru.erase (it);
+			n++;
+		} else it++;
+	}
+	return n;
+}
+
+inline void ElevTileCache::SetMaxSize (size_t _maxsize)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	maxsize = _maxsize;
+	Shrink();
+}
+
+inline void ElevTileCache::Shrink ()
+{
+	// the most recently used tile is always kept
+	while (size > maxsize && lru.size() > 1) {
+		Entry &e = lru.back();
+		size -= e.tile->Size();
+		index.erase (e.key);
+		lru.pop_back();
+		stats.nevict++;
+	}
+}
+
+#endif // !__ELEVTILECACHE_H
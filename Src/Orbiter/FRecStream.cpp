@@ -0,0 +1,658 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Flight recorder stream I/O
+// =======================================================================
+
+#include "FRecStream.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <math.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// =======================================================================
+// Binary sample stream format
+// A file header, followed by fixed-size records. Sample times are stored
+// as single-precision offsets to the previous sample. Whenever the offset
+// is too large to be represented accurately, a time key record with the
+// full time value is inserted.
+// Header lines longer than the tag field of a record continue in the
+// following records (version 2). Version 1 files only contain header
+// lines which fit into a single record, with taglen set to 0.
+
+static const char FRECBIN_MAGIC[8] = "ORBFREC";
+static const uint32_t FRECBIN_VERSION = 2;
+static const uint16_t FRECBIN_TIMEKEY = 0xFFFF;  // record type: full time value in v[0]
+static const double FRECBIN_MAXDT = 64.0;         // max. time offset for delta-encoded samples [s]
+static const size_t FRECBIN_MAXTAG = 0xFFFF;      // max. length of a header line [bytes]
+
+struct FRecBinHeader {
+	char     magic[8];     // FRECBIN_MAGIC
+	uint32_t version;      // FRECBIN_VERSION
+	uint32_t type;         // FRecStreamType
+};
+
+struct FRecBinRecord {
+	uint16_t nv;           // number of values, 0 for header lines, or FRECBIN_TIMEKEY
+	uint16_t taglen;       // header lines: length of the line, or 0 if 0-terminated
+	float    dt;           // time offset to previous sample [s]
+	union {
+		double v[FREC_MAXVAL]; // sample values
+		char tag[FREC_MAXVAL*sizeof(double)]; // header line (first part, if continued)
+	};
+};
+
+// Number of continuation records following a record
+static size_t TagRecords (const FRecBinRecord &rec)
+{
+	if (rec.nv || rec.taglen <= sizeof(rec.tag)) return 0;
+	return (rec.taglen - sizeof(rec.tag) + sizeof(FRecBinRecord)-1) / sizeof(FRecBinRecord);
+}
+
+static const int nval[3] = {6, 3, 0}; // number of sample values per stream type
+
+// Decode a binary record. ext points to the data of the continuation records
+// of a header line (see TagRecords). Returns false for time key records,
+// which only update the time base.
+static bool DecodeRecord (const FRecBinRecord &rec, const char *ext, double &tbase, FRecItem &item)
+{
+	if (rec.nv == FRECBIN_TIMEKEY) {
+		tbase = rec.v[0];
+		return false;
+	}
+	if (rec.nv == 0) {
+		if (rec.taglen > sizeof(rec.tag)) {
+			item.tag.assign (rec.tag, sizeof(rec.tag));
+			item.tag.append (ext, rec.taglen - sizeof(rec.tag));
+		} else if (rec.taglen) {
+			item.tag.assign (rec.tag, rec.taglen);
+		} else {
+			item.tag.assign (rec.tag, strnlen (rec.tag, sizeof(rec.tag)));
+		}
+		item.nv = 0;
+	} else {
+		item.tag.clear();
+		item.t = (tbase += rec.dt);
+		item.nv = min ((int)rec.nv, FREC_MAXVAL);
+		for (int i = 0; i < item.nv; i++) item.v[i] = rec.v[i];
+	}
+	return true;
+}
+
+// Decode a line of a text stream. Returns false for empty lines.
+// If timeonly is set, only the time of data samples is decoded.
+static bool DecodeLine (char *line, FRecItem &item, bool timeonly = false)
+{
+	size_t len = strlen (line);
+	if (len && line[len-1] == '\r') line[--len] = '\0';
+	if (!len) return false;
+	if (timeonly) {
+		char *end;
+		item.t = strtod (line, &end);
+		if (end != line) {
+			item.tag.clear();
+			item.nv = 1;
+			return true;
+		}
+	}
+	int n = sscanf (line, "%lf%lf%lf%lf%lf%lf%lf", &item.t, item.v+0, item.v+1, item.v+2, item.v+3, item.v+4, item.v+5);
+	if (n >= 1) {
+		item.tag.clear();
+		item.nv = n-1;
+	} else {
+		item.tag = line;
+		item.nv = 0;
+	}
+	return true;
+}
+
+// =======================================================================
+// Background flushing of output streams
+
+struct FRecOStream::Buffer {
+	ofstream ofs;
+	string pending;        // data not yet written to ofs
+	mutex mtx;             // protects pending
+	mutex fmtx;            // protects ofs
+
+	void Flush () {
+		lock_guard<mutex> flock(fmtx);
+		string data;
+		{
+			lock_guard<mutex> lock(mtx);
+			data.swap (pending);
+		}
+		if (data.size()) {
+			ofs.write (data.data(), data.size());
+			ofs.flush();
+		}
+	}
+};
+
+class FRecFlusher {
+public:
+	FRecFlusher (): bTerminate(false), bWake(false) {}
+
+	~FRecFlusher () {
+		if (thread.joinable()) {
+			{
+				lock_guard<mutex> lock(lmtx);
+				bTerminate = true;
+			}
+			cv.notify_one();
+			thread.join();
+		}
+	}
+
+	void Add (FRecOStream::Buffer *buf) {
+		lock_guard<mutex> clock(cmtx);
+		{
+			lock_guard<mutex> lock(lmtx);
+			buffer.push_back (buf);
+		}
+		if (!thread.joinable()) {
+			bTerminate = false;
+			thread = std::thread (&FRecFlusher::ThreadProc, this);
+		}
+	}
+
+	void Remove (FRecOStream::Buffer *buf) {
+		lock_guard<mutex> clock(cmtx);
+		bool stop;
+		{
+			// once we hold lmtx, the thread is not accessing buf
+			lock_guard<mutex> lock(lmtx);
+			for (auto it = buffer.begin(); it != buffer.end(); it++)
+				if (*it == buf) { buffer.erase (it); break; }
+			stop = buffer.empty();
+			if (stop) bTerminate = true;
+		}
+		if (stop && thread.joinable()) {
+			cv.notify_one();
+			thread.join();
+		}
+	}
+
+	void Wake () {
+		bWake = true;
+		cv.notify_one();
+	}
+
+private:
+	void ThreadProc () {
+		unique_lock<mutex> lock(lmtx);
+		while (!bTerminate) {
+			cv.wait_for (lock, chrono::seconds(1), [this]{ return bTerminate || bWake; });
+			bWake = false;
+			for (auto buf : buffer)
+				buf->Flush();
+		}
+	}
+
+	vector<FRecOStream::Buffer*> buffer; // open streams
+	std::thread thread;
+	mutex cmtx;            // serialises Add/Remove
+	mutex lmtx;            // protects buffer list; held by the thread while flushing
+	condition_variable cv;
+	bool bTerminate;
+	atomic<bool> bWake;    // a stream requests flushing
+};
+
+static FRecFlusher g_flusher;
+
+// =======================================================================
+// class FRecOStream
+
+FRecOStream::FRecOStream ()
+: buf(nullptr), type(FREC_EVENT), binary(false), tlast(-1e300)
+{}
+
+// =======================================================================
+
+FRecOStream::~FRecOStream ()
+{
+	Close();
+}
+
+// =======================================================================
+
+bool FRecOStream::Open (const char *fname, FRecStreamType _type, bool append, bool _binary)
+{
+	Close();
+	type = _type;
+	binary = _binary && type != FREC_EVENT;
+	tlast = -1e300;
+
+	bool writeheader = binary;
+	if (append) { // continue in the format of the existing stream
+		ifstream ifs (fname, ios::in | ios::binary);
+		FRecBinHeader hdr;
+		if (ifs.read ((char*)&hdr, sizeof(FRecBinHeader)))
+			binary = !memcmp (hdr.magic, FRECBIN_MAGIC, 8);
+		else if (ifs.gcount())
+			binary = false;
+		writeheader = binary && !ifs.gcount();
+	}
+
+	Buffer *b = new Buffer;
+	ios::openmode mode = ios::out | (append ? ios::app : ios::trunc);
+	if (binary) mode |= ios::binary;
+	b->ofs.open (fname, mode);
+	if (!b->ofs) {
+		delete b;
+		return false;
+	}
+	buf = b;
+	if (writeheader) {
+		FRecBinHeader hdr;
+		memset (&hdr, 0, sizeof(FRecBinHeader));
+		memcpy (hdr.magic, FRECBIN_MAGIC, 8);
+		hdr.version = FRECBIN_VERSION;
+		hdr.type = (uint32_t)type;
+		Append ((const char*)&hdr, sizeof(FRecBinHeader));
+	}
+	g_flusher.Add (buf);
+	return true;
+}
+
+// =======================================================================
+
+void FRecOStream::Close ()
+{
+	if (!buf) return;
+	g_flusher.Remove (buf);
+	buf->Flush();
+	buf->ofs.close();
+	delete buf;
+	buf = nullptr;
+}
+
+// =======================================================================
+
+void FRecOStream::Append (const char *data, size_t len)
+{
+	if (!buf) return;
+	size_t n;
+	{
+		lock_guard<mutex> lock(buf->mtx);
+		buf->pending.append (data, len);
+		n = buf->pending.size();
+	}
+	if (n > FLUSH_SIZE) g_flusher.Wake();
+}
+
+// =======================================================================
+
+void FRecOStream::Tag (const string &line)
+{
+	if (binary) {
+		FRecBinRecord rec;
+		memset (&rec, 0, sizeof(FRecBinRecord));
+		size_t len = min (line.size(), FRECBIN_MAXTAG);
+		rec.taglen = (uint16_t)len;
+		memcpy (rec.tag, line.data(), min (len, sizeof(rec.tag)));
+		Append ((const char*)&rec, sizeof(FRecBinRecord));
+		if (size_t n = TagRecords (rec)) { // continuation records
+			string ext (n*sizeof(FRecBinRecord), '\0');
+			memcpy (&ext[0], line.data()+sizeof(rec.tag), len-sizeof(rec.tag));
+			Append (ext.data(), ext.size());
+		}
+	} else {
+		Line (line);
+	}
+}
+
+// =======================================================================
+
+void FRecOStream::Sample (double t, const double *v)
+{
+	int i, nv = nval[type];
+	if (binary) {
+		FRecBinRecord rec;
+		memset (&rec, 0, sizeof(FRecBinRecord));
+		if (fabs (t-tlast) > FRECBIN_MAXDT) { // insert time key
+			rec.nv = FRECBIN_TIMEKEY;
+			rec.v[0] = tlast = t;
+			Append ((const char*)&rec, sizeof(FRecBinRecord));
+		}
+		rec.nv = (uint16_t)nv;
+		rec.dt = (float)(t-tlast);
+		tlast += rec.dt; // track the time as seen by the reader, to avoid drift
+		for (i = 0; i < nv; i++) rec.v[i] = v[i];
+		Append ((const char*)&rec, sizeof(FRecBinRecord));
+	} else {
+		char cbuf[256];
+		switch (type) {
+		case FREC_POS:
+			sprintf (cbuf, "%.10g %.12g %.12g %.12g %.10g %.10g %.10g\n", t, v[0], v[1], v[2], v[3], v[4], v[5]);
+			break;
+		case FREC_ATT:
+			sprintf (cbuf, "%.10g %.6g %.6g %.6g\n", t, v[0], v[1], v[2]);
+			break;
+		default:
+			return;
+		}
+		Append (cbuf, strlen (cbuf));
+	}
+}
+
+// =======================================================================
+
+void FRecOStream::Line (const string &line)
+{
+	Append (line.c_str(), line.size());
+	Append ("\n", 1);
+}
+
+// =======================================================================
+// class FRecIStream
+
+FRecIStream::FRecIStream ()
+: type(FREC_POS), binary(false), tlast(0.0)
+{}
+
+// =======================================================================
+
+bool FRecIStream::Open (const char *fname)
+{
+	ifs.open (fname, ios::in | ios::binary);
+	if (!ifs) return false;
+	FRecBinHeader hdr;
+	binary = (ifs.read ((char*)&hdr, sizeof(FRecBinHeader)) && !memcmp (hdr.magic, FRECBIN_MAGIC, 8) &&
+		hdr.version >= 1 && hdr.version <= FRECBIN_VERSION && hdr.type < FREC_EVENT);
+	if (binary) {
+		type = (FRecStreamType)hdr.type;
+	} else {
+		ifs.clear();
+		ifs.seekg (0);
+	}
+	tlast = 0.0;
+	return true;
+}
+
+// =======================================================================
+
+bool FRecIStream::Next (FRecItem &item)
+{
+	if (binary) {
+		FRecBinRecord rec;
+		vector<char> ext;
+		do {
+			if (!ifs.read ((char*)&rec, sizeof(FRecBinRecord))) return false;
+			ext.resize (TagRecords (rec) * sizeof(FRecBinRecord));
+			if (ext.size() && !ifs.read (ext.data(), ext.size())) return false;
+		} while (!DecodeRecord (rec, ext.data(), tlast, item));
+	} else {
+		string line;
+		do {
+			if (!getline (ifs, line)) return false;
+		} while (!DecodeLine (&line[0], item));
+	}
+	return true;
+}
+
+// =======================================================================
+// class FRecMappedStream
+
+FRecMappedStream::FRecMappedStream ()
+: data(nullptr), size(0), binary(false), hFile(nullptr), hMap(nullptr), nsample(0), nvmin(1)
+{}
+
+// =======================================================================
+
+FRecMappedStream::~FRecMappedStream ()
+{
+	Close();
+}
+
+// =======================================================================
+
+bool FRecMappedStream::Open (const char *fname, int _nvmin)
+{
+	Close();
+	nvmin = max (_nvmin, 1);
+
+	// map the file
+#ifdef _WIN32
+	HANDLE hf = CreateFileA (fname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hf == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER fsize;
+	if (!GetFileSizeEx (hf, &fsize) || !fsize.QuadPart) {
+		CloseHandle (hf);
+		return false;
+	}
+	HANDLE hm = CreateFileMappingA (hf, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!hm) {
+		CloseHandle (hf);
+		return false;
+	}
+	data = (const char*)MapViewOfFile (hm, FILE_MAP_READ, 0, 0, 0);
+	if (!data) {
+		CloseHandle (hm);
+		CloseHandle (hf);
+		return false;
+	}
+	hFile = hf;
+	hMap = hm;
+	size = (size_t)fsize.QuadPart;
+#else
+	int fd = open (fname, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat (fd, &st) || !st.st_size) {
+		close (fd);
+		return false;
+	}
+	void *p = mmap (0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd);
+	if (p == MAP_FAILED) return false;
+	data = (const char*)p;
+	size = (size_t)st.st_size;
+#endif
+
+	// check format
+	size_t ofs = 0;
+	binary = (size >= sizeof(FRecBinHeader) && !memcmp (data, FRECBIN_MAGIC, 8));
+	if (binary) ofs = sizeof(FRecBinHeader);
+
+	// scan the stream to build the time index and collect header lines.
+	// Lines are fully decoded here, so that samples are classified by the
+	// same rule as in the array loader.
+	FRecItem item;
+	double tbase = 0.0;
+	size_t ofs0 = ofs;
+	double tbase0 = tbase;
+	while (Decode (ofs, tbase, item)) {
+		if (item.nv >= nvmin) {
+			if (nsample % INDEX_STEP == 0) {
+				IndexEntry e = {item.t, tbase0, ofs0, false};
+				index.push_back (e);
+			}
+			nsample++;
+		} else if (item.nv) { // too few values: not a sample
+			if (nsample) index[(nsample-1) / INDEX_STEP].bShort = true;
+		} else {
+			if (segment.empty() || segment.back().first != nsample) {
+				Segment seg;
+				seg.first = nsample;
+				segment.push_back (seg);
+			}
+			segment.back().tag.push_back (item.tag);
+		}
+		ofs0 = ofs;
+		tbase0 = tbase;
+	}
+	return true;
+}
+
+// =======================================================================
+
+void FRecMappedStream::Close ()
+{
+	if (data) {
+#ifdef _WIN32
+		UnmapViewOfFile (data);
+		CloseHandle ((HANDLE)hMap);
+		CloseHandle ((HANDLE)hFile);
+#else
+		munmap ((void*)data, size);
+#endif
+		data = nullptr;
+		hFile = hMap = nullptr;
+		size = 0;
+	}
+	index.clear();
+	segment.clear();
+	nsample = 0;
+}
+
+// =======================================================================
+
+bool FRecMappedStream::Decode (size_t &ofs, double &tbase, FRecItem &item, bool timeonly) const
+{
+	if (binary) {
+		FRecBinRecord rec;
+		const char *ext;
+		do {
+			if (ofs + sizeof(FRecBinRecord) > size) return false;
+			memcpy (&rec, data+ofs, sizeof(FRecBinRecord));
+			ofs += sizeof(FRecBinRecord);
+			ext = data+ofs;
+			size_t extlen = TagRecords (rec) * sizeof(FRecBinRecord);
+			if (ofs + extlen > size) return false;
+			ofs += extlen;
+		} while (!DecodeRecord (rec, ext, tbase, item));
+	} else {
+		char cbuf[256];
+		string lbuf;  // for lines which don't fit into cbuf
+		char *line;
+		do {
+			if (ofs >= size) return false;
+			const char *eol = (const char*)memchr (data+ofs, '\n', size-ofs);
+			size_t len = (eol ? eol-(data+ofs) : size-ofs);
+			if (len < sizeof(cbuf)) {
+				memcpy (cbuf, data+ofs, len);
+				cbuf[len] = '\0';
+				line = cbuf;
+			} else {
+				lbuf.assign (data+ofs, len);
+				line = &lbuf[0];
+			}
+			ofs += len + (eol ? 1 : 0);
+		} while (!DecodeLine (line, item, timeonly));
+	}
+	return true;
+}
+
+// =======================================================================
+
+bool FRecMappedStream::NextSample (size_t &ofs, double &tbase, size_t i, FRecItem &item, bool timeonly) const
+{
+	// time-only decoding can't tell samples from lines with too few values,
+	// so it is only used if there are none since the previous sample
+	if (timeonly && i && index[(i-1) / INDEX_STEP].bShort) timeonly = false;
+	while (Decode (ofs, tbase, item, timeonly))
+		if (item.nv >= nvmin || (timeonly && item.nv)) return true;
+	return false;
+}
+
+// =======================================================================
+
+bool FRecMappedStream::GetSample (size_t i, FRecItem &item) const
+{
+	if (i >= nsample) return false;
+	const IndexEntry &e = index[i / INDEX_STEP];
+	size_t ofs = e.ofs;
+	double tbase = e.tbase;
+	for (size_t j = i - i % INDEX_STEP; j <= i; j++)
+		if (!NextSample (ofs, tbase, j, item, j < i)) return false;
+	return true;
+}
+
+// =======================================================================
+
+size_t FRecMappedStream::Find (double t) const
+{
+	// find the last index block starting before t
+	size_t lo = 0, hi = index.size();
+	while (lo < hi) {
+		size_t mid = (lo+hi)/2;
+		if (index[mid].t < t) lo = mid+1;
+		else hi = mid;
+	}
+	if (!lo) return 0;
+	size_t blk = lo-1;
+
+	// count the samples earlier than t in this block
+	size_t i = blk*INDEX_STEP;
+	size_t ofs = index[blk].ofs;
+	double tbase = index[blk].tbase;
+	FRecItem item;
+	while (i < nsample && NextSample (ofs, tbase, i, item, true)) {
+		if (item.t >= t) break;
+		i++;
+	}
+	return i;
+}
+
+// =======================================================================
+
+size_t FRecMappedStream::SegmentOf (size_t i) const
+{
+	// last segment with first <= i
+	size_t lo = 0, hi = segment.size();
+	while (lo < hi) {
+		size_t mid = (lo+hi)/2;
+		if (segment[mid].first <= i) lo = mid+1;
+		else hi = mid;
+	}
+	return lo-1;
+}
+
+// =======================================================================
+
+bool FRecConvertToText (const char *fname, const char *outname)
+{
+	FRecIStream is;
+	if (!is.Open (fname)) return false;
+	if (!is.IsBinary()) {
+		if (!outname) return true; // nothing to do
+		ifstream src (fname, ios::in | ios::binary);
+		ofstream dst (outname, ios::out | ios::binary | ios::trunc);
+		dst << src.rdbuf();
+		return dst.good();
+	}
+
+	// convert to a temporary file first, in case we are converting in place
+	string tmpname = string(outname ? outname : fname) + ".tmp";
+	{
+		FRecOStream os;
+		if (!os.Open (tmpname.c_str(), is.Type(), false, false)) return false;
+		FRecItem item;
+		while (is.Next (item)) {
+			if (item.nv) os.Sample (item.t, item.v);
+			else         os.Tag (item.tag);
+		}
+	}
+	is.Close();
+	string target (outname ? outname : fname);
+	remove (target.c_str());
+	return rename (tmpname.c_str(), target.c_str()) == 0;
+}
@@ -0,0 +1,196 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Flight recorder stream I/O
+// Buffered output of flight recorder streams (flushed to disk by a
+// background thread), and reading of position and attitude sample
+// streams in text or compact binary format.
+// This module has no dependencies on the rest of Orbiter, so that it can
+// be shared with the recording converter utility (Utils/frconv).
+// =======================================================================
+
+#ifndef __FRECSTREAM_H
+#define __FRECSTREAM_H
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define FREC_MAXVAL 6  // max. number of values in a stream sample
+
+enum FRecStreamType {
+	FREC_POS,          // position/velocity stream (6 values per sample)
+	FREC_ATT,          // attitude stream (3 Euler angles per sample)
+	FREC_EVENT         // event stream (free text, always written as text)
+};
+
+// =======================================================================
+// A single entry of a sample stream: either a header line (REF, FRM, etc.)
+// or a time-tagged data sample
+
+struct FRecItem {
+	std::string tag;        // header line, or empty for data samples
+	double t;               // sample time [s]
+	double v[FREC_MAXVAL];  // sample values
+	int nv;                 // number of sample values
+};
+
+// =======================================================================
+// class FRecOStream
+// Output stream for one flight recorder file. Writes go into a memory
+// buffer which is written to disk by a background thread, so that
+// recording does not stall the simulation on file access. Close flushes
+// all pending data synchronously.
+
+class FRecOStream {
+public:
+	FRecOStream ();
+	~FRecOStream ();
+
+	bool Open (const char *fname, FRecStreamType type, bool append, bool binary = false);
+	// Open stream file fname. If append is false, existing contents are
+	// discarded. binary selects the compact binary format for sample
+	// streams (ignored for event streams, and when appending to an
+	// existing text stream).
+
+	void Close ();
+	// Write all pending data and close the file
+
+	inline bool IsOpen () const { return buf != nullptr; }
+
+	void Tag (const std::string &line);
+	// Write a header line. In binary streams, lines are limited to 65535
+	// characters.
+
+	void Sample (double t, const double *v);
+	// Write a data sample with the number of values defined by the stream type
+
+	void Line (const std::string &line);
+	// Write a free-text line (event streams only)
+
+	static const size_t FLUSH_SIZE = 0x10000;
+	// buffer size [bytes] above which the background thread is woken
+
+	struct Buffer;  // file and pending data, shared with the flushing thread
+
+private:
+	void Append (const char *data, size_t len);
+
+	Buffer *buf;
+	FRecStreamType type;
+	bool binary;
+	double tlast;           // time base for delta-encoded binary sample times
+};
+
+// =======================================================================
+// class FRecIStream
+// Sequential reader for position and attitude sample streams. The file
+// format (text or binary) is detected automatically.
+
+class FRecIStream {
+public:
+	FRecIStream ();
+
+	bool Open (const char *fname);
+	// Open stream file fname. Returns false if the file can't be opened.
+
+	void Close () { ifs.close(); }
+
+	bool Next (FRecItem &item);
+	// Read the next item. Returns false at the end of the stream.
+
+	inline bool IsBinary () const { return binary; }
+	inline FRecStreamType Type () const { return type; }
+	// Stream type (binary streams only)
+
+private:
+	std::ifstream ifs;
+	FRecStreamType type;
+	bool binary;
+	double tlast;
+};
+
+// =======================================================================
+// class FRecMappedStream
+// Random access to the samples of a position or attitude stream (text or
+// binary) through a memory-mapped view of the file. Opening the stream
+// builds a sparse time index with one entry per INDEX_STEP samples, so
+// that seeking by time is a binary search followed by decoding at most
+// INDEX_STEP samples. Samples are decoded on demand; the stream is never
+// loaded into memory as a whole.
+
+class FRecMappedStream {
+public:
+	FRecMappedStream ();
+	~FRecMappedStream ();
+
+	bool Open (const char *fname, int nvmin = 1);
+	// Map stream file fname and index it. Lines with fewer than nvmin values
+	// are not counted as samples, and are skipped like the array loader
+	// does. Returns false if the file can't be opened or mapped.
+
+	void Close ();
+
+	inline size_t nSample () const { return nsample; }
+	// Number of data samples in the stream
+
+	bool GetSample (size_t i, FRecItem &item) const;
+	// Decode data sample i (0 <= i < nSample())
+
+	size_t Find (double t) const;
+	// Number of samples with a time earlier than t
+
+	struct Segment {
+		size_t first;                  // index of the first sample following the header lines
+		std::vector<std::string> tag;  // header lines
+	};
+	inline const std::vector<Segment> &Segments () const { return segment; }
+	// Header lines of the stream, grouped by the sample they precede.
+	// Header state is cumulative, i.e. the state for a sample is obtained by
+	// applying all segments up to and including the one returned by SegmentOf.
+
+	size_t SegmentOf (size_t i) const;
+	// Index of the last segment preceding sample i, or (size_t)-1 if there is none
+
+	static const size_t INDEX_STEP = 64;
+
+private:
+	struct IndexEntry {
+		double t;      // time of the first sample in the block
+		double tbase;  // time base for decoding the first record of the block
+		size_t ofs;    // file offset of the first record of the block
+		bool bShort;   // block contains lines with fewer than nvmin values
+	};
+
+	bool Decode (size_t &ofs, double &tbase, FRecItem &item, bool timeonly = false) const;
+	// Decode the item at file offset ofs and advance ofs to the next item.
+	// If timeonly is set, the values of text samples are not decoded.
+	// Returns false at the end of the file.
+
+	bool NextSample (size_t &ofs, double &tbase, size_t i, FRecItem &item, bool timeonly) const;
+	// Decode sample i, starting at file offset ofs, which must follow sample
+	// i-1 (or be the offset of an index block containing sample i), and
+	// advance ofs past it. If timeonly is set, only the sample time is
+	// decoded, unless the lines preceding the sample require classification
+	// by their value count.
+
+	const char *data;  // mapped file contents
+	size_t size;       // file size
+	bool binary;
+	void *hFile, *hMap;
+	std::vector<IndexEntry> index;
+	std::vector<Segment> segment;
+	size_t nsample;
+	int nvmin;         // min. number of values of a data sample
+};
+
+// =======================================================================
+
+bool FRecConvertToText (const char *fname, const char *outname = 0);
+// Convert a binary sample stream to the text format written by earlier
+// versions. If outname is not given, the file is converted in place.
+// Returns true if the file was converted, or was a text stream already.
+
+#endif // !__FRECSTREAM_H
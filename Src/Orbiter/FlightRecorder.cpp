@@ -73,6 +73,10 @@ void Vessel::FRecorder_Reset ()
 	frec_last.ref = 0;
 	frec = 0;
 	nfrec = 0;
+	FRpos_map = 0;
+	FRatt_map = 0;
+	frec_buf_idx[0] = frec_buf_idx[1] = -1;
+	frec_att_buf_idx[0] = frec_att_buf_idx[1] = -1;
 	frec_att = 0;
 	frec_att_last.simt = frec_att_last_syst = -1e10;
 	frec_att_last.frm = g_pOrbiter->Cfg()->CfgRecPlayPrm.RecordAttFrame;
@@ -104,9 +108,21 @@ void Vessel::FRecorder_Activate (bool active, const char *fname, bool append)
 		MJDofs = td.MJD0;
 		//frec_last.frm = 1;  // for now, record in equatorial frame by default
 		frec_last.crd = 1;  // for now, record in polar coordinates by default
+
+		// open the output streams, continuing existing streams if this is not the first sample
+		bool isfirst = (frec_last.fstatus == FLIGHTSTATUS_UNDEFINED);
+		bool binary = g_pOrbiter->Cfg()->CfgRecPlayPrm.bRecordBinary;
+		FRpos_ostream.Open (FRfname, FREC_POS, !isfirst, binary);
+		strcpy (cbuf, FRfname); strcpy (cbuf+strlen(cbuf)-3, "att");
+		FRatt_ostream.Open (cbuf, FREC_ATT, !isfirst, binary);
+		strcpy (cbuf+strlen(cbuf)-3, "atc");
+		FRatc_ostream.Open (cbuf, FREC_EVENT, !isfirst);
 	} else {
 		bFRrecord = false;
 		FRecorder_Save (true);
+		FRpos_ostream.Close();
+		FRatt_ostream.Close();
+		FRatc_ostream.Close();
 	}
 }
 
@@ -157,31 +173,35 @@ void Vessel::FRecorder_Save (bool force)
 				}
 				frec_last.rvel    = vel;
 
-				ofstream ofs (FRfname, ios::app);
-				ofs << setprecision(10)  << (frec_last.simt-Tofs) << ' ';
+				double v[6];
 				if (frec_last.crd == 1) { // store in polar coords
 					double r = frec_last.rpos.length();
 					double phi = atan2 (frec_last.rpos.z, frec_last.rpos.x);
 					double tht = asin (frec_last.rpos.y/r);
-					ofs << setprecision(12) << r << ' ' << phi << ' ' << tht << ' ';
 					double sphi = sin(phi), cphi = cos(phi), stht = sin(tht), ctht = cos(tht);
 					double arg  = cphi*frec_last.rvel.x + sphi*frec_last.rvel.z;
-					double vr   = stht*frec_last.rvel.y + ctht*arg;
-					double vphi = (cphi*frec_last.rvel.z - sphi*frec_last.rvel.x) / (r*ctht);
-					double vtht = (ctht*frec_last.rvel.y - stht*arg)/r;
-					ofs << setprecision(10) << vr << ' ' << vphi << ' ' << vtht << endl;
+					v[0] = r;
+					v[1] = phi;
+					v[2] = tht;
+					v[3] = stht*frec_last.rvel.y + ctht*arg;                             // vr
+					v[4] = (cphi*frec_last.rvel.z - sphi*frec_last.rvel.x) / (r*ctht); // vphi
+					v[5] = (ctht*frec_last.rvel.y - stht*arg)/r;                         // vtht
 				} else {
-					ofs << setprecision(12) << frec_last.rpos.x << ' ' << frec_last.rpos.y << ' ' << frec_last.rpos.z << ' ';
-					ofs << setprecision(10) << frec_last.rvel.x << ' ' << frec_last.rvel.y << ' ' << frec_last.rvel.z << endl;
+					for (i = 0; i < 3; i++) {
+						v[i] = frec_last.rpos.data[i];
+						v[i+3] = frec_last.rvel.data[i];
+					}
 				}
+				FRpos_ostream.Sample (frec_last.simt-Tofs, v);
 			}
 		}
 		if (cbody != ref) {
-			ofstream ofs(FRfname, isfirst ? ios::trunc : ios::app);
-			ofs << "STARTMJD " << setprecision(12) << MJDofs << endl;
-			ofs << "REF " << cbody->Name() << endl;
-			ofs << "FRM " << (frec_last.frm == 0 ? "ECLIPTIC" : "EQUATORIAL") << endl;
-			ofs << "CRD " << (frec_last.crd == 0 ? "CARTESIAN" : "POLAR") << endl;
+			char cbuf[256];
+			sprintf (cbuf, "STARTMJD %.12g", MJDofs);
+			FRpos_ostream.Tag (cbuf);
+			FRpos_ostream.Tag (string("REF ") + cbody->Name());
+			FRpos_ostream.Tag (frec_last.frm == 0 ? "FRM ECLIPTIC" : "FRM EQUATORIAL");
+			FRpos_ostream.Tag (frec_last.crd == 0 ? "CRD CARTESIAN" : "CRD POLAR");
 			frec_last.ref = ref = cbody;
 		}
 	} 
@@ -235,13 +255,7 @@ void Vessel::FRecorder_Save (bool force)
 				if (diff > alim) attforce = true;
 			}
 			if (attforce) {
-				char cbuf[256];
-				strcpy (cbuf, FRfname); strcpy (cbuf+strlen(cbuf)-3, "att");
-				ofstream ofs (cbuf, ios::app);
-				ofs << setprecision(10) << (td.SimT1-Tofs) << setprecision(6);
-				for (i = 0; i < 3; i++)
-					ofs << ' ' << (/*frec_att_last.att[i] =*/ a[i]);
-				ofs << endl;
+				FRatt_ostream.Sample (td.SimT1-Tofs, a);
 				frec_att_last.q.Set (q);
 				frec_att_last_syst = td.SysT1;
 				frec_att_last.simt = td.SimT1;
@@ -249,18 +263,18 @@ void Vessel::FRecorder_Save (bool force)
 		
 		}
 		if (ref != sp.ref) {
-			char cbuf[256];
-			strcpy (cbuf, FRfname); strcpy (cbuf+strlen(cbuf)-3, "att");
-			ofstream ofs (cbuf, isfirst ? ios::trunc : ios::app);
-			if (isfirst)
-				ofs << "STARTMJD " << setprecision(12) << MJDofs << endl;
+			if (isfirst) {
+				char cbuf[256];
+				sprintf (cbuf, "STARTMJD %.12g", MJDofs);
+				FRatt_ostream.Tag (cbuf);
+			}
 			switch (frec_att_last.frm) {
 			case 0:
-				ofs << "FRM ECLIPTIC" << endl;
+				FRatt_ostream.Tag ("FRM ECLIPTIC");
 				break;
 			case 1:
-				ofs << "REF " << sp.ref->Name() << endl;
-				ofs << "FRM HORIZON" << endl;
+				FRatt_ostream.Tag (string("REF ") + sp.ref->Name());
+				FRatt_ostream.Tag ("FRM HORIZON");
 				break;
 			}
 			frec_att_last.ref = ref = sp.ref;
@@ -280,37 +294,32 @@ void Vessel::FRecorder_Save (bool force)
 		}
 		else frec_eng = 0;
 	}
-	bool bfopen = false;
+	string line;
+	char cbuf[256];
 	dt = td.SimT1-frec_eng_simt;
 	alim = min (0.2, 0.1/dt);
-	ofstream ofs;
 	for (j = 0; j < m_thruster.size(); j++) {
 		if (fabs(frec_eng[j]-m_thruster[j]->level) > alim || force) {
-			if (!bfopen) {
+			if (line.empty()) {
 				frec_eng_simt = td.SimT1;
-				char cbuf[256];
-				strcpy (cbuf, FRfname); strcpy (cbuf+strlen(cbuf)-3, "atc");
-				ofs.open (cbuf, isfirst ? ios::trunc : ios::app);
-				ofs << setprecision(10) << (frec_eng_simt-Tofs) << " ENG";
-				bfopen = true;
+				sprintf (cbuf, "%.10g ENG", frec_eng_simt-Tofs);
+				line = cbuf;
 			}
-			ofs << ' ' << j << ':' << setprecision(2) << (frec_eng[j] = m_thruster[j]->level);
+			sprintf (cbuf, " %d:%.2g", (int)j, frec_eng[j] = m_thruster[j]->level);
+			line += cbuf;
 		}
 	}
-	if (bfopen) {
-		ofs << endl;
-		ofs.close();
-	}
+	if (line.size())
+		FRatc_ostream.Line (line);
 }
 
 // Save a vessel-specific event
 void Vessel::FRecorder_SaveEvent (const char *event_type, const char *event)
 {
 	if (!bFRrecord) return;
-	char cbuf[256];
-	strcpy (cbuf, FRfname); strcpy (cbuf+strlen(cbuf)-3, "atc");
-	ofstream ofs(cbuf, ios::app);
-	ofs << setprecision(10) << (td.SimT1-Tofs) << ' ' << event_type << ' ' << event << endl;
+	char cbuf[64];
+	sprintf (cbuf, "%.10g ", td.SimT1-Tofs);
+	FRatc_ostream.Line (string(cbuf) + event_type + ' ' + event);
 }
 
 void Vessel::FRecorder_SaveEventInt (const char *event_type, int event)
@@ -342,10 +351,27 @@ void Vessel::FRecorder_Clear ()
 		frec_eng = NULL;
 		nfrec_eng = 0;
 	}
+	if (FRpos_map) {
+		delete FRpos_map;
+		FRpos_map = 0;
+		nfrec = 0;
+	}
+	if (FRatt_map) {
+		delete FRatt_map;
+		FRatt_map = 0;
+		nfrec_att = 0;
+	}
+	frec_seg.clear();
+	frec_att_seg.clear();
+	frec_buf_idx[0] = frec_buf_idx[1] = -1;
+	frec_att_buf_idx[0] = frec_att_buf_idx[1] = -1;
 	if (FRfname) {
 		delete []FRfname;
 		FRfname = NULL;
 	}
+	FRpos_ostream.Close();
+	FRatt_ostream.Close();
+	FRatc_ostream.Close();
 	if (FRatc_stream) {
 		delete FRatc_stream;
 		FRatc_stream = 0;
@@ -354,6 +380,75 @@ void Vessel::FRecorder_Clear ()
 	bFRrecord = false;
 }
 
+// Apply a header line of a position stream to the stream state in rec
+static void FRecorder_PosTag (const char *line, FRecord &rec)
+{
+	char cbuf[256];
+	strncpy (cbuf, line, 255); cbuf[255] = '\0';
+	if (!_strnicmp (cbuf, "REF", 3)) {
+		rec.ref = g_psys->GetGravObj (trim_string (cbuf+4), true);
+		if (!rec.ref) rec.ref = g_psys->GetGravObj (0);
+	} else if (!_strnicmp (cbuf, "FRM", 3)) {
+		if (!_stricmp (trim_string (cbuf+4), "EQUATORIAL")) rec.frm = 1;
+		else rec.frm = 0;
+	} else if (!_strnicmp (cbuf, "CRD", 3)) {
+		if (!_stricmp (trim_string (cbuf+4), "POLAR")) rec.crd = 1;
+		else rec.crd = 0;
+	} else if (!_strnicmp (cbuf, "STARTMJD", 8)) {
+		sscanf (cbuf+9, "%lf", &MJDofs);
+	}
+}
+
+// Set position sample rec from stream data sample item, using the stream state in rec
+static void FRecorder_PosSample (const FRecItem &item, FRecord &rec)
+{
+	double x = item.v[0], y = item.v[1], z = item.v[2];
+	double vx = item.v[3], vy = item.v[4], vz = item.v[5];
+	if (rec.crd == 1) { // map from polar coords
+		double xz, r = x, phi = y, tht = z;
+		double vr = vx, vphi = vy, vtht = vz;
+		double sphi = sin(phi), cphi = cos(phi), stht = sin(tht), ctht = cos(tht);
+		y = r*sin(tht); xz = r*cos(tht);
+		x = xz*cos(phi); z = xz*sin(phi);
+		vx = vr*cphi*ctht - r*vphi*sphi*ctht - r*vtht*cphi*stht;
+		vy = vr*stht + r*vtht*ctht;
+		vz = vr*sphi*ctht + r*vphi*cphi*ctht - r*vtht*sphi*stht;
+		//vy = vr*sin(vtht); xz = vr*cos(vtht);
+		//vx = xz*cos(vphi); vz = xz*sin(vphi);
+	}
+	rec.simt = item.t;
+	rec.rpos.Set (x, y, z);
+	rec.rvel.Set (vx, vy, vz);
+}
+
+// Apply a header line of an attitude stream to the stream state in rec
+static void FRecorder_AttTag (const char *line, FRecord_att &rec)
+{
+	char cbuf[256];
+	strncpy (cbuf, line, 255); cbuf[255] = '\0';
+	if (!_strnicmp (cbuf, "REF", 3)) {
+		rec.ref = g_psys->GetGravObj (trim_string (cbuf+4), true);
+		if (!rec.ref) rec.ref = g_psys->GetGravObj (0);
+	} else if (!_strnicmp (cbuf, "FRM", 3)) {
+		if (!_stricmp (trim_string (cbuf+4), "HORIZON")) rec.frm = 1;
+		else rec.frm = 0;
+	} else if (!_strnicmp (cbuf, "STARTMJD", 8)) {
+		sscanf (cbuf+9, "%lf", &MJDofs);
+		// assumes that MJDofs from all streams are the same!
+	}
+}
+
+// Set attitude sample rec from stream data sample item, using the stream state in rec
+static void FRecorder_AttSample (const FRecItem &item, FRecord_att &rec)
+{
+	double a[3];
+	for (int i = 0; i < 3; i++) a[i] = item.v[i];
+	rec.simt = item.t;
+
+	// convert Euler angles to quaternions
+	Euler2Quaternion (a, rec.q, rec.frm);
+}
+
 bool Vessel::FRecorder_Read (const char *scname)
 {
 	int i;
@@ -363,103 +458,99 @@ bool Vessel::FRecorder_Read (const char *scname)
 		if (scname[i-1] == '\\') break;
 	sprintf (fname, "Flights/%s/%s.pos", scname+i, name.c_str());
 
-	ifstream ifs (fname);
-	if (!ifs) {
+	FRecIStream ifs;
+	if (!ifs.Open (fname)) {
 		bFRplayback = false;
 		return false;
 	}
 
 	FRecorder_Clear();
 	
-	int nbuf = 0, nbuf_att = 0, frm = 0, crd = 0, attfrm = 0;
-	double simt, x, y, z, vx, vy, vz;
-	const CelestialBody *ref = g_psys->GetGravObj(0);
+	int nbuf = 0, nbuf_att = 0;
+	bool mapped = g_pOrbiter->Cfg()->CfgRecPlayPrm.bMappedPlayback;
+	FRecItem item;
+	FRecord pos;
+	FRecord_att att;
+	pos.ref = att.ref = g_psys->GetGravObj(0);
+	pos.frm = pos.crd = att.frm = 0;
 
 	// open position/velocity stream
-	while (ifs.getline (cbuf, 256)) {
-		if (!_strnicmp (cbuf, "REF", 3)) {
-			ref = g_psys->GetGravObj (trim_string (cbuf+4), true);
-			if (!ref) ref = g_psys->GetGravObj (0);
-		} else if (!_strnicmp (cbuf, "FRM", 3)) {
-			if (!_stricmp (trim_string (cbuf+4), "EQUATORIAL")) frm = 1;
-			else frm = 0;
-		} else if (!_strnicmp (cbuf, "CRD", 3)) {
-			if (!_stricmp (trim_string (cbuf+4), "POLAR")) crd = 1;
-			else crd = 0;
-		} else if (!_strnicmp (cbuf, "STARTMJD", 8)) {
-			sscanf (cbuf+9, "%lf", &MJDofs);
-		} else {
-			if (sscanf (cbuf, "%lf%lf%lf%lf%lf%lf%lf", &simt, &x, &y, &z, &vx, &vy, &vz) != 7)
-				continue;
-			if (crd == 1) { // map from polar coords
-				double xz, r = x, phi = y, tht = z;
-				double vr = vx, vphi = vy, vtht = vz;
-				double sphi = sin(phi), cphi = cos(phi), stht = sin(tht), ctht = cos(tht);
-				y = r*sin(tht); xz = r*cos(tht);
-				x = xz*cos(phi); z = xz*sin(phi);
-				vx = vr*cphi*ctht - r*vphi*sphi*ctht - r*vtht*cphi*stht;
-				vy = vr*stht + r*vtht*ctht;
-				vz = vr*sphi*ctht + r*vphi*cphi*ctht - r*vtht*sphi*stht;
-				//vy = vr*sin(vtht); xz = vr*cos(vtht);
-				//vx = xz*cos(vphi); vz = xz*sin(vphi);
+	if (mapped) {
+		FRpos_map = new FRecMappedStream; TRACENEW
+		if (FRpos_map->Open (fname, 6) && FRpos_map->nSample() > 1) {
+			// evaluate the stream state for each header segment
+			for (const auto &seg : FRpos_map->Segments()) {
+				for (const auto &tag : seg.tag)
+					FRecorder_PosTag (tag.c_str(), pos);
+				frec_seg.push_back (pos);
 			}
-			if (nfrec == nbuf) { // re-allocate
-				FRecord *tmp = new FRecord[nbuf += 1024]; TRACENEW
-				if (nfrec) {
-					memcpy (tmp, frec, nfrec*sizeof(FRecord));
-					delete []frec;
+			nfrec = (int)FRpos_map->nSample();
+			frec_tend = FRecorder_Pos (nfrec-1).simt;
+		} else {
+			delete FRpos_map;
+			FRpos_map = 0;
+		}
+	}
+	if (!FRpos_map) {
+		while (ifs.Next (item)) {
+			if (!item.nv) { // header line
+				FRecorder_PosTag (item.tag.c_str(), pos);
+			} else if (item.nv == 6) { // data sample
+				if (nfrec == nbuf) { // re-allocate
+					FRecord *tmp = new FRecord[nbuf += 1024]; TRACENEW
+					if (nfrec) {
+						memcpy (tmp, frec, nfrec*sizeof(FRecord));
+						delete []frec;
+					}
+					frec = tmp;
 				}
-				frec = tmp;
+				FRecorder_PosSample (item, pos);
+				frec[nfrec++] = pos;
 			}
-			frec[nfrec].simt = simt;
-			frec[nfrec].frm  = frm;
-			frec[nfrec].ref  = ref;
-			frec[nfrec].rpos.Set (x, y, z);
-			frec[nfrec].rvel.Set (vx, vy, vz);
-			nfrec++;
 		}
+		frec_tend = (nfrec ? frec[nfrec-1].simt : -1e10);
 	}
-	ifs.close();
-	ifs.clear();
+	ifs.Close();
 	cfrec = 0;
 	cfrec_att = 0;
 
 	// open attitude stream
-	ref = g_psys->GetGravObj(0);
 	strcpy (fname+strlen(fname)-3, "att");
-	ifs.open (fname);
-	while (ifs.getline (cbuf, 256)) {
-		if (!_strnicmp (cbuf, "REF", 3)) {
-			ref = g_psys->GetGravObj (trim_string (cbuf+4), true);
-			if (!ref) ref = g_psys->GetGravObj (0);
-		} else if (!_strnicmp (cbuf, "FRM", 3)) {
-			if (!_stricmp (trim_string (cbuf+4), "HORIZON")) attfrm = 1;
-			else attfrm = 0;
-		} else if (!_strnicmp (cbuf, "STARTMJD", 8)) {
-			sscanf (cbuf+9, "%lf", &MJDofs);
-			// assumes that MJDofs from all streams are the same!
+	if (mapped) {
+		FRatt_map = new FRecMappedStream; TRACENEW
+		if (FRatt_map->Open (fname, 3) && FRatt_map->nSample() > 1) {
+			for (const auto &seg : FRatt_map->Segments()) {
+				for (const auto &tag : seg.tag)
+					FRecorder_AttTag (tag.c_str(), att);
+				frec_att_seg.push_back (att);
+			}
+			nfrec_att = (int)FRatt_map->nSample();
+			frec_att_tend = FRecorder_Att (nfrec_att-1).simt;
 		} else {
-			double a[3];
-			sscanf (cbuf, "%lf%lf%lf%lf", &simt, a+0, a+1, a+2);
-			if (nfrec_att == nbuf_att) { // re-allocate
-				FRecord_att *tmp = new FRecord_att[nbuf_att += 1024]; TRACENEW
-				if (nfrec_att) {
-					memcpy (tmp, frec_att, nfrec_att*sizeof(FRecord_att));
-					delete []frec_att;
+			delete FRatt_map;
+			FRatt_map = 0;
+		}
+	}
+	if (!FRatt_map) {
+		FRecIStream ifs_att;
+		ifs_att.Open (fname);
+		while (ifs_att.Next (item)) {
+			if (!item.nv) { // header line
+				FRecorder_AttTag (item.tag.c_str(), att);
+			} else if (item.nv >= 3) { // data sample
+				if (nfrec_att == nbuf_att) { // re-allocate
+					FRecord_att *tmp = new FRecord_att[nbuf_att += 1024]; TRACENEW
+					if (nfrec_att) {
+						memcpy (tmp, frec_att, nfrec_att*sizeof(FRecord_att));
+						delete []frec_att;
+					}
+					frec_att = tmp;
 				}
-				frec_att = tmp;
+				FRecorder_AttSample (item, att);
+				frec_att[nfrec_att++] = att;
 			}
-			frec_att[nfrec_att].simt = simt;
-			frec_att[nfrec_att].frm = attfrm;
-			frec_att[nfrec_att].ref = ref;
-
-			// convert Euler angles to quaternions
-			Euler2Quaternion (a, frec_att[nfrec_att].q, frec_att[nfrec_att].frm);
-			//for (int i = 0; i < 3; i++)
-			//	frec_att[nfrec_att].att[i] = a[i];
-
-			nfrec_att++;
 		}
+		frec_att_tend = (nfrec_att ? frec_att[nfrec_att-1].simt : -1e10);
 	}
 
 	// open articulation event stream
@@ -476,6 +567,85 @@ bool Vessel::FRecorder_Read (const char *scname)
 	return true;
 }
 
+const FRecord &Vessel::FRecorder_Pos (int i)
+{
+	if (!FRpos_map) return frec[i];
+
+	// decode from the mapped stream, caching the last two samples
+	FRecord &rec = frec_buf[i & 1];
+	if (frec_buf_idx[i & 1] != i) {
+		FRecItem item;
+		size_t seg = FRpos_map->SegmentOf (i);
+		if (seg != (size_t)-1) rec = frec_seg[seg];
+		else rec.ref = g_psys->GetGravObj(0), rec.frm = rec.crd = 0;
+		FRpos_map->GetSample (i, item);
+		FRecorder_PosSample (item, rec);
+		frec_buf_idx[i & 1] = i;
+	}
+	return rec;
+}
+
+const FRecord_att &Vessel::FRecorder_Att (int i)
+{
+	if (!FRatt_map) return frec_att[i];
+
+	FRecord_att &rec = frec_att_buf[i & 1];
+	if (frec_att_buf_idx[i & 1] != i) {
+		FRecItem item;
+		size_t seg = FRatt_map->SegmentOf (i);
+		if (seg != (size_t)-1) rec = frec_att_seg[seg];
+		else rec.ref = g_psys->GetGravObj(0), rec.frm = 0;
+		FRatt_map->GetSample (i, item);
+		FRecorder_AttSample (item, rec);
+		frec_att_buf_idx[i & 1] = i;
+	}
+	return rec;
+}
+
+// Return index i such that the samples i and i+1 bracket time t, or the
+// first or last sample interval if t is outside the recorded range.
+// Samples are traversed sequentially during normal playback, so the
+// current interval and its successor are tried before searching.
+int Vessel::FRecorder_SeekPos (int cur, double t)
+{
+	if (nfrec < 2) return 0;
+	for (int i = cur; i <= cur+1 && i+1 < nfrec; i++)
+		if (FRecorder_Pos(i+1).simt >= t && (!i || FRecorder_Pos(i).simt < t)) return i;
+	int k;
+	if (FRpos_map) {
+		k = (int)FRpos_map->Find (t);
+	} else {
+		int lo = 0, hi = nfrec;
+		while (lo < hi) {
+			int mid = (lo+hi)/2;
+			if (frec[mid].simt < t) lo = mid+1;
+			else hi = mid;
+		}
+		k = lo;
+	}
+	return max (0, min (k-1, nfrec-2));
+}
+
+int Vessel::FRecorder_SeekAtt (int cur, double t)
+{
+	if (nfrec_att < 2) return 0;
+	for (int i = cur; i <= cur+1 && i+1 < nfrec_att; i++)
+		if (FRecorder_Att(i+1).simt >= t && (!i || FRecorder_Att(i).simt < t)) return i;
+	int k;
+	if (FRatt_map) {
+		k = (int)FRatt_map->Find (t);
+	} else {
+		int lo = 0, hi = nfrec_att;
+		while (lo < hi) {
+			int mid = (lo+hi)/2;
+			if (frec_att[mid].simt < t) lo = mid+1;
+			else hi = mid;
+		}
+		k = lo;
+	}
+	return max (0, min (k-1, nfrec_att-2));
+}
+
 void Vessel::FRecorder_Play ()
 {
 	dCHECK(s1, "Update state not available.")
@@ -488,40 +658,41 @@ void Vessel::FRecorder_Play ()
 		int i;
 		static Vector s;
 
-		while (cfrec+2 < nfrec && frec[cfrec+1].simt < td.SimT1) cfrec++;
-		dT = frec[cfrec+1].simt - frec[cfrec].simt;
-		dt = td.SimT1 - frec[cfrec].simt;
+		cfrec = FRecorder_SeekPos (cfrec, td.SimT1);
+		const FRecord &f0 = FRecorder_Pos (cfrec), &f1 = FRecorder_Pos (cfrec+1);
+		dT = f1.simt - f0.simt;
+		dt = td.SimT1 - f0.simt;
 
-		Vector P0 = frec[cfrec].rpos, P1 = frec[cfrec+1].rpos;
-		Vector V0 = frec[cfrec].rvel, V1 = frec[cfrec+1].rvel;
-		if (frec[cfrec].frm == 1) { // map from equatorial frame
+		Vector P0 = f0.rpos, P1 = f1.rpos;
+		Vector V0 = f0.rvel, V1 = f1.rvel;
+		if (f0.frm == 1) { // map from equatorial frame
 			// propagate from current rotation state to rotation state at last sample
-			double dlng = Pi2*dt/frec[cfrec].ref->RotT(), sind = sin(dlng), cosd = cos(dlng);
+			double dlng = Pi2*dt/f0.ref->RotT(), sind = sin(dlng), cosd = cos(dlng);
 			s.x =  P0.x*cosd + P0.z*sind;
 			s.z = -P0.x*sind + P0.z*cosd;
 			s.y =  P0.y;
-			P0.Set (mul (frec[cfrec].ref->s1->R, s));
+			P0.Set (mul (f0.ref->s1->R, s));
 
 			// Needs to be fixed!
-			frec[cfrec].ref->LocalToEquatorial (s, lng, lat, rad);
-			vref = Pi2/frec[cfrec].ref->RotT() * rad * cos(lat);
+			f0.ref->LocalToEquatorial (s, lng, lat, rad);
+			vref = Pi2/f0.ref->RotT() * rad * cos(lat);
 			s.x =  V0.x*cosd + V0.z*sind;
 			s.z = -V0.x*sind + V0.z*cosd;
 			s.y =  V0.y;
-			V0.Set (mul (frec[cfrec].ref->s1->R, s + Vector (-vref*sin(lng),0,vref*cos(lng))));
+			V0.Set (mul (f0.ref->s1->R, s + Vector (-vref*sin(lng),0,vref*cos(lng))));
 		}
-		if (frec[cfrec+1].frm == 1) { // map from equatorial frame
-			double dlng = Pi2*(dt-dT)/frec[cfrec+1].ref->RotT(), sind = sin(dlng), cosd = cos(dlng);
+		if (f1.frm == 1) { // map from equatorial frame
+			double dlng = Pi2*(dt-dT)/f1.ref->RotT(), sind = sin(dlng), cosd = cos(dlng);
 			s.x =  P1.x*cosd + P1.z*sind;
 			s.z = -P1.x*sind + P1.z*cosd;
 			s.y =  P1.y;
-			P1.Set (mul (frec[cfrec+1].ref->s1->R, s));
-			frec[cfrec+1].ref->LocalToEquatorial (s, lng, lat, rad);
-			vref = Pi2/frec[cfrec+1].ref->RotT() * rad * cos(lat);
+			P1.Set (mul (f1.ref->s1->R, s));
+			f1.ref->LocalToEquatorial (s, lng, lat, rad);
+			vref = Pi2/f1.ref->RotT() * rad * cos(lat);
 			s.x =  V1.x*cosd + V1.z*sind;
 			s.z = -V1.x*sind + V1.z*cosd;
 			s.y =  V1.y;
-			V1.Set (mul (frec[cfrec].ref->s1->R, s + Vector (-vref*sin(lng),0,vref*cos(lng))));
+			V1.Set (mul (f0.ref->s1->R, s + Vector (-vref*sin(lng),0,vref*cos(lng))));
 		}
 
 		for (i = 0; i < 3; i++) {
@@ -533,39 +704,40 @@ void Vessel::FRecorder_Play ()
 			sv->pos.data[i] = r0 + v0*dt + 0.5*a0*dt*dt + b*dt*dt*dt/6.0;
 		}
 
-		sv->pos += frec[cfrec].ref->s1->pos;
-		sv->vel += frec[cfrec].ref->s1->vel;
+		sv->pos += f0.ref->s1->pos;
+		sv->vel += f0.ref->s1->vel;
 	
 		// attitude
-		if (td.SimT1 < frec_att[nfrec_att-1].simt) {
+		if (td.SimT1 < frec_att_tend) {
 
 			// store old orientation for calculating angular velocities
 			Vector r1 (sv->R.m11, sv->R.m21, sv->R.m31);
 			Vector r2 (sv->R.m12, sv->R.m22, sv->R.m32);
 			Vector r3 (sv->R.m13, sv->R.m23, sv->R.m33);
 
-			while (cfrec_att+2 < nfrec_att && frec_att[cfrec_att+1].simt < td.SimT1) cfrec_att++;
-			dt = frec_att[cfrec_att+1].simt - frec_att[cfrec_att].simt;
-			w1 = (td.SimT1-frec_att[cfrec_att].simt)/dt;
+			cfrec_att = FRecorder_SeekAtt (cfrec_att, td.SimT1);
+			const FRecord_att &fa0 = FRecorder_Att (cfrec_att), &fa1 = FRecorder_Att (cfrec_att+1);
+			dt = fa1.simt - fa0.simt;
+			w1 = (td.SimT1-fa0.simt)/dt;
 			w0 = 1.0-w1;
 
 			// Orientation at intermediate time point by interpolating endpoint quaternions
-			if (frec_att[cfrec_att].frm == 0) {
+			if (fa0.frm == 0) {
 				Quaternion Q;
-				Q.interp (frec_att[cfrec_att].q, frec_att[cfrec_att+1].q, w1);
+				Q.interp (fa0.q, fa1.q, w1);
 				sv->SetRot (Q);
 			} else {
 				Quaternion Q;
-				Q.interp (frec_att[cfrec_att].q, frec_att[cfrec_att+1].q, w1);
+				Q.interp (fa0.q, fa1.q, w1);
 				sv->R.Set (Q);
 				double lng, lat, rad, slng, clng, slat, clat;
-				Vector loc = tmul (frec_att[cfrec_att].ref->s1->R, sv->pos - frec_att[cfrec_att].ref->s1->pos);
-				frec_att[cfrec_att].ref->LocalToEquatorial (loc, lng, lat, rad);
+				Vector loc = tmul (fa0.ref->s1->R, sv->pos - fa0.ref->s1->pos);
+				fa0.ref->LocalToEquatorial (loc, lng, lat, rad);
 				slng = sin(lng), clng = cos(lng), slat = sin(lat), clat = cos(lat);
 				sv->R.postmul (Matrix (-slng,      0,     clng,
 					                    clat*clng, slat,  clat*slng,
 									   -slat*clng, clat, -slat*slng));
-				sv->R.tpostmul (frec_att[cfrec_att].ref->s1->R);
+				sv->R.tpostmul (fa0.ref->s1->R);
 				//rrot.postmul (sp.Local2Hor());
 				//rrot.tpostmul (cbody->GRot());
 				sv->SetRot (transp (sv->R));
@@ -734,7 +906,7 @@ void Vessel::FRecorder_PlayEvent ()
 
 void Vessel::FRecorder_CheckEnd ()
 {
-	if (td.SimT1 > frec[nfrec-1].simt) { // reached end of playback list
+	if (td.SimT1 > frec_tend) { // reached end of playback list
 		g_pOrbiter->EndPlayback();
 		//FRecorder_EndPlayback();
 		//g_pOrbiter->SNote()->ClearNote();
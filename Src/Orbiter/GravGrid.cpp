@@ -0,0 +1,259 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+#include "GravGrid.h"
+#include "PinesGrav.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+static const double PI = 3.14159265358979323846;
+
+static const char GRAVGRID_MAGIC[8] = "ORBGGRD";
+static const uint32_t GRAVGRID_VERSION = 1;
+
+struct GravGridHeader {
+	char     magic[8];     // GRAVGRID_MAGIC
+	uint32_t version;      // GRAVGRID_VERSION
+	int32_t  degree;       // model degree/order
+	int32_t  samples;      // nodes per half-wavelength
+	int32_t  ntile;        // size of the tile directory
+	double   rmin, rmax;   // radial extent [km]
+	int32_t  nstored;      // number of stored tiles
+	int32_t  tilesize;     // sizeof(Tile)
+};
+// The header is followed by nstored records of an int32 tile index and the tile data
+
+// =======================================================================
+// class GravGrid
+
+GravGrid::GravGrid (const PinesGravProp *_pines, int _samples, double maxalt, size_t maxmem)
+: pines(_pines), ntilebuilt(0), nbuilt(0), bBuilding(false), bTerminate(false)
+{
+	degree = (int)pines->GetCoeffCutoff();
+	samples = (_samples < 2 ? 2 : _samples);
+	errbound = (PI/samples)*(PI/samples)/8.0;
+
+	int n = (degree < 2 ? 2 : degree);
+	double R = pines->GetRefRadius();
+	int nlat = (samples*n + TILE_ANG-1) / TILE_ANG * TILE_ANG; // latitude cells
+	int nlng = 2*nlat;                                          // longitude cells
+	dlat = PI/nlat;
+	dlng = 2.0*PI/nlng;
+	dr = R*dlat;
+	rmin = R - TILE_RAD*dr; // allow for terrain below the reference radius
+	nband = (int)ceil ((maxalt + TILE_RAD*dr) / (TILE_RAD*dr));
+	rmax = rmin + nband*TILE_RAD*dr;
+	ntlat = nlat/TILE_ANG;
+	ntlng = nlng/TILE_ANG;
+	ntile = nband*ntlat*ntlng;
+	maxtile = maxmem / sizeof(Tile);
+
+	tile.reset (new std::atomic<Tile*>[ntile]);
+	requested.reset (new std::atomic<bool>[ntile]);
+	for (int i = 0; i < ntile; i++) {
+		tile[i].store (nullptr, std::memory_order_relaxed);
+		requested[i].store (false, std::memory_order_relaxed);
+	}
+}
+
+// =======================================================================
+
+GravGrid::~GravGrid ()
+{
+	if (builder.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock (buildMutex);
+			bTerminate = true;
+		}
+		cvQueue.notify_one();
+		builder.join();
+	}
+	for (int i = 0; i < ntile; i++)
+		delete tile[i].load (std::memory_order_relaxed);
+}
+
+// =======================================================================
+
+bool GravGrid::Eval (const Vector &rpos, Vector &acc)
+{
+	double r = rpos.length();
+	if (r < rmin || r >= rmax) return false;
+
+	double fr   = (r - rmin)/dr;
+	double flat = (asin (rpos.z/r) + 0.5*PI)/dlat;
+	double flng = (atan2 (rpos.y, rpos.x) + PI)/dlng;
+	int k = (int)fr, i = (int)flat, j = (int)flng;
+	if (i >= ntlat*TILE_ANG) i = ntlat*TILE_ANG-1; // north pole
+	if (j >= ntlng*TILE_ANG) j = 0, flng = 0.0;    // longitude wrap
+	fr -= k, flat -= i, flng -= j;
+
+	int tb = k/TILE_RAD, ti = i/TILE_ANG, tj = j/TILE_ANG;
+	int idx = TileIndex (tb, ti, tj);
+	Tile *t = tile[idx].load (std::memory_order_acquire);
+	if (!t) {
+		Request (idx);
+		return false;
+	}
+	k -= tb*TILE_RAD, i -= ti*TILE_ANG, j -= tj*TILE_ANG;
+
+	// trilinear interpolation
+	const float (*v0)[TILE_ANG+1][3] = t->v[k];
+	const float (*v1)[TILE_ANG+1][3] = t->v[k+1];
+	double w[8] = {
+		(1-fr)*(1-flat)*(1-flng), (1-fr)*(1-flat)*flng, (1-fr)*flat*(1-flng), (1-fr)*flat*flng,
+		fr*(1-flat)*(1-flng),     fr*(1-flat)*flng,     fr*flat*(1-flng),     fr*flat*flng
+	};
+	for (int c = 0; c < 3; c++) {
+		acc.data[c] =
+			w[0]*v0[i][j][c] + w[1]*v0[i][j+1][c] + w[2]*v0[i+1][j][c] + w[3]*v0[i+1][j+1][c] +
+			w[4]*v1[i][j][c] + w[5]*v1[i][j+1][c] + w[6]*v1[i+1][j][c] + w[7]*v1[i+1][j+1][c];
+	}
+	return true;
+}
+
+// =======================================================================
+
+void GravGrid::Request (int idx)
+{
+	if (requested[idx].exchange (true, std::memory_order_relaxed)) return; // queued before
+	std::lock_guard<std::mutex> lock (buildMutex);
+	if (ntilebuilt + queue.size() >= maxtile) return; // memory limit reached
+	queue.push_back (idx);
+	if (!builder.joinable())
+		builder = std::thread (&GravGrid::BuildProc, this);
+	cvQueue.notify_one();
+}
+
+// =======================================================================
+
+void GravGrid::Wait ()
+{
+	std::unique_lock<std::mutex> lock (buildMutex);
+	cvIdle.wait (lock, [this]{ return queue.empty() && !bBuilding; });
+}
+
+// =======================================================================
+
+void GravGrid::BuildProc ()
+{
+	std::unique_lock<std::mutex> lock (buildMutex);
+	for (;;) {
+		cvQueue.wait (lock, [this]{ return bTerminate || !queue.empty(); });
+		if (bTerminate) break;
+		int idx = queue.front();
+		queue.pop_front();
+		bBuilding = true;
+		lock.unlock();
+		Tile *t = Build (idx);
+		if (t) {
+			tile[idx].store (t, std::memory_order_release);
+			ntilebuilt++;
+			nbuilt++;
+		}
+		lock.lock();
+		bBuilding = false;
+		if (queue.empty()) cvIdle.notify_all();
+	}
+	bBuilding = false;
+	cvIdle.notify_all();
+}
+
+// =======================================================================
+
+GravGrid::Tile *GravGrid::Build (int idx)
+{
+	int tj = idx % ntlng;
+	int ti = (idx / ntlng) % ntlat;
+	int tb = idx / (ntlng*ntlat);
+
+	// evaluate the model one latitude row at a time, so that destroying
+	// the grid doesn't have to wait for a complete tile
+	const int nrow = TILE_ANG+1;
+	Vector pos[nrow], acc[nrow];
+	PinesGravProp::Workspace ws;
+	Tile *t = new Tile;
+
+	for (int k = 0; k <= TILE_RAD; k++) {
+		double r = rmin + (tb*TILE_RAD + k)*dr;
+		for (int i = 0; i <= TILE_ANG; i++) {
+			if (bTerminate) {
+				delete t;
+				return nullptr;
+			}
+			double lat = (ti*TILE_ANG + i)*dlat - 0.5*PI;
+			double slat = sin (lat), clat = cos (lat);
+			for (int j = 0; j <= TILE_ANG; j++) {
+				double lng = (tj*TILE_ANG + j)*dlng - PI;
+				pos[j].Set (r*clat*cos (lng), r*clat*sin (lng), r*slat);
+			}
+			pines->GetPinesGravBatch (pos, acc, nrow, degree, degree, ws);
+			for (int j = 0; j <= TILE_ANG; j++)
+				for (int c = 0; c < 3; c++)
+					t->v[k][i][j][c] = (float)acc[j].data[c];
+		}
+	}
+	return t;
+}
+
+// =======================================================================
+
+bool GravGrid::Load (const char *fname)
+{
+	FILE *f = fopen (fname, "rb");
+	if (!f) return false;
+
+	GravGridHeader hdr;
+	bool ok = (fread (&hdr, sizeof(GravGridHeader), 1, f) == 1 &&
+		!memcmp (hdr.magic, GRAVGRID_MAGIC, 8) && hdr.version == GRAVGRID_VERSION &&
+		hdr.degree == degree && hdr.samples == samples && hdr.ntile == ntile &&
+		hdr.rmin == rmin && hdr.rmax == rmax && hdr.tilesize == (int32_t)sizeof(Tile));
+
+	for (int32_t n = 0; ok && n < hdr.nstored && ntilebuilt < maxtile; n++) {
+		int32_t idx;
+		Tile *t = new Tile;
+		if (fread (&idx, sizeof(int32_t), 1, f) != 1 || idx < 0 || idx >= ntile ||
+			fread (t, sizeof(Tile), 1, f) != 1) {
+			delete t;
+			ok = false;
+			break;
+		}
+		Tile *old = tile[idx].exchange (t);
+		if (old) delete old;
+		else ntilebuilt++;
+	}
+	fclose (f);
+	nbuilt = 0;
+	return ok;
+}
+
+// =======================================================================
+
+bool GravGrid::Save (const char *fname) const
+{
+	FILE *f = fopen (fname, "wb");
+	if (!f) return false;
+
+	GravGridHeader hdr;
+	memset (&hdr, 0, sizeof(GravGridHeader));
+	memcpy (hdr.magic, GRAVGRID_MAGIC, 8);
+	hdr.version = GRAVGRID_VERSION;
+	hdr.degree = degree;
+	hdr.samples = samples;
+	hdr.ntile = ntile;
+	hdr.rmin = rmin;
+	hdr.rmax = rmax;
+	hdr.tilesize = (int32_t)sizeof(Tile);
+	for (int i = 0; i < ntile; i++)
+		if (tile[i].load (std::memory_order_acquire)) hdr.nstored++;
+
+	bool ok = (fwrite (&hdr, sizeof(GravGridHeader), 1, f) == 1);
+	for (int32_t i = 0; ok && i < ntile; i++) {
+		const Tile *t = tile[i].load (std::memory_order_acquire);
+		if (t)
+			ok = (fwrite (&i, sizeof(int32_t), 1, f) == 1 && fwrite (t, sizeof(Tile), 1, f) == 1);
+	}
+	if (fclose (f)) ok = false;
+	return ok;
+}
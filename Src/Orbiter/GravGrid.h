@@ -0,0 +1,125 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// GravGrid:
+// Cache of the perturbation acceleration of a spherical-harmonics gravity
+// model (PinesGravProp) on a grid of radial shells x latitude x longitude
+// in the body frame. Lookups interpolate trilinearly between the 8 grid
+// nodes surrounding the position, instead of summing the O(N^2) terms of
+// a degree N model.
+//
+// The node spacing is pi*R/(S*N) (R: model reference radius, S: samples
+// per half-wavelength of the highest degree), in latitude, in longitude
+// at the equator, and in radius. The interpolation error of a degree n
+// term is then about (pi*n/(S*N))^2/8 of its amplitude, so the error is
+// largest for the highest degrees, while the perturbation is dominated by
+// the lower degrees. The total error stays below (pi/S)^2/8 of the
+// magnitude of the perturbation.
+//
+// The grid is divided into tiles. A tile is requested on first use and
+// built by a background thread, so that building a tile of a high-degree
+// model (several seconds) doesn't stall the simulation. Until the tile is
+// ready, lookups in it fail, and the caller evaluates the model directly.
+// Tiles are kept until the grid is destroyed. Built tiles can be saved to
+// a file and loaded in later sessions. Lookups are lock-free and may run
+// concurrently with each other and with tile builds.
+// =======================================================================
+
+#ifndef __GRAVGRID_H
+#define __GRAVGRID_H
+
+#include "Vecmat.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+class PinesGravProp;
+
+class GravGrid {
+public:
+	GravGrid (const PinesGravProp *pines, int samples, double maxalt, size_t maxmem);
+	// pines: gravity model (must stay valid for the lifetime of the grid)
+	// samples: grid nodes per half-wavelength of the highest model degree (S)
+	// maxalt: altitude above the model reference radius covered by the grid [km]
+	// maxmem: memory limit for tiles [bytes]. Lookups outside the built
+	//    tiles fail once the limit is reached.
+
+	~GravGrid ();
+
+	bool Eval (const Vector &rpos, Vector &acc);
+	// Interpolated perturbation acceleration at position rpos (body frame,
+	// right-handed, km), in the units of PinesGravProp::GetPinesGrav.
+	// Returns false if rpos is outside the grid, or the tile containing
+	// rpos isn't built yet. In the latter case the tile is queued for
+	// building, unless the memory limit has been reached.
+
+	void Wait ();
+	// Wait until all queued tiles have been built
+
+	inline int Degree () const { return degree; }
+	// Model degree and order the grid was built for. Lookups for a different
+	// coefficient cutoff must use the model directly.
+
+	inline double NodeSpacing () const { return dr; }
+	// Node spacing [km]
+
+	inline double ErrorBound () const { return errbound; }
+	// Interpolation error bound, relative to the magnitude of the perturbation
+
+	bool Load (const char *fname);
+	// Load the tiles stored in file fname. Only valid before the first lookup.
+	// Returns false if the file doesn't exist or doesn't match the grid.
+
+	bool Save (const char *fname) const;
+	// Save all built tiles to file fname
+
+	inline int nBuilt () const { return nbuilt.load(); }
+	// Number of tiles built since construction or the last Load/Save
+
+	static const int TILE_ANG = 32; // tile size in latitude and longitude [cells]
+	static const int TILE_RAD = 8;  // tile size in radius [cells]
+
+private:
+	struct Tile {
+		float v[TILE_RAD+1][TILE_ANG+1][TILE_ANG+1][3]; // acceleration at the tile nodes
+	};
+
+	void Request (int idx);
+	// Queue tile idx for building
+
+	void BuildProc ();
+	// Builder thread: build the queued tiles
+
+	Tile *Build (int idx);
+	// Build tile idx. Returns nullptr if the grid is being destroyed.
+
+	inline int TileIndex (int band, int tlat, int tlng) const
+	{ return (band*ntlat + tlat)*ntlng + tlng; }
+
+	const PinesGravProp *pines;
+	int degree;              // model degree/order of the grid
+	int samples;             // nodes per half-wavelength
+	double errbound;         // relative interpolation error bound
+	double rmin, rmax;       // radial extent [km]
+	double dr, dlat, dlng;   // node spacing in radius [km], latitude and longitude [rad]
+	int nband, ntlat, ntlng; // number of tiles in radius, latitude and longitude
+	int ntile;               // total number of tiles
+	size_t maxtile;          // max. number of tiles to build (memory limit)
+	std::unique_ptr<std::atomic<Tile*>[]> tile; // tile directory
+	std::unique_ptr<std::atomic<bool>[]> requested; // tile has been queued
+	std::atomic<size_t> ntilebuilt; // number of allocated tiles
+	std::atomic<int> nbuilt; // tiles built since construction/load/save
+
+	std::deque<int> queue;   // tiles waiting to be built
+	bool bBuilding;          // builder thread is working on a tile
+	std::atomic<bool> bTerminate; // grid is being destroyed
+	std::thread builder;
+	std::mutex buildMutex;   // protects queue and bBuilding
+	std::condition_variable cvQueue, cvIdle;
+};
+
+#endif // !__GRAVGRID_H
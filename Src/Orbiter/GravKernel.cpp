@@ -0,0 +1,161 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+#include "GravKernel.h"
+#include <math.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define GRAV_X86
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+static const double PAD_DIST = 1e30; // position of padding entries [m]
+
+// ===========================================================
+// struct GravSources
+// ===========================================================
+
+void GravSources::Resize (int nsrc)
+{
+	int nbuf = (nsrc + GRAV_SIMD_WIDTH) / GRAV_SIMD_WIDTH * GRAV_SIMD_WIDTH;
+	n = nsrc;
+	x.assign (nbuf, PAD_DIST);
+	y.assign (nbuf, PAD_DIST);
+	z.assign (nbuf, PAD_DIST);
+	gm.assign (nbuf, 0.0);
+}
+
+// ===========================================================
+// Scalar reference kernel and dispatch
+// ===========================================================
+
+static void GravAccScalar (const GravSources &src, const double *p, const int *idx, int nidx, double *acc)
+{
+	const double *X = src.x.data(), *Y = src.y.data(), *Z = src.z.data(), *G = src.gm.data();
+	int k, i, nsum = (idx ? nidx : src.n);
+	double dx, dy, dz, d, f, ax = 0.0, ay = 0.0, az = 0.0;
+	for (k = 0; k < nsum; k++) {
+		i = (idx ? idx[k] : k);
+		dx = X[i]-p[0], dy = Y[i]-p[1], dz = Z[i]-p[2];
+		d  = sqrt (dx*dx + dy*dy + dz*dz);
+		f  = G[i] / (d*d*d);
+		ax += dx*f, ay += dy*f, az += dz*f;
+	}
+	acc[0] = ax, acc[1] = ay, acc[2] = az;
+}
+
+void GravAcc (const GravSources &src, const double *p, const int *idx, int nidx, double *acc, GravSimdLevel level)
+{
+	switch (level) {
+	case GRAV_SIMD_AVX2: GravAccAVX2 (src, p, idx, nidx, acc); break;
+	case GRAV_SIMD_SSE2: GravAccSSE2 (src, p, idx, nidx, acc); break;
+	default:             GravAccScalar (src, p, idx, nidx, acc); break;
+	}
+}
+
+const char *GravSimdName (GravSimdLevel level)
+{
+	static const char *name[3] = {"scalar", "SSE2", "AVX2"};
+	return name[level];
+}
+
+#ifdef GRAV_X86
+
+static void Cpuid (int leaf, int subleaf, unsigned int reg[4])
+{
+#ifdef _MSC_VER
+	__cpuidex ((int*)reg, leaf, subleaf);
+#else
+	__cpuid_count (leaf, subleaf, reg[0], reg[1], reg[2], reg[3]);
+#endif
+}
+
+static unsigned long long Xgetbv (unsigned int idx)
+{
+#ifdef _MSC_VER
+	return _xgetbv (idx);
+#else
+	unsigned int eax, edx;
+	__asm__ volatile ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(idx));
+	return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+
+GravSimdLevel GravSimdSupported ()
+{
+	unsigned int reg[4];
+	Cpuid (0, 0, reg);
+	int maxleaf = (int)reg[0];
+	if (maxleaf < 1) return GRAV_SIMD_SCALAR;
+	Cpuid (1, 0, reg);
+	if (!(reg[3] & (1u << 26))) return GRAV_SIMD_SCALAR; // no SSE2
+	bool osxsave = (reg[2] & (1u << 27)) != 0;
+	bool avx     = (reg[2] & (1u << 28)) != 0;
+	if (maxleaf < 7 || !osxsave || !avx) return GRAV_SIMD_SSE2;
+	if ((Xgetbv (0) & 6) != 6) return GRAV_SIMD_SSE2;    // OS doesn't save YMM registers
+	Cpuid (7, 0, reg);
+	if (!(reg[1] & (1u << 5))) return GRAV_SIMD_SSE2;    // no AVX2
+	return GRAV_SIMD_AVX2;
+}
+
+// ===========================================================
+// SSE2 kernel
+// Two sources per step. Index lists with an odd length are
+// completed with the padding entry.
+// ===========================================================
+
+static inline void Accumulate (__m128d dx, __m128d dy, __m128d dz, __m128d gm, __m128d &ax, __m128d &ay, __m128d &az)
+{
+	__m128d d = _mm_sqrt_pd (_mm_add_pd (_mm_add_pd (_mm_mul_pd (dx, dx), _mm_mul_pd (dy, dy)), _mm_mul_pd (dz, dz)));
+	__m128d f = _mm_div_pd (gm, _mm_mul_pd (_mm_mul_pd (d, d), d));
+	ax = _mm_add_pd (ax, _mm_mul_pd (dx, f));
+	ay = _mm_add_pd (ay, _mm_mul_pd (dy, f));
+	az = _mm_add_pd (az, _mm_mul_pd (dz, f));
+}
+
+void GravAccSSE2 (const GravSources &src, const double *p, const int *idx, int nidx, double *acc)
+{
+	const double *X = src.x.data(), *Y = src.y.data(), *Z = src.z.data(), *G = src.gm.data();
+	__m128d px = _mm_set1_pd (p[0]), py = _mm_set1_pd (p[1]), pz = _mm_set1_pd (p[2]);
+	__m128d ax = _mm_setzero_pd(), ay = _mm_setzero_pd(), az = _mm_setzero_pd();
+	int k;
+	if (idx) {
+		for (k = 0; k < nidx; k += 2) {
+			int i0 = idx[k], i1 = (k+1 < nidx ? idx[k+1] : src.n);
+			Accumulate (_mm_sub_pd (_mm_set_pd (X[i1], X[i0]), px),
+			            _mm_sub_pd (_mm_set_pd (Y[i1], Y[i0]), py),
+			            _mm_sub_pd (_mm_set_pd (Z[i1], Z[i0]), pz),
+			            _mm_set_pd (G[i1], G[i0]), ax, ay, az);
+		}
+	} else {
+		for (k = 0; k < src.n; k += 2) {
+			Accumulate (_mm_sub_pd (_mm_loadu_pd (X+k), px),
+			            _mm_sub_pd (_mm_loadu_pd (Y+k), py),
+			            _mm_sub_pd (_mm_loadu_pd (Z+k), pz),
+			            _mm_loadu_pd (G+k), ax, ay, az);
+		}
+	}
+	double res[2];
+	_mm_storeu_pd (res, ax); acc[0] = res[0] + res[1];
+	_mm_storeu_pd (res, ay); acc[1] = res[0] + res[1];
+	_mm_storeu_pd (res, az); acc[2] = res[0] + res[1];
+}
+
+#else // !GRAV_X86
+
+GravSimdLevel GravSimdSupported ()
+{
+	return GRAV_SIMD_SCALAR;
+}
+
+void GravAccSSE2 (const GravSources &src, const double *p, const int *idx, int nidx, double *acc)
+{
+	GravAccScalar (src, p, idx, nidx, acc);
+}
+
+#endif // GRAV_X86
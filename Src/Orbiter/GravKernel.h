@@ -0,0 +1,62 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Point-mass gravity kernels
+// Sums the gravitational acceleration of a set of point masses at a field
+// point. Source positions and GM values are stored as structure-of-arrays,
+// so that packed SIMD implementations (SSE2, AVX2) can evaluate several
+// sources per instruction. The implementation is selected at runtime from
+// the instruction sets supported by the CPU.
+// This module has no dependencies on the rest of Orbiter.
+// =======================================================================
+
+#ifndef __GRAVKERNEL_H
+#define __GRAVKERNEL_H
+
+#include <vector>
+
+enum GravSimdLevel {
+	GRAV_SIMD_SCALAR,  // reference implementation
+	GRAV_SIMD_SSE2,    // 2 sources per instruction
+	GRAV_SIMD_AVX2     // 4 sources per instruction
+};
+
+// =======================================================================
+// Source positions and GM values. The lists are padded to a multiple of
+// GRAV_SIMD_WIDTH with massless entries at a large distance, and always
+// contain at least one padding entry (index n), which the kernels use to
+// fill incomplete index groups.
+
+#define GRAV_SIMD_WIDTH 4
+
+struct GravSources {
+	std::vector<double> x, y, z, gm; // position [m], G*mass [m^3/s^2]
+	int n;                           // number of sources (excluding padding)
+
+	GravSources (): n(0) {}
+	void Resize (int nsrc);
+	// Set the number of sources. All entries are reset to padding.
+
+	inline void Set (int i, double px, double py, double pz, double GM)
+	{ x[i] = px, y[i] = py, z[i] = pz, gm[i] = GM; }
+};
+
+// =======================================================================
+
+void GravAcc (const GravSources &src, const double *p, const int *idx, int nidx, double *acc, GravSimdLevel level);
+// Acceleration acc[3] at field point p[3] due to the sources idx[0..nidx-1]:
+// acc = sum_i GM_i (r_i - p) / |r_i - p|^3.
+// If idx is NULL, all sources are summed. The field point must not
+// coincide with a source.
+
+GravSimdLevel GravSimdSupported ();
+// Highest kernel level supported by the CPU and operating system
+
+const char *GravSimdName (GravSimdLevel level);
+
+// Packed kernels (GravKernel.cpp, GravKernelAvx2.cpp)
+void GravAccSSE2 (const GravSources &src, const double *p, const int *idx, int nidx, double *acc);
+void GravAccAVX2 (const GravSources &src, const double *p, const int *idx, int nidx, double *acc);
+
+#endif // !__GRAVKERNEL_H
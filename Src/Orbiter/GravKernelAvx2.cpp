@@ -0,0 +1,73 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// AVX2 version of the point-mass gravity kernel. This file is compiled
+// with AVX2 code generation enabled, and is only called if the CPU
+// supports it (see GravSimdSupported). The algorithm is identical to the
+// SSE2 kernel in GravKernel.cpp, with indexed source lists loaded by
+// gather instructions.
+
+#include "GravKernel.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+static inline void Accumulate (__m256d dx, __m256d dy, __m256d dz, __m256d gm, __m256d &ax, __m256d &ay, __m256d &az)
+{
+	__m256d d = _mm256_sqrt_pd (_mm256_add_pd (_mm256_add_pd (_mm256_mul_pd (dx, dx), _mm256_mul_pd (dy, dy)), _mm256_mul_pd (dz, dz)));
+	__m256d f = _mm256_div_pd (gm, _mm256_mul_pd (_mm256_mul_pd (d, d), d));
+	ax = _mm256_add_pd (ax, _mm256_mul_pd (dx, f));
+	ay = _mm256_add_pd (ay, _mm256_mul_pd (dy, f));
+	az = _mm256_add_pd (az, _mm256_mul_pd (dz, f));
+}
+
+static inline double Sum (__m256d v)
+{
+	double res[4];
+	_mm256_storeu_pd (res, v);
+	return (res[0] + res[1]) + (res[2] + res[3]);
+}
+
+void GravAccAVX2 (const GravSources &src, const double *p, const int *idx, int nidx, double *acc)
+{
+	const double *X = src.x.data(), *Y = src.y.data(), *Z = src.z.data(), *G = src.gm.data();
+	__m256d px = _mm256_set1_pd (p[0]), py = _mm256_set1_pd (p[1]), pz = _mm256_set1_pd (p[2]);
+	__m256d ax = _mm256_setzero_pd(), ay = _mm256_setzero_pd(), az = _mm256_setzero_pd();
+	int k;
+	if (idx) {
+		int ibuf[4];
+		for (k = 0; k < nidx; k += 4) {
+			const int *ik = idx+k;
+			if (k+4 > nidx) { // complete the last group with the padding entry
+				for (int j = 0; j < 4; j++) ibuf[j] = (k+j < nidx ? idx[k+j] : src.n);
+				ik = ibuf;
+			}
+			__m128i vi = _mm_loadu_si128 ((const __m128i*)ik);
+			Accumulate (_mm256_sub_pd (_mm256_i32gather_pd (X, vi, 8), px),
+			            _mm256_sub_pd (_mm256_i32gather_pd (Y, vi, 8), py),
+			            _mm256_sub_pd (_mm256_i32gather_pd (Z, vi, 8), pz),
+			            _mm256_i32gather_pd (G, vi, 8), ax, ay, az);
+		}
+	} else {
+		for (k = 0; k < src.n; k += 4) {
+			Accumulate (_mm256_sub_pd (_mm256_loadu_pd (X+k), px),
+			            _mm256_sub_pd (_mm256_loadu_pd (Y+k), py),
+			            _mm256_sub_pd (_mm256_loadu_pd (Z+k), pz),
+			            _mm256_loadu_pd (G+k), ax, ay, az);
+		}
+	}
+	acc[0] = Sum (ax);
+	acc[1] = Sum (ay);
+	acc[2] = Sum (az);
+	_mm256_zeroupper();
+}
+
+#else
+
+void GravAccAVX2 (const GravSources &src, const double *p, const int *idx, int nidx, double *acc)
+{
+	GravAccSSE2 (src, p, idx, nidx, acc);
+}
+
+#endif
@@ -0,0 +1,274 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// Implementation of class GroundtrackProp
+
+#include "GroundtrackProp.h"
+#include <algorithm>
+
+// ==============================================================
+
+static Matrix BodyRot (const GroundtrackProp::Model &m, double t)
+{
+	// reference body orientation at time t, assuming rotation at constant
+	// rate around the body's y-axis
+	double a = m.omega*(t-m.t0), c = cos(a), s = sin(a);
+	return m.rot0 * Matrix (c,0,-s, 0,1,0, s,0,c);
+}
+
+// ==============================================================
+
+bool GroundtrackProp::Track::Interpolate (double t, Vector &p) const
+{
+	size_t n = vtx.size();
+	if (n < 2 || t < vtx[0].t || t > vtx[n-1].t) return false;
+
+	size_t i1 = std::upper_bound (vtx.begin(), vtx.end(), t,
+		[](double t, const VPointGT &v) { return t < v.t; }) - vtx.begin();
+	if (i1 >= n) i1 = n-1;
+	size_t i0 = i1-1;
+	double h = vtx[i1].t - vtx[i0].t;
+	double s = (t - vtx[i0].t)/h, s1 = 1.0-s;
+	p = pos[i0] * ((1.0+2.0*s)*s1*s1) + vel[i0] * (s*s1*s1*h) +
+		pos[i1] * (s*s*(3.0-2.0*s)) + vel[i1] * (s*s*(s-1.0)*h);
+	return true;
+}
+
+// ==============================================================
+
+GroundtrackProp::GroundtrackProp ()
+: pending(REQ_NONE), ptext(0), busy(false), bTerminate(false), req(REQ_NONE), seq(0),
+  t(0), bValid(false), bEnd(false), mid(1), front(0), back(2)
+{
+	work.seq = 0;
+	for (int i = 0; i < 3; i++) buf[i].seq = 0;
+}
+
+// ==============================================================
+
+GroundtrackProp::~GroundtrackProp ()
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		bTerminate = true;
+		req = REQ_CLEAR;
+	}
+	cv.notify_one();
+	if (thread.joinable())
+		thread.join();
+}
+
+// ==============================================================
+
+void GroundtrackProp::Restart (const Model &m)
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		pending = REQ_RESTART;
+		pmodel = m;
+		req = REQ_RESTART;
+		busy = true;
+		seq++;
+		if (!thread.joinable())
+			thread = std::thread (&GroundtrackProp::ThreadProc, this);
+	}
+	cv.notify_one();
+}
+
+// ==============================================================
+
+void GroundtrackProp::Extend (double t)
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		if (!thread.joinable() || pending > REQ_EXTEND) return; // a pending restart covers it
+		pending = REQ_EXTEND;
+		ptext = t;
+		busy = true;
+	}
+	cv.notify_one();
+}
+
+// ==============================================================
+
+void GroundtrackProp::Clear ()
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		if (!thread.joinable()) return; // nothing published yet
+		pending = REQ_CLEAR;
+		req = REQ_CLEAR;
+		busy = true;
+	}
+	cv.notify_one();
+}
+
+// ==============================================================
+
+bool GroundtrackProp::Busy ()
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	return busy;
+}
+
+// ==============================================================
+
+const GroundtrackProp::Track *GroundtrackProp::Current ()
+{
+	if (mid.load() & 4)
+		front = mid.exchange (front) & 3;
+	return buf+front;
+}
+
+// ==============================================================
+
+void GroundtrackProp::Publish ()
+{
+	buf[back] = work;
+	back = mid.exchange (back | 4) & 3;
+}
+
+// ==============================================================
+
+Vector GroundtrackProp::Acc (const Vector &r, const Vector &v, double t) const
+{
+	double d2 = r.length2(), d = sqrt(d2);
+	Vector a (r * (-model.mu/(d2*d)));
+
+	if (model.pert || model.dragk) {
+		Matrix rot (BodyRot (model, t));
+		if (model.pert)
+			a += model.pert (r, rot);
+
+		double alt = d - model.rad;
+		size_t n = model.lnrho.size();
+		if (model.dragk && n > 1 && alt < model.altmax) {
+			double x = std::max (0.0, alt)/model.altmax * (n-1);
+			size_t i = std::min ((size_t)x, n-2);
+			double f = x-i;
+			double rho = exp (model.lnrho[i]*(1.0-f) + model.lnrho[i+1]*f);
+			Vector loc (tmul (rot, r));
+			Vector vair (v - mul (rot, Vector (-loc.z, 0, loc.x)) * model.omega); // airspeed vector (atmosphere co-rotates)
+			a -= vair * (0.5*rho*model.dragk*vair.length());
+		}
+	}
+
+	for (auto &src : model.source) {
+		Vector p (src.pos (t));
+		Vector dp (p-r);
+		double dd = dp.length(), pd = p.length();
+		a += dp * (src.gm/(dd*dd*dd)) - p * (src.gm/(pd*pd*pd)); // indirect term: reference body is accelerated as well
+	}
+	return a;
+}
+
+// ==============================================================
+
+VPointGT GroundtrackProp::Vertex (const Vector &r, double t) const
+{
+	VPointGT p;
+	Vector loc (tmul (BodyRot (model, t), r));
+	double d = loc.length();
+	p.lng = atan2 (loc.z, loc.x);
+	p.lat = asin (loc.y/d);
+	p.rad = d/model.rad;
+	p.t = t;
+	p.dt = model.step;
+	return p;
+}
+
+// ==============================================================
+
+bool GroundtrackProp::Propagate (double tend)
+{
+	// 4th order Runge-Kutta with fixed step
+	const double h = model.step;
+
+	while (t < tend && !bEnd) {
+		if (Cancelled()) return false;
+
+		Vector a1 (Acc (r, v, t));
+		Vector r2 (r + v*(0.5*h)), v2 (v + a1*(0.5*h));
+		Vector a2 (Acc (r2, v2, t+0.5*h));
+		Vector r3 (r + v2*(0.5*h)), v3 (v + a2*(0.5*h));
+		Vector a3 (Acc (r3, v3, t+0.5*h));
+		Vector r4 (r + v3*h), v4 (v + a3*h);
+		Vector a4 (Acc (r4, v4, t+h));
+		r += (v + (v2+v3)*2.0 + v4) * (h/6.0);
+		v += (a1 + (a2+a3)*2.0 + a4) * (h/6.0);
+		t += h;
+
+		work.vtx.push_back (Vertex (r, t));
+		work.pos.push_back (r);
+		work.vel.push_back (v);
+
+		double d = r.length();
+		if (d < model.rad || d > model.rmax)
+			bEnd = true;
+	}
+	return true;
+}
+
+// ==============================================================
+
+void GroundtrackProp::ThreadProc ()
+{
+	for (;;) {
+		ReqType type;
+		double text;
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			busy = (pending != REQ_NONE);
+			cv.wait (lock, [this]{ return bTerminate || pending != REQ_NONE; });
+			if (bTerminate) break;
+			type = pending;
+			pending = REQ_NONE;
+			req = REQ_NONE;
+			if (type == REQ_RESTART) {
+				model = pmodel;
+				work.seq = seq;
+			}
+			text = ptext;
+			busy = true;
+		}
+
+		switch (type) {
+		case REQ_CLEAR:
+			bValid = false;
+			work.vtx.clear();
+			work.pos.clear();
+			work.vel.clear();
+			Publish();
+			break;
+		case REQ_RESTART:
+			bValid = true;
+			bEnd = false;
+			r = model.pos;
+			v = model.vel;
+			t = model.t0;
+			work.vtx.assign (1, Vertex (r, t));
+			work.pos.assign (1, r);
+			work.vel.assign (1, v);
+			if (Propagate (t + model.span))
+				Publish();
+			break;
+		case REQ_EXTEND:
+			if (bValid) {
+				// drop the vertices that have been passed, but keep the one
+				// preceding text so that the track covers it
+				size_t i = 0;
+				while (i+1 < work.vtx.size() && work.vtx[i+1].t <= text) i++;
+				if (i || !bEnd) {
+					work.vtx.erase (work.vtx.begin(), work.vtx.begin()+i);
+					work.pos.erase (work.pos.begin(), work.pos.begin()+i);
+					work.vel.erase (work.vel.begin(), work.vel.begin()+i);
+					if (Propagate (text + model.span))
+						Publish();
+				}
+			}
+			break;
+		default:
+			break;
+		}
+	}
+}
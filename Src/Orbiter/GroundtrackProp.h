@@ -0,0 +1,133 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// Background propagation of vessel groundtracks
+
+#ifndef __GROUNDTRACKPROP_H
+#define __GROUNDTRACKPROP_H
+
+#include "Vecmat.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct VPointGT {
+	double lng, lat;
+	double rad;
+	double t, dt;
+};
+
+// =======================================================================
+// class GroundtrackProp
+// Predicts the groundtrack of a vessel by numerical integration of its
+// trajectory over several orbits. The force model (central gravity,
+// nonspherical perturbation of the reference body, third-body perturbations
+// and atmospheric drag) is captured on the main thread in a Model, so the
+// worker thread does not access any simulation state.
+// The worker publishes each result as an immutable Track. The reader picks
+// up the latest track lock-free (triple buffer with a single writer and a
+// single reader). As the simulation advances, Extend drops the track points
+// that have been passed and continues the integration from the end of the
+// track instead of recomputing it.
+
+class GroundtrackProp {
+public:
+	struct Source {           // third-body perturbation
+		double gm;            // gravitational parameter [m^3/s^2]
+		std::function<Vector(double t)> pos; // position relative to the reference body at simulation time t
+	};
+
+	struct Model {
+		double t0;            // simulation time of the initial state
+		Vector pos, vel;      // vessel state relative to the reference body at t0 (global frame)
+		double mu;            // gravitational parameter of the reference body [m^3/s^2]
+		double rad;           // reference body radius [m]
+		Matrix rot0;          // reference body orientation at t0
+		double omega;         // reference body rotation rate [rad/s] (around its local y-axis)
+		std::function<Vector(const Vector &r, const Matrix &rot)> pert;
+		                      // nonspherical gravity perturbation at position r for body orientation rot (optional)
+		std::vector<Source> source; // third-body perturbations
+		double dragk;         // drag factor cd*A/m [m^2/kg] (0 for no drag)
+		double altmax;        // altitude range of the density profile [m]
+		std::vector<double> lnrho; // log density at equidistant altitudes from 0 to altmax
+		double span;          // prediction span ahead of the current time [s]
+		double step;          // integration step [s]
+		double rmax;          // stop integration beyond this radius [m]
+		Model (): t0(0), mu(0), rad(1), omega(0), dragk(0), altmax(0), span(0), step(1), rmax(0) {}
+	};
+
+	struct Track {
+		std::vector<VPointGT> vtx; // groundtrack vertices, one per integration step, time-ordered
+		std::vector<Vector> pos;   // vessel positions at vertex times, relative to the reference body
+		std::vector<Vector> vel;   // vessel velocities at vertex times
+		int seq;                   // Restart counter of the propagation that produced the track
+
+		bool Interpolate (double t, Vector &p) const;
+		// Position at time t by cubic Hermite interpolation between vertices.
+		// Returns false if t is outside the track.
+	};
+
+	GroundtrackProp ();
+	~GroundtrackProp ();
+
+	void Restart (const Model &model);
+	// Discard the current propagation and start a new one from the model's
+	// initial state
+
+	void Extend (double t);
+	// Drop the track points before t and continue the integration to
+	// t+span. Ignored if no propagation has been started.
+
+	void Clear ();
+	// Abort the propagation and publish an empty track
+
+	const Track *Current ();
+	// Latest published track. Must only be called from a single (reader)
+	// thread. The track remains valid until the next call.
+
+	bool Busy ();
+	// A request is pending or being processed
+
+	inline int Seq () const { return seq; }
+	// Number of Restart requests so far
+
+private:
+	enum ReqType { REQ_NONE, REQ_EXTEND, REQ_RESTART, REQ_CLEAR };
+
+	void ThreadProc ();
+	Vector Acc (const Vector &r, const Vector &v, double t) const;
+	VPointGT Vertex (const Vector &r, double t) const;
+	bool Propagate (double tend);
+	void Publish ();
+	bool Cancelled () const { return req > REQ_EXTEND; }
+
+	// request slot (protected by mtx)
+	std::mutex mtx;
+	std::condition_variable cv;
+	ReqType pending;
+	Model pmodel;           // model of a pending Restart
+	double ptext;           // time of a pending Extend
+	bool busy;
+	bool bTerminate;
+	std::thread thread;
+	std::atomic<int> req;   // type of pending request, polled by the worker to abort a propagation
+	int seq;
+
+	// worker state
+	Model model;            // current force model
+	Track work;             // track under construction
+	Vector r, v;            // integration state at the end of the track
+	double t;               // time at the end of the track
+	bool bValid;            // a propagation has been started
+	bool bEnd;              // trajectory has terminated (impact or escape)
+
+	// triple buffer
+	Track buf[3];
+	std::atomic<int> mid;   // index of the middle buffer (bit 2: contains a new track)
+	int front, back;        // reader and writer buffers
+};
+
+#endif // !__GROUNDTRACKPROP_H
@@ -813,171 +813,51 @@ void Mesh::RenderGroup (LPDIRECT3DDEVICE7 dev, DWORD grp, bool setstate) const
 {
 }
 
-istream &operator>> (istream &is, Mesh &mesh)
+void Mesh::Set (const MeshFileData &data)
 {
-	char cbuf[256];
-	int i, j, g, ngrp, nvtx, ntri, nidx, nmtrl, mtrl_idx, ntex, tex_idx, flag, res;
-	DWORD uflag;
-	WORD zbias;
-	D3DMATERIAL7 mtrl;
-	bool term, staticmesh = false;
-
-	mesh.Clear();
+	static_assert (sizeof(MeshFileVertex) == sizeof(NTVERTEX), "vertex layout mismatch");
+	static_assert (sizeof(MeshFileMaterial) == sizeof(D3DMATERIAL7), "material layout mismatch");
+	DWORD i;
 
-	if (!is.getline (cbuf, 256)) return is;
-	if (strcmp (cbuf, "MSHX1")) return is;
+	Clear();
 
-	for (;;) {
-		if (!is.getline (cbuf, 256)) return is;
-		if (!_strnicmp (cbuf, "GROUPS", 6)) {
-			if (sscanf (cbuf+6, "%d", &ngrp) != 1) return is;
-			break;
-		} else if (!_strnicmp (cbuf, "STATICMESH", 10)) {
-			staticmesh = true;
-		}
+	for (const auto &grp : data.grp) {
+		int g = AddGroup ((NTVERTEX*)grp.Vtx.data(), (DWORD)grp.Vtx.size(), (WORD*)grp.Idx.data(), (DWORD)grp.Idx.size(),
+			grp.MtrlIdx, grp.TexIdx, grp.zBias, 0, true);
+		Grp[g].Flags = grp.Flags;
+		Grp[g].UsrFlag = grp.UsrFlag;
+		if (grp.CalcNormals) CalcNormals (g, true);
+		if (grp.Flags & 0x04) MakeGroupVertexBuffer (g);
 	}
 
-	for (g = 0, term = false; g < ngrp && !term; g++) {
-
-		// set defaults
-		NTVERTEX *vtx;
-		WORD *idx;
-		mtrl_idx = SPEC_INHERIT;
-		tex_idx  = SPEC_INHERIT;
-		zbias    = 0;
-		flag     = (staticmesh ? 0x04 : 0);
-		uflag    = 0;
-		bool bnormal = true, calcnml = false;
-		bool flipidx = false;
-		nvtx = ntri = 0;
-
-		for (;;) {
-			if (!is.getline (cbuf, 256)) { term = true; break; }
-			if (!_strnicmp (cbuf, "MATERIAL", 8)) {       // read material index
-				sscanf (cbuf+8, "%d", &mtrl_idx);
-				mtrl_idx--;
-			} else if (!_strnicmp (cbuf, "TEXTURE", 7)) { // read texture index
-				sscanf (cbuf+7, "%d", &tex_idx);
-				tex_idx--;
-			} else if (!_strnicmp (cbuf, "ZBIAS", 5)) {   // read z-bias
-				sscanf (cbuf+5, "%hu", &zbias);
-			} else if (!_strnicmp (cbuf, "TEXWRAP", 7)) { // read wrap flags
-				char uvstr[10] = "";
-				sscanf (cbuf+7, "%9s", uvstr);
-				if (uvstr[0] == 'U' || uvstr[1] == 'U') flag |= 0x01;
-				if (uvstr[0] == 'V' || uvstr[1] == 'V') flag |= 0x02;
-			} else if (!_strnicmp (cbuf, "NONORMAL", 8)) {
-				bnormal = false; calcnml = true;
-			} else if (!_strnicmp (cbuf, "FLAG", 4)) {
-				sscanf (cbuf+4, "%lx", &uflag);
-			} else if (!_strnicmp (cbuf, "FLIP", 4)) {
-				flipidx = true;
-			} else if (!_strnicmp (cbuf, "LABEL", 5)) {
-				// ignore group labels here
-			} else if (!_strnicmp (cbuf, "STATIC", 6)) {
-				flag |= 0x04;
-			} else if (!_strnicmp (cbuf, "DYNAMIC", 7)) {
-				flag ^= 0x04;
-			} else if (!_strnicmp (cbuf, "GEOM", 4)) {    // read geometry
-				if (sscanf (cbuf+4, "%d%d", &nvtx, &ntri) != 2) break; // parse error - skip group
-				nidx = ntri*3;
-				vtx = new NTVERTEX[nvtx]; TRACENEW
-				ZeroMemory (vtx, sizeof (NTVERTEX)*nvtx);
-				for (i = 0; i < nvtx; i++) {
-					NTVERTEX &v = vtx[i];
-					if (!is.getline (cbuf, 256)) {
-						delete []vtx;
-						vtx = NULL;
-						nvtx = 0;
-						break;
-					}
-					if (bnormal) {
-						j = sscanf (cbuf, "%f%f%f%f%f%f%f%f",
-							&v.x, &v.y, &v.z, &v.nx, &v.ny, &v.nz, &v.tu, &v.tv);
-						if (j < 6) calcnml = true;
-					} else {
-						j = sscanf (cbuf, "%f%f%f%f%f",
-							&v.x, &v.y, &v.z, &v.tu, &v.tv);
-					}
-				}
-				idx = new WORD[nidx]; TRACENEW
-				ZeroMemory (idx, sizeof (WORD)*nidx);
-				for (i = j = 0; i < ntri; i++) {
-					if (!is.getline (cbuf, 256)) {
-						delete []vtx;
-						vtx = NULL;
-						delete []idx;
-						idx = NULL;
-						nvtx = nidx = 0;
-						break;
-					}
-					sscanf (cbuf, "%hd%hd%hd", idx+j, idx+j+1, idx+j+2);
-					j += 3;
-				}
-				if (flipidx)
-					for (i = 0; i < ntri; i++) {
-						WORD tmp = idx[i*3+1]; idx[i*3+1] = idx[i*3+2]; idx[i*3+2] = tmp;
-					}
-
-				break;
-			}
-		}
-		if (nvtx && nidx) {
-			mesh.AddGroup (vtx, nvtx, idx, nidx, mtrl_idx, tex_idx, zbias);
-			mesh.Grp[g].Flags = flag;
-			mesh.Grp[g].UsrFlag = uflag;
-			if (calcnml) mesh.CalcNormals (g, true);
-			if (flag & 0x04) mesh.MakeGroupVertexBuffer (g);
-		}
+	for (const auto &m : data.mtrl) {
+		D3DMATERIAL7 mtrl;
+		memcpy (&mtrl, &m, sizeof(D3DMATERIAL7));
+		AddMaterial (mtrl);
 	}
 
-	// read material list
-	if (is.getline (cbuf, 256) && !strncmp (cbuf, "MATERIALS", 9) && (sscanf (cbuf+9, "%d", &nmtrl) == 1)) {
-		Str256 *matname = new Str256[nmtrl]; TRACENEW
-		Str256 mnm;
-		for (i = 0; i < nmtrl; i++) {
-			is.getline (cbuf, 256);
-			sscanf (cbuf, "%s", matname[i]);
-		}
-		for (i = 0; i < nmtrl; i++) {
-			ZeroMemory (&mtrl, sizeof (D3DMATERIAL7));
-			is.getline (cbuf, 256);
-			sscanf (cbuf+8, "%255s", mnm);
-			is.getline (cbuf, 256);
-			sscanf (cbuf, "%f%f%f%f", &mtrl.diffuse.r, &mtrl.diffuse.g, &mtrl.diffuse.b, &mtrl.diffuse.a);
-			is.getline (cbuf, 256);
-			sscanf (cbuf, "%f%f%f%f", &mtrl.ambient.r, &mtrl.ambient.g, &mtrl.ambient.b, &mtrl.ambient.a);
-			is.getline (cbuf, 256);
-			res = sscanf (cbuf, "%f%f%f%f%f", &mtrl.specular.r, &mtrl.specular.g, &mtrl.specular.b, &mtrl.specular.a, &mtrl.power);
-			if (res < 5) mtrl.power = 0.0;
-			is.getline (cbuf, 256);
-			sscanf (cbuf, "%f%f%f%f", &mtrl.emissive.r, &mtrl.emissive.g, &mtrl.emissive.b, &mtrl.emissive.a);
-			mesh.AddMaterial (mtrl);
-		}
-		delete []matname;
-		matname = NULL;
-	}
-
-	// read texture list
-	mesh.ReleaseTextures ();
-	if (is.getline (cbuf, 256) && !strncmp (cbuf, "TEXTURES", 8) && (sscanf (cbuf+8, "%d", &ntex) == 1)) {
-		mesh.Tex = new SURFHANDLE[mesh.nTex = ntex]; TRACENEW
-		Str256 texname, flagstr;
-		for (i = 0; i < ntex; i++) {
-			is.getline (cbuf, 256);
-			flagstr[0] = '\0';
-			sscanf (cbuf, "%255s%255s", texname, flagstr);
-			mesh.Tex[i] = 0;
-			if (texname[0] != '0' || texname[1] != '\0') {
-				bool uncompress = (toupper(flagstr[0]) == 'D');
+	ReleaseTextures ();
+	if (data.tex.size()) {
+		Tex = new SURFHANDLE[nTex = (DWORD)data.tex.size()]; TRACENEW
+		for (i = 0; i < nTex; i++) {
+			const MeshFileTexture &tex = data.tex[i];
+			Tex[i] = 0;
+			if (tex.name != "0") {
 				if (g_pOrbiter->GetGraphicsClient())
-					mesh.Tex[i] = g_pOrbiter->GetGraphicsClient()->clbkLoadTexture (texname, 8 | (uncompress ? 2:0));
+					Tex[i] = g_pOrbiter->GetGraphicsClient()->clbkLoadTexture (tex.name.c_str(), 8 | (tex.uncompress ? 2:0));
 			}
 		}
 	}
 
-	mesh.Setup();
-	is.clear();
+	Setup();
+}
+
+istream &operator>> (istream &is, Mesh &mesh)
+{
+	MeshFileData data;
+	mesh.Clear();
+	if (ReadMeshText (is, data))
+		mesh.Set (data);
 	return is;
 }
 
@@ -1058,12 +938,32 @@ ostream &operator<< (ostream &os, const Mesh &mesh)
 
 bool Mesh::bEnableSpecular = false;
 
+// =======================================================================
+// Read mesh data from file fname, using the compiled binary version of the
+// mesh if it is up to date. Otherwise the text mesh is parsed and the binary
+// version is (re)generated for the next load. Failure to write the binary
+// file (e.g. read-only installation) is not an error.
+
+static bool LoadMeshData (const char *fname, MeshFileData &data)
+{
+	string binpath = MeshBinaryPath (fname);
+	MeshFileStamp stamp;
+	if (!GetMeshFileStamp (fname, stamp)) // no source file: accept a distributed binary mesh
+		return ReadMeshBinary (binpath.c_str(), data);
+	if (ReadMeshBinary (binpath.c_str(), data, &stamp))
+		return true;
+	ifstream ifs (fname, ios::in);
+	if (!ReadMeshText (ifs, data))
+		return false;
+	WriteMeshBinary (binpath.c_str(), data, stamp);
+	return true;
+}
+
 // =======================================================================
 // Class MeshManager
 
 MeshManager::MeshManager()
 {
-	nmlist = nmlistbuf = 0;
 }
 
 MeshManager::~MeshManager()
@@ -1073,28 +973,21 @@ MeshManager::~MeshManager()
 
 void MeshManager::Flush()
 {
-	for (int i = 0; i < nmlist; i++)
-		delete mlist[i].mesh;
-	if (nmlistbuf) {
-		delete []mlist;
-		nmlist = nmlistbuf = 0;
-	}
+	mlist.Clear();
 }
 
 const Mesh *MeshManager::LoadMesh (const char *fname, bool *firstload)
 {
-	int i;
-	DWORDLONG crc = Str2Crc (fname);
-	for (i = 0; i < nmlist; i++) {
-		if (crc == mlist[i].crc && !_strnicmp (fname, mlist[i].fname, 32)) {
-			if (firstload) *firstload = false;
-			return mlist[i].mesh; // found it
-		}
+	Mesh *mesh = mlist.Acquire (fname);
+	if (mesh) {
+		if (firstload) *firstload = false;
+		return mesh; // found it
 	}
 	// not found, so load from file
-	ifstream ifs (g_pOrbiter->MeshPath (fname), ios::in);
-	Mesh *mesh = new Mesh; TRACENEW
-	ifs >> *mesh;
+	MeshFileData data;
+	mesh = new Mesh; TRACENEW
+	if (LoadMeshData (g_pOrbiter->MeshPath (fname), data))
+		mesh->Set (data);
 	if (!mesh->nGroup()) { // load error
 		if (!fname[0]) LOGOUT_ERR ("Mesh file name not provided");
 		else LOGOUT_ERR ("Mesh not found: %s", g_pOrbiter->MeshPath (fname));
@@ -1102,32 +995,31 @@ const Mesh *MeshManager::LoadMesh (const char *fname, bool *firstload)
 		delete mesh;
 		return 0;
 	}
-	if (nmlist == nmlistbuf) { // need to allocate buffer
-		MeshBuffer *tmp = new MeshBuffer[nmlistbuf += 32]; TRACENEW
-		if (nmlist) {
-			memcpy (tmp, mlist, nmlist*sizeof(MeshBuffer));
-			delete []mlist;
-			mlist = NULL;
-		}
-		mlist = tmp;
-	}
 	mesh->SetName(fname);
-	mlist[nmlist].mesh = mesh;
-	mlist[nmlist].crc  = crc;
-	strncpy (mlist[nmlist].fname, fname, 32);
-	nmlist++;
+	mlist.Insert (fname, mesh);
 	if (firstload) *firstload = true;
 	return mesh;
 }
 
+bool MeshManager::ReleaseMesh (const Mesh *mesh)
+{
+	return mlist.Release (mesh);
+}
+
+int MeshManager::Evict ()
+{
+	return (int)mlist.Evict();
+}
+
 // =======================================================================
 // Nonmember functions
 
 bool LoadMesh (const char *meshname, Mesh &mesh)
 {
-	ifstream ifs (g_pOrbiter->MeshPath (meshname), ios::in);
-	ifs >> mesh;
-	if (ifs.good()) {
+	MeshFileData data;
+	mesh.Clear();
+	if (LoadMeshData (g_pOrbiter->MeshPath (meshname), data)) {
+		mesh.Set (data);
 		mesh.SetName(meshname);
 		return true;
 	} else {
@@ -14,6 +14,8 @@
 #include <d3dtypes.h>
 #include <iostream>
 #include "OrbiterAPI.h"
+#include "MeshFile.h"
+#include "RefRegistry.h"
 
 typedef char Str256[256];
 
@@ -76,6 +78,10 @@ public:
 
 	void Set (const Mesh &mesh);
 
+	void Set (const MeshFileData &data);
+	// Replace the mesh contents with data read from a mesh file, and load
+	// the textures it refers to
+
 	void Setup ();
 	// call after all groups are assembled or whenever groups change,
 	// to set up group parameters
@@ -253,14 +259,21 @@ public:
 	// Load a mesh from file (or just return a handle if loaded already.
 	// If firstload is used, it is set to true if the mesh was loaded from
 	// file, and false if the mesh was in memory already
+	// Each call adds a reference to the mesh, which can be returned with
+	// ReleaseMesh.
+
+	bool ReleaseMesh (const Mesh *mesh);
+	// Return a reference obtained with LoadMesh. The mesh remains in memory
+	// until the next call to Evict.
+
+	int Evict ();
+	// Destroy all meshes without outstanding references and return their
+	// number. Handles of evicted meshes become invalid.
+
+	inline int nMesh () const { return (int)mlist.Size(); }
 
 private:
-	struct MeshBuffer {
-		Mesh *mesh;
-		DWORDLONG crc;
-		char fname[32];
-	} *mlist;
-	int nmlist, nmlistbuf;
+	RefRegistry<Mesh> mlist;
 };
 
 // =======================================================================
@@ -0,0 +1,371 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Mesh file formats: MSHX1 text meshes and compiled binary meshes
+// =======================================================================
+
+#include "MeshFile.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <filesystem>
+#include <fstream>
+
+using namespace std;
+
+static const uint32_t SPEC_INHERIT = (uint32_t)(-2); // "inherit" material/texture flag
+
+// =======================================================================
+// Source file identification
+
+bool GetMeshFileStamp (const char *fname, MeshFileStamp &stamp)
+{
+	error_code ec;
+	filesystem::path path (fname);
+	uintmax_t size = filesystem::file_size (path, ec);
+	if (ec) return false;
+	filesystem::file_time_type mtime = filesystem::last_write_time (path, ec);
+	if (ec) return false;
+	stamp.size = (int64_t)size;
+	stamp.mtime = (int64_t)mtime.time_since_epoch().count();
+	return true;
+}
+
+// =======================================================================
+// Text mesh format
+
+bool ReadMeshText (istream &is, MeshFileData &data)
+{
+	char cbuf[256];
+	int i, j, g, ngrp, nvtx, ntri, nidx, nmtrl, mtrl_idx, ntex, tex_idx, flag, res;
+	unsigned long uflag;
+	unsigned short zbias;
+	bool term, staticmesh = false;
+
+	data.Clear();
+
+	if (!is.getline (cbuf, 256)) return false;
+	if (strcmp (cbuf, "MSHX1")) return false;
+
+	for (;;) {
+		if (!is.getline (cbuf, 256)) return false;
+		if (!_strnicmp (cbuf, "GROUPS", 6)) {
+			if (sscanf (cbuf+6, "%d", &ngrp) != 1) return false;
+			break;
+		} else if (!_strnicmp (cbuf, "STATICMESH", 10)) {
+			staticmesh = true;
+		}
+	}
+
+	for (g = 0, term = false; g < ngrp && !term; g++) {
+
+		// set defaults
+		MeshFileGroup grp;
+		mtrl_idx = (int)SPEC_INHERIT;
+		tex_idx  = (int)SPEC_INHERIT;
+		zbias    = 0;
+		flag     = (staticmesh ? 0x04 : 0);
+		uflag    = 0;
+		bool bnormal = true, calcnml = false;
+		bool flipidx = false;
+		nvtx = ntri = nidx = 0;
+
+		for (;;) {
+			if (!is.getline (cbuf, 256)) { term = true; break; }
+			if (!_strnicmp (cbuf, "MATERIAL", 8)) {       // read material index
+				sscanf (cbuf+8, "%d", &mtrl_idx);
+				mtrl_idx--;
+			} else if (!_strnicmp (cbuf, "TEXTURE", 7)) { // read texture index
+				sscanf (cbuf+7, "%d", &tex_idx);
+				tex_idx--;
+			} else if (!_strnicmp (cbuf, "ZBIAS", 5)) {   // read z-bias
+				sscanf (cbuf+5, "%hu", &zbias);
+			} else if (!_strnicmp (cbuf, "TEXWRAP", 7)) { // read wrap flags
+				char uvstr[10] = "";
+				sscanf (cbuf+7, "%9s", uvstr);
+				if (uvstr[0] == 'U' || uvstr[1] == 'U') flag |= 0x01;
+				if (uvstr[0] == 'V' || uvstr[1] == 'V') flag |= 0x02;
+			} else if (!_strnicmp (cbuf, "NONORMAL", 8)) {
+				bnormal = false; calcnml = true;
+			} else if (!_strnicmp (cbuf, "FLAG", 4)) {
+				sscanf (cbuf+4, "%lx", &uflag);
+			} else if (!_strnicmp (cbuf, "FLIP", 4)) {
+				flipidx = true;
+			} else if (!_strnicmp (cbuf, "LABEL", 5)) {
+				// ignore group labels here
+			} else if (!_strnicmp (cbuf, "STATIC", 6)) {
+				flag |= 0x04;
+			} else if (!_strnicmp (cbuf, "DYNAMIC", 7)) {
+				flag ^= 0x04;
+			} else if (!_strnicmp (cbuf, "GEOM", 4)) {    // read geometry
+				if (sscanf (cbuf+4, "%d%d", &nvtx, &ntri) != 2 || nvtx < 0 || ntri < 0) { // parse error - skip group
+					nvtx = ntri = 0;
+					break;
+				}
+				nidx = ntri*3;
+				grp.Vtx.assign (nvtx, MeshFileVertex());
+				for (i = 0; i < nvtx; i++) {
+					MeshFileVertex &v = grp.Vtx[i];
+					if (!is.getline (cbuf, 256)) {
+						grp.Vtx.clear();
+						nvtx = 0;
+						break;
+					}
+					if (bnormal) {
+						j = sscanf (cbuf, "%f%f%f%f%f%f%f%f",
+							&v.x, &v.y, &v.z, &v.nx, &v.ny, &v.nz, &v.tu, &v.tv);
+						if (j < 6) calcnml = true;
+					} else {
+						j = sscanf (cbuf, "%f%f%f%f%f",
+							&v.x, &v.y, &v.z, &v.tu, &v.tv);
+					}
+				}
+				grp.Idx.assign (nidx, 0);
+				for (i = j = 0; i < ntri; i++) {
+					if (!is.getline (cbuf, 256)) {
+						grp.Vtx.clear();
+						grp.Idx.clear();
+						nvtx = nidx = 0;
+						break;
+					}
+					sscanf (cbuf, "%hu%hu%hu", &grp.Idx[j], &grp.Idx[j+1], &grp.Idx[j+2]);
+					j += 3;
+				}
+				if (flipidx)
+					for (i = 0; i < ntri; i++)
+						swap (grp.Idx[i*3+1], grp.Idx[i*3+2]);
+
+				break;
+			}
+		}
+		if (nvtx && nidx) {
+			grp.MtrlIdx = (uint32_t)mtrl_idx;
+			grp.TexIdx = (uint32_t)tex_idx;
+			grp.UsrFlag = (uint32_t)uflag;
+			grp.zBias = zbias;
+			grp.Flags = (uint16_t)flag;
+			grp.CalcNormals = calcnml;
+			data.grp.push_back (move (grp));
+		}
+	}
+
+	// read material list
+	if (is.getline (cbuf, 256) && !strncmp (cbuf, "MATERIALS", 9) && (sscanf (cbuf+9, "%d", &nmtrl) == 1)) {
+		for (i = 0; i < nmtrl; i++)
+			is.getline (cbuf, 256); // material names are not used
+		for (i = 0; i < nmtrl; i++) {
+			MeshFileMaterial mtrl;
+			memset (&mtrl, 0, sizeof(MeshFileMaterial));
+			is.getline (cbuf, 256); // MATERIAL <name>
+			is.getline (cbuf, 256);
+			sscanf (cbuf, "%f%f%f%f", mtrl.diffuse+0, mtrl.diffuse+1, mtrl.diffuse+2, mtrl.diffuse+3);
+			is.getline (cbuf, 256);
+			sscanf (cbuf, "%f%f%f%f", mtrl.ambient+0, mtrl.ambient+1, mtrl.ambient+2, mtrl.ambient+3);
+			is.getline (cbuf, 256);
+			res = sscanf (cbuf, "%f%f%f%f%f", mtrl.specular+0, mtrl.specular+1, mtrl.specular+2, mtrl.specular+3, &mtrl.power);
+			if (res < 5) mtrl.power = 0.0f;
+			is.getline (cbuf, 256);
+			sscanf (cbuf, "%f%f%f%f", mtrl.emissive+0, mtrl.emissive+1, mtrl.emissive+2, mtrl.emissive+3);
+			data.mtrl.push_back (mtrl);
+		}
+	}
+
+	// read texture list
+	if (is.getline (cbuf, 256) && !strncmp (cbuf, "TEXTURES", 8) && (sscanf (cbuf+8, "%d", &ntex) == 1)) {
+		char texname[256], flagstr[256];
+		for (i = 0; i < ntex; i++) {
+			is.getline (cbuf, 256);
+			strcpy (texname, "0");
+			flagstr[0] = '\0';
+			sscanf (cbuf, "%255s%255s", texname, flagstr);
+			MeshFileTexture tex;
+			tex.name = texname;
+			tex.uncompress = (toupper(flagstr[0]) == 'D');
+			data.tex.push_back (tex);
+		}
+	}
+
+	is.clear();
+	return true;
+}
+
+// =======================================================================
+// Binary mesh format
+
+static const char MESHBIN_MAGIC[8] = "OMSHBIN";
+static const uint32_t MESHBIN_VERSION = 1;
+
+struct MeshBinHeader {
+	char     magic[8];         // MESHBIN_MAGIC
+	uint32_t version;          // MESHBIN_VERSION
+	uint32_t nGrp;             // number of entries in group table
+	uint32_t nMtrl;            // number of entries in material table
+	uint32_t nTex;             // number of entries in texture table
+	int64_t  srcSize;          // size of the source mesh file
+	int64_t  srcTime;          // modification time of the source mesh file
+};
+
+struct MeshBinGroup {
+	uint32_t nVtx, nIdx;       // vertex and index count
+	uint32_t MtrlIdx, TexIdx;  // material and texture index
+	uint32_t UsrFlag;          // user-defined flag
+	uint16_t zBias, Flags;
+	uint32_t CalcNormals;      // vertex normals must be computed after loading
+	uint32_t VtxOfs, IdxOfs;   // file offsets of vertex and index blocks
+};
+
+struct MeshBinTexture {
+	char     name[256];        // texture file name
+	uint32_t uncompress;       // load texture uncompressed
+};
+
+static inline size_t Align4 (size_t n) { return (n + 3) & ~(size_t)3; }
+
+string MeshBinaryPath (const char *fname)
+{
+	string path (fname);
+	size_t len = path.size();
+	if (len >= 4 && !_stricmp (path.c_str()+len-4, ".msh")) path += 'b';
+	else path += ".mshb";
+	return path;
+}
+
+static bool ReadMeshBinaryHeader (istream &is, MeshBinHeader &hdr)
+{
+	if (!is.read ((char*)&hdr, sizeof(MeshBinHeader))) return false;
+	return !memcmp (hdr.magic, MESHBIN_MAGIC, 8) && hdr.version == MESHBIN_VERSION;
+}
+
+bool ReadMeshBinary (const char *fname, MeshFileData &data, const MeshFileStamp *src)
+{
+	ifstream ifs (fname, ios::in | ios::binary);
+	MeshBinHeader hdr;
+	if (!ifs || !ReadMeshBinaryHeader (ifs, hdr)) return false;
+	if (src && (hdr.srcSize != src->size || hdr.srcTime != src->mtime)) return false; // stale
+
+	// read the rest of the file in one go
+	ifs.seekg (0, ios::end);
+	size_t fsize = (size_t)ifs.tellg();
+	size_t tblsize = sizeof(MeshBinHeader) + (size_t)hdr.nGrp*sizeof(MeshBinGroup) +
+		(size_t)hdr.nMtrl*sizeof(MeshFileMaterial) + (size_t)hdr.nTex*sizeof(MeshBinTexture);
+	if (fsize < tblsize) return false;
+	vector<char> buf (fsize);
+	ifs.seekg (0, ios::beg);
+	if (!ifs.read (buf.data(), fsize)) return false;
+
+	const char *p = buf.data() + sizeof(MeshBinHeader);
+	const MeshBinGroup *gtbl = (const MeshBinGroup*)p;
+	p += hdr.nGrp*sizeof(MeshBinGroup);
+	const MeshFileMaterial *mtbl = (const MeshFileMaterial*)p;
+	p += hdr.nMtrl*sizeof(MeshFileMaterial);
+	const MeshBinTexture *ttbl = (const MeshBinTexture*)p;
+
+	data.Clear();
+	data.grp.resize (hdr.nGrp);
+	for (uint32_t g = 0; g < hdr.nGrp; g++) {
+		const MeshBinGroup &gb = gtbl[g];
+		if ((size_t)gb.VtxOfs + (size_t)gb.nVtx*sizeof(MeshFileVertex) > fsize ||
+			(size_t)gb.IdxOfs + (size_t)gb.nIdx*sizeof(uint16_t) > fsize) {
+			data.Clear();
+			return false;
+		}
+		MeshFileGroup &grp = data.grp[g];
+		grp.Vtx.resize (gb.nVtx);
+		memcpy (grp.Vtx.data(), buf.data()+gb.VtxOfs, gb.nVtx*sizeof(MeshFileVertex));
+		grp.Idx.resize (gb.nIdx);
+		memcpy (grp.Idx.data(), buf.data()+gb.IdxOfs, gb.nIdx*sizeof(uint16_t));
+		grp.MtrlIdx = gb.MtrlIdx;
+		grp.TexIdx = gb.TexIdx;
+		grp.UsrFlag = gb.UsrFlag;
+		grp.zBias = gb.zBias;
+		grp.Flags = gb.Flags;
+		grp.CalcNormals = (gb.CalcNormals != 0);
+	}
+	data.mtrl.assign (mtbl, mtbl+hdr.nMtrl);
+	data.tex.resize (hdr.nTex);
+	for (uint32_t i = 0; i < hdr.nTex; i++) {
+		data.tex[i].name.assign (ttbl[i].name, strnlen (ttbl[i].name, sizeof(ttbl[i].name)));
+		data.tex[i].uncompress = (ttbl[i].uncompress != 0);
+	}
+	return true;
+}
+
+bool WriteMeshBinary (const char *fname, const MeshFileData &data, const MeshFileStamp &src)
+{
+	MeshBinHeader hdr;
+	memset (&hdr, 0, sizeof(MeshBinHeader));
+	memcpy (hdr.magic, MESHBIN_MAGIC, 8);
+	hdr.version = MESHBIN_VERSION;
+	hdr.nGrp = (uint32_t)data.grp.size();
+	hdr.nMtrl = (uint32_t)data.mtrl.size();
+	hdr.nTex = (uint32_t)data.tex.size();
+	hdr.srcSize = src.size;
+	hdr.srcTime = src.mtime;
+
+	// lay out the geometry blocks behind the tables
+	size_t ofs = sizeof(MeshBinHeader) + hdr.nGrp*sizeof(MeshBinGroup) +
+		hdr.nMtrl*sizeof(MeshFileMaterial) + hdr.nTex*sizeof(MeshBinTexture);
+	vector<MeshBinGroup> gtbl (hdr.nGrp);
+	for (uint32_t g = 0; g < hdr.nGrp; g++) {
+		const MeshFileGroup &grp = data.grp[g];
+		MeshBinGroup &gb = gtbl[g];
+		memset (&gb, 0, sizeof(MeshBinGroup));
+		gb.nVtx = (uint32_t)grp.Vtx.size();
+		gb.nIdx = (uint32_t)grp.Idx.size();
+		gb.MtrlIdx = grp.MtrlIdx;
+		gb.TexIdx = grp.TexIdx;
+		gb.UsrFlag = grp.UsrFlag;
+		gb.zBias = grp.zBias;
+		gb.Flags = grp.Flags;
+		gb.CalcNormals = (grp.CalcNormals ? 1 : 0);
+		gb.VtxOfs = (uint32_t)ofs;
+		ofs += Align4 (gb.nVtx*sizeof(MeshFileVertex));
+		gb.IdxOfs = (uint32_t)ofs;
+		ofs += Align4 (gb.nIdx*sizeof(uint16_t));
+	}
+
+	ofstream ofs_ (fname, ios::out | ios::binary | ios::trunc);
+	if (!ofs_) return false;
+	ofs_.write ((const char*)&hdr, sizeof(MeshBinHeader));
+	if (hdr.nGrp)
+		ofs_.write ((const char*)gtbl.data(), hdr.nGrp*sizeof(MeshBinGroup));
+	if (hdr.nMtrl)
+		ofs_.write ((const char*)data.mtrl.data(), hdr.nMtrl*sizeof(MeshFileMaterial));
+	for (const auto &tex : data.tex) {
+		MeshBinTexture tb;
+		memset (&tb, 0, sizeof(MeshBinTexture));
+		strncpy (tb.name, tex.name.c_str(), sizeof(tb.name)-1);
+		tb.uncompress = (tex.uncompress ? 1 : 0);
+		ofs_.write ((const char*)&tb, sizeof(MeshBinTexture));
+	}
+	static const char pad[4] = {0,0,0,0};
+	for (const auto &grp : data.grp) {
+		size_t vsize = grp.Vtx.size()*sizeof(MeshFileVertex);
+		size_t isize = grp.Idx.size()*sizeof(uint16_t);
+		if (vsize) ofs_.write ((const char*)grp.Vtx.data(), vsize);
+		ofs_.write (pad, Align4 (vsize) - vsize);
+		if (isize) ofs_.write ((const char*)grp.Idx.data(), isize);
+		ofs_.write (pad, Align4 (isize) - isize);
+	}
+	return ofs_.good();
+}
+
+bool CompileMesh (const char *fname)
+{
+	MeshFileStamp stamp;
+	if (!GetMeshFileStamp (fname, stamp)) return false;
+	string binpath = MeshBinaryPath (fname);
+
+	// nothing to do if the binary version is up to date
+	ifstream bfs (binpath.c_str(), ios::in | ios::binary);
+	MeshBinHeader hdr;
+	if (bfs && ReadMeshBinaryHeader (bfs, hdr) && hdr.srcSize == stamp.size && hdr.srcTime == stamp.mtime)
+		return true;
+	bfs.close();
+
+	ifstream ifs (fname);
+	MeshFileData data;
+	if (!ReadMeshText (ifs, data)) return false;
+	return WriteMeshBinary (binpath.c_str(), data, stamp);
+}
@@ -0,0 +1,100 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Mesh file formats: MSHX1 text meshes and compiled binary meshes
+// This module has no dependencies on the rest of Orbiter, so that it can
+// be shared with the mesh compiler utility (Utils/meshc).
+// =======================================================================
+
+#ifndef __MESHFILE_H
+#define __MESHFILE_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// =======================================================================
+// Mesh data as read from a mesh file, before textures are loaded.
+// Vertex and material records are layout-compatible with NTVERTEX and
+// D3DMATERIAL7, respectively.
+
+struct MeshFileVertex {
+	float x, y, z;     // position
+	float nx, ny, nz;  // normal
+	float tu, tv;      // texture coordinates
+};
+
+struct MeshFileMaterial {
+	float diffuse[4], ambient[4], specular[4], emissive[4]; // RGBA components
+	float power;       // specular power
+};
+
+struct MeshFileGroup {
+	std::vector<MeshFileVertex> Vtx;
+	std::vector<uint16_t> Idx;
+	uint32_t MtrlIdx;  // material index, or SPEC_DEFAULT/SPEC_INHERIT
+	uint32_t TexIdx;   // texture index, or SPEC_DEFAULT/SPEC_INHERIT
+	uint32_t UsrFlag;  // user-defined group flag
+	uint16_t zBias;
+	uint16_t Flags;    // texture wrap (bits 0-1) and static (bit 2) flags
+	bool CalcNormals;  // some vertex normals are missing and must be computed
+};
+
+struct MeshFileTexture {
+	std::string name;  // texture file name ("0" for none)
+	bool uncompress;   // 'D' flag: load texture uncompressed
+};
+
+struct MeshFileData {
+	std::vector<MeshFileGroup> grp;
+	std::vector<MeshFileMaterial> mtrl;
+	std::vector<MeshFileTexture> tex;
+
+	void Clear () { grp.clear(); mtrl.clear(); tex.clear(); }
+};
+
+// =======================================================================
+// Identification of a mesh source file version, stored in the compiled
+// binary mesh to detect stale files
+
+struct MeshFileStamp {
+	int64_t size;      // file size [bytes]
+	int64_t mtime;     // last modification time (file system clock ticks)
+};
+
+bool GetMeshFileStamp (const char *fname, MeshFileStamp &stamp);
+// Return size and modification time of file fname.
+// Returns false if the file doesn't exist.
+
+// =======================================================================
+// Text (MSHX1) mesh format
+
+bool ReadMeshText (std::istream &is, MeshFileData &data);
+// Parse an MSHX1 mesh from stream is. Returns false if the stream doesn't
+// contain a valid mesh header. Truncated group, material or texture lists
+// are accepted.
+
+// =======================================================================
+// Compiled binary mesh format
+// Layout: file header, group table, material table, texture table,
+// followed by the vertex and index blocks of all groups. Each block is
+// 4-byte aligned and can be copied directly into NTVERTEX or WORD arrays.
+
+std::string MeshBinaryPath (const char *fname);
+// Name of the compiled binary version of text mesh file fname
+
+bool ReadMeshBinary (const char *fname, MeshFileData &data, const MeshFileStamp *src = 0);
+// Read a compiled binary mesh. If src is provided, the file is rejected
+// if it was not compiled from a source file matching src.
+
+bool WriteMeshBinary (const char *fname, const MeshFileData &data, const MeshFileStamp &src);
+// Write mesh data to a compiled binary mesh file, tagged with the
+// stamp of the source file it was compiled from.
+
+bool CompileMesh (const char *fname);
+// Compile text mesh file fname into its binary version, if the binary
+// version is missing or out of date. Returns false on error.
+
+#endif // !__MESHFILE_H
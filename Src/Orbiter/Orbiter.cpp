@@ -1275,7 +1275,7 @@ void Orbiter::InsertVessel (Vessel *vessel)
 //-----------------------------------------------------------------------------
 bool Orbiter::KillVessels ()
 {
-	int i, n = g_psys->nVessel();
+	int i, n = g_psys->nVessel(), nkill = 0;
 	DWORD j;
 
 	for (i = n-1; i >= 0; i--) {
@@ -1328,8 +1328,11 @@ bool Orbiter::KillVessels ()
 			}
 			// kill the vessel
 			g_psys->DelVessel (vessel);
+			nkill++;
 		}
 	}
+	if (nkill) // release meshes no longer used by any vessel
+		meshmanager.Evict();
 	return true;
 }
 
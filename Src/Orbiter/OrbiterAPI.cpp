@@ -2287,14 +2287,18 @@ DLLEXPORT FILEHANDLE oapiOpenFile (const char *fname, FileAccessMode mode, PathR
 	}
 
 	switch (mode) {
-	case FILE_IN:
-		return (FILEHANDLE)(new ifstream (cbuf));
+	case FILE_IN: {
+		ifstream *ifs = new ifstream (cbuf);
+		IndexItems (*ifs);
+		return (FILEHANDLE)ifs;
+		}
 	case FILE_IN_ZEROONFAIL: {
 		ifstream *ifs = new ifstream (cbuf);
 		if (ifs->fail()) {
 			delete ifs;
 			ifs = 0;
-		}
+		} else
+			IndexItems (*ifs);
 		return (FILEHANDLE)ifs;
 		}
 	case FILE_OUT:
@@ -22,9 +22,9 @@
 
 #include <fstream>
 #include <cmath>
+#include <cstdio>
 #include "Vecmat.h"
 #include "PinesGrav.h"
-#include "Orbiter.h"
 
 PinesGravProp::PinesGravProp(CelestialBody* celestialbody)
 {
@@ -39,72 +39,48 @@ PinesGravProp::PinesGravProp(CelestialBody* celestialbody)
 	referenceLon = 0.0;
 	C = NULL;
 	S = NULL;
-	A = NULL;
-	R = NULL;
-	I = NULL;
 	numCoeff = 0;
 	CoeffCutoff = 0;
-
-	r = 0.0;
-	s = 0.0;
-	t = 0.0;
-	u = 0.0;
-	rho = 0.0;
-	rhop = 0.0;
-
-	g1temp = 0.0;
-	g2temp = 0.0;
-	g3temp = 0.0;
-	g4temp = 0.0;
-
-	g1 = 0.0;
-	g2 = 0.0;
-	g3 = 0.0;
-	g4 = 0.0;
+	tabDegree = -1;
 }
 
 PinesGravProp::~PinesGravProp()
 {
 	delete[] C;
 	delete[] S;
-	delete[] A;
-	delete[] R;
-	delete[] I;
 }
 
-inline void PinesGravProp::GenerateAssocLegendreMatrix(int maxDegree)
+void PinesGravProp::GenerateRecursionTables(int maxDegree)
 {
-	A[0] = sqrt(2.0);
-
-	for (int m = 0; m <= (maxDegree + 2); m++) {
-
-		if (m != 0) {
-			A[NM(m, m)] = sqrt(1. + (1. / (2. * (double)m))) * A[NM(m - 1, m - 1)]; // diagonal terms
-		}
-
-		if (m != (maxDegree + 2)) {
-			A[NM(m + 1, m)] = sqrt(2. * (double)m + 3.) * u * A[NM(m, m)]; // off-diagonal terms
-		}
-
-		if (m < maxDegree + 1) {
-			for (int n = m + 2; n <= (maxDegree + 2); n++) {
-				double ALPHA_NUM = (2. * (double)n + 1.) * (2. * (double)n - 1.);
-				double ALPHA_DEN = ((double)n - (double)m) * ((double)n + (double)m);
-				double ALPHA = sqrt(ALPHA_NUM / ALPHA_DEN);
-				double BETA_NUM = (2. * (double)n + 1.) * ((double)n - (double)m - 1.) * ((double)n + (double)m - 1.);
-				double BETA_DEN = (2. * (double)n - 3.) * ((double)n + (double)m) * ((double)n - (double)m);
-				double BETA = sqrt(BETA_NUM / BETA_DEN);
-
-
-				A[NM(n, m)] = ALPHA * u * A[NM(n - 1, m)] - BETA * A[NM(n - 2, m)]; // remaining terms in the column
-			}
+	int n, m, nmax = maxDegree + 2;
+	tabDegree = maxDegree;
+
+	diagFac.assign(nmax + 1, 0.0);
+	offFac.assign(nmax + 1, 0.0);
+	alphaFac.assign(NM(nmax + 1, 0), 0.0);
+	betaFac.assign(NM(nmax + 1, 0), 0.0);
+	sumFac.assign(NM(maxDegree + 1, 0), 0.0);
+
+	for (m = 0; m <= nmax; m++) {
+		if (m != 0)
+			diagFac[m] = sqrt(1. + (1. / (2. * (double)m)));
+		offFac[m] = sqrt(2. * (double)m + 3.);
+		for (n = m + 2; n <= nmax; n++) {
+			double ALPHA_NUM = (2. * (double)n + 1.) * (2. * (double)n - 1.);
+			double ALPHA_DEN = ((double)n - (double)m) * ((double)n + (double)m);
+			double BETA_NUM = (2. * (double)n + 1.) * ((double)n - (double)m - 1.) * ((double)n + (double)m - 1.);
+			double BETA_DEN = (2. * (double)n - 3.) * ((double)n + (double)m) * ((double)n - (double)m);
+			alphaFac[NM(n, m)] = sqrt(ALPHA_NUM / ALPHA_DEN);
+			betaFac[NM(n, m)] = sqrt(BETA_NUM / BETA_DEN);
 		}
 	}
 
-	for (int n = 0; n <= (maxDegree + 2); n++) {
-		A[NM(n, 0)] = A[NM(n, 0)] * sqrt(0.5);
+	for (n = 0; n <= maxDegree; n++) {
+		for (m = 0; m <= n; m++) {
+			double SM = (m == 0 ? 0.5 : 1.0);
+			sumFac[NM(n, m)] = sqrt(SM * ((double)n - (double)m) * ((double)n + (double)m + 1));
+		}
 	}
-
 }
 
 int PinesGravProp::readGravModel(char* filename, int cutoff, int &actualLoadedTerms, int &maxModelTerms)
@@ -120,9 +96,6 @@ int PinesGravProp::readGravModel(char* filename, int cutoff, int &actualLoadedTe
 	try {
 		C = new double[(size_t)NM(cutoff + 1, cutoff + 1)];
 		S = new double[(size_t)NM(cutoff + 1, cutoff + 1)];
-		R = new double[(size_t)cutoff + 2];
-		I = new double[(size_t)cutoff + 2];
-		A = new double[NM((size_t)cutoff + 3, (size_t)cutoff + 3)];
 	}
 	catch (std::bad_alloc) {
 		return 2; //Could not allocate space
@@ -173,6 +146,7 @@ int PinesGravProp::readGravModel(char* filename, int cutoff, int &actualLoadedTe
 				numCoeff = linecount++;
 			}
 		}
+		GenerateRecursionTables(CoeffCutoff);
 		actualLoadedTerms = NM(CoeffCutoff, CoeffCutoff);
 		maxModelTerms = NM(order,degree);
 		return 0; //successfully loaded gravity coefficients
@@ -182,83 +156,150 @@ int PinesGravProp::readGravModel(char* filename, int cutoff, int &actualLoadedTe
 	}
 }
 
-Vector PinesGravProp::GetPinesGrav(const Vector rpos, const int maxDegree, const int maxOrder)
+template<int W>
+void PinesGravProp::Evaluate(const Vector* rpos, Vector* g, int maxDegree, int maxOrder, Workspace& ws) const
 {
-	r = rpos.length();
-	s = rpos.x / r;
-	t = rpos.y / r;
-	u = rpos.z / r;
-
-	rho = GM / (r * refRad);
-	rhop = refRad / r;
-
-	R[0] = 0.0;
-	I[0] = 0.0;
-	R[1] = 1.0;
-	I[1] = 0.0;
-
-	for (int m = 2; m <= maxOrder + 1; m++) {
-		R[m] = s * R[m - 1] - t * I[m - 1];
-		I[m] = s * I[m - 1] + t * R[m - 1];
+	int n, m, k, nmodel;
+	const int nmax = maxDegree + 2;
+	double s[W], t[W], u[W], rho[W], rhop[W];
+	double g1[W], g2[W], g3[W], g4[W];
+	double g1temp[W], g2temp[W], g3temp[W], g4temp[W];
+
+	ws.A.resize(NM(nmax + 1, 0) * W);
+	ws.R.resize((maxOrder + 2) * W);
+	ws.I.resize((maxOrder + 2) * W);
+	double* __restrict A = ws.A.data();
+	double* __restrict R = ws.R.data();
+	double* __restrict I = ws.I.data();
+
+	for (k = 0; k < W; k++) {
+		double r = rpos[k].length();
+		s[k] = rpos[k].x / r;
+		t[k] = rpos[k].y / r;
+		u[k] = rpos[k].z / r;
+		rho[k] = GM / (r * refRad);
+		rhop[k] = refRad / r;
+		R[k] = 0.0;
+		I[k] = 0.0;
+		R[W + k] = 1.0;
+		I[W + k] = 0.0;
+		g1[k] = g2[k] = g3[k] = g4[k] = 0.0;
 	}
 
-	g1temp = 0.0;
-	g2temp = 0.0;
-	g3temp = 0.0;
-	g4temp = 0.0;
-
-	g1 = 0.0;
-	g2 = 0.0;
-	g3 = 0.0;
-	g4 = 0.0;
-
-	int nmodel = 0;
-	GenerateAssocLegendreMatrix(maxDegree);
-	for (int n = 0; n <= maxDegree; n++) {
-
-		g1temp = 0.0;
-		g2temp = 0.0;
-		g3temp = 0.0;
-		g4temp = 0.0;
-
-		double SM = 0.5;
-
-		if (n > maxOrder)
-			nmodel = maxOrder;
-		else
-			nmodel = n;
-
-
-		for (int m = 0; m <= nmodel; m++) {
-
-			double D = C[NM(n, m)] * R[m + 1] + S[NM(n, m)] * I[m + 1];
-			double E = C[NM(n, m)] * R[m] + S[NM(n, m)] * I[m];
-			double F = S[NM(n, m)] * R[m] - C[NM(n, m)] * I[m];
-
+	for (m = 2; m <= maxOrder + 1; m++) {
+		for (k = 0; k < W; k++) {
+			R[m * W + k] = s[k] * R[(m - 1) * W + k] - t[k] * I[(m - 1) * W + k];
+			I[m * W + k] = s[k] * I[(m - 1) * W + k] + t[k] * R[(m - 1) * W + k];
+		}
+	}
 
-			double ALPHA = sqrt(SM * ((double)n - (double)m) * ((double)n + (double)m + 1));
+	// associated Legendre functions
+	for (k = 0; k < W; k++)
+		A[k] = sqrt(2.0);
 
-			g1temp = g1temp + A[NM(n, m)] * (double)m * E;
-			g2temp = g2temp + A[NM(n, m)] * (double)m * F;
-			g3temp = g3temp + ALPHA * A[NM(n, m + 1)] * D;
-			g4temp = g4temp + (((double)n + (double)m + 1) * A[NM(n, m)] + ALPHA * u * A[NM(n, m + 1)]) * D;
+	for (m = 0; m <= nmax; m++) {
+		if (m != 0) { // diagonal terms
+			const double f = diagFac[m];
+			for (k = 0; k < W; k++)
+				A[NM(m, m) * W + k] = f * A[NM(m - 1, m - 1) * W + k];
+		}
+		if (m != nmax) { // off-diagonal terms
+			const double f = offFac[m];
+			for (k = 0; k < W; k++)
+				A[NM(m + 1, m) * W + k] = f * u[k] * A[NM(m, m) * W + k];
+		}
+		if (m < maxDegree + 1) { // remaining terms in the column
+			for (n = m + 2; n <= nmax; n++) {
+				const double a = alphaFac[NM(n, m)], b = betaFac[NM(n, m)];
+				const double* A1 = A + NM(n - 1, m) * W;
+				const double* A2 = A + NM(n - 2, m) * W;
+				double* A0 = A + NM(n, m) * W;
+				for (k = 0; k < W; k++)
+					A0[k] = a * u[k] * A1[k] - b * A2[k];
+			}
+		}
+	}
 
-			if (m == 0) { SM = 1.0; ; }
+	for (n = 0; n <= nmax; n++)
+		for (k = 0; k < W; k++)
+			A[NM(n, 0) * W + k] *= sqrt(0.5);
+
+	// acceleration sums
+	for (n = 0; n <= maxDegree; n++) {
+
+		for (k = 0; k < W; k++)
+			g1temp[k] = g2temp[k] = g3temp[k] = g4temp[k] = 0.0;
+
+		nmodel = (n > maxOrder ? maxOrder : n);
+
+		for (m = 0; m <= nmodel; m++) {
+			const double Cnm = C[NM(n, m)], Snm = S[NM(n, m)];
+			const double ALPHA = sumFac[NM(n, m)];
+			const double dm = (double)m, dnm1 = (double)n + (double)m + 1;
+			const double* An = A + NM(n, m) * W;
+			const double* An1 = A + NM(n, m + 1) * W;
+			const double* Rm = R + m * W;
+			const double* Im = I + m * W;
+			const double* Rm1 = R + (m + 1) * W;
+			const double* Im1 = I + (m + 1) * W;
+
+			for (k = 0; k < W; k++) {
+				double D = Cnm * Rm1[k] + Snm * Im1[k];
+				double E = Cnm * Rm[k] + Snm * Im[k];
+				double F = Snm * Rm[k] - Cnm * Im[k];
+
+				g1temp[k] += An[k] * dm * E;
+				g2temp[k] += An[k] * dm * F;
+				g3temp[k] += ALPHA * An1[k] * D;
+				g4temp[k] += (dnm1 * An[k] + ALPHA * u[k] * An1[k]) * D;
+			}
 		}
-		rho = rhop * rho;
 
-		g1 = g1 + rho * g1temp;
-		g2 = g2 + rho * g2temp;
-		g3 = g3 + rho * g3temp;
-		g4 = g4 + rho * g4temp;
+		for (k = 0; k < W; k++) {
+			rho[k] *= rhop[k];
+			g1[k] += rho[k] * g1temp[k];
+			g2[k] += rho[k] * g2temp[k];
+			g3[k] += rho[k] * g3temp[k];
+			g4[k] += rho[k] * g4temp[k];
+		}
+	}
 
+	for (k = 0; k < W; k++) {
+		g[k].x = (g1[k] - g4[k] * s[k]);
+		g[k].y = (g2[k] - g4[k] * t[k]);
+		g[k].z = (g3[k] - g4[k] * u[k]);
 	}
+}
 
-	Vector gperturbed;
+Vector PinesGravProp::GetPinesGrav(const Vector rpos, const int maxDegree, const int maxOrder) const
+{
+	static thread_local Workspace ws;
+	return GetPinesGrav(rpos, maxDegree, maxOrder, ws);
+}
 
-	gperturbed.x = (g1 - g4 * s);
-	gperturbed.y = (g2 - g4 * t);
-	gperturbed.z = (g3 - g4 * u);
+Vector PinesGravProp::GetPinesGrav(const Vector rpos, const int maxDegree, const int maxOrder, Workspace& ws) const
+{
+	Vector gperturbed;
+	if (tabDegree < 0) return gperturbed; // no model loaded
 
+	int ndeg = (maxDegree < tabDegree ? maxDegree : tabDegree);
+	int nord = (maxOrder < ndeg ? maxOrder : ndeg);
+	Evaluate<1>(&rpos, &gperturbed, ndeg, nord, ws);
 	return gperturbed;
-}
\ No newline at end of file
+}
+
+void PinesGravProp::GetPinesGravBatch(const Vector* rpos, Vector* g, int npos, const int maxDegree, const int maxOrder, Workspace& ws) const
+{
+	int i;
+	if (tabDegree < 0) { // no model loaded
+		for (i = 0; i < npos; i++) g[i].Set(0, 0, 0);
+		return;
+	}
+
+	int ndeg = (maxDegree < tabDegree ? maxDegree : tabDegree);
+	int nord = (maxOrder < ndeg ? maxOrder : ndeg);
+	for (i = 0; i + PINES_BATCH <= npos; i += PINES_BATCH)
+		Evaluate<PINES_BATCH>(rpos + i, g + i, ndeg, nord, ws);
+	for (; i < npos; i++)
+		Evaluate<1>(rpos + i, g + i, ndeg, nord, ws);
+}
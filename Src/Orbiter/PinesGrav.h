@@ -21,6 +21,7 @@
 
 #ifndef __PINESGRAV_H
 #define __PINESGRAV_H
+#include <vector>
 class CelestialBody;
 
 class PinesGravProp
@@ -29,11 +30,38 @@ public:
 	PinesGravProp(CelestialBody* celestialbody);
 	~PinesGravProp();
 	int readGravModel(char* filename, int cutoff, int& actualLoadedTerms, int& maxModelTerms);
-	Vector GetPinesGrav(const Vector rposmax, const int maxDegree, const int maxOrder);
+
+	// Scratch space for the Legendre functions and longitude terms of an evaluation.
+	// Evaluations don't modify the PinesGravProp object, so any number of callers can
+	// evaluate the same field concurrently, each with its own workspace.
+	struct Workspace {
+		std::vector<double> A, R, I;
+	};
+
+	// Perturbation acceleration at position rpos (planet frame, right-handed, km).
+	// The first version uses a workspace local to the calling thread.
+	Vector GetPinesGrav(const Vector rpos, const int maxDegree, const int maxOrder) const;
+	Vector GetPinesGrav(const Vector rpos, const int maxDegree, const int maxOrder, Workspace& ws) const;
+
+	// Perturbation accelerations g[i] at npos positions rpos[i]. Positions are evaluated
+	// in groups of PINES_BATCH, with the inner loops running across the group.
+	void GetPinesGravBatch(const Vector* rpos, Vector* g, int npos, const int maxDegree, const int maxOrder, Workspace& ws) const;
+
 	inline unsigned int GetCoeffCutoff() const { return CoeffCutoff; }
+	inline double GetRefRadius() const { return refRad; }
+
+	static const int PINES_BATCH = 4;
+
 private:
 	CelestialBody* parentBody;
-	inline void GenerateAssocLegendreMatrix(int maxDegree);
+
+	template<int W>
+	void Evaluate(const Vector* rpos, Vector* g, int maxDegree, int maxOrder, Workspace& ws) const;
+	// Evaluate W positions, with workspace arrays interleaved by position
+
+	void GenerateRecursionTables(int maxDegree);
+	// Precompute the degree- and order-dependent factors of the Legendre recursion
+	// and of the acceleration sums up to maxDegree
 
 	static inline unsigned int NM(unsigned int n, unsigned int m) { return (n * n + n) / 2 + m; }
 
@@ -47,23 +75,14 @@ private:
 	double referenceLon;
 	double* __restrict C;
 	double* __restrict S;
-	double* __restrict A;
-	double* __restrict R;
-	double* __restrict I;
 	unsigned long int numCoeff;
 
-	double r, s, t, u;
-	double rho, rhop;
-
-	double g1temp;
-	double g2temp;
-	double g3temp;
-	double g4temp;
-
-	double g1;
-	double g2;
-	double g3;
-	double g4;
+	int tabDegree;                  // max degree covered by the recursion tables
+	std::vector<double> diagFac;    // diagonal Legendre terms: A(m,m) = diagFac[m] * A(m-1,m-1)
+	std::vector<double> offFac;     // off-diagonal terms: A(m+1,m) = offFac[m] * u * A(m,m)
+	std::vector<double> alphaFac;   // column terms: A(n,m) = alphaFac[NM(n,m)] * u * A(n-1,m)
+	std::vector<double> betaFac;    //                        - betaFac[NM(n,m)] * A(n-2,m)
+	std::vector<double> sumFac;     // sqrt(SM*(n-m)*(n+m+1)) for the acceleration sums
 };
 
 #endif
\ No newline at end of file
@@ -15,6 +15,7 @@
 #include "Element.h"
 #include "Planet.h"
 #include "elevmgr.h"
+#include "AtmTable.h"
 #include "Base.h"
 #include "Camera.h"
 #include "Log.h"
@@ -178,6 +179,8 @@ Planet::Planet (double _mass, double _mean_radius)
 	minelev      = 0.0;
 	maxelev = 0.0;
 	AtmInterface = 0;
+	atmtable     = NULL;
+	atmtable_nepoch = 96.0;
 	atm_attenuationalt = 0.0;
 	bHasCloudlayer = false;
 	bBrightClouds  = false;
@@ -215,8 +218,11 @@ Planet::Planet (char *fname)
 	maxelev = 0.0;
 	labelLegend  = NULL;
 	nLabelLegend = 0;
+	atmtable     = NULL;
+	atmtable_nepoch = 96.0;
 	ifstream ifs (g_pOrbiter->ConfigPath (fname));
 	if (!ifs) return;
+	IndexItems (ifs);
 
 	AtmInterface = 0;
 	memset (&atm, 0, sizeof(ATMCONST));
@@ -277,6 +283,20 @@ Planet::Planet (char *fname)
 		}
 		if (!GetItemVector (ifs, "AtmTintColor", tintcol))
 			tintcol.Set (fog.col.x*0.2, fog.col.y*0.2, fog.col.z*0.2);
+
+		// optional table of the atmosphere module parameters
+		if (AtmInterface == 4 && GetItemReal (ifs, "AtmTableTolerance", d) && d > 0.0) {
+			double refresh = 900.0;
+			GetItemReal (ifs, "AtmTableRefresh", refresh);
+			atmtable_nepoch = max (1.0, floor (86400.0/max (refresh, 1.0) + 0.5));
+			atmtable = new AtmTable ([this](double alt, double lat, double lst, AtmTable::Prm &prm) {
+				ATMPARAM ap;
+				GetAtmParamExact (alt, normangle (SubsolarLongitude() + (lst-12.0)*Pi/12.0), lat, &ap);
+				prm.T = ap.T, prm.p = ap.p, prm.rho = ap.rho;
+			}, -1e3, atm.altlimit, d); TRACENEW
+			LOGOUT("ATMOSPHERE: Tabulated parameters enabled for %s, tolerance %0.1e, refresh interval %0.0f s",
+				name, d, 86400.0/atmtable_nepoch);
+		}
 	}
 
 	GetItemReal (ifs, "HorizonExcess", horizon_excess);
@@ -456,6 +476,11 @@ Planet::~Planet ()
 	g_pOrbiter->UpdateDeallocationProgress();
 
 	delete emgr;
+	if (atmtable) {
+		LOGOUT_FINE("Atmosphere table [%s]: %d altitude nodes, %d slice builds, %d lookups beyond tolerance", name,
+			(int)atmtable->nAltNodes(), (int)atmtable->nBuilt(), (int)atmtable->nRejected());
+		delete atmtable;
+	}
 }
 
 void Planet::ScanBases (char *path)
@@ -781,6 +806,13 @@ void Planet::Update (bool force)
 
 	CelestialBody::Update (force);
 
+	// Move the atmosphere table to the current epoch, and rebuild
+	// a few of the slices in use if it has changed
+	if (atmtable) {
+		atmtable->SetEpoch ((int64_t)floor (td.MJD1*atmtable_nepoch));
+		atmtable->Refresh (2);
+	}
+
 	// Update bases
 	for (DWORD i = 0; i < nbase; i++)
 		baselist[i]->Update (force);
@@ -833,6 +865,21 @@ const Base *Planet::GetBase (const char *_name, bool ignorecase) const
 }
 
 bool Planet::GetAtmParam (double alt, double lng, double lat, ATMPARAM *prm) const
+{
+	if (atmtable && alt <= atm.altlimit) {
+		AtmTable::Prm p;
+		double lst = posangle (lng - SubsolarLongitude()) * 12.0/Pi + 12.0;
+		if (atmtable->Eval (alt, lat, lst, p)) {
+			prm->T = p.T;
+			prm->p = p.p;
+			prm->rho = p.rho;
+			return true;
+		}
+	}
+	return GetAtmParamExact (alt, lng, lat, prm);
+}
+
+bool Planet::GetAtmParamExact (double alt, double lng, double lat, ATMPARAM *prm) const
 {
 	if (!AtmInterface || alt > atm.altlimit) {
 		prm->T = prm->p = prm->rho = 0.0;
@@ -883,6 +930,12 @@ do_test=false;
 	}
 }
 
+double Planet::SubsolarLongitude () const
+{
+	Vector sdir = (s1 ? tmul (s1->R, -s1->pos) : tmul (s0->R, -s0->pos));
+	return atan2 (sdir.z, sdir.x);
+}
+
 double Planet::Elevation (double lng, double lat) const
 {
 	return (emgr ? emgr->Elevation(lat,lng) : 0.0);
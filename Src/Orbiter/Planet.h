@@ -35,6 +35,7 @@ class TileManager;
 class SurfTile;
 class CloudTile;
 class ElevationManager;
+class AtmTable;
 
 struct _finddata_t;
 
@@ -134,7 +135,16 @@ public:
 
 	bool GetAtmParam (double alt, double lng, double lat, ATMPARAM *prm) const;
 	// returns atmospheric parameters as a function of altitude from mean radius and
-	// geographic position
+	// geographic position. Uses the tabulated parameters if enabled.
+
+	bool GetAtmParamExact (double alt, double lng, double lat, ATMPARAM *prm) const;
+	// as GetAtmParam, but always evaluates the atmosphere model
+
+	inline const AtmTable *AtmParamTable () const { return atmtable; }
+	// tabulated atmospheric parameters, or NULL if disabled
+
+	double SubsolarLongitude () const;
+	// longitude of the subsolar point [rad] (sun assumed at the origin)
 
 	inline double AtmSoundSpeed (double T) const
 	{ return (AtmInterface ? sqrt (atm.gamma * atm.R * T) : 0.0); }
@@ -230,6 +240,8 @@ protected:
 	                         // 3: use CELBODY::clbkAtmParam interface
 	                         // 4: use CELBODY2::clbkAtmParam interface
 	ATMCONST atm;            // atmospheric parameters	
+	AtmTable *atmtable;      // tabulated atmospheric parameters (AtmInterface 4), or NULL for exact evaluation
+	double atmtable_nepoch;  // number of table refresh epochs per day
 	double atm_attenuationalt; // altitude limit for calculation of light attenuation on vessels (should be moved into ATMCONST!)
 
 	bool bHasCloudlayer;     // planet has separate cloud layer
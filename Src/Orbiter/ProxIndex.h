@@ -0,0 +1,148 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// Spatial index for proximity queries between objects (vessels)
+
+#ifndef __PROXINDEX_H
+#define __PROXINDEX_H
+
+#include "Vecmat.h"
+#include <vector>
+#include <algorithm>
+
+// =======================================================================
+// class ProximityIndex
+// A balanced 3-d tree over the global positions of a set of objects,
+// rebuilt once per frame. Supports nearest-neighbour and within-radius
+// queries in O(log n) instead of a linear scan over all objects.
+// Object type T must provide GPos() and Size().
+
+template<class T> class ProximityIndex {
+public:
+	ProximityIndex (): maxsize(0.0) {}
+
+	void Build (const std::vector<T*> &objs);
+	// Rebuild the index from the current global positions of objs
+
+	void Clear () { item.clear(); maxsize = 0.0; }
+
+	inline size_t Size () const { return item.size(); }
+
+	inline double MaxSize () const { return maxsize; }
+	// largest object radius (T::Size) in the index
+
+	T *Nearest (const Vector &pos, const T *exclude = 0, double *dist2 = 0) const;
+	// Return the indexed object closest to pos, omitting 'exclude'.
+	// Returns 0 if the index contains no eligible object.
+	// If dist2 != 0, it receives the square of the distance.
+
+	void Within (const Vector &pos, double radius, std::vector<T*> &list, const T *exclude = 0) const;
+	// Append all indexed objects within 'radius' of pos to list, omitting 'exclude'.
+
+private:
+	struct Item {
+		Vector pos;  // object position at time of Build
+		T *obj;
+		int axis;    // split axis of the subtree rooted at this item
+	};
+	std::vector<Item> item; // implicit tree: median of [lo,hi) is the node
+
+	double maxsize;
+
+	void BuildRange (size_t lo, size_t hi);
+	void NearestRange (size_t lo, size_t hi, const Vector &pos, const T *exclude, T *&best, double &bestd2) const;
+	void WithinRange (size_t lo, size_t hi, const Vector &pos, double r2, std::vector<T*> &list, const T *exclude) const;
+
+	static inline double Dist2 (const Vector &a, const Vector &b)
+	{ double dx = a.x-b.x, dy = a.y-b.y, dz = a.z-b.z; return dx*dx + dy*dy + dz*dz; }
+};
+
+// =======================================================================
+
+template<class T> void ProximityIndex<T>::Build (const std::vector<T*> &objs)
+{
+	item.resize (objs.size());
+	maxsize = 0.0;
+	for (size_t i = 0; i < objs.size(); i++) {
+		item[i].pos = objs[i]->GPos();
+		item[i].obj = objs[i];
+		item[i].axis = 0;
+		maxsize = std::max (maxsize, objs[i]->Size());
+	}
+	BuildRange (0, item.size());
+}
+
+template<class T> void ProximityIndex<T>::BuildRange (size_t lo, size_t hi)
+{
+	if (hi - lo < 2) return;
+
+	// split along the axis of largest extent
+	Vector pmin(item[lo].pos), pmax(item[lo].pos);
+	for (size_t i = lo+1; i < hi; i++) {
+		for (int j = 0; j < 3; j++) {
+			double p = item[i].pos(j);
+			if      (p < pmin(j)) pmin(j) = p;
+			else if (p > pmax(j)) pmax(j) = p;
+		}
+	}
+	Vector ext(pmax - pmin);
+	int axis = (ext.x >= ext.y ? (ext.x >= ext.z ? 0 : 2) : (ext.y >= ext.z ? 1 : 2));
+
+	size_t m = (lo+hi)/2;
+	std::nth_element (item.begin()+lo, item.begin()+m, item.begin()+hi,
+		[axis](const Item &a, const Item &b) { return a.pos(axis) < b.pos(axis); });
+	item[m].axis = axis;
+	BuildRange (lo, m);
+	BuildRange (m+1, hi);
+}
+
+template<class T> T *ProximityIndex<T>::Nearest (const Vector &pos, const T *exclude, double *dist2) const
+{
+	T *best = 0;
+	double bestd2 = 1e100;
+	NearestRange (0, item.size(), pos, exclude, best, bestd2);
+	if (dist2) *dist2 = bestd2;
+	return best;
+}
+
+template<class T> void ProximityIndex<T>::NearestRange (size_t lo, size_t hi, const Vector &pos, const T *exclude, T *&best, double &bestd2) const
+{
+	if (lo >= hi) return;
+	size_t m = (lo+hi)/2;
+	const Item &node = item[m];
+	if (node.obj != exclude) {
+		double d2 = Dist2 (pos, node.pos);
+		if (d2 < bestd2) bestd2 = d2, best = node.obj;
+	}
+	if (hi - lo == 1) return;
+
+	double d = pos(node.axis) - node.pos(node.axis);
+	if (d < 0.0) {
+		NearestRange (lo, m, pos, exclude, best, bestd2);
+		if (d*d < bestd2) NearestRange (m+1, hi, pos, exclude, best, bestd2);
+	} else {
+		NearestRange (m+1, hi, pos, exclude, best, bestd2);
+		if (d*d < bestd2) NearestRange (lo, m, pos, exclude, best, bestd2);
+	}
+}
+
+template<class T> void ProximityIndex<T>::Within (const Vector &pos, double radius, std::vector<T*> &list, const T *exclude) const
+{
+	WithinRange (0, item.size(), pos, radius*radius, list, exclude);
+}
+
+template<class T> void ProximityIndex<T>::WithinRange (size_t lo, size_t hi, const Vector &pos, double r2, std::vector<T*> &list, const T *exclude) const
+{
+	if (lo >= hi) return;
+	size_t m = (lo+hi)/2;
+	const Item &node = item[m];
+	if (node.obj != exclude && Dist2 (pos, node.pos) <= r2)
+		list.push_back (node.obj);
+	if (hi - lo == 1) return;
+
+	double d = pos(node.axis) - node.pos(node.axis);
+	if (d <= 0.0 || d*d <= r2) WithinRange (lo, m, pos, r2, list, exclude);
+	if (d >= 0.0 || d*d <= r2) WithinRange (m+1, hi, pos, r2, list, exclude);
+}
+
+#endif // !__PROXINDEX_H
@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <algorithm>
+#include <thread>
 
 #include "Config.h"
 #include "Psys.h"
@@ -14,6 +15,7 @@
 #include "Element.h"
 #include "Vessel.h"
 #include "SuperVessel.h"
+#include "WorkerPool.h"
 #include "Log.h"
 
 using namespace std;
@@ -24,12 +26,21 @@ extern char DBG_MSG[256];
 
 PlanetarySystem::PlanetarySystem (char *fname, const Config* config, OutputLoadStatusCallback outputLoadStatus, void* callbackContext)
 {
+	vesselindex_dirty = true;
+	ngsrc = ngsrcslot = 0;
+	gravsimd = GravSimdSupported();
+	LOGOUT("Gravity kernel: %s", GravSimdName (gravsimd)); // results differ in the last bits between kernels
+	int nthread = config->CfgPhysicsPrm.nUpdateThreads;
+	if (config->CfgCmdlinePrm.UpdateThreads >= 0)
+		nthread = config->CfgCmdlinePrm.UpdateThreads;
+	workerpool = (nthread > 0 ? new WorkerPool (nthread) : 0);
 	Read (fname, config, outputLoadStatus, callbackContext);
 }
 
 PlanetarySystem::~PlanetarySystem ()
 {
 	Clear ();
+	if (workerpool) delete workerpool;
 }
 
 void PlanetarySystem::Clear ()
@@ -62,6 +73,9 @@ void PlanetarySystem::Clear ()
 		delete supervessels[i];
 	}
 	supervessels.clear();
+
+	vesselindex.Clear();
+	vesselindex_dirty = true;
 }
 
 void PlanetarySystem::InitState (const char *fname)
@@ -125,6 +139,15 @@ Vessel *PlanetarySystem::GetVessel (const char *name, bool ignorecase) const
 	return 0;
 }
 
+const ProximityIndex<Vessel> &PlanetarySystem::VesselIndex ()
+{
+	if (vesselindex_dirty) {
+		vesselindex.Build (vessels);
+		vesselindex_dirty = false;
+	}
+	return vesselindex;
+}
+
 bool PlanetarySystem::isObject (const Body *obj) const
 {
 	for (DWORD i = 0; i < bodies.size(); i++)
@@ -393,6 +416,7 @@ size_t PlanetarySystem::AddVessel (Vessel *_vessel)
 {
 	vessels.emplace_back(_vessel);
 	AddBody (_vessel); // register in general list
+	vesselindex_dirty = true;
 	g_bForceUpdate = true;
 	return vessels.size();
 }
@@ -411,6 +435,7 @@ bool PlanetarySystem::DelVessel (Vessel *_vessel)
 	DelBody (_vessel); //DelBody takes care of freeing the vessel
 	std::iter_swap(vessels.begin() + i, vessels.end() - 1);
 	vessels.pop_back();
+	vesselindex_dirty = true;
 
 	g_bForceUpdate = true;
 	return true;
@@ -576,17 +601,25 @@ Vector PlanetarySystem::GaccAt (double t, const Vector &gpos, const Body *exclud
 }
 
 Vector SingleGacc_perturbation (const Vector &rpos, const CelestialBody *body)
+{
+	return SingleGacc_perturbation (rpos, body, body->GRot());
+}
+
+Vector SingleGacc_perturbation (const Vector &rpos, const CelestialBody *body, const Matrix &rot)
 {
 	// Calculate perturbation of gravitational acceleration due to nonspherical
 	// shape of the body.
 	// rpos: relative position of 'bodies' wrt. r (global frame)
+	// rot: body orientation (allows evaluation for a body rotation other than
+	//   the current one, e.g. for trajectory prediction)
+	// Only reads body parameters that are constant during the simulation, so
+	// it can be called from a worker thread.
 
 	Vector dg;
 
 	if (body->UseComplexGravity() && body->usePines()) {
 		
 		//Rotate position vector into the planet's local frame
-		Matrix rot = body->GRot();
 		Vector lpos = -tmul(rot,rpos)/1000.0;
 
 		//Convert to right-handed
@@ -597,11 +630,7 @@ Vector SingleGacc_perturbation (const Vector &rpos, const CelestialBody *body)
 
 		unsigned int maxDegreeOrder = body->GetPinesCutoff();
 		//get aceleration vector from spherical harmonics
-		{
-			//Limit scope of the const cast. the internal state of body.PinesGravProp does need to change when this finction is called.
-			CelestialBody* unconstbody = const_cast<CelestialBody*>(body);
-			dg = unconstbody->pinesAccel(lpos, maxDegreeOrder, maxDegreeOrder);
-		}
+		dg = body->pinesAccel(lpos, maxDegreeOrder, maxDegreeOrder);
 
 		//Convert back to Orbiter's lefthandedness
 		temp_y = dg.y;
@@ -628,7 +657,7 @@ Vector SingleGacc_perturbation (const Vector &rpos, const CelestialBody *body)
 		double Jn_Rrn = body->Jcoeff(0) * Rrn;  // relative influence of J2 term
 		if (fabs (Jn_Rrn) > eps) {
 			Vector er (rpos.unit());  // radial unit vector
-			Vector loc (tmul (body->GRot(), er));
+			Vector loc (tmul (rot, er));
 			double lat = asin(-loc.y), slat = sin(lat), clat = cos(lat); // latitude
 			gacc_r += 1.5 * Jn_Rrn * (1.0 - 3.0*slat*slat);
 			gacc_p += 3.0 * Jn_Rrn * clat*slat;
@@ -655,7 +684,7 @@ Vector SingleGacc_perturbation (const Vector &rpos, const CelestialBody *body)
 			double GM = Ggrav * body->Mass();
 			double T0 = GM / (d*d);
 
-			Vector ep, ea (crossp (er, body->RotAxis())); // azimuth vector
+			Vector ep, ea (crossp (er, Vector (rot.m12, rot.m22, rot.m32))); // azimuth vector
 			double lea = ea.length();
 			if (lea > eps) ep.Set (crossp (er, ea/lea));  // polar unit vector
 			else ep.Set (0,0,0);
@@ -679,7 +708,11 @@ Vector PlanetarySystem::Gacc (const Vector &gpos, const Body *exclude, const GFi
 	Vector acc;
 	DWORD i, j;
 
-	if (gfd) {
+	const GravSources *src;
+
+	if (gfd && (src = GravSourcesAt (0.0, gfd))) {
+		acc = GaccSources (*src, gpos, gfd, exclude);
+	} else if (gfd) {
 		for (j = 0; j < gfd->ngrav; j++) {
 			i = gfd->gravidx[j];
 			if (exclude == celestials[i]) continue;
@@ -698,8 +731,11 @@ Vector PlanetarySystem::Gacc_intermediate (const Vector &gpos, double n, const B
 {
 	Vector acc;
 	DWORD i, j;
+	const GravSources *src;
 	
-	if (gfd) { // use body's source list
+	if (gfd && (src = GravSourcesAt (n, gfd))) { // packed kernel
+		acc = GaccSources (*src, gpos, gfd, exclude);
+	} else if (gfd) { // use body's source list
 		for (j = 0; j < gfd->ngrav; j++) {
 			i = gfd->gravidx[j];
 			if (exclude == celestials[i]) continue;
@@ -719,8 +755,13 @@ Vector PlanetarySystem::Gacc_intermediate_pert (const CelestialBody *cbody, cons
 	Vector acc;
 	DWORD i, j;
 	Vector gpos = relpos + cbody->InterpolatePosition (n);
+	const GravSources *src;
 
-	if (gfd) { // use body's source list
+	if (gfd && (src = GravSourcesAt (n, gfd))) { // packed kernel
+		bool incl;
+		acc = GaccSources (*src, gpos, gfd, exclude, cbody, &incl);
+		if (incl) acc += SingleGacc_perturbation (-relpos, cbody);
+	} else if (gfd) { // use body's source list
 		for (j = 0; j < gfd->ngrav; j++) {
 			i = gfd->gravidx[j];
 			if (exclude == celestials[i]) continue;
@@ -747,8 +788,11 @@ Vector PlanetarySystem::GaccRel (const Vector &rpos, const CelestialBody *cbody,
 	DWORD i, j;
 
 	Vector gpos (rpos + cbody->InterpolatePosition (n));
+	const GravSources *src;
 
-	if (gfd) { // use bodies's source list
+	if (gfd && (src = GravSourcesAt (n, gfd))) { // packed kernel
+		acc = GaccSources (*src, gpos, gfd, exclude);
+	} else if (gfd) { // use bodies's source list
 		for (j = 0; j < gfd->ngrav; j++) {
 			i = gfd->gravidx[j];
 			if (exclude == celestials[i]) continue;
@@ -763,6 +807,101 @@ Vector PlanetarySystem::GaccRel (const Vector &rpos, const CelestialBody *cbody,
 	return acc;
 }
 
+void PlanetarySystem::BuildGravSources ()
+{
+	// Only the sources listed by the free-flight vessels are packed. Their
+	// lists don't change during propagation, and callers with other sources
+	// are refused by GravSourcesAt.
+	size_t k, nc = celestials.size();
+	gsrcin.assign (nc, 0);
+	gsrcpert.resize (nc);
+	gsrcidx.clear();
+	for (auto v : freeflyers) {
+		const GFieldData &gfd = v->GetGFieldData();
+		for (DWORD j = 0; j < gfd.ngrav; j++) {
+			DWORD i = gfd.gravidx[j];
+			if (gsrcin[i]) continue;
+			const CelestialBody *body = celestials[i];
+			gsrcin[i] = 1;
+			gsrcpert[i] = (body->UseComplexGravity() && (body->usePines() || body->nJcoeff() > 0));
+			gsrcidx.push_back (i);
+		}
+	}
+	if (!gsrcidx.size()) {
+		ngsrc = 0;
+		return;
+	}
+	ngsrc = 2 + stagefrac.size();
+	if (ngsrcslot < ngsrc) {
+		gsrc.reset (new GravSourceSlot[ngsrc]);
+		ngsrcslot = ngsrc;
+	}
+	for (k = 0; k < ngsrc; k++) {
+		if (gsrc[k].src.n != (int)nc) gsrc[k].src.Resize ((int)nc);
+		gsrc[k].state.store (GSRC_EMPTY, std::memory_order_relaxed);
+	}
+}
+
+const GravSources *PlanetarySystem::GravSourcesAt (double n, const GFieldData *gfd) const
+{
+	if (!ngsrc) return 0;
+	for (DWORD j = 0; j < gfd->ngrav; j++)
+		if (!gsrcin[gfd->gravidx[j]]) return 0;
+
+	size_t k;
+	if (n == 0.0) k = 0;
+	else if (n == 1.0) k = 1;
+	else {
+		auto it = std::lower_bound (stagefrac.begin(), stagefrac.end(), n);
+		if (it == stagefrac.end() || *it != n) return 0;
+		k = 2 + (it - stagefrac.begin());
+	}
+
+	// The first caller fills the table. Others wait for it rather than
+	// summing directly, so that the result doesn't depend on the timing.
+	GravSourceSlot &slot = gsrc[k];
+	int state = slot.state.load (std::memory_order_acquire);
+	if (state == GSRC_VALID) return &slot.src;
+	if (state == GSRC_EMPTY && slot.state.compare_exchange_strong (state, GSRC_BUSY, std::memory_order_acquire)) {
+		for (DWORD i : gsrcidx) {
+			const CelestialBody *body = celestials[i];
+			Vector p (k == 0 ? body->s0->pos : k == 1 ? body->s1->pos : body->InterpolatePosition (n));
+			slot.src.Set ((int)i, p.x, p.y, p.z, Ggrav * body->Mass());
+		}
+		slot.state.store (GSRC_VALID, std::memory_order_release);
+	} else {
+		while (slot.state.load (std::memory_order_acquire) != GSRC_VALID)
+			std::this_thread::yield();
+	}
+	return &slot.src;
+}
+
+Vector PlanetarySystem::GaccSources (const GravSources &src, const Vector &gpos, const GFieldData *gfd,
+	const Body *exclude, const CelestialBody *skip, bool *skipped) const
+{
+	// The point-mass terms of all sources are summed by the packed kernel,
+	// nonspherical perturbations are added for the flagged sources only
+	int idx[MAXGFIELDLIST], nidx = 0;
+	double p[3] = {gpos.x, gpos.y, gpos.z}, a[3];
+	Vector acc;
+
+	if (skipped) *skipped = false;
+	for (DWORD j = 0; j < gfd->ngrav; j++) {
+		DWORD i = gfd->gravidx[j];
+		const CelestialBody *body = celestials[i];
+		if (body == exclude) continue;
+		if (body == skip) {
+			if (skipped) *skipped = true;
+			continue;
+		}
+		idx[nidx++] = (int)i;
+		if (gsrcpert[i])
+			acc += SingleGacc_perturbation (Vector (src.x[i], src.y[i], src.z[i]) - gpos, body);
+	}
+	GravAcc (src, p, idx, nidx, a, gravsimd);
+	return acc + Vector (a[0], a[1], a[2]);
+}
+
 Vector PlanetarySystem::GaccPn_perturbation (const Vector &gpos, double n, const CelestialBody *cbody) const
 {
 	return SingleGacc_perturbation (cbody->InterpolatePosition (n) - gpos, cbody);
@@ -821,13 +960,54 @@ void PlanetarySystem::Update (bool force)
 	for (i = 0; i < celestials  .size(); i++) celestials  [i]->Update (force);
 	for (i = 0; i < vessels     .size(); i++) vessels     [i]->UpdateBodyForces ();
 	for (i = 0; i < supervessels.size(); i++) supervessels[i]->Update (force);
-	for (i = 0; i < vessels     .size(); i++) vessels     [i]->Update (force);
+	UpdateVessels (force);
+}
+
+void PlanetarySystem::UpdateVessels (bool force)
+{
+	// Free-flight vessels clear of any surface only depend on their own state
+	// and the (already updated) celestial bodies, so their propagation can be
+	// distributed over worker threads. The preparation step and the remaining
+	// vessel updates run serially in a fixed order, so results don't depend
+	// on the number of threads.
+	DWORD i;
+	freeflyers.clear();
+	for (i = 0; i < vessels.size(); i++)
+		if (vessels[i]->BeginFreeflightUpdate (force))
+			freeflyers.push_back (vessels[i]);
+
+	// The propagators of all vessels sample the celestial bodies at a few
+	// common stage times, so interpolate their states only once per step
+	stagefrac.clear();
+	for (auto v : freeflyers) v->StageFractions (stagefrac);
+	std::sort (stagefrac.begin(), stagefrac.end());
+	stagefrac.erase (std::unique (stagefrac.begin(), stagefrac.end()), stagefrac.end());
+	stagefrac.erase (std::remove_if (stagefrac.begin(), stagefrac.end(),
+		[](double n) { return n == 0.0 || n == 1.0; }), stagefrac.end()); // not interpolated
+	if (stagefrac.size())
+		for (i = 0; i < celestials.size(); i++) celestials[i]->SetStageCache (&stagefrac);
+	BuildGravSources();
+
+	if (workerpool && freeflyers.size() > 1) {
+		workerpool->ParallelFor (freeflyers.size(), [this](size_t j) { freeflyers[j]->FreeflightUpdate(); });
+	} else {
+		for (auto v : freeflyers) v->FreeflightUpdate();
+	}
+
+	for (i = 0; i < vessels.size(); i++) vessels[i]->Update (force);
 }
 
 void PlanetarySystem::FinaliseUpdate ()
 {
 	DWORD i;
+	ngsrc = 0;
+	if (stagefrac.size()) {
+		for (i = 0; i < celestials.size(); i++) celestials[i]->SetStageCache (0);
+		stagefrac.clear();
+	}
 	for (i = 0; i < bodies.size(); i++) bodies[i]->EndStateUpdate ();
+	vesselindex.Build (vessels); // vessel positions are final for this frame
+	vesselindex_dirty = false;
 	for (i = 0; i < supervessels.size(); i++) supervessels[i]->PostUpdate ();
 	for (i = 0; i < vessels.size(); i++) vessels[i]->PostUpdate ();
 }
@@ -843,6 +1023,7 @@ void PlanetarySystem::Timejump (const TimeJumpData& jump)
 
 	for (i = 0; i < vessels.size(); i++)
 		vessels[i]->Timejump(jump.dt, jump.mode);
+	vesselindex_dirty = true;
 }
 
 void PlanetarySystem::InitDeviceObjects ()
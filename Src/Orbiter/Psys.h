@@ -9,14 +9,20 @@
 #include "Base.h"
 #include "Star.h"
 #include "Planet.h"
+#include "ProxIndex.h"
+#include "GravKernel.h"
+#include <atomic>
 #include <functional>
+#include <memory>
 
 class Vessel;
 class SuperVessel;
+class WorkerPool;
 struct TimeJumpData;
 
 Vector SingleGacc (const Vector &rpos, const CelestialBody *body);
 Vector SingleGacc_perturbation (const Vector &rpos, const CelestialBody *body);
+Vector SingleGacc_perturbation (const Vector &rpos, const CelestialBody *body, const Matrix &rot);
 
 class PlanetarySystem {
 	friend class Body;
@@ -67,6 +73,14 @@ public:
 	inline std::vector<Vessel *> &GetVessels() { return vessels; }
 	// Return pointer to vessel by name or index, or 0 if not present
 
+	const ProximityIndex<Vessel> &VesselIndex ();
+	// Spatial index of vessel positions for proximity queries.
+	// Rebuilt once per frame, and on demand after the vessel list has changed
+	// or a vessel has been relocated
+
+	inline void InvalidateVesselIndex () { vesselindex_dirty = true; }
+	// Request a rebuild of the vessel index before the next query
+
 	bool isObject (const Body *obj) const;
 	// returns true if obj is a registered object
 
@@ -226,6 +240,60 @@ private:
 	std::vector<SuperVessel*> supervessels;
 	// List of spacecraft groups (composite vessels)
 
+	ProximityIndex<Vessel> vesselindex;
+	bool vesselindex_dirty;
+	// Spatial index of vessel positions, and flag for pending rebuild
+
+	WorkerPool *workerpool;
+	std::vector<Vessel*> freeflyers;
+	// Worker threads for vessel propagation (0 if disabled), and list
+	// of vessels propagated concurrently in the current step
+
+	std::vector<double> stagefrac;
+	// Fractional step times at which the celestial body states are cached
+	// for the vessel propagators in the current step
+
+	enum { GSRC_EMPTY, GSRC_BUSY, GSRC_VALID };
+	struct GravSourceSlot {
+		GravSources src;         // positions and GM values, indexed like celestials
+		std::atomic<int> state;  // GSRC_xxx; src is valid once GSRC_VALID
+	};
+	std::unique_ptr<GravSourceSlot[]> gsrc;
+	size_t ngsrc, ngsrcslot;
+	// Source tables for the packed gravity kernel at the start (gsrc[0]) and
+	// end (gsrc[1]) of the current step and at the stage times stagefrac
+	// (gsrc[2+k]), each filled on its first request. ngsrc is the number of
+	// tables in use, or 0 outside the vessel update phase, ngsrcslot the
+	// allocated length of gsrc.
+
+	std::vector<DWORD> gsrcidx;
+	std::vector<char> gsrcin, gsrcpert;
+	// Celestial bodies in the source lists of the free-flight vessels, which
+	// are the only entries filled in the tables, their flags by celestial
+	// index, and flags for those with a nonspherical gravity field
+
+	GravSimdLevel gravsimd;
+	// Instruction set of the gravity kernel
+
+	void BuildGravSources ();
+	// Prepare the gravity source tables for the current step
+
+	const GravSources *GravSourcesAt (double n, const GFieldData *gfd) const;
+	// Gravity source table for fractional step time n, filled on first
+	// request, or NULL if n is not tabulated or a source in gfd's list
+	// is not packed
+
+	Vector GaccSources (const GravSources &src, const Vector &gpos, const GFieldData *gfd,
+		const Body *exclude, const CelestialBody *skip = 0, bool *skipped = 0) const;
+	// Acceleration at gpos from the sources in gfd (except exclude), using the
+	// positions in src. The point mass and perturbation of body 'skip' are not
+	// included; skipped returns whether it was in the list.
+
+	void UpdateVessels (bool force);
+	// Vessel state updates for the current time step. Free-flight vessels
+	// away from planetary surfaces are propagated concurrently if enabled
+	// in the physics configuration.
+
 	std::vector< oapi::GraphicsClient::LABELLIST> m_labelList; ///< list of celestial markers
 	//oapi::GraphicsClient::LABELLIST *labellist;
 	//int nlabellist;
@@ -0,0 +1,122 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// Registry of shared, reference-counted objects identified by name
+
+#ifndef __REFREGISTRY_H
+#define __REFREGISTRY_H
+
+#include <ctype.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// =======================================================================
+// class RefRegistry
+// Owns a set of objects of type T, each identified by a case-insensitive
+// name. Lookups are hashed. Every successful Acquire or Insert adds a
+// reference which is returned with Release. Objects whose reference count
+// has dropped to zero remain available for re-use until Evict is called.
+
+template<class T> class RefRegistry {
+public:
+	T *Acquire (const char *name);
+	// Return the object registered under name and add a reference to it,
+	// or return 0 if no such object exists.
+
+	T *Insert (const char *name, T *obj);
+	// Register obj under name with a reference count of 1. The registry
+	// takes ownership of obj. name must not be registered yet.
+
+	bool Release (const T *obj);
+	// Return a reference to obj. Returns false if obj is not registered or
+	// has no outstanding references.
+
+	int RefCount (const T *obj) const;
+	// Current reference count of obj, or -1 if obj is not registered
+
+	size_t Evict ();
+	// Destroy all objects without outstanding references. Returns the
+	// number of objects destroyed.
+
+	void Clear () { entry.clear(); index.clear(); }
+	// Destroy all objects, regardless of their reference count
+
+	inline size_t Size () const { return entry.size(); }
+
+private:
+	struct Entry {
+		std::unique_ptr<T> obj;
+		int nref;
+	};
+
+	static std::string Key (const char *name);
+
+	std::unordered_map<std::string, Entry> entry;  // objects by lower-case name
+	std::unordered_map<const T*, std::string> index; // reverse lookup for Release
+};
+
+// =======================================================================
+
+template<class T>
+std::string RefRegistry<T>::Key (const char *name)
+{
+	std::string key (name);
+	for (auto &c : key) c = (char)tolower ((unsigned char)c);
+	return key;
+}
+
+template<class T>
+T *RefRegistry<T>::Acquire (const char *name)
+{
+	auto it = entry.find (Key (name));
+	if (it == entry.end()) return 0;
+	it->second.nref++;
+	return it->second.obj.get();
+}
+
+template<class T>
+T *RefRegistry<T>::Insert (const char *name, T *obj)
+{
+	std::string key = Key (name);
+	Entry &e = entry[key];
+	e.obj.reset (obj);
+	e.nref = 1;
+	index[obj] = key;
+	return obj;
+}
+
+template<class T>
+bool RefRegistry<T>::Release (const T *obj)
+{
+	auto it = index.find (obj);
+	if (it == index.end()) return false;
+	Entry &e = entry[it->second];
+	if (!e.nref) return false;
+	e.nref--;
+	return true;
+}
+
+template<class T>
+int RefRegistry<T>::RefCount (const T *obj) const
+{
+	auto it = index.find (obj);
+	if (it == index.end()) return -1;
+	return entry.find (it->second)->second.nref;
+}
+
+template<class T>
+size_t RefRegistry<T>::Evict ()
+{
+	size_t n = 0;
+	for (auto it = entry.begin(); it != entry.end();) {
+		if (!it->second.nref) {
+			index.erase (it->second.obj.get());
+			it = entry.erase (it);
+			n++;
+		} else it++;
+	}
+	return n;
+}
+
+#endif // !__REFREGISTRY_H
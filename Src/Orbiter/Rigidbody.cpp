@@ -69,6 +69,7 @@ RigidBody::RigidBody (char *fname): Body (fname)
 RigidBody::~RigidBody ()
 {
 	if (el) delete el;
+	if (railsEl) delete railsEl;
 }
 
 void RigidBody::GlobalSetup ()
@@ -92,6 +93,11 @@ void RigidBody::SetDefaultCaps ()
 	PropLevel = 0;
 	PropSubMax = g_pOrbiter->Cfg()->CfgPhysicsPrm.PropSubMax;
 	nPropSubsteps = 1;
+	propTol = 0.0;
+	hAdapt = 0.0;
+	bAdaptiveStep = false;
+	railsEl = 0;
+	bOnRails = bRailsExit = false;
 	gfielddata.ngrav = 0;
 	gfielddata.updt = -1e10; // invalidate
 }
@@ -100,6 +106,7 @@ void RigidBody::ReadGenericCaps (ifstream &ifs)
 {
 	GetItemVector (ifs, "Inertia", pmi);
 	GetItemReal (ifs, "GravityGradientDamping", tidaldamp);
+	GetItemReal (ifs, "PropTolerance", propTol);
 }
 
 void RigidBody::SetDefaultState ()
@@ -111,6 +118,7 @@ void RigidBody::SetDefaultState ()
 void RigidBody::SetOrbitReference (CelestialBody *body)
 {
 	if (body && body != cbody) { // otherwise nothing to do
+		EndRails();
 		cbody = body;
 		el->Setup (mass, cbody->Mass(), el->MJDepoch());
 		el_valid = false;
@@ -153,6 +161,7 @@ void RigidBody::SetupPropagationModes ()
 		case PROP_SY4:  PropMode[i].propagator = &RigidBody::SY4_LinAng;  break;
 		case PROP_SY6:  PropMode[i].propagator = &RigidBody::SY6_LinAng;  break;
 		case PROP_SY8:  PropMode[i].propagator = &RigidBody::SY8_LinAng;  break;
+		case PROP_RK45: PropMode[i].propagator = &RigidBody::RK45_LinAng; break;
 		default:        PropMode[i].propagator = &RigidBody::RK4_LinAng;  break;
 		}
 	}
@@ -179,20 +188,63 @@ void RigidBody::SetPropagator (int &plevel, int &nstep) const
 
 // =======================================================================
 
+bool RigidBody::UseAdaptivePropagator (int plevel) const
+{
+	return propTol > 0.0 || PropMode[plevel].propidx == PROP_RK45;
+}
+
+// =======================================================================
+
+void RigidBody::SetPropTolerance (double tol)
+{
+	propTol = max (0.0, tol);
+}
+
+// =======================================================================
+
+bool RigidBody::DenseState (double t, Vector &pos, Vector &vel) const
+{
+	if (!bAdaptiveStep || dense.empty() || t < dense.front().t0 || t > dense.back().t0 + dense.back().h)
+		return false;
+
+	// locate the substep containing t
+	size_t i0 = 0, i1 = dense.size()-1;
+	while (i0 < i1) {
+		size_t i = (i0+i1+1)/2;
+		if (dense[i].t0 <= t) i0 = i;
+		else i1 = i-1;
+	}
+	const DenseSeg &seg = dense[i0];
+	double s = (t - seg.t0) / seg.h, s1 = 1.0 - s;
+	pos = seg.rp[0] + (seg.rp[1] + (seg.rp[2] + (seg.rp[3] + seg.rp[4]*s1)*s)*s1)*s;
+	vel = seg.rv[0] + (seg.rv[1] + (seg.rv[2] + (seg.rv[3] + seg.rv[4]*s1)*s)*s1)*s;
+	return true;
+}
+
+// =======================================================================
+
 void RigidBody::Update (bool force)
 {
-	if (bDynamicPosVel) {
+	PrepareUpdate (force);
+	IntegrateUpdate (force);
+}
 
-		// Update velocity and position according to
-		// graviational field.
-		// Notes:
-		// 1. Dynamic updates are only allowed for toplevel
-		//    objects, i.e. no parent and rpos=gpos
-		// 2. We split rpos and rvel into a base and
-		//    incremental part to minimise roundoff errors
+// =======================================================================
 
-		int i;
-		Vector tau;
+void RigidBody::PrepareUpdate (bool force)
+{
+	if (bRailsExit) {
+		// the on-rails steps only kept track of the reference body's point mass
+		bRailsExit = false;
+		if (bDynamicPosVel) {
+			Vector tau;
+			ScanGFieldSources (g_psys);
+			gfielddata.updt = td.SimT0 + gfielddata_updt_interval;
+			GetIntermediateMoments (acc, tau, *s0, 0, td.SimDT);
+			arot.Set (EulerInv_full (tau, s0->omega));
+		}
+	}
+	if (bDynamicPosVel) {
 		pcpos.Set (cpos);
 		ostep = cvel.length()*td.SimDT / (Pi2 * cpos.length());
 
@@ -210,6 +262,25 @@ void RigidBody::Update (bool force)
 			UpdateGFieldSources (g_psys);
 			gfielddata.updt = td.SimT0 + gfielddata_updt_interval;
 		}
+	}
+}
+
+// =======================================================================
+
+void RigidBody::IntegrateUpdate (bool force)
+{
+	if (bDynamicPosVel) {
+
+		// Update velocity and position according to
+		// graviational field.
+		// Notes:
+		// 1. Dynamic updates are only allowed for toplevel
+		//    objects, i.e. no parent and rpos=gpos
+		// 2. We split rpos and rvel into a base and
+		//    incremental part to minimise roundoff errors
+
+		int i;
+		Vector tau;
 
 		// First check if we should do a stabilised state update
 		if (bCanUpdateStabilised &&
@@ -230,6 +301,7 @@ void RigidBody::Update (bool force)
 				el->Calculate (cpos, cvel, td.SimT0); // get elements from previous step
 			}
 			Encke();
+			bAdaptiveStep = false;
 			s1->pos.Set (cpos + cbody->s1->pos);
 			s1->vel.Set (cvel + cbody->s1->vel);
 			FlushRPos();
@@ -245,6 +317,12 @@ void RigidBody::Update (bool force)
 			do {
 				// Select propagator
 				SetPropagator (PropLevel, nPropSubsteps);
+				LinAngPropagator propagator = PropMode[PropLevel].propagator;
+				bAdaptiveStep = UseAdaptivePropagator (PropLevel);
+				if (bAdaptiveStep) {
+					propagator = &RigidBody::RK45_LinAng;
+					nPropSubsteps = 1; // substeps are chosen by the propagator
+				}
 				double dt = td.SimDT/nPropSubsteps;
 
 				// Perform step propagation with sub-steps
@@ -252,7 +330,7 @@ void RigidBody::Update (bool force)
 				acc = acc0, arot = arot0;
 				rpos_add = rpos_add0, rvel_add = rvel_add0;
 				for (i = 0; i < nPropSubsteps; i++) {
-					((*this).*(PropMode[PropLevel].propagator)) (dt, nPropSubsteps, i);
+					((*this).*propagator) (dt, nPropSubsteps, i);
 					s1->pos = rpos_base + rpos_add;
 					s1->vel = rvel_base + rvel_add;
 					s1->R.Set (s1->Q);
@@ -303,6 +381,97 @@ void RigidBody::Update (bool force)
 
 // =======================================================================
 
+void RigidBody::StageFractions (std::vector<double> &frac) const
+{
+	if (!bDynamicPosVel || bOnRails) return;
+
+	// stabilised steps sample the perturbations at variable times
+	if (bCanUpdateStabilised && ostep > g_pOrbiter->Cfg()->CfgPhysicsPrm.Stabilise_SLimit)
+		return;
+
+	int plevel, nsub;
+	SetPropagator (plevel, nsub);
+	if (UseAdaptivePropagator (plevel)) return; // step sizes are chosen on the fly
+	StageFractions_LinAng (PropMode[plevel].propidx, nsub, frac);
+}
+
+// =======================================================================
+// Rotate v by angle a around unit axis u (right-handed sense in the
+// physical frame, which is left-handed in global coordinates)
+
+static Vector RotateAround (const Vector &v, const Vector &u, double a)
+{
+	double cosa = cos(a), sina = sin(a);
+	return v*cosa + crossp (v, u)*sina + u*(dotp (u, v)*(1.0-cosa));
+}
+
+bool RigidBody::BeginRails ()
+{
+	if (!bDynamicPosVel || !cbody || !el) return false;
+
+	if (!railsEl) railsEl = new Elements;
+	railsEl->Setup (mass, cbody->Mass(), el->MJDepoch());
+	railsEl->Calculate (cpos, cvel, td.SimT0);
+	if (railsEl->e >= 1.0) return false;
+
+	railsT0 = td.SimT0;
+	railsH = railsEl->HVec().unit();
+	railsPole = cbody->RotAxis();
+	railsDArg = railsDNode = railsDTime = 0.0;
+	if (bGPerturb && cbody->nJcoeff()) {
+		// secular rates of the orbit orientation and mean anomaly due to J2
+		double e = railsEl->e;
+		double n = Pi2 / railsEl->OrbitT();
+		double R = cbody->Size() / railsEl->P();
+		double cosi = dotp (railsH, railsPole);
+		double k = 1.5 * n * cbody->Jcoeff(0) * R*R;
+		railsDNode = -k*cosi;
+		railsDArg = 0.5*k*(5.0*cosi*cosi - 1.0);
+		railsDTime = 0.5*k*sqrt(1.0-e*e)*(3.0*cosi*cosi - 1.0) / n;
+	}
+	bOnRails = true;
+	bRailsExit = false;
+	bOrbitStabilised = bAdaptiveStep = false;
+	nPropSubsteps = 1;
+	return true;
+}
+
+void RigidBody::EndRails ()
+{
+	if (bOnRails) {
+		bOnRails = false;
+		bRailsExit = true;
+	}
+}
+
+void RigidBody::RailsUpdate ()
+{
+	double dt = td.SimT1 - railsT0;
+
+	s1->Set (*s0);
+	railsEl->PosVel (cpos, cvel, td.SimT1 + railsDTime*dt);
+	if (railsDArg || railsDNode) {
+		double da = railsDArg*dt, dn = railsDNode*dt;
+		cpos = RotateAround (RotateAround (cpos, railsH, da), railsPole, dn);
+		cvel = RotateAround (RotateAround (cvel, railsH, da), railsPole, dn);
+	}
+	s1->pos.Set (cpos + cbody->s1->pos);
+	s1->vel.Set (cvel + cbody->s1->vel);
+	FlushRPos();
+	FlushRVel();
+	s1->Q.Rotate (s0->omega * td.SimDT);
+	s1->R.Set (s1->Q);
+
+	// point mass acceleration of the reference body; the full moments are
+	// recalculated when numerical integration resumes
+	double r = cpos.length();
+	acc.Set (cbody->Acceleration() - cpos * (Ggrav*cbody->Mass()/(r*r*r)));
+	arot.Set (0,0,0);
+	el_valid = false;
+}
+
+// =======================================================================
+
 void RigidBody::ScanGFieldSources (const PlanetarySystem *psys)
 {
 	psys->ScanGFieldSources (&s0->pos, this, &gfielddata);
@@ -525,12 +694,13 @@ void RigidBody::SetDynamicUpdate (bool dynamic)
 const char *RigidBody::PropagatorStr (DWORD idx, bool verbose) {
 	static const char *ShortPropModeStr[NPROP_METHOD] = {
 		"RK2", "RK4", "RK5", "RK6", "RK7", "RK8",
-		"SY2", "SY4", "SY6", "SY8"
+		"SY2", "SY4", "SY6", "SY8", "RK45"
 	};
 	static const char *LongPropModeStr[NPROP_METHOD] = {
 		"Runge-Kutta, 2nd order (RK2)", "Runge-Kutta, 4th order (RK4)", "Runge-Kutta, 5th order (RK5)", "Runge-Kutta, 6th order (RK6)",
 		"Runge-Kutta, 7th order (RK7)", "Runge-Kutta, 8th order (RK8)",
-		"Symplectic, 2nd order (SY2)", "Symplectic, 4th order (SY4)", "Symplectic, 6th order (SY6)", "Symplectic, 8th order (SY8)"
+		"Symplectic, 2nd order (SY2)", "Symplectic, 4th order (SY4)", "Symplectic, 6th order (SY6)", "Symplectic, 8th order (SY8)",
+		"Runge-Kutta, adaptive 5(4) (RK45)"
 	};
 	return (idx < NPROP_METHOD ? (verbose ? LongPropModeStr[idx] : ShortPropModeStr[idx]) : "unknown");
 }
@@ -538,7 +708,8 @@ const char *RigidBody::PropagatorStr (DWORD idx, bool verbose) {
 const char *RigidBody::CurPropagatorStr (bool verbose) const
 {
 	if (!bDynamicPosVel) return "none";
-	else return PropagatorStr (PropMode[PropLevel].propidx, verbose);
+	else if (bOnRails) return (verbose ? "Kepler orbit (on rails)" : "Kepler");
+	else return PropagatorStr (bAdaptiveStep ? PROP_RK45 : PropMode[PropLevel].propidx, verbose);
 }
 
 const char *RigidBody::RotationModel () const
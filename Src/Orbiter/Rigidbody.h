@@ -17,6 +17,7 @@
 #define __RIGIDBODY_H
 
 #include "Body.h"
+#include <vector>
 
 class RigidBody;
 
@@ -85,11 +86,58 @@ public:
 	// according to graviational forces. Derived types which do their
 	// own updates may override or augment this.
 
+	void PrepareUpdate (bool force = false);
+	// First part of Update: orbit step estimate and gravity source list
+	// maintenance. Must be called from the main thread, in a fixed order
+	// across bodies (it consumes random numbers).
+
+	void IntegrateUpdate (bool force = false);
+	// Second part of Update: state vector propagation over the current
+	// time step. For a body whose surface forces are inactive this only
+	// modifies the body's own state, so different bodies can be
+	// propagated concurrently.
+
+	void StageFractions (std::vector<double> &frac) const;
+	// Append the fractional step times [0..1] at which the next IntegrateUpdate
+	// will sample the gravity field, if it can be predicted (fixed-step
+	// propagators). Must be called after PrepareUpdate.
+
 	virtual void SetPropagator (int &plevel, int &nstep) const;
 	// return propagator level (0..nPropLevel-1) and substep number (1..PropSubMax)
 	// for current step. Note that nstep > PropSubMax is valid, but should only be
 	// used for immediate collision treatment
 
+	virtual bool UseAdaptivePropagator (int plevel) const;
+	// return true if the current step at propagator level plevel should be
+	// propagated with the adaptive embedded Runge-Kutta method (RK45)
+
+	void SetPropTolerance (double tol);
+	// set the relative error tolerance of the adaptive propagator for this
+	// body. tol > 0 propagates the body always with the adaptive method;
+	// tol = 0 reverts to the global propagator stages and tolerance
+
+	inline double PropTolerance () const { return propTol; }
+	// body-specific adaptive propagator tolerance (0 if not set)
+
+	bool DenseState (double t, Vector &pos, Vector &vel) const;
+	// Returns position and velocity (global frame) at simulation time t within
+	// the last propagated time step, interpolated from the dense output of
+	// the adaptive propagator. Returns false if the step was not propagated
+	// with the adaptive method or t is outside the step.
+
+	bool BeginRails ();
+	// Switch to analytic propagation along the current 2-body orbit w.r.t.
+	// the reference body ("on rails"), with secular J2 drift if nonspherical
+	// gravity is enabled. Returns false if the orbit is not closed.
+
+	void EndRails ();
+	// Return to numerical state integration from the state of the last
+	// analytic update. Accelerations and gravity sources are refreshed at
+	// the beginning of the next step.
+
+	inline bool OnRails () const { return bOnRails; }
+	// return true if the body is propagated on rails
+
 	virtual void GetIntermediateMoments (Vector &acc, Vector &tau,
 		const StateVectors &state, double tfrac, double dt);
 	// Returns acceleration acc and torque tau, at time SimT0+tfrac*SimDT
@@ -153,7 +201,7 @@ public:
 	// method at the current time step (e.g. "RK4")
 
 	virtual const int CurPropagatorSubsamples () const
-	{ return nPropSubsteps; }
+	{ return (bAdaptiveStep ? (int)dense.size() : nPropSubsteps); }
 	// Returns the number of subdivisions of the current frame interval
 	// for the dynamic state integrator
 
@@ -196,6 +244,10 @@ protected:
 	void ReadGenericCaps (std::ifstream &ifs);
 	// Read parameters from a config file
 
+	void RailsUpdate ();
+	// Update the state vectors to SimT1 from the orbit captured by BeginRails.
+	// The body rotates freely with constant angular velocity.
+
 	inline int NumPropLevel() const { return nPropLevel; } // number of defined propagator levels
 	inline int MaxSubStep() const { return PropSubMax; }   // max number of substeps per step update
 
@@ -252,6 +304,10 @@ private:
 	void SY4_LinAng (double h, int nsub, int isub);  // symplectic, order 4, linear+angular
 	void SY6_LinAng (double h, int nsub, int isub);  // symplectic, order 6, linear+angular
 	void SY8_LinAng (double h, int nsub, int isub);  // symplectic, order 8, linear+angular
+	void RK45_LinAng (double h, int nsub, int isub); // adaptive Dormand-Prince 5(4), linear+angular
+
+	static void StageFractions_LinAng (int propidx, int nsub, std::vector<double> &frac);
+	// stage sample times of propagator propidx over nsub substeps
 
 	// Propagators for 2-body orbit perturbations
 	//void RK2_LinAng_Encke (double h, int nsub, int isub);
@@ -277,6 +333,27 @@ private:
 	int PropLevel;         // current propagator stage
 	int PropSubMax;        // upper limit for number of subsamples
 	int nPropSubsteps;     // current number of subsamples
+
+	// adaptive propagator state
+	struct DenseSeg {      // dense output coefficients of an accepted RK45 substep
+		double t0, h;      // substep start time and length [s]
+		Vector rp[5], rv[5]; // interpolation coefficients for position and velocity
+	};
+	std::vector<DenseSeg> dense; // dense output for the last time step
+	double propTol;        // body-specific tolerance (0: use global settings)
+	double hAdapt;         // adaptive substep length estimate for the next step [s]
+	bool bAdaptiveStep;    // last step was propagated with the adaptive method
+
+	// on-rails propagation state
+	Elements *railsEl;     // 2-body orbit at the start of on-rails propagation
+	double railsT0;        // simulation time of the orbit capture [s]
+	Vector railsH;         // orbit normal at capture (unit vector)
+	Vector railsPole;      // rotation axis of the reference body (unit vector)
+	double railsDArg;      // J2 apsidal rotation rate [rad/s]
+	double railsDNode;     // J2 nodal regression rate [rad/s]
+	double railsDTime;     // J2 mean motion change, as fraction of the unperturbed rate
+	bool bOnRails;         // body is propagated on rails
+	bool bRailsExit;       // on-rails propagation ended since the last step
 };
 
 #endif // !__RIGIDBODY_H
\ No newline at end of file
@@ -0,0 +1,330 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+#include "StarCatalogue.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char STARCAT_MAGIC[8] = "ORBSTAR";
+static const uint32_t STARCAT_VERSION = 1;
+static const double STARCAT_PI = 3.14159265358979323846;
+
+// ===========================================================
+// Cell and bucket indices
+// ===========================================================
+
+static inline int BucketIdx (const StarCatHeader *h, double mag)
+{
+	double b = floor ((mag - h->mag0) / h->dmag);
+	return (b < 0.0 ? 0 : b >= h->nbucket ? (int)h->nbucket-1 : (int)b);
+}
+
+static inline int BandIdx (const StarCatHeader *h, double y)
+{
+	// equal-area bands: equal steps in sin(latitude)
+	int i = (int)floor ((y + 1.0) * 0.5 * h->nband);
+	return (i < 0 ? 0 : i >= (int)h->nband ? (int)h->nband-1 : i);
+}
+
+static inline int LngIdx (const StarCatHeader *h, double lng)
+{
+	// wraps lng into 0..2pi
+	int n = (int)h->nlng;
+	int i = (int)floor (lng / (2.0*STARCAT_PI) * n) % n;
+	return (i < 0 ? i+n : i);
+}
+
+// ===========================================================
+// class StarCatalogue
+// ===========================================================
+
+StarCatalogue::StarCatalogue ()
+: hdr(0), idx(0), rec(0), ncell(0), size(0), hFile(0), hMap(0)
+{}
+
+StarCatalogue::~StarCatalogue ()
+{
+	Close();
+}
+
+bool StarCatalogue::Open (const char *fname)
+{
+	Close();
+
+	const char *data;
+#ifdef _WIN32
+	HANDLE hf = CreateFileA (fname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hf == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER fsize;
+	if (!GetFileSizeEx (hf, &fsize) || (size_t)fsize.QuadPart < sizeof(StarCatHeader)) {
+		CloseHandle (hf);
+		return false;
+	}
+	HANDLE hm = CreateFileMappingA (hf, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!hm) {
+		CloseHandle (hf);
+		return false;
+	}
+	data = (const char*)MapViewOfFile (hm, FILE_MAP_READ, 0, 0, 0);
+	if (!data) {
+		CloseHandle (hm);
+		CloseHandle (hf);
+		return false;
+	}
+	hFile = hf;
+	hMap = hm;
+	size = (size_t)fsize.QuadPart;
+#else
+	int fd = open (fname, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat (fd, &st) || (size_t)st.st_size < sizeof(StarCatHeader)) {
+		close (fd);
+		return false;
+	}
+	void *p = mmap (0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd);
+	if (p == MAP_FAILED) return false;
+	data = (const char*)p;
+	size = (size_t)st.st_size;
+#endif
+	hdr = (const StarCatHeader*)data;
+	if (!Attach (data, size)) {
+		Close();
+		return false;
+	}
+	return true;
+}
+
+bool StarCatalogue::Create (const std::vector<StarBinRec> &src)
+{
+	Close();
+	Build (src, buf);
+	if (!Attach (buf.data(), buf.size())) {
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void StarCatalogue::Close ()
+{
+	if (hdr && buf.empty()) {
+#ifdef _WIN32
+		UnmapViewOfFile (hdr);
+		CloseHandle ((HANDLE)hMap);
+		CloseHandle ((HANDLE)hFile);
+#else
+		munmap ((void*)hdr, size);
+#endif
+	}
+	buf.clear();
+	buf.shrink_to_fit();
+	hdr = 0;
+	idx = 0;
+	rec = 0;
+	ncell = 0;
+	hFile = hMap = 0;
+	size = 0;
+}
+
+bool StarCatalogue::Attach (const char *data, size_t datasize)
+{
+	const StarCatHeader *h = (const StarCatHeader*)data;
+	if (datasize < sizeof(StarCatHeader) || memcmp (h->magic, STARCAT_MAGIC, 8) || h->version != STARCAT_VERSION ||
+		!h->nband || !h->nlng || !h->nbucket || !(h->dmag > 0.0f))
+		return false;
+
+	uint64_t nidx = (uint64_t)h->nbucket * h->nband * h->nlng + 1;
+	uint64_t need = sizeof(StarCatHeader) + nidx*sizeof(uint32_t) + (uint64_t)h->nrec*sizeof(StarCatRec);
+	if (need > datasize) return false;
+	const uint32_t *x = (const uint32_t*)(data + sizeof(StarCatHeader));
+	if (x[nidx-1] != h->nrec) return false;
+
+	// queries read the records between consecutive index entries, so the
+	// offsets must be non-decreasing and within the record table
+	for (uint64_t i = 0; i < nidx-1; i++)
+		if (x[i] > x[i+1]) return false;
+
+	hdr = h;
+	idx = x;
+	rec = (const StarCatRec*)(x + nidx);
+	ncell = h->nband * h->nlng;
+	return true;
+}
+
+void StarCatalogue::Query (double maxmag, std::vector<const StarCatRec*> &res) const
+{
+	res.clear();
+	if (!hdr) return;
+
+	// the buckets below the one containing maxmag are complete and contiguous
+	int bmax = BucketIdx (hdr, maxmag);
+	const uint32_t *bidx = idx + bmax*ncell;
+	uint32_t i, n = bidx[0];
+	res.reserve (bidx[ncell]);
+	for (i = 0; i < n; i++)
+		res.push_back (rec+i);
+
+	// within the last bucket, the records of each cell are sorted by magnitude
+	for (uint32_t c = 0; c < ncell; c++)
+		for (i = bidx[c]; i < bidx[c+1] && rec[i].mag < maxmag; i++)
+			res.push_back (rec+i);
+
+	auto bymag = [](const StarCatRec *a, const StarCatRec *b) { return a->mag < b->mag; };
+	for (int b = 0; b < bmax; b++)
+		std::sort (res.begin() + idx[b*ncell], res.begin() + idx[(b+1)*ncell], bymag);
+	std::sort (res.begin() + n, res.end(), bymag);
+}
+
+void StarCatalogue::Query (const double *dir, double radius, double maxmag, std::vector<const StarCatRec*> &res) const
+{
+	res.clear();
+	if (!hdr) return;
+
+	const double pi05 = 0.5*STARCAT_PI;
+	double d = sqrt (dir[0]*dir[0] + dir[1]*dir[1] + dir[2]*dir[2]);
+	double x = dir[0]/d, y = dir[1]/d, z = dir[2]/d;
+	double cosr = cos (radius);
+
+	// bounding box of the cone in bands and longitude cells (slightly
+	// enlarged to be safe against rounding at cell boundaries)
+	int b0 = 0, b1 = (int)hdr->nband-1, l0 = 0, l1 = (int)hdr->nlng-1;
+	bool fullband = true;
+	double r = radius + 1e-6;
+	if (r < STARCAT_PI) {
+		double lat = asin (y);
+		b0 = BandIdx (hdr, sin (std::max (-pi05, lat-r)));
+		b1 = BandIdx (hdr, sin (std::min (pi05, lat+r)));
+		if (fabs (lat) + r < pi05) { // cone does not contain a pole
+			double lng = atan2 (z, x);
+			double dl = asin (sin (r) / cos (lat));
+			l0 = (int)floor ((lng-dl) / (2.0*STARCAT_PI) * hdr->nlng);
+			l1 = (int)floor ((lng+dl) / (2.0*STARCAT_PI) * hdr->nlng);
+			fullband = (l1-l0+1 >= (int)hdr->nlng);
+		}
+	}
+
+	int bmax = BucketIdx (hdr, maxmag);
+	for (int b = 0; b <= bmax; b++) {
+		const uint32_t *bidx = idx + b*ncell;
+		bool partial = (b == bmax);
+		for (int band = b0; band <= b1; band++) {
+			int lcount = (fullband ? 1 : l1-l0+1);
+			for (int k = 0; k < lcount; k++) {
+				uint32_t i0, i1;
+				if (fullband) { // all cells of the band are contiguous
+					i0 = bidx[band*hdr->nlng];
+					i1 = bidx[(band+1)*hdr->nlng];
+				} else {
+					int c = band*hdr->nlng + LngIdx (hdr, (l0+k+0.5) * 2.0*STARCAT_PI / hdr->nlng);
+					i0 = bidx[c];
+					i1 = bidx[c+1];
+				}
+				for (uint32_t i = i0; i < i1; i++) {
+					const StarCatRec &s = rec[i];
+					if (partial && s.mag >= maxmag) continue;
+					if (s.x*x + s.y*y + s.z*z < cosr) continue;
+					res.push_back (&s);
+				}
+			}
+		}
+	}
+}
+
+bool StarCatalogue::ReadStarBin (const char *fname, std::vector<StarBinRec> &src)
+{
+	src.clear();
+	FILE *f = fopen (fname, "rb");
+	if (!f) return false;
+	fseek (f, 0, SEEK_END);
+	long fsize = ftell (f);
+	fseek (f, 0, SEEK_SET);
+	src.resize (fsize > 0 ? fsize / sizeof(StarBinRec) : 0);
+	size_t n = (src.size() ? fread (src.data(), sizeof(StarBinRec), src.size(), f) : 0);
+	fclose (f);
+	src.resize (n);
+	return n > 0;
+}
+
+bool StarCatalogue::Write (const char *fname, const std::vector<StarBinRec> &src)
+{
+	std::vector<char> data;
+	Build (src, data);
+	FILE *f = fopen (fname, "wb");
+	if (!f) return false;
+	bool ok = (fwrite (data.data(), 1, data.size(), f) == data.size());
+	fclose (f);
+	return ok;
+}
+
+void StarCatalogue::Build (const std::vector<StarBinRec> &src, std::vector<char> &data)
+{
+	// records with valid data only
+	std::vector<StarCatRec> r;
+	r.reserve (src.size());
+	float magmin = 0.0f, magmax = 0.0f;
+	for (size_t i = 0; i < src.size(); i++) {
+		const StarBinRec &s = src[i];
+		if (!std::isfinite (s.lng) || !std::isfinite (s.lat) || !std::isfinite (s.mag)) continue;
+		double xz = cos ((double)s.lat);
+		StarCatRec c;
+		c.x = (float)(xz * cos ((double)s.lng));
+		c.y = (float)sin ((double)s.lat);
+		c.z = (float)(xz * sin ((double)s.lng));
+		c.mag = s.mag;
+		c.specidx = s.specidx;
+		c.flags = 0;
+		if (r.empty() || c.mag < magmin) magmin = c.mag;
+		if (r.empty() || c.mag > magmax) magmax = c.mag;
+		r.push_back (c);
+	}
+
+	// about 64 stars per cell on average, 0.5 mag buckets
+	StarCatHeader h;
+	memset (&h, 0, sizeof(StarCatHeader));
+	memcpy (h.magic, STARCAT_MAGIC, 8);
+	h.version = STARCAT_VERSION;
+	h.nrec = (uint32_t)r.size();
+	h.nband = std::max (8u, (uint32_t)sqrt (r.size() / 128.0));
+	h.nlng = 2*h.nband;
+	h.dmag = 0.5f;
+	h.mag0 = floor (magmin);
+	h.nbucket = std::min (64u, std::max (1u, (uint32_t)((magmax - h.mag0) / h.dmag) + 1));
+
+	// sort by bucket and cell, then magnitude
+	uint32_t nc = h.nband * h.nlng;
+	uint32_t nkey = h.nbucket * nc;
+	std::vector<uint32_t> key (r.size());
+	for (size_t i = 0; i < r.size(); i++) {
+		const StarCatRec &c = r[i];
+		key[i] = BucketIdx (&h, c.mag) * nc + BandIdx (&h, c.y) * h.nlng + LngIdx (&h, atan2 ((double)c.z, (double)c.x));
+	}
+	std::vector<uint32_t> perm (r.size());
+	for (size_t i = 0; i < perm.size(); i++) perm[i] = (uint32_t)i;
+	std::sort (perm.begin(), perm.end(), [&](uint32_t a, uint32_t b) {
+		return key[a] != key[b] ? key[a] < key[b] : r[a].mag < r[b].mag;
+	});
+
+	data.resize (sizeof(StarCatHeader) + (nkey+1)*sizeof(uint32_t) + r.size()*sizeof(StarCatRec));
+	memcpy (data.data(), &h, sizeof(StarCatHeader));
+	uint32_t *x = (uint32_t*)(data.data() + sizeof(StarCatHeader));
+	StarCatRec *out = (StarCatRec*)(x + nkey+1);
+	uint32_t k = 0;
+	for (uint32_t i = 0; i < h.nrec; i++) {
+		uint32_t ki = key[perm[i]];
+		while (k <= ki) x[k++] = i;
+		out[i] = r[perm[i]];
+	}
+	while (k <= nkey) x[k++] = h.nrec;
+}
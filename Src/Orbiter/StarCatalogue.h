@@ -0,0 +1,106 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Indexed star catalogue
+// A binary star database which is memory-mapped at runtime and indexed by
+// magnitude bucket and sky cell, so that the stars brighter than a given
+// magnitude, either on the whole sky or within a view cone, can be
+// extracted in time proportional to the result size, without reading or
+// converting the rest of the catalogue.
+// The sky is divided into bands of equal area (equal steps in the sine of
+// the ecliptic latitude), each divided into cells of equal longitude
+// range. Records are sorted by magnitude bucket, then cell, then
+// magnitude, and store the direction as a unit vector.
+// Catalogue files (star.cat) are generated from star.bin-format data with
+// Utils/starcat. If no catalogue file is present, the index can be built
+// in memory from the records of star.bin.
+// This module has no dependencies on the Orbiter API.
+// =======================================================================
+
+#ifndef __STARCATALOGUE_H
+#define __STARCATALOGUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#pragma pack(push,1)
+struct StarBinRec {        // star.bin record (source data)
+	float lng;             // ecliptic longitude (J2000) [rad]
+	float lat;             // ecliptic latitude (J2000) [rad]
+	float mag;             // apparent magnitude
+	uint16_t specidx;      // spectral class index (0-69)
+};
+#pragma pack(pop)
+
+struct StarCatHeader {
+	char     magic[8];     // "ORBSTAR"
+	uint32_t version;      // file format version
+	uint32_t nrec;         // number of star records
+	uint32_t nband;        // number of latitude bands
+	uint32_t nlng;         // number of cells per band
+	uint32_t nbucket;      // number of magnitude buckets
+	float    mag0;         // lower magnitude limit of the first bucket
+	float    dmag;         // bucket width [mag]
+	uint32_t reserved[7];
+};
+// The header is followed by the index (nbucket*nband*nlng+1 record
+// offsets of type uint32_t, one per bucket and cell, bucket-major) and
+// nrec StarCatRec records. The first and last buckets are open-ended.
+
+struct StarCatRec {
+	float x, y, z;         // direction in the J2000 ecliptic frame (unit vector; y = ecliptic north)
+	float mag;             // apparent magnitude
+	uint16_t specidx;      // spectral class index (0-69)
+	uint16_t flags;        // reserved
+};
+
+class StarCatalogue {
+public:
+	StarCatalogue ();
+	~StarCatalogue ();
+
+	bool Open (const char *fname);
+	// Map catalogue file fname. Returns false if the file can't be opened,
+	// is not a star catalogue or is inconsistent.
+
+	bool Create (const std::vector<StarBinRec> &src);
+	// Build the catalogue in memory from source records
+
+	void Close ();
+
+	inline bool IsOpen () const { return hdr != 0; }
+	inline bool IsMapped () const { return IsOpen() && buf.empty(); }
+	inline uint32_t Count () const { return hdr ? hdr->nrec : 0; }
+	inline const StarCatRec *Records () const { return rec; }
+	inline const StarCatHeader *Header () const { return hdr; }
+
+	void Query (double maxmag, std::vector<const StarCatRec*> &res) const;
+	// All stars brighter than maxmag, sorted by magnitude (brightest first)
+
+	void Query (const double *dir, double radius, double maxmag, std::vector<const StarCatRec*> &res) const;
+	// Stars brighter than maxmag within angular distance radius [rad] of
+	// direction dir (unit vector, 3 components). The result is ordered by
+	// magnitude bucket, i.e. sorted by magnitude to within the bucket width.
+
+	static bool ReadStarBin (const char *fname, std::vector<StarBinRec> &src);
+	// Read all records of a star.bin-format file
+
+	static bool Write (const char *fname, const std::vector<StarBinRec> &src);
+	// Build the catalogue from source records and write it to file fname
+
+private:
+	static void Build (const std::vector<StarBinRec> &src, std::vector<char> &data);
+	bool Attach (const char *data, size_t size);
+
+	const StarCatHeader *hdr;          // start of the catalogue data
+	const uint32_t *idx;               // index: record offsets per bucket and cell
+	const StarCatRec *rec;             // star records
+	uint32_t ncell;                    // cells per bucket (nband*nlng)
+	std::vector<char> buf;             // catalogue data if built in memory
+	size_t size;                       // mapped file size
+	void *hFile, *hMap;                // Windows file and mapping handles
+};
+
+#endif // !__STARCATALOGUE_H
@@ -333,7 +333,7 @@ char *ExtraPropagation::Description ()
 
 int ExtraDynamics::PropId[NPROP_METHOD] = {
 	PROP_RK2, PROP_RK4, PROP_RK5, PROP_RK6, PROP_RK7, PROP_RK8,
-	PROP_SY2, PROP_SY4, PROP_SY6, PROP_SY8
+	PROP_SY2, PROP_SY4, PROP_SY6, PROP_SY8, PROP_RK45
 };
 
 char *ExtraDynamics::Name ()
@@ -405,6 +405,8 @@ void ExtraDynamics::SetDialog (HWND hWnd, const CFG_PHYSICSPRM &prm)
 	}
 	sprintf (cbuf, "%d", prm.PropSubMax);
 	SetWindowText (GetDlgItem (hWnd, IDC_PROP_MAXSAMPLE), cbuf);
+	sprintf (cbuf, "%g", prm.PropTol);
+	SetWindowText (GetDlgItem (hWnd, IDC_PROP_TOLERANCE), cbuf);
 }
 
 void ExtraDynamics::Activate (HWND hWnd, int which)
@@ -501,6 +503,15 @@ bool ExtraDynamics::StoreParams (HWND hWnd)
 		cfg->CfgPhysicsPrm.PropSubMax = i;
 	}
 
+	double tol;
+	GetWindowText (GetDlgItem (hWnd, IDC_PROP_TOLERANCE), cbuf, 256);
+	if ((sscanf (cbuf, "%lf", &tol) != 1) || tol <= 0.0 || tol >= 1.0) {
+		Error ("Invalid value for adaptive propagator tolerance (0 < tolerance < 1 required).");
+		return false;
+	} else {
+		cfg->CfgPhysicsPrm.PropTol = tol;
+	}
+
 	return true;
 }
 
@@ -5,6 +5,7 @@
 
 #include "VectorMap.h"
 #include "Psys.h"
+#include "Astro.h"
 #include "Mfd.h"
 #include "Util.h"
 
@@ -234,13 +235,18 @@ void VectorMap::Update ()
 
 	if (dispflag & DISP_GROUNDTRACK) {
 		if (dispflag & DISP_ORBITFOCUS && g_focusobj->ElRef() == cbody) {
+			if (gt_this.vessel != g_focusobj) // focus has changed
+				gt_this.Reset (cbody, g_focusobj->Els(), g_focusobj);
 			for (i = 0; i < nstep; i++) gt_this.Update();
+			gt_this.UpdateProp();
 		}
 		if (dispflag & DISP_ORBITSEL && selection.type == DISP_VESSEL) {
 			Vessel *v = (Vessel*)selection.obj;
 			if ((v != g_focusobj) || ((dispflag & DISP_ORBITFOCUS) == 0)) {
-				if (v->ElRef() == cbody)
+				if (v->ElRef() == cbody) {
 					for (i = 0; i < nstep; i++) gt_tgt.Update();
+					gt_tgt.UpdateProp();
+				}
 			}
 		} else if (selection.type == DISP_MOON) {
 			for (i = 0; i < nstep; i++) gt_tgt.Update();
@@ -275,7 +281,7 @@ bool VectorMap::SetCBody (const CelestialBody *body)
 			sprintf (relpath, "%s\\data\\contour.vec", cbody->Name());
 			strcpy (path, g_pOrbiter->Cfg()->ConfigPathNoext (relpath));
 			contour.Load (path, OUTLINE_CONTOUR);
-			gt_this.Reset (cbody, g_focusobj->Els());
+			gt_this.Reset (cbody, g_focusobj->Els(), g_focusobj);
 			mkrlist = planet->LabelList (&nmkrlist);
 			mkrset.Connect (mkrlist, nmkrlist);
 			AllocCustomResources();
@@ -373,7 +379,7 @@ bool VectorMap::SetSelection (const OBJTYPE &obj)
 	selection = obj;
 	if (cbody) {
 		if (obj.type == DISP_VESSEL)
-			gt_tgt.Reset (cbody, ((Vessel*)obj.obj)->Els());
+			gt_tgt.Reset (cbody, ((Vessel*)obj.obj)->Els(), (Vessel*)obj.obj);
 		else if (obj.type == DISP_MOON)
 			gt_tgt.Reset (cbody, ((CelestialBody*)obj.obj)->Els());
 	}
@@ -795,11 +801,11 @@ void VectorMap::DrawPolyline (oapi::Sketchpad *skp, int type, VPoint *vp, int n,
 
 // =======================================================================
 
-void VectorMap::DrawGroundtrackLine (oapi::Sketchpad *skp, int type, VPointGT *vp, int n, int n0, int n1)
+void VectorMap::DrawGroundtrackLine (oapi::Sketchpad *skp, int type, const VPointGT *vp, int n, int n0, int n1)
 {
 	int i, x0, x1, y0, y1;
 	int mapw = (int)(cw*PI/dlng);
-	VPointGT *va, *vb;
+	const VPointGT *va, *vb;
 	bool replicate;
 
 	if (n1 < n0) n1 += n;
@@ -1181,7 +1187,20 @@ void VectorMap::DrawGroundtrack_future (oapi::Sketchpad *skp, Groundtrack &gt, i
 		LineTo (hDCmem, mapx(gt.vtx[0].lng), mapy(gt.vtx[0].lat));
 	}
 #endif
-	DrawGroundtrackLine (skp, OUTLINE_GROUNDTRACK, gt.vtx, gt.nvtx, gt.vcurr, gt.vlast);
+	const GroundtrackProp::Track *trk = gt.PropTrack();
+	if (trk) {
+		// propagated track, joined to the current point
+		const VPointGT &vc = gt.vtx[gt.vcurr];
+		int n = (int)trk->vtx.size();
+		int i0 = (int)(std::upper_bound (trk->vtx.begin(), trk->vtx.end(), vc.t,
+			[](double t, const VPointGT &v) { return t < v.t; }) - trk->vtx.begin());
+		if (i0 < n) {
+			VPointGT seg[2] = {vc, trk->vtx[i0]};
+			DrawGroundtrackLine (skp, OUTLINE_GROUNDTRACK, seg, 2, 0, 1);
+			DrawGroundtrackLine (skp, OUTLINE_GROUNDTRACK, trk->vtx.data(), n, i0, n-1);
+		}
+	} else
+		DrawGroundtrackLine (skp, OUTLINE_GROUNDTRACK, gt.vtx, gt.nvtx, gt.vcurr, gt.vlast);
 	if (ppen) skp->SetPen(ppen);
 }
 
@@ -1424,12 +1443,18 @@ void CustomMkrSet::Connect (oapi::GraphicsClient::LABELLIST *ll, int nlist)
 
 const double Groundtrack::tgtstep = 10.0*RAD;
 const double Groundtrack::tstep_max = 5*60;
+const int Groundtrack::norbit = 3;
 
 Groundtrack::Groundtrack()
 {
 	nvtx = 128;
 	vtx = new VPointGT[nvtx];
 	vfirst = vlast = vcurr = 0;
+	cbody = NULL;
+	vessel = NULL;
+	prop = NULL;
+	dragk = 0.0;
+	span = 0.0;
 }
 
 Groundtrack::~Groundtrack()
@@ -1438,9 +1463,10 @@ Groundtrack::~Groundtrack()
 		delete []vtx;
 		vtx = NULL;
 	}
+	delete prop;
 }
 
-void Groundtrack::Reset (const CelestialBody *body, const Elements *_el)
+void Groundtrack::Reset (const CelestialBody *body, const Elements *_el, const Vessel *_vessel)
 {
 	int i;
 	const double tstep = 120; // arbitrary first interval
@@ -1448,6 +1474,10 @@ void Groundtrack::Reset (const CelestialBody *body, const Elements *_el)
 	if (!cbody) return;
 	el = _el;
 	prad = cbody->Size();
+	if (_vessel != vessel) dragk = 0.0;
+	vessel = _vessel;
+	if (vessel && !prop) prop = new GroundtrackProp;
+	if (prop) prop->Clear(); // restarted by UpdateProp
 	
 	// initialise the time points
 	vfirst = vupdt = 0;
@@ -1495,7 +1525,7 @@ void Groundtrack::Update ()
 
 	if (!cbody) return;
 	if (td.SimT1 < vtx[vcurr].t) { // simulation has jumped back in time!
-		Reset (cbody, el);
+		Reset (cbody, el, vessel);
 		return;
 	}
 
@@ -1546,3 +1576,101 @@ void Groundtrack::Update ()
 	}
 	omega_updt = fabs (omega_updt);
 }
+
+// =======================================================================
+// Numerical propagation of the future groundtrack
+// The Kepler vertex ring above ignores nonspherical gravity, drag and
+// third-body perturbations. For vessels, a GroundtrackProp integrates the
+// trajectory over several orbits in the background. The propagation is
+// restarted when the vessel departs from the prediction (thrust, time jumps,
+// model errors), and otherwise extended as time advances.
+
+void Groundtrack::UpdateProp ()
+{
+	if (!prop || !vessel || !cbody) return;
+	if (vessel->GetStatus() != FLIGHTSTATUS_FREEFLIGHT) {
+		prop->Clear();
+		return;
+	}
+
+	// drag factor from the vessel's current drag force
+	const SurfParam *sp = vessel->GetSurfParam();
+	if (sp && sp->ref == cbody && vessel->AtmDensity() > 0.0 && sp->airspd > 1.0)
+		dragk = vessel->GetDrag() / (0.5*vessel->AtmDensity()*sp->airspd*sp->airspd*vessel->Mass());
+
+	if (prop->Busy()) return;
+
+	const GroundtrackProp::Track *trk = prop->Current();
+	Vector pos (vessel->GPos() - cbody->GPos()), ppos;
+	double tol = 1e-4 * pos.length(); // position tolerance for the prediction
+	if (trk->seq != prop->Seq() || !trk->Interpolate (td.SimT0, ppos) || ppos.dist (pos) > tol)
+		prop->Restart (PropModel (pos));
+	else if (trk->vtx.back().t < td.SimT0 + span*(norbit-1)/norbit) // extend by one orbit at a time
+		prop->Extend (td.SimT0);
+}
+
+const GroundtrackProp::Track *Groundtrack::PropTrack ()
+{
+	if (!prop || !vessel) return NULL;
+	const GroundtrackProp::Track *trk = prop->Current();
+	if (trk->seq != prop->Seq() || trk->vtx.size() < 2) return NULL;
+	return trk;
+}
+
+GroundtrackProp::Model Groundtrack::PropModel (const Vector &pos)
+{
+	GroundtrackProp::Model m;
+	m.t0 = td.SimT0;
+	m.pos = pos;
+	m.vel = vessel->GVel() - cbody->GVel();
+	m.mu = Ggrav * cbody->Mass();
+	m.rad = prad;
+	m.rot0 = cbody->GRot();
+	m.omega = Pi2/cbody->RotT();
+	m.rmax = prad * 1e3;
+
+	// step size resolves the periapsis passage, span covers norbit orbits
+	double v2 = m.vel.length2(), r = pos.length();
+	double a = 1.0 / (2.0/r - v2/m.mu);
+	double e = ((pos * (v2 - m.mu/r) - m.vel * dotp (pos, m.vel)) / m.mu).length();
+	double rp = std::max (a*(1.0-e), 0.5*prad); // periapsis distance (elliptic and hyperbolic)
+	m.step = std::min (30.0, 0.02 * sqrt (rp*rp*rp/m.mu));
+	m.span = (e < 1.0 ? norbit * Pi2 * sqrt (a*a*a/m.mu) : 86400.0);
+	m.span = span = std::min (m.span, std::min (2.0*86400.0, 2e4*m.step));
+
+	if (cbody->UseComplexGravity()) {
+		const CelestialBody *cb = cbody;
+		m.pert = [cb](const Vector &p, const Matrix &rot) { return SingleGacc_perturbation (-p, cb, rot); };
+	}
+
+	// third bodies on Kepler orbits: the moons of the reference body and its primary
+	for (DWORD i = 0; i < cbody->nSecondary(); i++) {
+		const CelestialBody *sec = cbody->Secondary (i);
+		const Elements *sel = sec->Els();
+		if (!sel) continue;
+		Elements sel_t (*sel);
+		m.source.push_back ({Ggrav * sec->Mass(), [sel_t](double t) { return sel_t.Pos (t); }});
+	}
+	if (cbody->Primary() && cbody->Els()) {
+		Elements cel_t (*cbody->Els());
+		m.source.push_back ({Ggrav * cbody->Primary()->Mass(), [cel_t](double t) { return -cel_t.Pos (t); }});
+	}
+
+	// drag with the measured drag factor and the density profile above the vessel's current position
+	if (dragk > 0.0 && cbody->Type() == OBJTP_PLANET && ((const Planet*)cbody)->HasAtmosphere()) {
+		const Planet *pl = (const Planet*)cbody;
+		const int nsample = 64;
+		const SurfParam *sp = vessel->GetSurfParam();
+		double lng = 0.0, lat = 0.0;
+		if (sp && sp->ref == cbody) lng = sp->lng, lat = sp->lat;
+		ATMPARAM prm;
+		m.dragk = dragk;
+		m.altmax = pl->AtmAltLimit();
+		m.lnrho.resize (nsample);
+		for (int i = 0; i < nsample; i++) {
+			if (!pl->GetAtmParam (m.altmax*i/(nsample-1), lng, lat, &prm)) prm.rho = 0.0;
+			m.lnrho[i] = log (std::max (prm.rho, 1e-30));
+		}
+	}
+	return m;
+}
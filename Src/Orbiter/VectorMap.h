@@ -13,6 +13,7 @@
 #include "Orbiter.h"
 #include "Planet.h"
 #include "Element.h"
+#include "GroundtrackProp.h"
 
 #define NVTX_CIRCLE 64
 
@@ -49,12 +50,6 @@ struct VPoint {
 	double lng, lat;
 };
 
-struct VPointGT {
-	double lng, lat;
-	double rad;
-	double t, dt;
-};
-
 struct PolyLineSpec {
 	int vofs;   // offset of first node in vertex list
 	int nvtx;   // number of nodes in the list
@@ -96,19 +91,29 @@ struct CustomMkrSet {
 struct Groundtrack {
 	Groundtrack();
 	~Groundtrack();
-	void Reset (const CelestialBody *body, const Elements *_el);
+	void Reset (const CelestialBody *body, const Elements *_el, const Vessel *_vessel = NULL);
 	void CalcPoint (VPointGT &p, double *angvel = NULL);
 	double VtxDst (const VPointGT &vp1, const VPointGT &vp2);
 	void Update();
+	void UpdateProp();
+	// restart or extend the numerical propagation of the vessel trajectory
+	const GroundtrackProp::Track *PropTrack();
+	// propagated track of the current propagation, or NULL if not available
+	GroundtrackProp::Model PropModel (const Vector &pos);
 	VPointGT *vtx; // groundtrack vertex points
 	int nvtx;    // number of vertices
 	int vfirst, vlast, vcurr, vupdt; // index of start, end and current vertex
 	const Elements *el;
 	const CelestialBody *cbody;
+	const Vessel *vessel;  // vessel for numerical propagation, or NULL (Kepler orbit only)
+	GroundtrackProp *prop; // numerical propagator of the future track
+	double dragk;          // last measured drag factor of the vessel [m^2/kg]
+	double span;           // time span of the propagated track [s]
 	double prad; // planet radius
 	double omega_curr, omega_updt; // angular velocity at current/update position
 	static const double tgtstep;
 	static const double tstep_max;
+	static const int norbit; // number of orbits covered by the propagated track
 };
 
 // =======================================================================
@@ -215,7 +220,7 @@ protected:
 	void DrawGroundtrack_past (oapi::Sketchpad *skp, Groundtrack &gt, int which);
 	void DrawGroundtrack_future (oapi::Sketchpad *skp, Groundtrack &gt, int which);
 	void DrawHorizon (oapi::Sketchpad *skp, double lng, double lat, double rad, bool focus);
-	void DrawGroundtrackLine (oapi::Sketchpad *skp, int type, VPointGT *vp, int n, int n0, int n1);
+	void DrawGroundtrackLine (oapi::Sketchpad *skp, int type, const VPointGT *vp, int n, int n0, int n1);
 
 	// drawing primitives
 	void DrawMarker (oapi::Sketchpad *skp, double lng, double lat, const char *name, int which); // which: 0=focusobj, 1=orbittarget, 2=basetarget
@@ -197,6 +197,8 @@ Vessel::~Vessel ()
 		classname = NULL;
 	}
 	ClearMeshes();
+	for (auto mesh : classmesh)
+		g_pOrbiter->meshmanager.ReleaseMesh ((const Mesh*)mesh);
 	ClearThrusterDefinitions();
 	ClearPropellantResources();
 	ClearAirfoilDefinitions();
@@ -240,12 +242,16 @@ bool Vessel::OpenConfigFile (ifstream &cfgfile) const
 	strcat (cbuf, classname ? classname : name.c_str());
 	// first search in $CONFIGDIR\Vessels
 	cfgfile.open (g_pOrbiter->ConfigPath (cbuf));
-	if (cfgfile.good()) return true;
-	else cfgfile.clear();
+	if (cfgfile.good()) {
+		IndexItems (cfgfile);
+		return true;
+	} else cfgfile.clear();
 	// next search in $CONFIGDIR
 	cfgfile.open (g_pOrbiter->ConfigPath (cbuf+8));
-	if (cfgfile.good()) return true;
-	else {
+	if (cfgfile.good()) {
+		IndexItems (cfgfile);
+		return true;
+	} else {
 		cfgfile.clear();
 		LOGOUT_ERR_FILENOTFOUND_MSG(g_pOrbiter->ConfigPath(cbuf + 8), "No vessel class configuration file found for: %s", classname ? classname : name);
 		//LogOut (">>> ERROR: No vessel class configuration file found for:");
@@ -296,7 +302,6 @@ void Vessel::SetDefaultState ()
 	undock_t            = -1000;
 	proxyvessel         = 0;
 	supervessel         = 0;
-	scanvessel          = 0;
 	attmode             = 1;
 	ctrlsurfmode        = 0;
 	for (i = 0; i < 6; i++)
@@ -310,6 +315,7 @@ void Vessel::SetDefaultState ()
 	sp.is_in_atm        = false;
 	m_bThrustEngaged    = false;
 	bForceActive        = false;
+	bFreeflightPending  = false;
 	rpressure           = g_pOrbiter->Cfg()->CfgPhysicsPrm.bRadiationPressure;
 	Lift = Drag = SideForce = 0.0;
 	attach_status.pname = 0;
@@ -436,7 +442,10 @@ void Vessel::ReadGenericCaps (ifstream &ifs)
 	// recursively read base class specs
 	if (GetItemString (ifs, "BaseClass", cbuf)) {
 		ifstream basef (g_pOrbiter->ConfigPath (cbuf));
-		if (basef) ReadGenericCaps (basef);
+		if (basef) {
+			IndexItems (basef);
+			ReadGenericCaps (basef);
+		}
 	}
 
 	// read base class parameters
@@ -445,8 +454,10 @@ void Vessel::ReadGenericCaps (ifstream &ifs)
 	if (GetItemString(ifs, "MeshName", cbuf)) {
 		// preload mesh template
 		MESHHANDLE mesh = (MESHHANDLE)g_pOrbiter->meshmanager.LoadMesh(cbuf);
-		if (mesh)
+		if (mesh) {
+			classmesh.push_back(mesh);
 			AddMesh(mesh);
+		}
 		else
 			g_pOrbiter->TerminateOnError(); // we assume that vessel meshes are required
 	}
@@ -855,9 +866,11 @@ void Vessel::RPlace_individual (const Vector &rpos, const Vector &rvel)
 	// to the supervessel
 
 	if (bFRplayback) return; // ignore explicit state vector setting during playback
+	EndRails();
 	fstatus = FLIGHTSTATUS_FREEFLIGHT;
 	bSurfaceContact = false;
 	RigidBody::RPlace (rpos, rvel);
+	g_psys->InvalidateVesselIndex(); // vessel may have moved to a different cell
 	cpos = s0->pos - cbody->GPos();
  	cvel = s0->vel - cbody->GVel();
 
@@ -941,7 +954,7 @@ void Vessel::GetIntermediateMoments_pert (Vector &acc, Vector &tau,
 
 Vector Vessel::GetTorque () const
 {
-	static Vector F(0,0,0);
+	Vector F(0,0,0);
 	Vector M(Amom);
 	AddSurfaceForces (&F, &M, s0, 0, 0);
 	return RigidBody::GetTorque() + M/mass;
@@ -1022,6 +1035,7 @@ void Vessel::InitNavRadios (DWORD n)
 			tmp[i].step   = 0;
 			tmp[i].dbidx  = -1; // undefined
 			tmp[i].sender = NULL;
+			tmp[i].sig    = 0.0;
 		}
 	} else
 		tmp = 0;
@@ -2711,9 +2725,13 @@ PortSpec* Vessel::GetProxyDock(PortSpec *pD)
 
 	Vector dofs = mul(s0->R, pD->ref);
 
-	for (auto v : g_psys->GetVessels())
+	const ProximityIndex<Vessel> &vidx = g_psys->VesselIndex();
+	double range = max (1.5 * (size + vidx.MaxSize()), size + vidx.MaxSize() + 1e3);
+	std::vector<Vessel*> vlist;
+	vidx.Within (s0->pos, range, vlist, this);
+
+	for (auto v : vlist)
 	{
-		if (v == this) continue;
 		if (v->proxybody != proxybody) continue;
 		if (v->ndock == 0) continue;
 		
@@ -4288,14 +4306,7 @@ bool Vessel::AddSurfaceForces (Vector *F, Vector *M, const StateVectors *s, doub
 
 	int i, j;
 	double alt = 0, tdymin = 0;
-	static int *tidx = new int[3];
-	static double *tdy = new double[3];
-	static double *fn = new double[3];
-	static double *flng = new double[3];
-	static double *flat = new double[3];
-	static DWORD ntdy = 3;
-
-	static StateVectors ls; // local state
+	StateVectors ls; // local state
 	if (!proxybody) return false;
 	StateVectors ps = proxybody->InterpolateState (tfrac); // intermediate planet state; should probably be passed in as function argument
 	SurfParam surfp; // intermediate surface parameters; should probably be passed in as function argument
@@ -4326,19 +4337,18 @@ bool Vessel::AddSurfaceForces (Vector *F, Vector *M, const StateVectors *s, doub
 	Matrix T (s->R); // transformation vessel local -> planet local
 	T.tpremul (ps.R);
 
-	if (ntdy < ntouchdown_vtx) {
-		ntdy = ntouchdown_vtx;
-		delete []tidx;
-		tidx = new int[ntdy];
-		delete []tdy;
-		tdy = new double[ntdy];
-		delete []fn;
-		fn = new double[ntdy];
-		delete []flng;
-		flng = new double[ntdy];
-		delete []flat;
-		flat = new double[ntdy];
+	if (tdwork.tdy.size() < ntouchdown_vtx) {
+		tdwork.tidx.resize (ntouchdown_vtx);
+		tdwork.tdy.resize (ntouchdown_vtx);
+		tdwork.fn.resize (ntouchdown_vtx);
+		tdwork.flng.resize (ntouchdown_vtx);
+		tdwork.flat.resize (ntouchdown_vtx);
 	}
+	int *tidx = tdwork.tidx.data();
+	double *tdy = tdwork.tdy.data();
+	double *fn = tdwork.fn.data();
+	double *flng = tdwork.flng.data();
+	double *flat = tdwork.flat.data();
 
 	ElevationManager* emgr = (cbody->Type() == OBJTP_PLANET ? ((Planet*)cbody)->ElevMgr() : 0);
 	int reslvl = 1;
@@ -4568,8 +4578,6 @@ bool Vessel::AddSurfaceForces (Vector *F, Vector *M, const StateVectors *s, doub
 		// limit the change in angle over the current time step induced by impact forces
 		Vector dA = EulerInv_full (M_surf/mass, s->omega)*dt*dt;
 		double da = dA.length();
-		static double da_max = 0.0;
-		if (da > da_max) da_max = da;
 		if (da > 10.0*RAD) {
 			double scale = 10.0*RAD/da;
 			M_surf *= scale;
@@ -4706,6 +4714,68 @@ bool Vessel::AddSurfaceForces (Vector *F, Vector *M, const StateVectors *s, doub
 	return true;
 }
 
+// =======================================================================
+// free-flight state update, split into a serial and a concurrent part
+
+bool Vessel::UpdateRailsMode ()
+{
+	const CFG_PHYSICSPRM &prm = g_pOrbiter->Cfg()->CfgPhysicsPrm;
+	int cmdrails = g_pOrbiter->Cfg()->CfgCmdlinePrm.OnRails;
+	double dmin2 = prm.OnRailsDist*prm.OnRailsDist;
+
+	bool rails = (cmdrails >= 0 ? cmdrails != 0 : prm.bOnRails) && cbody && !bForceActive && this != g_focusobj &&
+		g_camera->Target() != this && s0->pos.dist2 (g_camera->GPos()) > dmin2;
+	if (rails) {
+		double d2;
+		rails = !g_psys->VesselIndex().Nearest (s0->pos, this, &d2) || d2 > dmin2;
+	}
+	if (rails) // leave the rails before the orbit is perturbed by another body
+		rails = g_psys->GetGravityContribution (cbody, s0->pos) > 1.0-prm.Stabilise_PLimit;
+	if (rails && !OnRails()) {
+		// the whole orbit must stay clear of the atmosphere and the surface
+		double pemin = cbody->Size() + prm.OnRailsAlt;
+		if (cbody->Type() == OBJTP_PLANET && ((Planet*)cbody)->HasAtmosphere())
+			pemin += ((Planet*)cbody)->AtmAltLimit();
+		const Elements *e = Els();
+		rails = e && e->PeDist() > pemin && BeginRails();
+	}
+	if (!rails) EndRails();
+	return rails;
+}
+
+// =======================================================================
+
+bool Vessel::BeginFreeflightUpdate (bool force)
+{
+	if (attach || supervessel || bFRplayback || fstatus != FLIGHTSTATUS_FREEFLIGHT ||
+		!canDynamicPosVel() || bSurfaceContact) {
+		EndRails();
+		return false;
+	}
+	if (UpdateRailsMode())
+		return false; // propagated analytically by Update
+
+	if (proxybody) {
+		// AddSurfaceForces must return before touching the surface (elevation
+		// or ground contact) at every intermediate state of the step
+		double dt = td.SimDT;
+		double dr = (s0->vel - proxybody->GVel()).length()*dt + acc.length()*dt*dt;
+		if (sp.alt0 - dr < sp.elev + 2e4)
+			return false;
+	}
+
+	RigidBody::PrepareUpdate (force);
+	bFreeflightPending = true;
+	return true;
+}
+
+// =======================================================================
+
+void Vessel::FreeflightUpdate ()
+{
+	RigidBody::IntegrateUpdate ();
+}
+
 // =======================================================================
 // vessel state update
 
@@ -4723,6 +4793,10 @@ void Vessel::Update (bool force)
 		if (!supervessel) {
 			if (bFRplayback) {
 				FRecorder_Play();          // update from playback stream
+			} else if (bFreeflightPending) {
+				bFreeflightPending = false; // already propagated by FreeflightUpdate
+			} else if (OnRails()) {
+				RailsUpdate ();            // analytic update along the 2-body orbit
 			} else {
 				RigidBody::Update (force); // standard dynamic update
 			}
@@ -4767,6 +4841,17 @@ void Vessel::Update (bool force)
 	if (proxybody && fstatus != FLIGHTSTATUS_LANDED)
 		UpdateSurfParams();
 
+	// queue the elevation tiles along the ground track for loading in the background
+	if (proxyplanet && proxyplanet == proxybody && fstatus != FLIGHTSTATUS_LANDED && sp.alt0 < 1e5) {
+		ElevationManager *emgr = proxyplanet->ElevMgr();
+		if (emgr) {
+			const StateVectors *sref = (proxyplanet->s1 ? proxyplanet->s1 : proxyplanet->s0);
+			Vector vh (mul (sp.L2H, tmul (sref->R, sp.groundvel_glob))); // ground velocity in local horizon frame
+			int reslvl = (int)(32.0-log(max(sp.alt0,100.0))*LOG2);
+			emgr->Prefetch (sp.lat, sp.lng, vh.z/sp.rad, vh.x/(sp.rad*max(sp.clat,1e-3)), reslvl);
+		}
+	}
+
 	if (proxyplanet && fstatus != FLIGHTSTATUS_LANDED && !bFRplayback) {
 
 		// handle planetary surface touchdown events
@@ -4990,65 +5075,66 @@ void Vessel::PostUpdate ()
 
 	if (fstatus == FLIGHTSTATUS_FREEFLIGHT && td.SimT1 > undock_t+1.0) {
 
-		// check for vessel-vessel docking
-		// check one vessel per frame (this may not be enough if universe is densely
-		// populated. Instead there should be a list of vessels, sorted into 2 or 3 distance
-		// bins (eg < 10km, <1000km, rest) and 1 vessel per *bin* should be checked)
+		// check for vessel-vessel docking with all vessels within capture range
 
 		if (ndock) {
-			if (++scanvessel >= g_psys->nVessel()) scanvessel = 0;
-			Vessel *v = g_psys->GetVessel(scanvessel);
-			if (v != this && v->ndock && v->proxybody == proxybody) {
-				double dst = s0->pos.dist (v->GPos());
-
-				if ((dst < 1.5 * (size + v->Size()) || (dst < size + v->Size() + 1e3))) { // valid candidate
-					Vector dref, gref, vref;
-					for (j = 0; j < ndock; j++) { // loop over my own docks
-						if (dock[j]->mate) continue; // dock already busy
-						if (dockmode == 0) { // legacy docking mode
-							if (dotp (s0->vel - v->GVel(), mul (s0->R, dock[j]->dir)) < -0.01) continue; // moving away from dock
-							for (k = 0; k < v->ndock; k++) { // loop over other vessel's docks
-								if (v->dock[k]->mate) continue; // dock already busy
-								dref.Set (tmul (v->GRot(), mul (s0->R, dock[j]->ref) + s0->pos - v->GPos()));
-								double d = dref.dist (v->dock[k]->ref);
-								if (d < MIN_DOCK_DIST) {
-									if (dock[j]->autodock && v->dock[k]->autodock)
-										Dock (v, j, k);
-								}
-							}
-						} else { // new docking mode
-							for (k = 0; k < v->ndock; k++) { // loop over other vessel's docks
-								if (v->dock[k]->mate) continue; // dock already busy
-								gref.Set (mul (s0->R, dock[j]->ref) + s0->pos);            // my dock in global frame
-								vref.Set (mul (v->GRot(), v->dock[k]->ref) + v->GPos()); // target dock in global frame
-								//dref.Set (tmul (v->GRot(), mul (*grot, dock[j]->ref) + *gpos - v->GPos())); // my dock in the target's frame
-								double d = gref.dist(vref); //dref.dist (v->dock[k]->ref);
-								if (d < MIN_DOCK_DIST) {
-									if (dotp (s0->vel - v->GVel(), vref-gref) >= 0) { // on approach
-										dock[j]->pending = v;
-									} else if (dock[j]->pending == v) {
+			const ProximityIndex<Vessel> &vidx = g_psys->VesselIndex();
+			double range = max (1.5 * (size + vidx.MaxSize()), size + vidx.MaxSize() + 1e3);
+			std::vector<Vessel*> vlist;
+			vidx.Within (s0->pos, range, vlist, this);
+			for (auto v : vlist) {
+				if (v->ndock && v->proxybody == proxybody) {
+					double dst = s0->pos.dist (v->GPos());
+
+					if ((dst < 1.5 * (size + v->Size()) || (dst < size + v->Size() + 1e3))) { // valid candidate
+						Vector dref, gref, vref;
+						for (j = 0; j < ndock; j++) { // loop over my own docks
+							if (dock[j]->mate) continue; // dock already busy
+							if (dockmode == 0) { // legacy docking mode
+								if (dotp (s0->vel - v->GVel(), mul (s0->R, dock[j]->dir)) < -0.01) continue; // moving away from dock
+								for (k = 0; k < v->ndock; k++) { // loop over other vessel's docks
+									if (v->dock[k]->mate) continue; // dock already busy
+									dref.Set (tmul (v->GRot(), mul (s0->R, dock[j]->ref) + s0->pos - v->GPos()));
+									double d = dref.dist (v->dock[k]->ref);
+									if (d < MIN_DOCK_DIST) {
 										if (dock[j]->autodock && v->dock[k]->autodock)
 											Dock (v, j, k);
 									}
 								}
+							} else { // new docking mode
+								for (k = 0; k < v->ndock; k++) { // loop over other vessel's docks
+									if (v->dock[k]->mate) continue; // dock already busy
+									gref.Set (mul (s0->R, dock[j]->ref) + s0->pos);            // my dock in global frame
+									vref.Set (mul (v->GRot(), v->dock[k]->ref) + v->GPos()); // target dock in global frame
+									//dref.Set (tmul (v->GRot(), mul (*grot, dock[j]->ref) + *gpos - v->GPos())); // my dock in the target's frame
+									double d = gref.dist(vref); //dref.dist (v->dock[k]->ref);
+									if (d < MIN_DOCK_DIST) {
+										if (dotp (s0->vel - v->GVel(), vref-gref) >= 0) { // on approach
+											dock[j]->pending = v;
+										} else if (dock[j]->pending == v) {
+											if (dock[j]->autodock && v->dock[k]->autodock)
+												Dock (v, j, k);
+										}
+									}
+								}
 							}
 						}
-					}
-					// update information about closest dock in range of our dock 0
-					if (closedock.vessel && closedock.vessel->ndock && closedock.dock < closedock.vessel->ndock) {
-						dref.Set (tmul (closedock.vessel->GRot(), mul (s0->R, dock[0]->ref) + s0->pos - closedock.vessel->GPos()));
-						closedock.dist = dref.dist (closedock.vessel->dock[closedock.dock]->ref);
-					} else {
-						closedock.dist = 1e50;
-					}
-					for (k = 0; k < v->ndock; k++) {
-						if (v->dock[k]->mate) continue;
-						dref.Set (tmul (v->GRot(), mul (s0->R, dock[0]->ref) + s0->pos - v->GPos()));
-						double d = dref.dist (v->dock[k]->ref);
-						if (d < closedock.dist) {
-							closedock.dist = d;
-							closedock.vessel = v;
-							closedock.dock = k;
+						// update information about closest dock in range of our dock 0
+						if (closedock.vessel && closedock.vessel->ndock && closedock.dock < closedock.vessel->ndock) {
+							dref.Set (tmul (closedock.vessel->GRot(), mul (s0->R, dock[0]->ref) + s0->pos - closedock.vessel->GPos()));
+							closedock.dist = dref.dist (closedock.vessel->dock[closedock.dock]->ref);
+						} else {
+							closedock.dist = 1e50;
+						}
+						for (k = 0; k < v->ndock; k++) {
+							if (v->dock[k]->mate) continue;
+							dref.Set (tmul (v->GRot(), mul (s0->R, dock[0]->ref) + s0->pos - v->GPos()));
+							double d = dref.dist (v->dock[k]->ref);
+							if (d < closedock.dist) {
+								closedock.dist = d;
+								closedock.vessel = v;
+								closedock.dock = k;
+							}
 						}
 					}
 				}
@@ -5081,6 +5167,8 @@ void Vessel::Timejump (double dt, int mode)
 	if (supervessel && supervessel->GetVessel(0) != this) return;
 	// let the supervessel deal with the jump
 
+	EndRails();
+
 	if (fstatus == FLIGHTSTATUS_FREEFLIGHT) {
 
 		el->Calculate (cpos, cvel, td.SimT0);
@@ -5197,19 +5285,8 @@ void Vessel::UpdateProxies ()
 {
 	VesselBase::UpdateProxies ();
 
-	int i;
-	double dist2, proxydist2;
-
 	// check for closest vessel
-	proxyvessel = 0;
-	for (i = g_psys->nVessel()-1, proxydist2 = 1e100; i >= 0; i--) {
-		Vessel *vessel = g_psys->GetVessel(i);
-		if (vessel == this) continue;
-		if ((dist2 = s0->pos.dist2 (vessel->GPos())) < proxydist2) {
-			proxydist2 = dist2;
-			proxyvessel = vessel;
-		}
-	}
+	proxyvessel = g_psys->VesselIndex().Nearest (s0->pos, this);
 }
 
 void Vessel::UpdateReceiverStatus (DWORD idx)
@@ -5218,19 +5295,13 @@ void Vessel::UpdateReceiverStatus (DWORD idx)
 
 	int i, j;
 	DWORD m, n, n0, n1, nn, r0, r1, rm, step;
-	double dist2, sig;
+	double sig;
 
-	static DWORD nscan = 1;
-	static double *navsig = new double[nscan];
-	if (nnav > nscan) {
-		delete []navsig;
-		navsig = new double[nscan = nnav]; TRACENEW
-	}
 	if (idx < nnav) n0 = idx, n1 = idx + 1;
 	else            n0 = 0, n1 = nnav;
 
 	for (n = n0; n < n1; n++) {
-		navsig[n] = 0.0;
+		nav[n].sig = 0.0;
 		nav[n].sender = NULL;
 	}
 
@@ -5250,8 +5321,8 @@ void Vessel::UpdateReceiverStatus (DWORD idx)
 			} else r0 = nav[n].dbidx;
 			for (; r0 < nn && nlist[r0]->GetStep() == step; r0++) {
 				sig = nlist[r0]->FieldStrength (s0->pos);
-				if (sig > 0.9 && sig > navsig[n]) {
-					navsig[n] = sig;
+				if (sig > 0.9 && sig > nav[n].sig) {
+					nav[n].sig = sig;
 					nav[n].sender = nlist[r0]; break;
 				}
 			}
@@ -5267,8 +5338,8 @@ void Vessel::UpdateReceiverStatus (DWORD idx)
 				for (m = n0; m < n1; m++) {
 					if (navsend->GetStep() == nav[m].step) { // && navsend->InRange (*gpos))
 						sig = navsend->FieldStrength (s0->pos);
-						if (sig > 0.9 && sig > navsig[m]) {
-							navsig[m] = sig;
+						if (sig > 0.9 && sig > nav[m].sig) {
+							nav[m].sig = sig;
 							nav[m].sender = navsend;
 						}
 					}
@@ -5278,34 +5349,33 @@ void Vessel::UpdateReceiverStatus (DWORD idx)
 	}
 
 	// scan for vessel-mounted XPDR and IDS transmitters
-	for (i = g_psys->nVessel()-1; i >= 0; i--) {
-		Vessel *vessel = g_psys->GetVessel(i);
-		if (vessel == this) continue;
-		if ((dist2 = s0->pos.dist2 (vessel->GPos())) < 1e12) { // max XPDR range 1000 km
-
-			for (n = n0; n < n1; n++) {
-				if (vessel->xpdr && vessel->xpdr->GetStep() == nav[n].step) {
-					sig = vessel->xpdr->FieldStrength (s0->pos);
-					if (sig > 0.9 && sig > navsig[n]) {
-						navsig[n] =  sig;
-						nav[n].sender = vessel->xpdr;
-					}
+	std::vector<Vessel*> vlist;
+	g_psys->VesselIndex().Within (s0->pos, 1e6, vlist, this); // max XPDR range 1000 km
+	for (i = (int)vlist.size()-1; i >= 0; i--) {
+		Vessel *vessel = vlist[i];
+
+		for (n = n0; n < n1; n++) {
+			if (vessel->xpdr && vessel->xpdr->GetStep() == nav[n].step) {
+				sig = vessel->xpdr->FieldStrength (s0->pos);
+				if (sig > 0.9 && sig > nav[n].sig) {
+					nav[n].sig =  sig;
+					nav[n].sender = vessel->xpdr;
 				}
 			}
+		}
 
-			if (dist2 < 1e10) { // max IDS range 100 km
-				for (j = (int)vessel->nDock()-1; j >= 0; j--) {
-					const PortSpec *ps = vessel->GetDockParams (j);
-					if (ps->ids) {
-						for (n = n0; n < n1; n++)
-							if (ps->ids->GetStep() == nav[n].step) {
-								sig = ps->ids->FieldStrength (s0->pos);
-								if (sig > 0.9 && sig > navsig[n]) {
-									navsig[n] = sig;
-									nav[n].sender = ps->ids;
-								}
+		if (s0->pos.dist2 (vessel->GPos()) < 1e10) { // max IDS range 100 km
+			for (j = (int)vessel->nDock()-1; j >= 0; j--) {
+				const PortSpec *ps = vessel->GetDockParams (j);
+				if (ps->ids) {
+					for (n = n0; n < n1; n++)
+						if (ps->ids->GetStep() == nav[n].step) {
+							sig = ps->ids->FieldStrength (s0->pos);
+							if (sig > 0.9 && sig > nav[n].sig) {
+								nav[n].sig = sig;
+								nav[n].sender = ps->ids;
 							}
-					}
+						}
 				}
 			}
 		}
@@ -5313,8 +5383,8 @@ void Vessel::UpdateReceiverStatus (DWORD idx)
 
 	// if the signal strength is right at the edge, drop it intermittently
 	for (n = n0; n < n1; n++) {
-		if (navsig[n] < 1.1) {
-			double p = (navsig[n] - 0.9) / 0.2; // signal probability: linear from strength 0.9 to 1.1
+		if (nav[n].sig < 1.1) {
+			double p = (nav[n].sig - 0.9) / 0.2; // signal probability: linear from strength 0.9 to 1.1
 			if (rand1() > p)
 				nav[n].sender = NULL; // drop signal
 		}
@@ -7019,6 +7089,25 @@ double VESSEL::GetGravityGradientDamping () const
 	return vessel->GetGravityGradientDamping ();
 }
 
+void VESSEL::SetPropagatorTolerance (double tol) const
+{
+	vessel->SetPropTolerance (tol);
+}
+
+double VESSEL::GetPropagatorTolerance () const
+{
+	return vessel->PropTolerance ();
+}
+
+bool VESSEL::GetIntermediateState (double simt, VECTOR3 &pos, VECTOR3 &vel) const
+{
+	Vector p, v;
+	if (!vessel->DenseState (simt, p, v)) return false;
+	pos = MakeVECTOR3 (p);
+	vel = MakeVECTOR3 (v);
+	return true;
+}
+
 void VESSEL::SetISP (double isp) const
 {
 	vessel->m_defaultIsp = isp;
@@ -8741,6 +8830,11 @@ bool VESSEL::OrbitStabilised () const
 	return vessel->isOrbitStabilised();
 }
 
+bool VESSEL::OnRails () const
+{
+	return vessel->OnRails();
+}
+
 bool VESSEL::NonsphericalGravityEnabled () const
 {
 	return vessel->bGPerturb;
@@ -23,8 +23,10 @@
 
 #include <array>
 #include <fstream>
+#include <vector>
 
 #include "Vesselbase.h"
+#include "FRecStream.h"
 #include "Log.h"
 
 class Elements;
@@ -159,6 +161,7 @@ typedef struct {      // nav radio definition
 	DWORD step;             // discrete frequency setting (freq = MinFreq + step * 0.05MHz)
 	int dbidx;              // index into NAV data base for current proxybody and frequency
 	const Nav *sender;      // incoming transmitter signal
+	double sig;             // field strength of the current sender
 } NavRadioSpec;
 
 typedef struct {      // reentry texture definition
@@ -1128,6 +1131,25 @@ public:
 	// Keyboard handler for buffered keys
 
 	void Update (bool force = false);
+
+	bool BeginFreeflightUpdate (bool force = false);
+	// If the vessel is in free flight and far enough from the surface of
+	// its proximity body that no ground contact forces can act during the
+	// current step, prepare the dynamic state update and return true.
+	// The state must then be propagated with FreeflightUpdate before
+	// Update is called, which will skip the dynamic update.
+
+	void FreeflightUpdate ();
+	// Propagate the state of a vessel prepared with BeginFreeflightUpdate.
+	// Only modifies the vessel's own state, so it can be called for
+	// different vessels concurrently.
+
+	bool UpdateRailsMode ();
+	// Check if a free-flying vessel can be propagated analytically along its
+	// 2-body orbit: no active forces, not in focus or near the camera or other
+	// vessels, reference body dominant, and periapsis clear of the atmosphere.
+	// Switches the vessel on or off rails accordingly and returns the result.
+
 	void UpdatePassive ();
 	void UpdateAttachments();
 	void UpdateBodyForces ();
@@ -1640,7 +1662,6 @@ private:
 	Base    *landtgt;         // landing target (base)
 	int   lstatus;            // landing/docking comms status (0=no contact, 1=contact,
 	DWORD nport;              // allocated landing pad/docking port no (>=0, (DWORD)-1=none)
-	UINT  scanvessel;         // next vessel to check for docking event
 
 	mutable bool surfprm_valid;
 	bool pyp_valid;
@@ -1654,6 +1675,11 @@ private:
 	DWORD ntouchdown_vtx;    // number of touchdown vertices
 	DWORD next_hullvtx;      // used by hull vertex iterator
 
+	mutable struct TouchdownWork { // per-vessel scratch buffers for AddSurfaceForces
+		std::vector<int> tidx;     // indices of touchdown points in contact
+		std::vector<double> tdy, fn, flng, flat; // penetration depth and force components
+	} tdwork;
+
 	Vector campos;             // internal camera position (cockpit mode);
 	Vector camdir0;            // internal default camera direction (cockpit mode)
 	double camtilt0;           // internal default camera rotation around default direction (cockpit mode)
@@ -1706,6 +1732,7 @@ private:
 		WORD vismode;      // visibility mode: 1=external only, 2=internal only, 3=both
 	} **meshlist;
 	UINT nmesh;        // number of meshes
+	std::vector<MESHHANDLE> classmesh; // global meshes referenced by the class config (released on destruction)
 	DWORD_PTR mesh_crc;    // visual state checksum
 
 	UINT exhaust_id;   // next exhaust id to attach
@@ -1736,6 +1763,10 @@ private:
 	bool bFRplayback;
 	// True if vessel is currently played back
 
+	bool bFreeflightPending;
+	// True if the dynamic state update for the current step has already been
+	// done by FreeflightUpdate
+
 	bool bFRrecord;
 	// True if vessel is currently recording is flight data
 
@@ -1745,6 +1776,9 @@ private:
 	char *FRfname;
 	// flight record file name
 
+	FRecOStream FRpos_ostream, FRatt_ostream, FRatc_ostream;
+	// buffered output streams for recording (position, attitude, articulation)
+
 	FRecord *frec;
 	int nfrec;
 	int cfrec;
@@ -1755,6 +1789,22 @@ private:
 	int cfrec_att;
 	// Playback attitude sample list
 
+	FRecMappedStream *FRpos_map, *FRatt_map;
+	// Memory-mapped playback streams (position, attitude), used instead of
+	// the sample lists if mapped playback is enabled
+
+	std::vector<FRecord> frec_seg;
+	std::vector<FRecord_att> frec_att_seg;
+	// Header state (reference, frame) for each header segment of the mapped streams
+
+	FRecord frec_buf[2];
+	FRecord_att frec_att_buf[2];
+	int frec_buf_idx[2], frec_att_buf_idx[2];
+	// Most recently decoded mapped samples and their indices
+
+	double frec_tend, frec_att_tend;
+	// Time of the last position and attitude playback samples
+
 	double frec_last_syst;
 	double frec_att_last_syst;
 	// system time for last sample output (pos, att)
@@ -1787,6 +1837,15 @@ private:
 	void FRecorder_Play ();
 	// set vessel status from playback sample list
 
+	const FRecord &FRecorder_Pos (int i);
+	const FRecord_att &FRecorder_Att (int i);
+	// Playback sample i, from the sample list or the mapped stream
+
+	int FRecorder_SeekPos (int cur, double t);
+	int FRecorder_SeekAtt (int cur, double t);
+	// Index of the playback sample interval containing time t, starting
+	// the search from the current interval cur. Works in both directions.
+
 	void FRecorder_PlayEvent ();
 
 	void FRecorder_CheckEnd ();
@@ -397,6 +397,14 @@ void VesselBase::SetPropagator (int &plevel, int &nstep) const
 	collision_during_update = false; // reset collision check
 }
 
+// ==============================================================
+
+bool VesselBase::UseAdaptivePropagator (int plevel) const
+{
+	// collision treatment relies on fixed substeps
+	return !bSurfaceContact && RigidBody::UseAdaptivePropagator (plevel);
+}
+
 // =======================================================================
 
 bool VesselBase::ValidateStateUpdate (StateVectors *s)
@@ -174,6 +174,9 @@ protected:
 	virtual void SetPropagator (int &plevel, int &nstep) const;
 	// set timestep propagator parameters; overrides defaults during ground contact
 
+	virtual bool UseAdaptivePropagator (int plevel) const;
+	// the adaptive propagator is disabled during ground contact
+
 	virtual bool ValidateStateUpdate (StateVectors *s);
 
 	virtual bool AddSurfaceForces (Vector *F, Vector *M,
@@ -0,0 +1,93 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// Implementation of class WorkerPool
+
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool (int nthread)
+: job(0), generation(0), nbusy(0), bTerminate(false)
+{
+	block.reset (new Block[nthread+1]);
+	for (int i = 0; i <= nthread; i++)
+		block[i].next = block[i].end = 0;
+	for (int i = 0; i < nthread; i++)
+		worker.emplace_back (&WorkerPool::ThreadProc, this, i+1);
+}
+
+// ==============================================================
+
+WorkerPool::~WorkerPool ()
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		bTerminate = true;
+	}
+	cv_start.notify_all();
+	for (auto &t : worker)
+		t.join();
+}
+
+// ==============================================================
+
+void WorkerPool::ParallelFor (size_t n, const std::function<void(size_t)> &func)
+{
+	if (!n) return;
+	if (worker.empty() || n == 1) {
+		for (size_t i = 0; i < n; i++) func(i);
+		return;
+	}
+
+	size_t nblock = worker.size()+1;
+	for (size_t i = 0; i < nblock; i++) {
+		block[i].next = n*i/nblock;
+		block[i].end  = n*(i+1)/nblock;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		job = &func;
+		nbusy = nThread();
+		generation++;
+	}
+	cv_start.notify_all();
+
+	RunBlocks (0);
+
+	std::unique_lock<std::mutex> lock(mtx);
+	cv_done.wait (lock, [this]{ return nbusy == 0; });
+	job = 0;
+}
+
+// ==============================================================
+
+void WorkerPool::ThreadProc (int idx)
+{
+	unsigned int gen = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			cv_start.wait (lock, [&]{ return bTerminate || generation != gen; });
+			if (bTerminate) return;
+			gen = generation;
+		}
+		RunBlocks (idx);
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			if (--nbusy == 0) cv_done.notify_one();
+		}
+	}
+}
+
+// ==============================================================
+
+void WorkerPool::RunBlocks (int idx)
+{
+	// work through our own block first, then steal from the others
+	size_t nblock = worker.size()+1;
+	for (size_t k = 0; k < nblock; k++) {
+		Block &b = block[(idx+k) % nblock];
+		size_t i;
+		while ((i = b.next.fetch_add(1)) < b.end)
+			(*job)(i);
+	}
+}
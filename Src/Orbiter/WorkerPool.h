@@ -0,0 +1,54 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// Pool of worker threads for distributing loops over independent objects
+
+#ifndef __WORKERPOOL_H
+#define __WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool {
+public:
+	WorkerPool (int nthread);
+	// Create a pool with nthread worker threads. The calling thread
+	// participates in each loop in addition to the workers.
+
+	~WorkerPool ();
+
+	inline int nThread () const { return (int)worker.size(); }
+
+	void ParallelFor (size_t n, const std::function<void(size_t)> &func);
+	// Call func(i) for i = 0..n-1, distributed over the worker threads and
+	// the calling thread. Each thread starts on its own contiguous block of
+	// indices and steals from the blocks of the other threads once its own
+	// block is exhausted. Returns when all calls have completed.
+	// The order in which the calls are made is undefined, so func must not
+	// depend on the results of other calls in the same loop.
+
+private:
+	struct Block {
+		std::atomic<size_t> next; // next unclaimed index
+		size_t end;               // one past the last index of the block
+	};
+
+	void ThreadProc (int idx);
+	void RunBlocks (int idx);
+
+	std::vector<std::thread> worker;
+	std::unique_ptr<Block[]> block;  // one block per thread (caller + workers)
+	const std::function<void(size_t)> *job; // current loop body
+	std::mutex mtx;
+	std::condition_variable cv_start, cv_done;
+	unsigned int generation;         // incremented for each ParallelFor call
+	int nbusy;                       // workers still processing the current loop
+	bool bTerminate;
+};
+
+#endif // !__WORKERPOOL_H
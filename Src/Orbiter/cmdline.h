@@ -74,6 +74,8 @@ namespace orbiter {
 			KEY_MAXSYSTIME,
 			KEY_MAXSIMTIME,
 			KEY_FRAMECOUNT,
+			KEY_UPDATETHREADS,
+			KEY_ONRAILS,
 			KEY_PLUGIN
 		};
 
@@ -5,6 +5,7 @@
 #include "Celbody.h"
 #include "Planet.h"
 #include "Orbiter.h"
+#include "Log.h"
 #include <filesystem>
 
 using std::min;
@@ -14,6 +15,11 @@ static int elev_grid = 256;
 static int elev_stride = elev_grid+3;
 static int MAXLVL_LIMIT = SURF_MAX_PATCHLEVEL2 - 7;
 
+// Tiles are decoded on the prefetch thread and on the vessel update threads.
+// The graphics client's elevation filter is not required to be reentrant, so
+// calls to it are serialised across all bodies.
+static std::mutex filterMutex;
+
 extern Orbiter *g_pOrbiter;
 extern TimeData td;
 extern char DBG_MSG[256];
@@ -35,10 +41,26 @@ struct ELEVFILEHEADER { // file header for patch elevation data file
 
 #pragma pack(pop)
 
+// Inflate a tile from a tree archive into a buffer owned by the calling
+// thread. The data remain valid until the next call on the same thread.
+static const BYTE *ReadTreeTile (const ZTreeMgr *mgr, int lvl, int ilat, int ilng, DWORD &ndata)
+{
+	static thread_local std::vector<BYTE> buf;
+	ndata = 0;
+	DWORD idx = (ilat < 0 || ilng < 0 ? (DWORD)-1 : mgr->Idx (lvl, ilat, ilng));
+	if (idx == (DWORD)-1) return 0;
+	DWORD size = mgr->NodeSizeInflated (idx);
+	if (!size) return 0;
+	if (buf.size() < size) buf.resize (size);
+	ndata = mgr->ReadData (idx, buf.data(), size);
+	return buf.data();
+}
+
 ElevationManager::ElevationManager (const CelestialBody *_cbody)
-: cbody(_cbody)
+: cbody(_cbody), nviewhit(0), ncachehit(0), nload(0), nprefetch(0)
 {
 	mode = g_pOrbiter->Cfg()->CfgVisualPrm.ElevMode;
+	TileCache().SetMaxSize ((size_t)g_pOrbiter->Cfg()->CfgPRenderPrm.ElevCacheSize << 20);
 	tilesource = g_pOrbiter->Cfg()->CfgPRenderPrm.TileLoadFlags;
 	maxlvl = MAXLVL_LIMIT;
 	elev_res = 1.0;
@@ -68,10 +90,21 @@ ElevationManager::ElevationManager (const CelestialBody *_cbody)
 	g_pOrbiter->Cfg()->PTexPath(path, fname);
 	auto y = std::filesystem::status(path);
 	bModExists = std::filesystem::is_directory(y);
+
+	prefetch_t = (mode ? g_pOrbiter->Cfg()->CfgPRenderPrm.ElevPrefetchTime : 0.0);
+	if (prefetch_t > 0.0)
+		Prefetcher().Attach (cbody, [this](int lvl, int ilat, int ilng) { PrefetchTile (lvl, ilat, ilng); });
 }
 
 ElevationManager::~ElevationManager ()
 {
+	if (prefetch_t > 0.0)
+		Prefetcher().Detach (cbody);
+	if (nload || nprefetch) {
+		LOGOUT_FINE("Elevation tiles [%s]: %d local hits, %d shared cache hits, %d loads, %d prefetched", cbody->Name(),
+			(int)nviewhit, (int)ncachehit, (int)nload, (int)nprefetch);
+	}
+	TileCache().Remove (cbody);
 	if (local_cache) delete local_cache;
 	for (int i = 0; i < 2; i++)
 		if (treeMgr[i])
@@ -102,6 +135,112 @@ bool ElevationManager::TileIdx (double lat, double lng, int lvl, int *ilat, int
 	return true;
 }
 
+ElevTileCache &ElevationManager::TileCache ()
+{
+	static ElevTileCache cache(64 << 20);
+	return cache;
+}
+
+ElevPrefetcher &ElevationManager::Prefetcher ()
+{
+	static ElevPrefetcher prefetcher;
+	return prefetcher;
+}
+
+ElevTileCache::TilePtr ElevationManager::GetElevationTile (int lvl, int ilat, int ilng, bool prefetch) const
+{
+	ElevTileKey key = {cbody, lvl, ilat, ilng};
+	ElevTileCache::TilePtr tile = (prefetch ? TileCache().Peek (key) : TileCache().Find (key));
+	if (tile) {
+		if (!prefetch) ncachehit++;
+		return tile;
+	}
+
+	// Not cached: decode the tile. Tiles that don't exist are cached as well.
+	// If another thread is decoding the same tile, wait for it instead.
+	{
+		std::unique_lock<std::mutex> lock(loadMutex);
+		loadDone.wait (lock, [this, &key]{ return !loading.count (key); });
+		tile = TileCache().Peek (key);
+		if (tile) {
+			if (!prefetch) ncachehit++;
+			return tile;
+		}
+		loading.insert (key);
+	}
+	std::shared_ptr<ElevTileData> t = std::make_shared<ElevTileData>();
+	t->elev.reset (LoadElevationTile (lvl+4, ilat, ilng, elev_res));
+	if (t->elev) {
+		LoadElevationTile_mod (lvl+4, ilat, ilng, elev_res, t->elev.get()); // load modifications
+		int nlat = 1 << lvl;
+		int nlng = 2 << lvl;
+		t->ndat = elev_stride*elev_stride;
+		t->latmin = (0.5-(double)(ilat+1)/double(nlat))*Pi;
+		t->latmax = (0.5-(double)ilat/double(nlat))*Pi;
+		t->lngmin = (double)ilng/(double)nlng*Pi2 - Pi;
+		t->lngmax = (double)(ilng+1)/(double)nlng*Pi2 - Pi;
+
+		if (lvl < maxlvl) {
+			// Check if higher lvl data exists for any of the quadrants, 
+			// set flag bit to mark it dirty (un-usable)
+			int qlat = ilat * 2, qlng = ilng * 2, qlvl = lvl + 1;
+			t->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 0, qlng + 0)) << 0; // NW
+			t->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 0, qlng + 1)) << 1;	// NE
+			t->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 1, qlng + 0)) << 2; // SW
+			t->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 1, qlng + 1)) << 3;	// SE
+		}
+
+		auto gc = g_pOrbiter->GetGraphicsClient();
+		if (gc) {
+			std::lock_guard<std::mutex> lock(filterMutex);
+			gc->clbkFilterElevation((OBJHANDLE)cbody, ilat, ilng, lvl, elev_res, t->elev.get());
+		}
+	}
+	if (prefetch) nprefetch++;
+	else nload++;
+	tile = TileCache().Insert (key, t);
+	{
+		std::lock_guard<std::mutex> lock(loadMutex);
+		loading.erase (key);
+	}
+	loadDone.notify_all();
+	return tile;
+}
+
+void ElevationManager::PrefetchTile (int lvl, int ilat, int ilng) const
+{
+	// same level fallback as in Elevation
+	for (; lvl >= 0; lvl--, ilat >>= 1, ilng >>= 1)
+		if (GetElevationTile (lvl, ilat, ilng, true)->elev) break;
+}
+
+void ElevationManager::Prefetch (double lat, double lng, double vlat, double vlng, int reqlvl) const
+{
+	static const int MAXSAMPLE = 16;
+	if (prefetch_t <= 0.0) return;
+	reqlvl = (reqlvl ? min (max(0,reqlvl-7), maxlvl) : maxlvl);
+
+	// sample the track at least twice per tile crossed
+	int nlat = 1 << reqlvl;
+	double ncross = prefetch_t * max (fabs(vlat), fabs(vlng)) * nlat/Pi;
+	int nsample = max (1, min (MAXSAMPLE, (int)ceil (2.0*ncross)));
+	double dt = prefetch_t/nsample;
+
+	int ilat, ilng, ilat0 = -1, ilng0 = -1;
+	for (int i = 1; i <= nsample; i++) {
+		double plat = lat + vlat*i*dt;
+		if (plat >= Pi05 || plat <= -Pi05) break; // don't follow the track across the poles
+		double plng = fmod (lng + vlng*i*dt + Pi, Pi2);
+		if (plng < 0.0) plng += Pi2;
+		TileIdx (plat, plng - Pi, reqlvl, &ilat, &ilng);
+		if (ilat == ilat0 && ilng == ilng0) continue;
+		ilat0 = ilat, ilng0 = ilng;
+		ElevTileKey key = {cbody, reqlvl, ilat, ilng};
+		if (!TileCache().Peek (key))
+			Prefetcher().Request (key);
+	}
+}
+
 bool ElevationManager::HasElevationTile(int lvl, int ilat, int ilng) const
 {
 	if (mode) {
@@ -162,12 +301,12 @@ INT16 *ElevationManager::LoadElevationTile (int lvl, int ilat, int ilng, double
 			}
 		}
 		if (!elev && treeMgr[0]) {
-			BYTE *buf;
-			DWORD ndata = treeMgr[0]->ReadData(lvl, ilat, ilng, &buf);
+			DWORD ndata;
+			const BYTE *buf = ReadTreeTile (treeMgr[0], lvl, ilat, ilng, ndata);
 			if (ndata) {
-				BYTE *p = buf;
+				const BYTE *p = buf;
 				elev = new INT16[ndat];
-				ELEVFILEHEADER *phdr = (ELEVFILEHEADER*)p;
+				const ELEVFILEHEADER *phdr = (const ELEVFILEHEADER*)p;
 				p += phdr->hdrsize;
 				scale  = phdr->scale;
 				offset = phdr->offset;
@@ -184,7 +323,6 @@ INT16 *ElevationManager::LoadElevationTile (int lvl, int ilat, int ilng, double
 					p += ndat*sizeof(INT16);
 					break;
 				}
-				treeMgr[0]->ReleaseData(buf);
 			}
 		}
 		if (elev) {
@@ -263,11 +401,11 @@ bool ElevationManager::LoadElevationTile_mod (int lvl, int ilat, int ilng, doubl
 			}
 		}
 		if (treeMgr[1]) {
-			BYTE *buf;
-			DWORD ndata = treeMgr[1]->ReadData(lvl, ilat, ilng, &buf);
+			DWORD ndata;
+			const BYTE *buf = ReadTreeTile (treeMgr[1], lvl, ilat, ilng, ndata);
 			if (ndata) {
-				BYTE *p = buf;
-				ELEVFILEHEADER *phdr = (ELEVFILEHEADER*)p;
+				const BYTE *p = buf;
+				const ELEVFILEHEADER *phdr = (const ELEVFILEHEADER*)p;
 				p += phdr->hdrsize;
 				INT16 ofs = (INT16)phdr->offset;
 				rescale = (do_rescale = (phdr->scale != tgt_res)) ? phdr->scale/tgt_res : 1.0;
@@ -287,7 +425,7 @@ bool ElevationManager::LoadElevationTile_mod (int lvl, int ilat, int ilng, doubl
 					} break;
 				case -16: {
 					const INT16 mask = SHRT_MAX;
-					INT16 *buf16 = (INT16*)p;
+					const INT16 *buf16 = (const INT16*)p;
 					for (i = 0; i < ndat; i++) {
 						if (buf16[i] != mask) {
 							elev[i] = (do_rescale ? (INT16)(buf16[i]*rescale) : buf16[i]);
@@ -296,7 +434,6 @@ bool ElevationManager::LoadElevationTile_mod (int lvl, int ilat, int ilng, doubl
 					}
 					} break;
 				}
-				treeMgr[1]->ReleaseData(buf);
 				return true;
 			}
 		}
@@ -356,10 +493,11 @@ double ElevationManager::Elevation (double lat, double lng, int reqlvl, std::vec
 				}
 				//oapiWriteLogV("CacheHit idx=%d, lvl=%d, f=0x%X, q=%d, ilat=%d, ilng=%d", i, tile[i].lvl, tile[i].quadrants, q, tile[i].ilat, tile[i].ilng);
 				t = tile + i;
+				nviewhit++;
 				break;
 			}
 		}
-		if (!t) { // correct tile not in list - need to load from file
+		if (!t) { // correct tile not in list - get it from the shared cache
 			t = tile;  // find oldest tile
 			for (i = 1; i < ntile; i++) 
 				if (tile[i].last_access < t->last_access)
@@ -369,39 +507,20 @@ double ElevationManager::Elevation (double lat, double lng, int reqlvl, std::vec
 
 			for (lvl = reqlvl; lvl >= 0; lvl--) {
 				TileIdx (lat, lng, lvl, &ilat, &ilng);
-				t->data = LoadElevationTile (lvl+4, ilat, ilng, elev_res);
-				if (t->data) {
-					LoadElevationTile_mod (lvl+4, ilat, ilng, elev_res, t->data); // load modifications
-					int nlat = 1 << lvl;
-					int nlng = 2 << lvl;
+				ElevTileCache::TilePtr ct = GetElevationTile (lvl, ilat, ilng);
+				if (ct->elev) {
+					t->tile = ct;
+					t->data = ct->elev.get();
 					t->mgr = this;
 					t->lvl = lvl;
 					t->ilat = ilat;
 					t->ilng = ilng;
 					t->tgtlvl = reqlvl;
-					t->latmin = (0.5-(double)(ilat+1)/double(nlat))*Pi;
-					t->latmax = (0.5-(double)ilat/double(nlat))*Pi;
-					t->lngmin = (double)ilng/(double)nlng*Pi2 - Pi;
-					t->lngmax = (double)(ilng+1)/(double)nlng*Pi2 - Pi;
-					t->quadrants = 0;
-
-					if (reqlvl > lvl) 
-					{
-						// Check if higher lvl data exists for any of the quadrants, 
-						// set flag bit to mark it dirty (un-usable)
-						int qlat = ilat * 2, qlng = ilng * 2, qlvl = lvl + 1;
-						t->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 0, qlng + 0)) << 0; // NW
-						t->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 0, qlng + 1)) << 1;	// NE
-						t->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 1, qlng + 0)) << 2; // SW
-						t->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 1, qlng + 1)) << 3;	// SE
-					}
-
-					//int q = Quadrant(lat, lng, lvl);
-					//oapiWriteLogV("LoadTile[0x%X]: lvl=%d, flags=0x%X, q=%d, i(%d, %d)", t, lvl, t->quadrants, q, ilng, ilat);
-
-					// still need to store emin and emax
-					auto gc = g_pOrbiter->GetGraphicsClient();
-					if (gc) gc->clbkFilterElevation((OBJHANDLE)cbody, ilat, ilng, lvl, elev_res, t->data);
+					t->latmin = ct->latmin;
+					t->latmax = ct->latmax;
+					t->lngmin = ct->lngmin;
+					t->lngmax = ct->lngmax;
+					t->quadrants = (reqlvl > lvl ? ct->quadrants : 0); // higher-level quadrants only matter below the target level
 					break;
 				}
 			}
@@ -409,12 +528,12 @@ double ElevationManager::Elevation (double lat, double lng, int reqlvl, std::vec
 		}
 
 		if (t->data) {
-			INT16 *elev_base = t->data+elev_stride+1; // strip padding
+			const INT16 *elev_base = t->data+elev_stride+1; // strip padding
 			double latidx = (lat-t->latmin) * elev_grid/(t->latmax-t->latmin);
 			double lngidx = (lng-t->lngmin) * elev_grid/(t->lngmax-t->lngmin);
 			int lat0 = (int)latidx;
 			int lng0 = (int)lngidx;
-			INT16 *eptr = elev_base + lat0*elev_stride + lng0;
+			const INT16 *eptr = elev_base + lat0*elev_stride + lng0;
 			if (mode == 1) { // linear interpolation
 				bool tri;
 				double w_lat = latidx-lat0;
@@ -7,19 +7,25 @@
 #include "windows.h"
 #include "vecmat.h"
 #include "ZTreeMgr.h"
+#include "ElevTileCache.h"
+#include "ElevPrefetch.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <unordered_set>
 #include <vector>
 
 class CelestialBody;
 
+// Entry of a per-caller tile list: a view onto a tile of the shared
+// ElevTileCache, with the caller's access state
 struct ElevationTile {
 	ElevationTile() { 
-		data = nullptr;
 		Clear();
 	}
-	~ElevationTile() { if (data) delete []data; }
 
 	void Clear() { 
-		if (data) delete[]data; 
+		tile.reset();
 		data = nullptr;
 		mgr = nullptr;
 		lvl = tgtlvl = 0;
@@ -34,7 +40,8 @@ struct ElevationTile {
 		nmlidx = 0;
 	}
 
-	INT16 *data;
+	ElevTileCache::TilePtr tile; // shared tile data
+	const INT16 *data;           // elevation grid of tile
 	int lvl, tgtlvl;
 	double latmin, latmax;
 	double lngmin, lngmax;
@@ -69,12 +76,35 @@ public:
 	void ElevationGrid (int ilat, int ilng, int lvl, int pilat, int pilng, int plvl, INT16 *pelev, float *elev, double *emean=0) const;
 	void ElevationGrid(int ilat, int ilng, int lvl, int pilat, int pilng, int plvl, INT16* pelev, INT16* elev, double* emean = 0) const;
 
+	void Prefetch (double lat, double lng, double vlat, double vlng, int reqlvl=0) const;
+	/**
+	* \brief Queue the elevation tiles along a predicted surface track for
+	*   loading by the background prefetch thread
+	* \param lat, lng current position [rad]
+	* \param vlat, vlng latitude and longitude rates [rad/s]
+	* \param reqlvl requested resolution level, as for Elevation
+	* \note The track is followed for the time set by ElevPrefetchTime in
+	*   Orbiter.cfg. Tiles already in the tile cache are skipped.
+	*/
+
+	static ElevTileCache &TileCache ();
+	// Process-wide cache of decoded elevation tiles. The per-caller tile lists
+	// passed to Elevation only hold references to tiles of this cache.
+
+	static ElevPrefetcher &Prefetcher ();
+	// Background loader for tiles requested by Prefetch
+
 protected:
 	int  Quadrant(double lat, double lng, int lvl) const;
 	bool TileIdx (double lat, double lng, int lvl, int *ilat, int *ilng) const;
 	INT16 *LoadElevationTile (int lvl, int ilat, int ilng, double tgt_res) const;
 	bool LoadElevationTile_mod (int lvl, int ilat, int ilng, double tgt_res, INT16 *elev) const;
 	bool HasElevationTile(int lvl, int ilat, int ilng) const;
+	ElevTileCache::TilePtr GetElevationTile (int lvl, int ilat, int ilng, bool prefetch=false) const;
+	// Return tile (lvl, ilat, ilng) from the shared cache, or load it into the cache.
+	// prefetch: called from the prefetch thread
+	void PrefetchTile (int lvl, int ilat, int ilng) const;
+	// Load tile (lvl, ilat, ilng), or its closest ancestor with elevation data
 
 private:
 	const CelestialBody *cbody;
@@ -85,6 +115,11 @@ private:
 	ZTreeMgr *treeMgr[5];
 	bool bDirExists, bModExists;
 	mutable std::vector<ElevationTile> *local_cache = nullptr;
+	double prefetch_t;     // prefetch look-ahead time [s] (0=no prefetching)
+	mutable std::mutex loadMutex; // protects loading
+	mutable std::condition_variable loadDone;
+	mutable std::unordered_set<ElevTileKey, ElevTileKeyHash> loading; // tiles being decoded
+	mutable std::atomic<size_t> nviewhit, ncachehit, nload, nprefetch; // tile access statistics
 };
 
 #endif // !__ELEVMGR_H
\ No newline at end of file
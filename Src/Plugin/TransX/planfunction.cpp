@@ -22,6 +22,8 @@
 #include <windows.h>
 #include <cstdio>
 #include <cmath>
+#include <algorithm>
+#include <vector>
 #include "orbitersdk.h"
 #include "mapfunction.h"
 #include "mfd.h"
@@ -619,6 +621,8 @@ bool majorejectplan::init(class MFDvarhandler *vars, class basefunction *base)
 	m_inheritvel=1;//MFDvariable capabilities not used in this class
 	m_outwardvel.init(vars,3,3,"Outward vel.", 0,-1e8,1e8,0.1,1000);
 	m_chplvel.init(vars,3,3,"Ch. plane vel.", 0, -1e8, 1e8, 0.1,1000);
+	m_search.init(vars,3,3,"Window search",0,2,"Off","Search","Apply","","");
+	m_searchspan.init(vars,3,3,"Search span",730,10,1e5,0.1,1000);
 
 	m_prograde.sethelpstrings(
 		"Positive to move outward from MAJ",
@@ -632,6 +636,12 @@ bool majorejectplan::init(class MFDvarhandler *vars, class basefunction *base)
 	m_chplvel.sethelpstrings(
 		"Adjust grey target plane intersect",
 		"line to coincide with intercept.");
+	m_search.sethelpstrings(
+		"Map transfers to the target. Apply",
+		"sets date and velocities of best.");
+	m_searchspan.sethelpstrings(
+		"Range of departure dates to search",
+		"in days from now.");
 	base->sethelp(
 		"Used to set direction at exit of",
 		"SOI to aim for another planet eg",
@@ -649,6 +659,196 @@ void majorejectplan::calcejectvector(const VECTOR3 &rminplane,const VECTOR3 &min
 	ejectvector=forward+outward+sideward; //=Eject vector in RMin frame
 }
 
+void majorejectplan::calculate(class MFDvarhandler *vars,basefunction *base)
+{
+	updatesearch(base);
+	majejectplan::calculate(vars,base);
+}
+
+void majorejectplan::updatesearch(basefunction *base)
+{
+	OBJHANDLE hmajor,hminor,htarget,hcraft,hbase;
+	base->gethandles(&hmajor,&hminor,&htarget,&hcraft,&hbase);
+	if (m_search==2) applysearch(base);
+	if (m_search!=1 || hminor==NULL || htarget==NULL)
+	{
+		search.Stop();
+		searchdep=searcharr=NULL;
+		return;
+	}
+	if (hminor!=searchdep || htarget!=searcharr || m_searchspan!=searchspan)
+		startsearch(base);
+}
+
+void majorejectplan::startsearch(basefunction *base)
+{
+	OBJHANDLE hmajor,hminor,htarget,hcraft,hbase;
+	base->gethandles(&hmajor,&hminor,&htarget,&hcraft,&hbase);
+	search.Stop();
+	searchdep=searcharr=NULL;
+	const OrbitElements &rmin=base->getminororbit();
+	const OrbitElements &target=base->gettargetorbit();
+	if (!rmin.isvalid() || !target.isvalid()) return;
+
+	VECTOR3 pos,vel;
+	rmin.getcurrentvectors(&pos,&vel);
+	double r1=length(pos);
+	target.getcurrentvectors(&pos,&vel);
+	double r2=length(pos);
+	double gm=rmin.getgmplanet();
+	TransferSearch::Grid grid=TransferSearch::DefaultGrid(oapiGetSimMJD(),m_searchspan,gm,r1,r2);
+	double depend=grid.dep0+(grid.ndep-1)*grid.ddep;
+	double arrend=depend+grid.tof0+(grid.ntof-1)*grid.dtof;
+	double dt=std::min(1.0,std::min(grid.ddep,grid.dtof));
+
+	// The body tables are sampled here, as the planet modules must not be
+	// called from the search threads. Bodies without an ephemeris follow
+	// their current orbit.
+	double simstart=oapiTime2MJD(0);
+	TransferSearch::Ephemeris dep,arr;
+	searchephem=TransferSearch::SampleBody(hminor,hmajor,grid.dep0,depend,dt,&dep,
+		[&rmin,simstart](double mjd,VECTOR3 *p,VECTOR3 *v){rmin.timetovectors((mjd-simstart)*SECONDS_PER_DAY-rmin.gettimestamp(),p,v);});
+	if (!TransferSearch::SampleBody(htarget,hmajor,grid.dep0+grid.tof0,arrend,dt,&arr,
+		[&target,simstart](double mjd,VECTOR3 *p,VECTOR3 *v){target.timetovectors((mjd-simstart)*SECONDS_PER_DAY-target.gettimestamp(),p,v);}))
+		searchephem=false;
+	search.Start(gm,grid,dep,arr);
+	searchdep=hminor;
+	searcharr=htarget;
+	searchspan=m_searchspan;
+}
+
+void majorejectplan::applysearch(basefunction *base)
+{
+	m_search=0;
+	TransferSearch::Solution best=search.Best();
+	const OrbitElements &rmin=base->getminororbit();
+	if (!best.valid || !rmin.isvalid()) return;
+
+	// Express the departure excess velocity in the axes of calcejectvector
+	VECTOR3 minorpos,minorvel;
+	rmin.timetovectors((best.dep-oapiTime2MJD(0))*SECONDS_PER_DAY-rmin.gettimestamp(),&minorpos,&minorvel);
+	VECTOR3 rminplane=rmin.getplanevector();
+	m_ejdate=best.dep;
+	m_prograde=dotp(best.vinfdep,unit(minorvel));
+	m_outwardvel=dotp(best.vinfdep,unit(crossp(minorvel,rminplane)));
+	m_chplvel=dotp(best.vinfdep,unit(rminplane));
+}
+
+static void drawcontourcell(oapi::Sketchpad *sketchpad, double level, const int *x, const int *y, const double *v)
+{//Marching squares on one cell. Corners are (x0,y0),(x1,y0),(x1,y1),(x0,y1)
+	int cx[4]={x[0],x[1],x[1],x[0]};
+	int cy[4]={y[0],y[0],y[1],y[1]};
+	int px[4],py[4],n=0;
+	for (int a=0;a<4;a++)
+	{
+		int b=(a+1)%4;
+		if ((v[a]<level)==(v[b]<level)) continue;
+		double f=(level-v[a])/(v[b]-v[a]);
+		px[n]=cx[a]+int(f*(cx[b]-cx[a]));
+		py[n]=cy[a]+int(f*(cy[b]-cy[a]));
+		n++;
+	}
+	for (int i=0;i+1<n;i+=2)
+	{
+		sketchpad->MoveTo(px[i],py[i]);
+		sketchpad->LineTo(px[i+1],py[i+1]);
+	}
+}
+
+bool majorejectplan::maingraph(oapi::Sketchpad *sketchpad,Graph *graph,basefunction *base)
+{
+	if (m_search!=1 || searchdep==NULL) return true;
+	const TransferSearch::Grid &grid=search.GetGrid();
+	DWORD xstart,ystart,xend,yend;
+	graph->getviewwindow(&xstart,&ystart,&xend,&yend);
+	int linespacing=(yend-ystart)/24;
+	int left=xstart+(xend-xstart)/16, right=xend-(xend-xstart)/16;
+	int top=ystart+6*linespacing, bottom=ystart+17*linespacing;
+
+	base->SelectDefaultPen(sketchpad,TransXFunction::Grey);
+	base->SelectBrush(sketchpad,TransXFunction::Hollow);
+	sketchpad->Rectangle(left,top,right,bottom);
+	TransferSearch::Solution best=search.Best();
+	if (!best.valid || grid.ndep<2 || grid.ntof<2) return false;
+
+	// Departure dates along x, times of flight along y. Rows are drawn as
+	// they complete, thinned out to one per two pixels.
+	std::vector<int> rows,rowx;
+	for (int i=0;i<grid.ndep;i++)
+	{
+		if (!search.RowDone(i)) continue;
+		int x=left+(right-left)*i/(grid.ndep-1);
+		if (!rowx.empty() && x-rowx.back()<2) continue;
+		rows.push_back(i);
+		rowx.push_back(x);
+	}
+	int tofstep=std::max(1,2*grid.ntof/(bottom-top+1));
+
+	// Contours of total excess velocity above the best transfer
+	const double level[]={250,500,1000,2000,4000};
+	const int pen[]={TransXFunction::Green,TransXFunction::Yellow,TransXFunction::Red,TransXFunction::Blue,TransXFunction::GreyDashed};
+	for (int k=0;k<5;k++)
+	{
+		base->SelectDefaultPen(sketchpad,pen[k]);
+		for (size_t c=1;c<rows.size();c++)
+		{
+			for (int j=tofstep;j<grid.ntof;j+=tofstep)
+			{
+				int x[2]={rowx[c-1],rowx[c]};
+				int y[2]={bottom-(bottom-top)*(j-tofstep)/(grid.ntof-1),bottom-(bottom-top)*j/(grid.ntof-1)};
+				double v[4]={search.Cost(rows[c-1],j-tofstep),search.Cost(rows[c],j-tofstep),search.Cost(rows[c],j),search.Cost(rows[c-1],j)};
+				for (int i=0;i<4;i++)
+					if (v[i]<0) v[i]=1e9;//No transfer
+				drawcontourcell(sketchpad,best.dv+level[k],x,y,v);
+			}
+		}
+	}
+
+	// Mark the best transfer
+	int xb=left+int((right-left)*(best.dep-grid.dep0)/(grid.ddep*(grid.ndep-1)));
+	int yb=bottom-int((bottom-top)*(best.tof-grid.tof0)/(grid.dtof*(grid.ntof-1)));
+	int size=linespacing/3+1;
+	base->SelectDefaultPen(sketchpad,TransXFunction::White);
+	sketchpad->MoveTo(xb-size,yb);
+	sketchpad->LineTo(xb+size+1,yb);
+	sketchpad->MoveTo(xb,yb-size);
+	sketchpad->LineTo(xb,yb+size+1);
+	return false;//Porkchop replaces the orbit graph
+}
+
+void majorejectplan::wordupdate(oapi::Sketchpad *sketchpad,int width, int height, basefunction *base)
+{
+	if (m_search!=1)
+	{
+		majejectplan::wordupdate(sketchpad,width,height,base);
+		return;
+	}
+	int linespacing=height/24;
+	char buffer[40];
+	int len;
+	if (searchdep==NULL)
+	{
+		len=sprintf(buffer,"Select a target to search");
+		sketchpad->Text(0,18*linespacing,buffer,len);
+		return;
+	}
+	const TransferSearch::Grid &grid=search.GetGrid();
+	len=sprintf(buffer,"Dep. MJD %.0f - %.0f",grid.dep0,grid.dep0+(grid.ndep-1)*grid.ddep);
+	sketchpad->Text(0,18*linespacing,buffer,len);
+	len=sprintf(buffer,"TOF %.0f - %.0f days",grid.tof0,grid.tof0+(grid.ntof-1)*grid.dtof);
+	sketchpad->Text(0,19*linespacing,buffer,len);
+	len=sprintf(buffer,"Searched %d%%%s",100*search.RowsDone()/grid.ndep,searchephem?"":" (approx.)");
+	sketchpad->Text(0,20*linespacing,buffer,len);
+
+	TransferSearch::Solution best=search.Best();
+	if (!best.valid) return;
+	len=sprintf(buffer,"Best MJD %.2f",best.dep);
+	sketchpad->Text(0,21*linespacing,buffer,len);
+	TextShow(sketchpad,"TOF (days):",0,22*linespacing,best.tof);
+	TextShow(sketchpad,"Dep. vinf:",0,23*linespacing,length(best.vinfdep));
+	TextShow(sketchpad,"Arr. vinf:",width/2,23*linespacing,length(best.vinfarr));
+}
+
 void slingejectplan::calcejectvector(const VECTOR3 &rminplane,const VECTOR3 &minorvel, double inheritedvelocity)
 {
 	VECTOR3 forward=unit(minorvel)*m_outwardangle.getcos()*m_incangle.getcos();
@@ -24,6 +24,7 @@
 #include "mfdvarhandler.h"
 #include "mfdvartypes.h"
 #include "orbitelements.h"
+#include "transfersearch.h"
 
 class basefunction;
 
@@ -99,9 +100,22 @@ class majorejectplan:public majejectplan
 {
 private:
 	MFDvarfloat m_prograde,m_outwardvel,m_chplvel;
+	MFDvardiscrete m_search;
+	MFDvarfloat m_searchspan;
+	TransferSearch search;//Transfer window search, runs on worker threads
+	OBJHANDLE searchdep,searcharr;//Bodies of the current search (NULL if none)
+	double searchspan;//Departure span of the current search
+	bool searchephem;//Search uses the planet modules' ephemerides
 	virtual bool init(class MFDvarhandler *vars, basefunction *base);
 	virtual void calcejectvector(const VECTOR3 &rminplane,const VECTOR3 &minorvel, double inheritedvelocity);
+	void updatesearch(basefunction *base);//Starts, stops or applies the window search
+	void startsearch(basefunction *base);
+	void applysearch(basefunction *base);//Sets eject date and velocities from the best transfer found
 public:
+	majorejectplan():searchdep(NULL),searcharr(NULL),searchspan(0),searchephem(false){};
+	virtual void calculate(class MFDvarhandler *vars,basefunction *base);
+	virtual bool maingraph(oapi::Sketchpad *sketchpad,Graph *graph,basefunction *base);
+	virtual void wordupdate(oapi::Sketchpad *sketchpad,int width, int height, basefunction *base);
 	virtual int getplanid(){return 2;};
 	virtual void getlabel(char *buffer){strcpy(buffer,"Plan:Eject");};
 	virtual void getviewname(char *buffer){strcpy(buffer,"View:Eject Plan");};
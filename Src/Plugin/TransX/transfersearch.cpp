@@ -0,0 +1,396 @@
+/* Copyright © 2007-9 Steve Arch, Duncan Sharpe
+** Copyright © 2011 atomicdryad - 'ENT' button & Pen allocation fix
+** Copyright © 2013 Dimitris Gatsoulis (dgatsoulis) - Hacks
+** Copyright © 2013 Szymon Ender (Enjo) - Auto-Min™, Auto-Center™ & other hacks
+**
+** X11 License ("MIT License")
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy
+** of this software and associated documentation files (the "Software"), to deal
+** in the Software without restriction, including without limitation the rights
+** to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+** copies of the Software, and to permit persons to whom the Software is
+** furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+** OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+** THE SOFTWARE.*/
+
+#include "transfersearch.h"
+#include "CelBodyAPI.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const double DAY = 86400.0;
+	const double ZMAX = 4.0*PI*PI;  // upper limit of z for single revolution transfers
+	const double ZMIN = -16.0*PI*PI; // lower limit (fast hyperbolic transfers)
+
+	// Stumpff functions C(z) and S(z)
+	inline void stumpff(double z, double *c, double *s)
+	{
+		if (z > 1e-3)
+		{
+			double sz = sqrt(z);
+			*c = (1.0 - cos(sz))/z;
+			*s = (sz - sin(sz))/(sz*z);
+		}
+		else if (z < -1e-3)
+		{
+			double sz = sqrt(-z);
+			*c = (cosh(sz) - 1.0)/(-z);
+			*s = (sinh(sz) - sz)/(-sz*z);
+		}
+		else
+		{
+			*c = 0.5 - z*(1.0/24.0 - z/720.0);
+			*s = 1.0/6.0 - z*(1.0/120.0 - z/5040.0);
+		}
+	}
+
+	// Derivatives dC/dz and dS/dz of the Stumpff functions, given C(z) and S(z)
+	inline void dstumpff(double z, double c, double s, double *dc, double *ds)
+	{
+		if (fabs(z) > 1e-3)
+		{
+			*dc = (1.0 - z*s - 2.0*c)/(2.0*z);
+			*ds = (c - 3.0*s)/(2.0*z);
+		}
+		else
+		{
+			*dc = -1.0/24.0 + z*(1.0/360.0 - z/13440.0);
+			*ds = -1.0/120.0 + z*(1.0/2520.0 - z/120960.0);
+		}
+	}
+}
+
+bool TransferSearch::Ephemeris::Interpolate(double mjd, VECTOR3 *p, VECTOR3 *v) const
+{
+	int n = (int)pos.size();
+	double x = (mjd - mjd0)/dt;
+	if (n < 2 || x < 0.0 || x > n-1) return false;
+	int i = std::min((int)x, n-2);
+	double s = x - i, s1 = 1.0 - s;
+	double h = dt*DAY;
+	*p = pos[i]*((1.0 + 2.0*s)*s1*s1) + vel[i]*(s*s1*s1*h) + pos[i+1]*(s*s*(3.0 - 2.0*s)) + vel[i+1]*(s*s*(s - 1.0)*h);
+	*v = (pos[i] - pos[i+1])*(6.0*s*(s - 1.0)/h) + vel[i]*((3.0*s - 1.0)*(s - 1.0)) + vel[i+1]*(s*(3.0*s - 2.0));
+	return true;
+}
+
+TransferSearch::TransferSearch()
+: mu(0), next(0), ndone(0), nrun(0), bAbort(false)
+{
+}
+
+TransferSearch::~TransferSearch()
+{
+	Stop();
+}
+
+TransferSearch::Grid TransferSearch::DefaultGrid(double dep0, double span, double mu, double r1, double r2)
+{
+	double a = 0.5*(r1 + r2);
+	double th = PI*sqrt(a*a*a/mu)/DAY;
+	Grid g;
+	g.ndep = 256;
+	g.ntof = 160;
+	g.dep0 = dep0;
+	g.ddep = span/(g.ndep - 1);
+	g.tof0 = 0.3*th;
+	g.dtof = 1.4*th/(g.ntof - 1);
+	return g;
+}
+
+bool TransferSearch::SampleBody(OBJHANDLE hBody, OBJHANDLE hRef, double mjd0, double mjd1, double dt, Ephemeris *eph, const StateFunc &fallback)
+{
+	int n = std::max(2, (int)ceil((mjd1 - mjd0)/dt) + 1);
+	eph->mjd0 = mjd0;
+	eph->dt = dt;
+	eph->pos.resize(n);
+	eph->vel.resize(n);
+
+	// The planet module's ephemeris, if it is given relative to hRef. Data
+	// computed relative to the barycentre of the parent system
+	// (EPHEM_PARENTBARY) are used as they are: the offset is negligible
+	// for the purpose of a transfer window search.
+	CELBODY *cb = (oapiGetGbodyParent(hBody) == hRef ? oapiGetCelbodyInterface(hBody) : NULL);
+	if (cb && cb->bEphemeris())
+	{
+		int i;
+		for (i = 0; i < n; i++)
+		{
+			double ret[12], crt[6], *d = ret;
+			int flg = cb->clbkEphemeris(mjd0 + i*dt, EPHEM_TRUEPOS | EPHEM_TRUEVEL, ret);
+			if (!(flg & EPHEM_TRUEPOS))
+			{
+				if (!(flg & EPHEM_BARYPOS)) break;
+				d = ret + 6;
+			}
+			if (flg & EPHEM_POLAR)
+			{
+				// longitude, latitude [rad], distance [AU] and rates -> cartesian
+				double rad = d[2]*AU, cosp = cos(d[0]), sinp = sin(d[0]), cost = cos(d[1]), sint = sin(d[1]);
+				double xz = rad*cost, vl = xz*d[3], vb = rad*d[4], vr = d[5]*AU;
+				crt[0] = xz*cosp; crt[1] = rad*sint; crt[2] = xz*sinp;
+				crt[3] = cosp*cost*vr - cosp*sint*vb - sinp*vl;
+				crt[4] = sint*vr + cost*vb;
+				crt[5] = sinp*cost*vr - sinp*sint*vb + cosp*vl;
+				d = crt;
+			}
+			eph->pos[i] = _V(d[0], d[1], d[2]);
+			eph->vel[i] = _V(d[3], d[4], d[5]);
+		}
+		if (i == n) return true;
+	}
+
+	if (fallback)
+	{
+		for (int i = 0; i < n; i++)
+			fallback(mjd0 + i*dt, &eph->pos[i], &eph->vel[i]);
+	}
+	else
+	{
+		VECTOR3 pos, vel;
+		oapiGetRelativePos(hBody, hRef, &pos);
+		oapiGetRelativeVel(hBody, hRef, &vel);
+		double gm = GGRAV*(oapiGetMass(hRef) + oapiGetMass(hBody));
+		double mjd = oapiGetSimMJD();
+		for (int i = 0; i < n; i++)
+			KeplerState(gm, (mjd0 + i*dt - mjd)*DAY, pos, vel, &eph->pos[i], &eph->vel[i]);
+	}
+	return false;
+}
+
+void TransferSearch::KeplerState(double mu, double dt, const VECTOR3 &pos, const VECTOR3 &vel, VECTOR3 *p, VECTOR3 *v)
+{
+	// universal variable formulation
+	double smu = sqrt(mu);
+	double r0 = length(pos);
+	double rv = dotp(pos, vel);
+	double alpha = 2.0/r0 - dotp(vel, vel)/mu;
+
+	double x;
+	if (alpha > 1e-12)
+		x = smu*alpha*dt;
+	else if (alpha < -1e-12 && dt != 0.0)
+	{
+		double a = 1.0/alpha, sg = (dt > 0.0 ? 1.0 : -1.0);
+		x = sg*sqrt(-a)*log((-2.0*mu*alpha*dt)/(rv + sg*sqrt(-mu*a)*(1.0 - r0*alpha)));
+	}
+	else
+		x = smu*dt/r0;
+
+	double z = 0, c = 0.5, s = 1.0/6.0;
+	for (int i = 0; i < 50; i++)
+	{
+		z = alpha*x*x;
+		stumpff(z, &c, &s);
+		double x2 = x*x;
+		double f = rv/smu*x2*c + (1.0 - alpha*r0)*x2*x*s + r0*x - smu*dt;
+		double df = rv/smu*x*(1.0 - z*s) + (1.0 - alpha*r0)*x2*c + r0;
+		double dx = f/df;
+		x -= dx;
+		if (fabs(dx) <= 1e-12*(fabs(x) + 1e-6)) break;
+	}
+	z = alpha*x*x;
+	stumpff(z, &c, &s);
+
+	double x2 = x*x;
+	double f = 1.0 - x2/r0*c;
+	double g = dt - x2*x/smu*s;
+	*p = pos*f + vel*g;
+	double r = length(*p);
+	double fd = smu/(r*r0)*(z*s - 1.0)*x;
+	double gd = 1.0 - x2/r*c;
+	*v = pos*fd + vel*gd;
+}
+
+void TransferSearch::Lambert(int n, double mu, const VECTOR3 &r1, const VECTOR3 &hn, const VECTOR3 *r2, const double *tof, VECTOR3 *v1, VECTOR3 *v2, bool *ok)
+{
+	// Universal variable method. The time of flight increases monotonically
+	// with z, so z is found by Newton iteration inside a bracket that shrinks
+	// with every step. Steps that would leave the bracket are replaced by
+	// bisection. Where y < 0 the transfer needs a larger z, so y < 0 is
+	// treated like a short time. Each problem starts from the solution of
+	// the previous one, which is close for neighbouring cells of a grid row.
+	const int MAXITER = 60;
+	const double smu = sqrt(mu);
+	const double R1 = length(r1);
+	double z0 = 0.0;
+
+	for (int i = 0; i < n; i++)
+	{
+		double R2 = length(r2[i]);
+		double cth = dotp(r1, r2[i])/(R1*R2);
+		double sg = (dotp(crossp(r1, r2[i]), hn) >= 0.0 ? 1.0 : -1.0);
+		double A = sg*sqrt(std::max(0.0, R1*R2*(1.0 + cth)));
+		double T = tof[i]*smu;
+		double zlo = ZMIN, zhi = ZMAX*(1.0 - 1e-9);
+		double z = z0, c, s, y, t;
+
+		for (int k = 0; k < MAXITER && T > 0.0; k++)
+		{
+			stumpff(z, &c, &s);
+			double sc = sqrt(c);
+			y = R1 + R2 + A*(z*s - 1.0)/sc;
+			if (y <= 0.0)
+			{
+				zlo = z;
+				z = 0.5*(zlo + zhi);
+				continue;
+			}
+			double x = sqrt(y/c);
+			t = x*x*x*s + A*sqrt(y);
+			if (fabs(t - T) <= 1e-12*T) break;
+			if (t < T) zlo = z;
+			else zhi = z;
+
+			double dc, ds;
+			dstumpff(z, c, s, &dc, &ds);
+			double dy = A*((s + z*ds)/sc - 0.5*(z*s - 1.0)*dc/(c*sc));
+			double dx = 0.5*(dy - y*dc/c)/(c*x);
+			double dt = 3.0*x*x*dx*s + x*x*x*ds + 0.5*A*dy/sqrt(y);
+			double zn = z - (t - T)/dt;
+			z = (dt > 0.0 && zn > zlo && zn < zhi ? zn : 0.5*(zlo + zhi));
+		}
+
+		stumpff(z, &c, &s);
+		y = R1 + R2 + A*(z*s - 1.0)/sqrt(c);
+		t = (y > 0.0 ? pow(y/c, 1.5)*s + A*sqrt(y) : -1.0);
+		double g = A*sqrt(std::max(y, 0.0)/mu);
+		ok[i] = tof[i] > 0.0 && y > 0.0 && fabs(g) > 1e-9*tof[i] && fabs(t - T) <= 1e-6*T;
+		if (ok[i])
+		{
+			double f = 1.0 - y/R1, gd = 1.0 - y/R2;
+			v1[i] = (r2[i] - r1*f)/g;
+			v2[i] = (r2[i]*gd - r1)/g;
+			z0 = z;
+		}
+	}
+}
+
+bool TransferSearch::Start(double gm, const Grid &g, const Ephemeris &dep, const Ephemeris &arr, int nthread)
+{
+	Stop();
+	if (g.ndep < 1 || g.ntof < 1) return false;
+
+	mu = gm;
+	grid = g;
+	ephdep = dep;
+	epharr = arr;
+	cost.assign(grid.ndep*grid.ntof, -1.0f);
+	rowdone.reset(new std::atomic<int>[grid.ndep]);
+	for (int i = 0; i < grid.ndep; i++)
+		rowdone[i] = 0;
+
+	// coarse to fine: every 64th row first, then the rows halfway between
+	order.clear();
+	for (int stride = 64; stride >= 1; stride /= 2)
+		for (int i = 0; i < grid.ndep; i += stride)
+			if (stride == 64 || i % (2*stride))
+				order.push_back(i);
+
+	best = Solution();
+	next = 0;
+	ndone = 0;
+	bAbort = false;
+
+	if (nthread <= 0)
+	{
+		int ncore = (int)std::thread::hardware_concurrency();
+		nthread = std::max(1, std::min(8, ncore - 1)); // leave a core to the simulation
+	}
+	nrun = nthread;
+	for (int i = 0; i < nthread; i++)
+		threads.push_back(std::thread(&TransferSearch::ThreadProc, this));
+	return true;
+}
+
+void TransferSearch::Stop()
+{
+	bAbort = true;
+	Join();
+}
+
+void TransferSearch::Wait()
+{
+	Join();
+}
+
+void TransferSearch::Join()
+{
+	for (size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+	threads.clear();
+}
+
+TransferSearch::Solution TransferSearch::Best()
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	return best;
+}
+
+void TransferSearch::ThreadProc()
+{
+	for (;;)
+	{
+		int k = next++;
+		if (k >= (int)order.size() || bAbort) break;
+		ProcessRow(order[k]);
+	}
+	nrun--;
+}
+
+void TransferSearch::ProcessRow(int idep)
+{
+	const int n = grid.ntof;
+	double mjd = grid.dep0 + idep*grid.ddep;
+	VECTOR3 r1, u1;
+	if (ephdep.Interpolate(mjd, &r1, &u1))
+	{
+		std::vector<VECTOR3> r2(n), u2(n), v1(n), v2(n);
+		std::vector<double> tof(n);
+		std::unique_ptr<bool[]> ok(new bool[n]);
+		for (int j = 0; j < n; j++)
+		{
+			double t = grid.tof0 + j*grid.dtof;
+			tof[j] = (epharr.Interpolate(mjd + t, &r2[j], &u2[j]) ? t*DAY : 0.0);
+			if (tof[j] == 0.0) r2[j] = r1; // lane is skipped
+		}
+		Lambert(n, mu, r1, crossp(r1, u1), r2.data(), tof.data(), v1.data(), v2.data(), ok.get());
+
+		int jmin = -1;
+		double cmin = 0;
+		float *row = cost.data() + idep*n;
+		for (int j = 0; j < n; j++)
+		{
+			if (!ok[j]) continue;
+			double c = length(v1[j] - u1) + length(v2[j] - u2[j]);
+			row[j] = (float)c;
+			if (jmin < 0 || c < cmin) jmin = j, cmin = c;
+		}
+		if (jmin >= 0)
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			if (!best.valid || cmin < best.dv)
+			{
+				best.valid = true;
+				best.dep = mjd;
+				best.tof = tof[jmin]/DAY;
+				best.dv = cmin;
+				best.vinfdep = v1[jmin] - u1;
+				best.vinfarr = v2[jmin] - u2[jmin];
+			}
+		}
+	}
+	rowdone[idep].store(1, std::memory_order_release);
+	ndone++;
+}
@@ -0,0 +1,161 @@
+/* Copyright © 2007-9 Steve Arch, Duncan Sharpe
+** Copyright © 2011 atomicdryad - 'ENT' button & Pen allocation fix
+** Copyright © 2013 Dimitris Gatsoulis (dgatsoulis) - Hacks
+** Copyright © 2013 Szymon Ender (Enjo) - Auto-Min™, Auto-Center™ & other hacks
+**
+** X11 License ("MIT License")
+**
+** Permission is hereby granted, free of charge, to any person obtaining a copy
+** of this software and associated documentation files (the "Software"), to deal
+** in the Software without restriction, including without limitation the rights
+** to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+** copies of the Software, and to permit persons to whom the Software is
+** furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+** OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+** THE SOFTWARE.*/
+
+#ifndef __TRANSFERSEARCH_H
+#define __TRANSFERSEARCH_H
+
+#include "OrbiterAPI.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Transfer window ("porkchop") search between two bodies orbiting the same
+// central body. For every cell of a departure date x time of flight grid
+// the Lambert problem is solved, and the cell is rated by the sum of the
+// hyperbolic excess velocities at departure and arrival.
+// The engine does not depend on the rest of TransX, so that it can be
+// used without an MFD (e.g. from a script).
+//
+// The body positions are sampled into Ephemeris tables on the calling
+// thread before the search starts, because the planet modules are not
+// guaranteed to be thread-safe. The grid is then processed by a pool of
+// worker threads, one departure date (grid row) at a time. Rows are handed
+// out coarse to fine, so that a complete low-resolution map is available
+// early and is refined while the search progresses. Completed rows can be
+// read while the search is running.
+
+class TransferSearch
+{
+public:
+	struct Ephemeris
+	{
+		double mjd0;              // MJD of the first sample
+		double dt;                // sample interval [days]
+		std::vector<VECTOR3> pos; // positions relative to the central body [m]
+		std::vector<VECTOR3> vel; // velocities [m/s]
+
+		bool Interpolate(double mjd, VECTOR3 *p, VECTOR3 *v) const;
+		// State at mjd by cubic Hermite interpolation between the samples.
+		// Returns false if mjd is outside the table.
+	};
+
+	typedef std::function<void(double mjd, VECTOR3 *pos, VECTOR3 *vel)> StateFunc;
+
+	struct Grid
+	{
+		double dep0, ddep;        // first departure date [MJD] and departure date step [days]
+		double tof0, dtof;        // shortest time of flight and time of flight step [days]
+		int ndep, ntof;           // number of departure dates and times of flight
+		Grid(): dep0(0), ddep(1), tof0(1), dtof(1), ndep(0), ntof(0) {}
+	};
+
+	struct Solution
+	{
+		bool valid;
+		double dep;               // departure date [MJD]
+		double tof;               // time of flight [days]
+		double dv;                // departure + arrival excess velocity [m/s]
+		VECTOR3 vinfdep;          // hyperbolic excess velocity at departure [m/s]
+		VECTOR3 vinfarr;          // hyperbolic excess velocity at arrival [m/s]
+		Solution(): valid(false), dep(0), tof(0), dv(0) {}
+	};
+
+	TransferSearch();
+	~TransferSearch();
+
+	static Grid DefaultGrid(double dep0, double span, double mu, double r1, double r2);
+	// Grid spanning span days of departure dates from dep0. The times of
+	// flight cover 0.3 to 1.7 times the Hohmann transfer time between
+	// circular orbits of radius r1 and r2 about a body of gravitational
+	// parameter mu.
+
+	static bool SampleBody(OBJHANDLE hBody, OBJHANDLE hRef, double mjd0, double mjd1, double dt, Ephemeris *eph, const StateFunc &fallback = StateFunc());
+	// Samples the state of hBody relative to hRef from mjd0 to mjd1 in steps
+	// of dt days. Uses the planet module's ephemeris if hRef is the parent
+	// of hBody and the module supports it. Otherwise uses fallback if given,
+	// or a two-body orbit from the current state. Must be called from the
+	// simulation thread.
+
+	static void KeplerState(double mu, double dt, const VECTOR3 &pos, const VECTOR3 &vel, VECTOR3 *p, VECTOR3 *v);
+	// Two-body propagation of state (pos,vel) by dt seconds
+
+	static void Lambert(int n, double mu, const VECTOR3 &r1, const VECTOR3 &hn, const VECTOR3 *r2, const double *tof, VECTOR3 *v1, VECTOR3 *v2, bool *ok);
+	// Solves n Lambert problems from a common departure position r1 to the
+	// arrival positions r2[i] in times tof[i] [s] (single revolution,
+	// universal variables, Newton iteration). The transfer direction is the
+	// one whose angular momentum points along hn. Returns the departure and
+	// arrival velocities in v1 and v2, and ok[i]=false where no solution was
+	// found. Each problem starts from the solution of the previous one, so
+	// converges fastest if the problems are ordered, e.g. by time of flight.
+
+	bool Start(double mu, const Grid &grid, const Ephemeris &dep, const Ephemeris &arr, int nthread = 0);
+	// Starts a search on the grid with the body tables dep and arr, which
+	// must cover the departure and arrival dates. Aborts a running search.
+	// nthread = 0 selects the number of worker threads from the number of
+	// hardware cores.
+
+	void Stop();
+	// Aborts the search and waits for the worker threads
+
+	void Wait();
+	// Blocks until the search is complete
+
+	bool Running() const { return nrun > 0; }
+	bool Done() const { return grid.ndep > 0 && ndone == grid.ndep; }
+	int RowsDone() const { return ndone; }
+	const Grid &GetGrid() const { return grid; }
+
+	bool RowDone(int idep) const { return rowdone[idep].load(std::memory_order_acquire) != 0; }
+	// Row idep of the map is complete and can be read
+
+	float Cost(int idep, int itof) const { return cost[idep*grid.ntof+itof]; }
+	// Departure + arrival excess velocity [m/s] of a cell of a completed row,
+	// or a negative value if the transfer has no solution
+
+	Solution Best();
+	// Cheapest transfer found so far
+
+private:
+	void ThreadProc();
+	void ProcessRow(int idep);
+	void Join();
+
+	Grid grid;
+	double mu;
+	Ephemeris ephdep, epharr;
+	std::vector<int> order;           // row processing order (coarse to fine)
+	std::vector<float> cost;          // ndep x ntof map
+	std::unique_ptr<std::atomic<int>[]> rowdone;
+	std::vector<std::thread> threads;
+	std::atomic<int> next, ndone, nrun;
+	std::atomic<bool> bAbort;
+	std::mutex mtx;                   // protects best
+	Solution best;
+};
+
+#endif
@@ -26,6 +26,7 @@ extern "C" {
 #include <lua/lauxlib.h>
 }
 #include "orbitersdk.h"
+#include "Interpreter.h" // lua_tovector, lua_touservector
 #include <filesystem>
 namespace fs = std::filesystem;
 
@@ -104,18 +105,6 @@ DLLCLBK void ExitModule (HINSTANCE hDLL)
 {
 }
 
-static VECTOR3 lua_tovector(lua_State* L, int idx)
-{
-	VECTOR3 vec;
-	lua_getfield(L, idx, "x");
-	vec.x = lua_tonumber(L, -1); lua_pop(L, 1);
-	lua_getfield(L, idx, "y");
-	vec.y = lua_tonumber(L, -1); lua_pop(L, 1);
-	lua_getfield(L, idx, "z");
-	vec.z = lua_tonumber(L, -1); lua_pop(L, 1);
-	return vec;
-}
-
 static void lua_pushvector(lua_State* L, const VECTOR3& vec)
 {
 	lua_createtable(L, 0, 3);
@@ -129,6 +118,7 @@ static void lua_pushvector(lua_State* L, const VECTOR3& vec)
 
 static int lua_isvector(lua_State* L, int idx)
 {
+	if (lua_touservector(L, idx)) return 1;
 	if (!lua_istable(L, idx)) return 0;
 	static char fieldname[3] = { 'x','y','z' };
 	static char field[2] = "x";
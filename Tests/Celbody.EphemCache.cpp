@@ -0,0 +1,106 @@
+#include "EphemCache.h"
+#include "EphemFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+// Synthetic moon ephemeris: circular orbit with a short-period perturbation
+// Positions in m, velocities in m/s, time in MJD
+static const double PI = 3.14159265358979323846;
+static const double R = 4.2e8, P = 1.77, dR = 2e5, dP = 0.21;
+
+static void Orbit (double mjd, double *ret)
+{
+	const double w = 2.0*PI/P, dw = 2.0*PI/dP;
+	double r = R + dR*sin(dw*mjd), rdot = dR*dw*cos(dw*mjd);
+	double c = cos(w*mjd), s = sin(w*mjd);
+	ret[0] = r*c;
+	ret[1] = 0.01*r*s;
+	ret[2] = r*s;
+	ret[3] = (rdot*c - r*w*s)/86400.0;
+	ret[4] = 0.01*(rdot*s + r*w*c)/86400.0;
+	ret[5] = (rdot*s + r*w*c)/86400.0;
+}
+
+TEST_CASE("Cached ephemeris matches the full solution", "[EphemCache]")
+{
+	int nfunc = 0;
+	EphemCache cache ([&](double mjd, double *ret) { nfunc++; Orbit (mjd, ret); }, 0.1);
+	double ref[6], res[6];
+	double dpos = 0.0, dvel = 0.0;
+
+	// forward, then backward over the same interval, crossing segment boundaries
+	for (double mjd = 10.0; mjd < 12.0; mjd += 0.0013) {
+		Orbit (mjd, ref); cache.Eval (mjd, res);
+		for (int i = 0; i < 3; i++) {
+			dpos = std::max (dpos, fabs (res[i]-ref[i]));
+			dvel = std::max (dvel, fabs (res[i+3]-ref[i+3]));
+		}
+	}
+	int nfwd = nfunc;
+	for (double mjd = 11.999; mjd > 10.0; mjd -= 0.0017) {
+		Orbit (mjd, ref); cache.Eval (mjd, res);
+		for (int i = 0; i < 3; i++) {
+			dpos = std::max (dpos, fabs (res[i]-ref[i]));
+			dvel = std::max (dvel, fabs (res[i+3]-ref[i+3]));
+		}
+	}
+	REQUIRE(dpos < 1e-3);     // m
+	REQUIRE(dvel < 1e-6);     // m/s
+	REQUIRE(nfunc == nfwd);   // backward pass served from the cache
+	REQUIRE(nfunc <= 21*(cache.Order()+1));
+}
+
+TEST_CASE("Cached velocity is the derivative of cached position", "[EphemCache]")
+{
+	EphemCache cache (Orbit, 0.1);
+	const double h = 1e-5; // days
+	for (double mjd = 10.0; mjd < 11.0; mjd += 0.0371) {
+		double r0[6], r1[6], res[6];
+		cache.Eval (mjd-h, r0);
+		cache.Eval (mjd+h, r1);
+		cache.Eval (mjd, res);
+		for (int i = 0; i < 3; i++)
+			REQUIRE(fabs ((r1[i]-r0[i])/(2.0*h*86400.0) - res[i+3]) < 1e-4);
+	}
+}
+
+TEST_CASE("Ephemeris file reproduces the cache", "[EphemCache]")
+{
+	const char *fname = "Celbody.EphemCache.eph";
+	EphemCache cache (Orbit, 0.1);
+	REQUIRE(EphemFile::Write (fname, "Test", cache, 10.05, 11.95, 1));
+
+	EphemFile file;
+	REQUIRE(file.Open (fname));
+	REQUIRE(file.Flags() == 1);
+	REQUIRE(fabs (file.StartMJD() - 10.0) < 1e-9);
+	REQUIRE(fabs (file.EndMJD() - 12.0) < 1e-9);
+
+	double ref[6], res[6];
+	REQUIRE(!file.Eval (9.99, res));
+	REQUIRE(!file.Eval (12.01, res));
+	for (double mjd = 10.0; mjd < 12.0; mjd += 0.0013) {
+		cache.Eval (mjd, ref);
+		REQUIRE(file.Eval (mjd, res));
+		for (int i = 0; i < 6; i++)
+			REQUIRE(res[i] == ref[i]);
+	}
+
+	// a cache backed by the file doesn't evaluate the function in the covered range
+	int nfunc = 0;
+	EphemCache fcache ([&](double mjd, double *ret) { nfunc++; Orbit (mjd, ret); }, 0.1);
+	fcache.SetFile (&file);
+	for (double mjd = 10.0; mjd < 12.0; mjd += 0.0013)
+		fcache.Eval (mjd, res);
+	REQUIRE(nfunc == 0);
+	fcache.Eval (12.05, res);
+	REQUIRE(nfunc > 0);
+
+	file.Close();
+	remove (fname);
+}
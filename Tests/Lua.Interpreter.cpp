@@ -1,5 +1,6 @@
 #include "Interpreter.h"
 
+#include <cstring>
 #include <memory>
 
 // these collide with std::min/max
@@ -13,7 +14,7 @@ using std::make_unique;
 using std::string;
 
 // Test that interpreter is created and destroyed without exceptions
-TEST_CASE("Create and test Lua interpreter", "[LuaInterpreter]" ) 
+TEST_CASE("Create and test Lua interpreter", "[LuaInterpreter]" )
 {
 	auto interp = make_unique<Interpreter>();
 	interp->Initialise();
@@ -27,3 +28,222 @@ TEST_CASE("Create and test Lua interpreter", "[LuaInterpreter]" )
 	lua_getglobal(L, "a");
 	REQUIRE(lua_tointeger(L, -1) == 4);
 };
+
+static double GetGlobalNumber (lua_State *L, const char *name)
+{
+	lua_getglobal(L, name);
+	double v = lua_tonumber(L, -1);
+	lua_pop(L, 1);
+	return v;
+}
+
+static bool GetGlobalBool (lua_State *L, const char *name)
+{
+	lua_getglobal(L, name);
+	bool v = lua_toboolean(L, -1) != 0;
+	lua_pop(L, 1);
+	return v;
+}
+
+TEST_CASE("Vector and matrix types", "[LuaInterpreter]")
+{
+	auto interp = make_unique<Interpreter>();
+	interp->Initialise();
+	auto L = interp->GetState();
+
+	string script =
+		"v = vec.set(1,2,3)\n"
+		"vtype = type(v)\n"
+		"v.x = 4\n"
+		"w = v + {x=1,y=1,z=1}\n"            // legacy tables are accepted as operands
+		"wx, wy, wz = w.x, w.y, w.z\n"
+		"s = vec.dotp(2*v - v/2, {x=0,y=0,z=1})\n"
+		"n = (-v).y\n"
+		"eq = (v == vec.set(4,2,3)) and not (v == w)\n"
+		"str = tostring(v)\n"
+		"m = mat.identity()\n"
+		"m.m12 = 2\n"
+		"mv = m * v\n"
+		"mm = (m * m).m12\n"
+		"tv = mat.mul(m, {x=4,y=2,z=3}).x\n";
+	REQUIRE(interp->RunChunk(script.data(), script.size()) == 0);
+
+	lua_getglobal(L, "vtype");
+	REQUIRE(string(lua_tostring(L, -1)) == "userdata");
+	lua_pop(L, 1);
+	REQUIRE(GetGlobalNumber(L, "wx") == 5.0);
+	REQUIRE(GetGlobalNumber(L, "wy") == 3.0);
+	REQUIRE(GetGlobalNumber(L, "wz") == 4.0);
+	REQUIRE(GetGlobalNumber(L, "s") == 4.5);
+	REQUIRE(GetGlobalNumber(L, "n") == -2.0);
+	REQUIRE(GetGlobalBool(L, "eq"));
+	lua_getglobal(L, "str");
+	REQUIRE(string(lua_tostring(L, -1)) == "[4 2 3]");
+	lua_pop(L, 1);
+	REQUIRE(GetGlobalNumber(L, "mm") == 4.0);
+	REQUIRE(GetGlobalNumber(L, "tv") == 8.0);
+
+	// C++ side accepts both forms
+	lua_getglobal(L, "mv");
+	VECTOR3 mv = lua_tovector(L, -1);
+	lua_pop(L, 1);
+	REQUIRE(mv.x == 8.0);
+	REQUIRE(mv.y == 2.0);
+	lua_getglobal(L, "w");
+	VECTOR3 w = lua_tovector(L, -1);
+	lua_pop(L, 1);
+	REQUIRE(w.z == 4.0);
+}
+
+TEST_CASE("pairs() iterates over vector and matrix fields", "[LuaInterpreter]")
+{
+	auto interp = make_unique<Interpreter>();
+	interp->Initialise();
+	auto L = interp->GetState();
+
+	// scripts written for vectors and matrices as tables
+	string script =
+		"local v = vec.set(1,2,3)\n"
+		"vkeys, vsum = '', 0\n"
+		"for k, x in pairs(v) do vkeys = vkeys .. k; vsum = vsum + x end\n"
+		"local m = mat.identity()\n"
+		"m.m23 = 5\n"
+		"mn, msum = 0, 0\n"
+		"for k, x in pairs(m) do mn = mn + 1; msum = msum + x end\n"
+		"tn = 0\n"
+		"for k, x in pairs({a=1, b=2}) do tn = tn + x end\n";
+	REQUIRE(interp->RunChunk(script.data(), script.size()) == 0);
+
+	lua_getglobal(L, "vkeys");
+	REQUIRE(string(lua_tostring(L, -1)) == "xyz");
+	lua_pop(L, 1);
+	REQUIRE(GetGlobalNumber(L, "vsum") == 6.0);
+	REQUIRE(GetGlobalNumber(L, "mn") == 9.0);
+	REQUIRE(GetGlobalNumber(L, "msum") == 8.0);
+	REQUIRE(GetGlobalNumber(L, "tn") == 3.0); // tables are unaffected
+}
+
+// =======================================================================
+// Autopilot benchmark. The same script runs with the vec library and with
+// a copy of it that returns vectors as tables, as the interpreter did
+// before vectors became userdata.
+
+static void PushTableVector (lua_State *L, const VECTOR3 &v)
+{
+	lua_createtable(L, 0, 3);
+	lua_pushnumber(L, v.x); lua_setfield(L, -2, "x");
+	lua_pushnumber(L, v.y); lua_setfield(L, -2, "y");
+	lua_pushnumber(L, v.z); lua_setfield(L, -2, "z");
+}
+
+static int tvec_set (lua_State *L)
+{
+	PushTableVector(L, _V(lua_tonumber(L, 1), lua_tonumber(L, 2), lua_tonumber(L, 3)));
+	return 1;
+}
+
+static int tvec_add (lua_State *L) { PushTableVector(L, lua_tovector(L, 1) + lua_tovector(L, 2)); return 1; }
+static int tvec_sub (lua_State *L) { PushTableVector(L, lua_tovector(L, 1) - lua_tovector(L, 2)); return 1; }
+static int tvec_mul (lua_State *L) { PushTableVector(L, lua_tovector(L, 1) * lua_tonumber(L, 2)); return 1; }
+static int tvec_crossp (lua_State *L) { PushTableVector(L, crossp(lua_tovector(L, 1), lua_tovector(L, 2))); return 1; }
+static int tvec_unit (lua_State *L) { PushTableVector(L, unit(lua_tovector(L, 1))); return 1; }
+static int tvec_dotp (lua_State *L) { lua_pushnumber(L, dotp(lua_tovector(L, 1), lua_tovector(L, 2))); return 1; }
+static int tvec_length (lua_State *L) { lua_pushnumber(L, length(lua_tovector(L, 1))); return 1; }
+
+static const char *autopilot_script =
+	"function autopilot(V, nframe)\n"
+	"  local tgt = V.set(6771e3, 0, 0)\n"
+	"  local pos, vel = V.set(6700e3, 1000, 200), V.set(10, 7600, 50)\n"
+	"  local cmd = 0\n"
+	"  for i = 1, nframe do\n"
+	"    local dr = V.sub(tgt, pos)\n"
+	"    local dist = V.length(dr)\n"
+	"    local dir = V.unit(dr)\n"
+	"    local nml = V.unit(V.crossp(pos, vel))\n"
+	"    local vr = V.dotp(vel, dir)\n"
+	"    local err = V.sub(V.mul(dir, vr), vel)\n"
+	"    cmd = cmd + V.dotp(err, nml)*1e-6 + dist*1e-9\n"
+	"    pos = V.add(pos, V.mul(vel, 0.02))\n"
+	"    vel = V.add(vel, V.mul(dir, 0.01))\n"
+	"  end\n"
+	"  return cmd\n"
+	"end\n"
+	// returns the script result and the memory allocated per frame [bytes]
+	"function measure(V, nframe)\n"
+	"  collectgarbage('collect')\n"
+	"  collectgarbage('stop')\n"
+	"  local m0 = collectgarbage('count')\n"
+	"  local res = autopilot(V, nframe)\n"
+	"  local m1 = collectgarbage('count')\n"
+	"  collectgarbage('restart')\n"
+	"  return res, (m1-m0)*1024/nframe\n"
+	"end\n";
+
+static void SetupAutopilot (Interpreter *interp)
+{
+	lua_State *L = interp->GetState();
+	static const struct luaL_reg tvecLib[] = {
+		{"set", tvec_set}, {"add", tvec_add}, {"sub", tvec_sub}, {"mul", tvec_mul},
+		{"crossp", tvec_crossp}, {"unit", tvec_unit}, {"dotp", tvec_dotp}, {"length", tvec_length},
+		{NULL, NULL}
+	};
+	luaL_openlib(L, "tvec", tvecLib, 0);
+	lua_pop(L, 1);
+	interp->RunChunk(autopilot_script, strlen(autopilot_script));
+}
+
+static double Measure (lua_State *L, const char *lib, int nframe, double &bytes)
+{
+	lua_getglobal(L, "measure");
+	lua_getglobal(L, lib);
+	lua_pushinteger(L, nframe);
+	lua_call(L, 2, 2);
+	double res = lua_tonumber(L, -2);
+	bytes = lua_tonumber(L, -1);
+	lua_pop(L, 2);
+	return res;
+}
+
+TEST_CASE("Vector userdata allocation in an autopilot script", "[LuaInterpreter]")
+{
+	auto interp = make_unique<Interpreter>();
+	interp->Initialise();
+	SetupAutopilot(interp.get());
+	auto L = interp->GetState();
+
+	double bytes_table, bytes_udata;
+	double res_table = Measure(L, "tvec", 1000, bytes_table);
+	double res_udata = Measure(L, "vec", 1000, bytes_udata);
+
+	// same arithmetic, less garbage per frame
+	REQUIRE(res_udata == res_table);
+	REQUIRE(bytes_udata > 0.0);
+	REQUIRE(bytes_udata*2.0 < bytes_table);
+}
+
+TEST_CASE("Vector userdata performance", "[LuaInterpreter][!benchmark]")
+{
+	auto interp = make_unique<Interpreter>();
+	interp->Initialise();
+	SetupAutopilot(interp.get());
+	auto L = interp->GetState();
+
+	BENCHMARK("Autopilot, 1000 frames, table vectors") {
+		lua_getglobal(L, "autopilot");
+		lua_getglobal(L, "tvec");
+		lua_pushinteger(L, 1000);
+		lua_call(L, 2, 1);
+		double res = lua_tonumber(L, -1);
+		lua_pop(L, 1);
+		return res;
+	};
+	BENCHMARK("Autopilot, 1000 frames, userdata vectors") {
+		lua_getglobal(L, "autopilot");
+		lua_getglobal(L, "vec");
+		lua_pushinteger(L, 1000);
+		lua_call(L, 2, 1);
+		double res = lua_tonumber(L, -1);
+		lua_pop(L, 1);
+		return res;
+	};
+}
@@ -0,0 +1,16 @@
+# Runs the OnRails scenario without on-rails propagation, which writes the
+# free-flight reference states, and then with on-rails propagation, which
+# checks the vessel states against them.
+# Arguments: SERVER (Orbiter executable), SCENARIO, WORKDIR
+
+file(REMOVE ${WORKDIR}/OnRails.ref)
+foreach(rails 0 1)
+	execute_process(
+		COMMAND ${SERVER} --scenariox=${SCENARIO} --fixedstep=10 --onrails=${rails}
+		WORKING_DIRECTORY ${WORKDIR}
+		RESULT_VARIABLE res
+	)
+	if(NOT res EQUAL 0 OR NOT EXISTS ${WORKDIR}/OnRails.ref)
+		message(FATAL_ERROR "OnRails scenario failed with --onrails=${rails}")
+	endif()
+endforeach()
@@ -0,0 +1,136 @@
+#include "AtmTable.h"
+
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+static const double PI = 3.14159265358979323846;
+
+// Analytic stand-in for an atmosphere module: exponential profile with a
+// scale height that varies with latitude, local time and solar activity
+struct TestModel {
+	double f107 = 140.0;
+	int ncall = 0;
+
+	void Eval (double alt, double lat, double lst, AtmTable::Prm &prm)
+	{
+		ncall++;
+		double H = 8e3 * (1.0 + 0.02*cos (lat)) * (1.0 + 0.03*cos ((lst-14.0)*PI/12.0)) * f107/140.0;
+		prm.T = 200.0 + 50.0*tanh (alt*1e-5) * (1.0 + 0.1*sin ((lst-6.0)*PI/12.0));
+		prm.rho = 1.225 * exp (-alt/H);
+		prm.p = prm.rho * 286.91 * prm.T;
+	}
+};
+
+static double RelErr (double a, double b) { return fabs (a-b) / fabs (b); }
+
+TEST_CASE("Tabulated atmosphere accuracy", "[AtmTable]")
+{
+	TestModel model;
+	const double tol = 5e-3;
+	AtmTable table ([&model](double alt, double lat, double lst, AtmTable::Prm &prm) { model.Eval (alt, lat, lst, prm); },
+		0.0, 200e3, tol);
+
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<double> ualt(0.0, 200e3), ulat(-0.5*PI, 0.5*PI), ulst(-24.0, 48.0);
+	double maxerr = 0.0;
+	int nfail = 0;
+	for (int n = 0; n < 10000; n++) {
+		double alt = ualt(rng), lat = ulat(rng), lst = ulst(rng);
+		AtmTable::Prm t, x;
+		if (!table.Eval (alt, lat, lst, t)) { nfail++; continue; }
+		model.Eval (alt, lat, lst, x);
+		maxerr = std::max (maxerr, std::max (RelErr (t.T, x.T), std::max (RelErr (t.p, x.p), RelErr (t.rho, x.rho))));
+	}
+	REQUIRE(table.nAltNodes() > 2);
+	REQUIRE(nfail == (int)table.nRejected());
+	REQUIRE(nfail < 100);
+	REQUIRE(maxerr < tol);
+
+	// outside the altitude range the caller must use the model
+	AtmTable::Prm prm;
+	REQUIRE(!table.Eval (-10.0, 0.0, 12.0, prm));
+	REQUIRE(!table.Eval (201e3, 0.0, 12.0, prm));
+}
+
+TEST_CASE("Tabulated atmosphere epoch refresh", "[AtmTable]")
+{
+	TestModel model;
+	AtmTable table ([&model](double alt, double lat, double lst, AtmTable::Prm &prm) { model.Eval (alt, lat, lst, prm); },
+		0.0, 1000e3, 1e-2);
+	table.SetEpoch (1);
+
+	AtmTable::Prm t0, t1, x;
+	REQUIRE(table.Eval (400e3, 0.3, 10.0, t0));
+	size_t nbuild = table.nBuilt();
+	REQUIRE(nbuild == 2); // only the two slices around the lookup are built
+
+	// further lookups in the same cell don't evaluate the model
+	int ncall = model.ncall;
+	REQUIRE(table.Eval (400.1e3, 0.31, 10.5, t1));
+	REQUIRE(model.ncall == ncall);
+
+	// solar activity changes: stale slices are used until refreshed
+	model.f107 = 200.0;
+	REQUIRE(!table.SetEpoch (1));
+	REQUIRE(table.SetEpoch (2));
+	REQUIRE(table.Eval (400e3, 0.3, 10.0, t1));
+	REQUIRE(t1.rho == t0.rho);
+	REQUIRE(table.Refresh (1) == 1);
+	REQUIRE(table.Refresh (8) == 1);
+	REQUIRE(table.Refresh (8) == 0);
+	REQUIRE(table.nBuilt() == nbuild+2);
+	REQUIRE(table.Eval (400e3, 0.3, 10.0, t1));
+	model.Eval (400e3, 0.3, 10.0, x);
+	REQUIRE(t1.rho > 10.0*t0.rho);
+	REQUIRE(RelErr (t1.rho, x.rho) < 1e-2);
+}
+
+TEST_CASE("Concurrent tabulated atmosphere lookups", "[AtmTable]")
+{
+	auto eval = [](double alt, double lat, double lst, AtmTable::Prm &prm) {
+		TestModel model;
+		model.Eval (alt, lat, lst, prm);
+	};
+	AtmTable serial (eval, 0.0, 200e3, 5e-3), shared (eval, 0.0, 200e3, 5e-3);
+
+	const int nthread = 4, npt = 2000;
+	std::vector<double> alt(npt), lat(npt), lst(npt);
+	std::mt19937 rng(99);
+	std::uniform_real_distribution<double> ualt(0.0, 200e3), ulat(-0.5*PI, 0.5*PI), ulst(0.0, 24.0);
+	for (int n = 0; n < npt; n++)
+		alt[n] = ualt(rng), lat[n] = ulat(rng), lst[n] = ulst(rng);
+
+	// all threads start with an empty table and build slices on first use.
+	// Lookups next to a slice under construction fail; the rest must match
+	// the table built by a single thread.
+	std::vector<std::vector<int>> ok(nthread, std::vector<int>(npt));
+	std::vector<std::vector<AtmTable::Prm>> res(nthread, std::vector<AtmTable::Prm>(npt));
+	std::vector<std::thread> threads;
+	for (int t = 0; t < nthread; t++)
+		threads.emplace_back ([&, t]() {
+			for (int n = 0; n < npt; n++)
+				ok[t][n] = shared.Eval (alt[n], lat[n], lst[n], res[t][n]);
+		});
+	for (auto &th : threads) th.join();
+
+	int nok = 0;
+	for (int n = 0; n < npt; n++) {
+		AtmTable::Prm ref;
+		bool refok = serial.Eval (alt[n], lat[n], lst[n], ref);
+		for (int t = 0; t < nthread; t++) {
+			if (!ok[t][n]) continue;
+			REQUIRE(refok);
+			REQUIRE(res[t][n].T == ref.T);
+			REQUIRE(res[t][n].p == ref.p);
+			REQUIRE(res[t][n].rho == ref.rho);
+			nok++;
+		}
+	}
+	REQUIRE(nok > nthread*npt/2);
+	REQUIRE(shared.nBuilt() == serial.nBuilt());
+}
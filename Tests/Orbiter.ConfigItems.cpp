@@ -0,0 +1,156 @@
+#include "Config.h"
+
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// these collide with std::min/max
+#undef min
+#undef max
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+namespace fs = std::filesystem;
+using std::string;
+using std::vector;
+
+// All .cfg files of the shipped configuration tree
+static vector<string> ConfigFiles ()
+{
+	vector<string> files;
+	for (auto &entry : fs::recursive_directory_iterator(CONFIG_DIR))
+		if (entry.is_regular_file() && entry.path().extension() == ".cfg")
+			files.push_back(entry.path().string());
+	return files;
+}
+
+// Item labels of a configuration file, with case variants and some labels
+// that don't exist
+static vector<string> ItemLabels (const string &fname)
+{
+	vector<string> labels = { "NoSuchItem", "", "END_PARSE" };
+	std::ifstream ifs(fname);
+	char cbuf[512];
+	while (ifs.getline(cbuf, 512)) {
+		char *cl = trim_string(cbuf);
+		char *eq = strchr(cl, '=');
+		if (!eq) continue;
+		string label(cl, eq-cl);
+		while (!label.empty() && (label.back() == ' ' || label.back() == '\t')) label.pop_back();
+		if (label.empty()) continue;
+		labels.push_back(label);
+		for (auto &c : label) c = (char)toupper(c);
+		labels.push_back(label);
+	}
+	return labels;
+}
+
+// Look up a label in a stream and record the result and the stream state
+struct Lookup {
+	bool found;
+	string val;
+	std::streampos pos;
+	bool good;
+
+	Lookup (std::istream &is, const string &label)
+	{
+		char cbuf[1024] = "";
+		found = GetItemString(is, label.c_str(), cbuf);
+		val = (found ? cbuf : "");
+		good = is.good();
+		pos = (good ? is.tellg() : std::streampos(-1));
+	}
+	bool operator== (const Lookup &l) const
+	{ return found == l.found && val == l.val && good == l.good && pos == l.pos; }
+};
+
+TEST_CASE("Indexed lookups match the linear scan", "[ConfigItems]")
+{
+	const char *text =
+		"; comment line\n"
+		"Name = First   ; trailing comment\n"
+		"  Size=12.5\n"
+		"EmptyItem =\n"
+		"name = Second\n"
+		"Vec = 1 2 3\n"
+		"Flag = TRUE\n"
+		"END_PARSE\n"
+		"Hidden = 1\n";
+	std::istringstream scan(text), indexed(text);
+	IndexItems(indexed);
+
+	for (const char *label : { "Name", "NAME", "Size", "EmptyItem", "Vec", "Flag", "Hidden", "Missing" }) {
+		Lookup a(scan, label), b(indexed, label);
+		REQUIRE(a == b);
+	}
+
+	char cbuf[256];
+	REQUIRE(GetItemString(indexed, "name", cbuf));
+	REQUIRE(string(cbuf) == "First");
+	REQUIRE(!GetItemString(indexed, "EmptyItem", cbuf));
+	REQUIRE(!GetItemString(indexed, "Hidden", cbuf));
+	double d;
+	REQUIRE(GetItemReal(indexed, "size", d));
+	REQUIRE(d == 12.5);
+	bool b;
+	REQUIRE(GetItemBool(indexed, "Flag", b));
+	REQUIRE(b);
+	Vector v;
+	REQUIRE(GetItemVector(indexed, "Vec", v));
+	REQUIRE((v.x == 1.0 && v.y == 2.0 && v.z == 3.0));
+
+	// the stream continues after the matched line, as with the scan
+	REQUIRE(GetItemString(indexed, "Size", cbuf));
+	indexed.getline(cbuf, 256);
+	REQUIRE(string(cbuf) == "EmptyItem =");
+}
+
+TEST_CASE("Indexed lookups match the linear scan for the Config tree", "[ConfigItems]")
+{
+	auto files = ConfigFiles();
+	REQUIRE(!files.empty());
+	for (auto &fname : files) {
+		INFO(fname);
+		std::ifstream scan(fname), indexed(fname);
+		IndexItems(indexed);
+		for (auto &label : ItemLabels(fname)) {
+			INFO(label);
+			Lookup a(scan, label), b(indexed, label);
+			REQUIRE(a == b);
+		}
+	}
+}
+
+// Cost of reading every item of every file in the Config tree, as done
+// when loading vessel classes and planet configurations
+TEST_CASE("Config item lookup performance", "[ConfigItems][!benchmark]")
+{
+	vector<std::pair<string, vector<string>>> files;
+	for (auto &fname : ConfigFiles())
+		files.emplace_back(fname, ItemLabels(fname));
+
+	auto readAll = [&files](bool index) {
+		size_t found = 0;
+		char cbuf[1024];
+		for (auto &f : files) {
+			std::ifstream ifs(f.first);
+			if (index) IndexItems(ifs);
+			for (auto &label : f.second)
+				if (GetItemString(ifs, label.c_str(), cbuf)) found++;
+		}
+		return found;
+	};
+
+	BENCHMARK("Linear scan") {
+		return readAll(false);
+	};
+
+	BENCHMARK("Item index") {
+		return readAll(true);
+	};
+}
@@ -0,0 +1,179 @@
+#include "ElevTileCache.h"
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+using std::vector;
+
+static const double PI = 3.14159265358979323846;
+static const int ELEV_STRIDE = 259; // grid points per tile row, incl. padding
+
+// Stand-in for decoding a tile from the archive
+static ElevTileCache::TilePtr DecodeTile (const ElevTileKey &key)
+{
+	auto t = std::make_shared<ElevTileData>();
+	t->ndat = ELEV_STRIDE*ELEV_STRIDE;
+	t->elev.reset (new int16_t[t->ndat]);
+	for (size_t i = 0; i < t->ndat; i++)
+		t->elev[i] = (int16_t)((key.ilat*31 + key.ilng*17 + i) & 0x3FF);
+	return t;
+}
+
+static ElevTileKey Key (const void *body, int lvl, int ilat, int ilng)
+{
+	ElevTileKey key = {body, lvl, ilat, ilng};
+	return key;
+}
+
+TEST_CASE("Elevation tile cache lookup and LRU eviction", "[ElevTileCache]")
+{
+	static int moon, earth;
+	size_t tilesize = DecodeTile (Key (&moon, 0, 0, 0))->Size();
+	ElevTileCache cache (3*tilesize);
+
+	REQUIRE(!cache.Find (Key (&moon, 5, 1, 2)));
+	for (int i = 0; i < 3; i++)
+		cache.Insert (Key (&moon, 5, 1, i), DecodeTile (Key (&moon, 5, 1, i)));
+	REQUIRE(cache.Count() == 3);
+	REQUIRE(cache.Size() == 3*tilesize);
+
+	// the same indices on another body or level are different tiles
+	REQUIRE(!cache.Find (Key (&earth, 5, 1, 0)));
+	REQUIRE(!cache.Find (Key (&moon, 6, 1, 0)));
+
+	// touch tile 0, so that tile 1 is the least recently used one
+	ElevTileCache::TilePtr t0 = cache.Find (Key (&moon, 5, 1, 0));
+	REQUIRE(t0);
+	cache.Insert (Key (&moon, 5, 1, 3), DecodeTile (Key (&moon, 5, 1, 3)));
+	REQUIRE(cache.Count() == 3);
+	REQUIRE(cache.Find (Key (&moon, 5, 1, 0)) == t0);
+	REQUIRE(!cache.Find (Key (&moon, 5, 1, 1)));
+	REQUIRE(cache.Find (Key (&moon, 5, 1, 2)));
+
+	// inserting an existing key keeps the cached tile
+	REQUIRE(cache.Insert (Key (&moon, 5, 1, 0), DecodeTile (Key (&moon, 5, 1, 0))) == t0);
+
+	// evicted tiles stay valid for their users
+	cache.SetMaxSize (tilesize);
+	REQUIRE(cache.Count() == 1);
+	REQUIRE(t0->elev[0] == (int16_t)((31) & 0x3FF));
+
+	ElevTileCache::Stats st = cache.GetStats();
+	REQUIRE(st.nhit == 3);
+	REQUIRE(st.nmiss == 4);
+	REQUIRE(st.nevict == 3);
+
+	// tiles that don't exist are cached as empty records
+	cache.SetMaxSize (4*tilesize);
+	cache.Insert (Key (&earth, 9, 0, 0), std::make_shared<ElevTileData>());
+	ElevTileCache::TilePtr t = cache.Find (Key (&earth, 9, 0, 0));
+	REQUIRE(t);
+	REQUIRE(!t->elev);
+
+	REQUIRE(cache.Remove (&moon) == 1);
+	REQUIRE(cache.Remove (&earth) == 1);
+	REQUIRE(cache.Count() == 0);
+	REQUIRE(cache.Size() == 0);
+}
+
+// =======================================================================
+// 100 landed and low-flying vessels on the Moon. Each vessel keeps a
+// two-entry tile list (as Vessel::etile) and queries the tile under it
+// every frame. Without the shared cache, each list miss decodes the tile.
+
+struct MoonVessel {
+	double lat, lng;   // position [rad]
+	double dlat, dlng; // motion per frame [rad]
+	struct View {
+		ElevTileCache::TilePtr tile;
+		int ilat = -1, ilng = -1;
+		int last = -1;
+	} view[2];
+};
+
+static vector<MoonVessel> MakeMoonFleet (size_t n)
+{
+	// vessels around a few landing sites; a quarter of them in low flight
+	static const double site[4][2] = {{0.0117, 0.4071}, {-0.1564, -0.0532}, {0.4555, 0.0547}, {-0.1565, -0.3295}};
+	std::mt19937 rng(4321);
+	std::uniform_real_distribution<double> u(-1.0, 1.0);
+	vector<MoonVessel> fleet(n);
+	for (size_t i = 0; i < n; i++) {
+		MoonVessel &v = fleet[i];
+		v.lat = site[i%4][0] + 2e-3*u(rng);
+		v.lng = site[i%4][1] + 2e-3*u(rng);
+		bool flying = (i%4 == 3);
+		v.dlat = flying ? 1e-5*u(rng) : 0.0; // ~17 m per frame
+		v.dlng = flying ? 1e-5*u(rng) : 0.0;
+	}
+	return fleet;
+}
+
+// Run nframe frames, return the number of tile decodes
+static size_t RunFleet (vector<MoonVessel> &fleet, int nframe, int lvl, ElevTileCache *cache)
+{
+	static int moon;
+	size_t ndecode = 0;
+	int nlat = 1 << lvl, nlng = 2 << lvl;
+	for (int f = 0; f < nframe; f++) {
+		for (auto &v : fleet) {
+			v.lat += v.dlat, v.lng += v.dlng;
+			int ilat = (int)((0.5*PI - v.lat)/PI * nlat);
+			int ilng = (int)((v.lng + PI)/(2.0*PI) * nlng);
+			MoonVessel::View *w = 0;
+			for (auto &vw : v.view)
+				if (vw.tile && vw.ilat == ilat && vw.ilng == ilng) { w = &vw; break; }
+			if (!w) {
+				w = (v.view[0].last <= v.view[1].last ? v.view : v.view+1);
+				ElevTileKey key = Key (&moon, lvl, ilat, ilng);
+				ElevTileCache::TilePtr t = (cache ? cache->Find (key) : ElevTileCache::TilePtr());
+				if (!t) {
+					t = DecodeTile (key);
+					ndecode++;
+					if (cache) t = cache->Insert (key, t);
+				}
+				w->tile = t, w->ilat = ilat, w->ilng = ilng;
+			}
+			w->last = f;
+		}
+	}
+	return ndecode;
+}
+
+TEST_CASE("Shared elevation tile cache with 100 vessels on the Moon", "[ElevTileCache]")
+{
+	const int lvl = 9; // about 3.4 km tiles at the lunar equator
+	auto fleet_private = MakeMoonFleet (100);
+	auto fleet_shared = fleet_private;
+	ElevTileCache cache (64 << 20);
+
+	size_t ndecode_private = RunFleet (fleet_private, 200, lvl, 0);
+	size_t ndecode_shared = RunFleet (fleet_shared, 200, lvl, &cache);
+
+	// every tile is decoded once, instead of once per vessel using it
+	REQUIRE(ndecode_shared == cache.Count());
+	REQUIRE(ndecode_shared*5 < ndecode_private);
+	ElevTileCache::Stats st = cache.GetStats();
+	REQUIRE(st.nmiss == ndecode_shared);
+	REQUIRE(st.nhit + st.nmiss == ndecode_private);
+	REQUIRE(st.nevict == 0);
+}
+
+TEST_CASE("Shared elevation tile cache performance", "[ElevTileCache][!benchmark]")
+{
+	const int lvl = 9;
+	BENCHMARK("100 vessels, 200 frames, private tile lists") {
+		auto fleet = MakeMoonFleet (100);
+		return RunFleet (fleet, 200, lvl, 0);
+	};
+	BENCHMARK("100 vessels, 200 frames, shared tile cache") {
+		auto fleet = MakeMoonFleet (100);
+		ElevTileCache cache (64 << 20);
+		return RunFleet (fleet, 200, lvl, &cache);
+	};
+}
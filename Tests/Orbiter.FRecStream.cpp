@@ -0,0 +1,223 @@
+#include "FRecStream.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+using std::string;
+using std::vector;
+
+// Contents of a recorded stream
+struct Recording {
+	vector<FRecItem> item;
+};
+
+// Position stream with header lines of various lengths, regular samples
+// and a gap which requires a time key in binary streams
+static Recording TestRecording ()
+{
+	Recording rec;
+	FRecItem item;
+	auto tag = [&](const string &line) {
+		item.tag = line;
+		item.nv = 0;
+		rec.item.push_back(item);
+	};
+	tag("STARTMJD 51982.529292558");
+	tag("REF Earth");
+	tag(string(47, 'a'));
+	tag(string(48, 'b'));
+	tag("REF " + string(120, 'c'));
+	tag(string(300, 'd') + " END");
+	double t = 0.0;
+	for (int i = 0; i < 200; i++) {
+		if (i == 120) {
+			t += 500.0; // longer than the binary delta time limit
+			tag("FRM EQUATORIAL");
+		}
+		item.tag.clear();
+		item.nv = 6;
+		item.t = t;
+		for (int j = 0; j < 6; j++)
+			item.v[j] = (j < 3 ? 6.7e6 : 7.5e3) * std::sin(0.01*i + j);
+		rec.item.push_back(item);
+		t += 0.25 + 0.01*(i % 7);
+	}
+	return rec;
+}
+
+static void Write (const char *fname, const Recording &rec, bool binary)
+{
+	FRecOStream os;
+	REQUIRE(os.Open(fname, FREC_POS, false, binary));
+	for (auto &item : rec.item) {
+		if (item.nv) os.Sample(item.t, item.v);
+		else         os.Tag(item.tag);
+	}
+	os.Close();
+}
+
+static Recording Read (const char *fname, bool &binary)
+{
+	Recording rec;
+	FRecIStream is;
+	REQUIRE(is.Open(fname));
+	binary = is.IsBinary();
+	FRecItem item;
+	while (is.Next(item))
+		rec.item.push_back(item);
+	return rec;
+}
+
+// Compare recordings. Times must agree to ttol [s], values to the relative
+// tolerance vtol. Header lines must be identical.
+static bool Match (const Recording &a, const Recording &b, double ttol, double vtol)
+{
+	if (a.item.size() != b.item.size()) return false;
+	for (size_t i = 0; i < a.item.size(); i++) {
+		const FRecItem &p = a.item[i], &q = b.item[i];
+		if (p.nv != q.nv) return false;
+		if (!p.nv) {
+			if (p.tag != q.tag) return false;
+			continue;
+		}
+		if (std::fabs(p.t - q.t) > ttol) return false;
+		for (int j = 0; j < p.nv; j++)
+			if (std::fabs(p.v[j] - q.v[j]) > vtol*std::fabs(p.v[j])) return false;
+	}
+	return true;
+}
+
+TEST_CASE("Binary stream round trip", "[FRecStream]")
+{
+	const char *fname = "FRecStream_test.pos";
+	Recording rec = TestRecording();
+	Write(fname, rec, true);
+
+	bool binary;
+	Recording res = Read(fname, binary);
+	REQUIRE(binary);
+	// sample values are stored in full precision, times as float offsets
+	REQUIRE(Match(rec, res, 1e-5, 0.0));
+
+	std::remove(fname);
+}
+
+TEST_CASE("Binary streams convert to text", "[FRecStream]")
+{
+	const char *fname = "FRecStream_test.pos";
+	const char *txtname = "FRecStream_test_txt.pos";
+	const char *refname = "FRecStream_test_ref.pos";
+	Recording rec = TestRecording();
+	Write(fname, rec, true);
+	Write(refname, rec, false);
+
+	REQUIRE(FRecConvertToText(fname, txtname));
+	bool binary;
+	Recording res = Read(txtname, binary);
+	REQUIRE(!binary);
+	Recording ref = Read(refname, binary);
+	REQUIRE(!binary);
+	REQUIRE(Match(ref, res, 1e-5, 1e-9));
+
+	// in-place conversion; text streams are left alone
+	REQUIRE(FRecConvertToText(fname));
+	res = Read(fname, binary);
+	REQUIRE(!binary);
+	REQUIRE(Match(ref, res, 1e-5, 1e-9));
+	REQUIRE(FRecConvertToText(fname));
+
+	std::remove(fname);
+	std::remove(txtname);
+	std::remove(refname);
+}
+
+// Samples of a stream as loaded by the array playback path
+static vector<FRecItem> LoadSamples (const char *fname, int nvmin)
+{
+	vector<FRecItem> sample;
+	FRecIStream is;
+	REQUIRE(is.Open(fname));
+	FRecItem item;
+	while (is.Next(item))
+		if (item.nv >= nvmin) sample.push_back(item);
+	return sample;
+}
+
+static void CheckMapped (const char *fname, int nvmin)
+{
+	vector<FRecItem> sample = LoadSamples(fname, nvmin);
+	FRecMappedStream ms;
+	REQUIRE(ms.Open(fname, nvmin));
+	REQUIRE(ms.nSample() == sample.size());
+
+	// random access, in and across index blocks
+	FRecItem item;
+	for (size_t i = 0; i < sample.size(); i++) {
+		REQUIRE(ms.GetSample(i, item));
+		REQUIRE(item.t == sample[i].t);
+		REQUIRE(item.nv == sample[i].nv);
+		for (int j = 0; j < item.nv; j++)
+			REQUIRE(item.v[j] == sample[i].v[j]);
+	}
+	REQUIRE(!ms.GetSample(sample.size(), item));
+
+	// seeking: number of samples earlier than t
+	auto count = [&sample](double t) {
+		size_t n = 0;
+		while (n < sample.size() && sample[n].t < t) n++;
+		return n;
+	};
+	vector<double> tq = { -1e10, 1e10 };
+	for (size_t i = 0; i < sample.size(); i += 7) {
+		tq.push_back(sample[i].t);
+		tq.push_back(sample[i].t + 0.01);
+		tq.push_back(sample[i].t - 0.01);
+	}
+	for (double t : tq)
+		REQUIRE(ms.Find(t) == count(t));
+}
+
+TEST_CASE("Mapped streams index and seek like the array loader", "[FRecStream]")
+{
+	const char *fname = "FRecStream_test.pos";
+	Recording rec = TestRecording();
+
+	SECTION("Binary stream") {
+		Write(fname, rec, true);
+		CheckMapped(fname, 6);
+	}
+	SECTION("Text stream") {
+		Write(fname, rec, false);
+		CheckMapped(fname, 6);
+	}
+	SECTION("Text stream with incomplete lines") {
+		// numeric lines with too few values are not samples
+		std::ofstream ofs(fname);
+		ofs << "REF Earth\n";
+		for (int i = 0; i < 500; i++) {
+			ofs << i*0.5 << " 1 2 3 4 5 " << i << '\n';
+			if (i % 37 == 5) ofs << i*0.5 + 0.1 << " 1 2\n";
+			if (i % 101 == 50) ofs << "FRM EQUATORIAL\n\n";
+		}
+		ofs.close();
+		CheckMapped(fname, 6);
+		CheckMapped(fname, 2);
+
+		FRecMappedStream ms;
+		REQUIRE(ms.Open(fname, 6));
+		REQUIRE(ms.nSample() == 500);
+		REQUIRE(ms.Segments().size() == 6);
+		REQUIRE(ms.SegmentOf(0) == 0);
+		REQUIRE(ms.SegmentOf(50) == 0);
+		REQUIRE(ms.SegmentOf(51) == 1);
+		REQUIRE(ms.Segments()[1].tag[0] == "FRM EQUATORIAL");
+		REQUIRE(ms.SegmentOf(499) == 5);
+	}
+	std::remove(fname);
+}
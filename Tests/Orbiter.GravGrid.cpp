@@ -0,0 +1,111 @@
+#include "GravGrid.h"
+#include "PinesGrav.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+using std::vector;
+
+// Lunar gravity model, truncated to a degree that builds quickly
+static const int CUTOFF = 30;
+
+static void LoadModel (PinesGravProp &pines)
+{
+	std::string fname = std::string(GRAVITY_MODEL_DIR) + "/jgl165p1.sha";
+	vector<char> buf(fname.begin(), fname.end());
+	buf.push_back('\0');
+	int nloaded, nmodel;
+	REQUIRE(pines.readGravModel(buf.data(), CUTOFF, nloaded, nmodel) == 0);
+	REQUIRE(pines.GetCoeffCutoff() == CUTOFF);
+}
+
+// Random positions between 10 and 160 km altitude, uniformly distributed
+// over the sphere
+static vector<Vector> SamplePoints (double rad, int n)
+{
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<double> u(0.0, 1.0);
+	vector<Vector> pos;
+	for (int i = 0; i < n; i++) {
+		double r = rad + 10.0 + 150.0*u(rng);
+		double lat = std::asin(2.0*u(rng) - 1.0);
+		double lng = 2.0*3.14159265358979323846*u(rng);
+		pos.push_back(Vector(r*std::cos(lat)*std::cos(lng), r*std::cos(lat)*std::sin(lng), r*std::sin(lat)));
+	}
+	return pos;
+}
+
+// Max. interpolation error at the sample points, relative to the max.
+// magnitude of the perturbation
+static double RelError (const PinesGravProp &pines, GravGrid &grid, const vector<Vector> &pos)
+{
+	Vector acc;
+	for (auto &p : pos)
+		grid.Eval(p, acc);
+	grid.Wait();
+
+	double emax = 0.0, gmax = 0.0;
+	for (auto &p : pos) {
+		REQUIRE(grid.Eval(p, acc));
+		Vector g = pines.GetPinesGrav(p, CUTOFF, CUTOFF);
+		emax = std::max(emax, (acc - g).length());
+		gmax = std::max(gmax, g.length());
+	}
+	REQUIRE(gmax > 0.0);
+	return emax / gmax;
+}
+
+TEST_CASE("Tiles are built in the background", "[GravGrid]")
+{
+	PinesGravProp pines(nullptr);
+	LoadModel(pines);
+	GravGrid grid(&pines, 4, 200.0, (size_t)1 << 30);
+	Vector pos(pines.GetRefRadius() + 100.0, 0.0, 0.0), acc;
+
+	// the first lookup queues the tile, and the caller falls back to the model
+	REQUIRE(!grid.Eval(pos, acc));
+	grid.Wait();
+	REQUIRE(grid.nBuilt() == 1);
+	REQUIRE(grid.Eval(pos, acc));
+
+	// outside the grid
+	REQUIRE(!grid.Eval(Vector(pines.GetRefRadius() + 1000.0, 0.0, 0.0), acc));
+	REQUIRE(grid.nBuilt() == 1);
+}
+
+TEST_CASE("Lookups fail once the memory limit is reached", "[GravGrid]")
+{
+	PinesGravProp pines(nullptr);
+	LoadModel(pines);
+	GravGrid grid(&pines, 4, 200.0, 1);
+	Vector acc;
+	REQUIRE(!grid.Eval(Vector(pines.GetRefRadius() + 100.0, 0.0, 0.0), acc));
+	grid.Wait();
+	REQUIRE(grid.nBuilt() == 0);
+}
+
+TEST_CASE("Interpolation error is within the error bound", "[GravGrid]")
+{
+	PinesGravProp pines(nullptr);
+	LoadModel(pines);
+	vector<Vector> pos = SamplePoints(pines.GetRefRadius(), 2000);
+
+	GravGrid coarse(&pines, 4, 200.0, (size_t)1 << 30);
+	double ecoarse = RelError(pines, coarse, pos);
+	INFO("S=4: error " << ecoarse << ", bound " << coarse.ErrorBound());
+	REQUIRE(ecoarse < coarse.ErrorBound());
+
+	GravGrid fine(&pines, 8, 200.0, (size_t)1 << 30);
+	double efine = RelError(pines, fine, pos);
+	INFO("S=8: error " << efine << ", bound " << fine.ErrorBound());
+	REQUIRE(efine < fine.ErrorBound());
+
+	// the error scales with the square of the node spacing
+	REQUIRE(efine < 0.5*ecoarse);
+}
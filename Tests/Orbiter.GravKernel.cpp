@@ -0,0 +1,80 @@
+#include "GravKernel.h"
+
+#include <cmath>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+// Jupiter and its Galilean moons, with positions relative to Jupiter [m]
+static GravSources JupiterSystem ()
+{
+	static const double body[5][4] = {
+		{ 0.0, 0.0, 0.0, 1.26686534e17 },
+		{ 4.217e8, 0.0, 1.2e6, 5.959916e12 },
+		{ -3.3e8, 5.2e8, -2.0e6, 3.202739e12 },
+		{ 1.0e8, -1.06e9, 4.1e6, 9.887834e12 },
+		{ -1.882e9, 2.0e7, 0.0, 7.179289e12 }
+	};
+	GravSources src;
+	src.Resize (5);
+	for (int i = 0; i < 5; i++)
+		src.Set (i, body[i][0], body[i][1], body[i][2], body[i][3]);
+	return src;
+}
+
+static void Reference (const GravSources &src, const double *p, const int *idx, int nidx, double *acc)
+{
+	acc[0] = acc[1] = acc[2] = 0.0;
+	for (int k = 0; k < nidx; k++) {
+		int i = idx[k];
+		double dx = src.x[i]-p[0], dy = src.y[i]-p[1], dz = src.z[i]-p[2];
+		double d = std::sqrt (dx*dx + dy*dy + dz*dz);
+		double f = src.gm[i] / (d*d*d);
+		acc[0] += dx*f, acc[1] += dy*f, acc[2] += dz*f;
+	}
+}
+
+static bool Close (const double *a, const double *b)
+{
+	double len = std::sqrt (b[0]*b[0] + b[1]*b[1] + b[2]*b[2]);
+	for (int i = 0; i < 3; i++)
+		if (std::fabs (a[i]-b[i]) > 1e-14*len) return false;
+	return true;
+}
+
+TEST_CASE("Packed kernels match the point-mass sum", "[GravKernel]")
+{
+	GravSources src = JupiterSystem();
+	REQUIRE(src.x.size() % GRAV_SIMD_WIDTH == 0);
+	REQUIRE((int)src.x.size() > src.n);
+
+	const double p[3][3] = {
+		{ 7.1e7, 1.0e6, -3.0e5 },   // low Jupiter orbit
+		{ 4.2e8, 2.0e6, 1.0e6 },    // close to Io
+		{ -1.5e9, 9.0e8, 3.0e7 }
+	};
+	const int all[5] = { 0, 1, 2, 3, 4 };
+	const int sub[4][4] = { {2}, {4, 0}, {1, 3, 0}, {3, 2, 1, 4} };
+	GravSimdLevel maxlevel = GravSimdSupported();
+
+	for (int level = GRAV_SIMD_SCALAR; level <= maxlevel; level++) {
+		double acc[3], ref[3];
+		for (int j = 0; j < 3; j++) {
+			// all sources
+			Reference (src, p[j], all, 5, ref);
+			GravAcc (src, p[j], 0, 0, acc, (GravSimdLevel)level);
+			REQUIRE(Close (acc, ref));
+			GravAcc (src, p[j], all, 5, acc, (GravSimdLevel)level);
+			REQUIRE(Close (acc, ref));
+
+			// index lists of all lengths up to the lane width
+			for (int n = 1; n <= 4; n++) {
+				Reference (src, p[j], sub[n-1], n, ref);
+				GravAcc (src, p[j], sub[n-1], n, acc, (GravSimdLevel)level);
+				REQUIRE(Close (acc, ref));
+			}
+		}
+		GravAcc (src, p[0], all, 0, acc, (GravSimdLevel)level);
+		REQUIRE((acc[0] == 0.0 && acc[1] == 0.0 && acc[2] == 0.0));
+	}
+}
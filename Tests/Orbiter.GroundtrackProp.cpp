@@ -0,0 +1,163 @@
+#include "GroundtrackProp.h"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+static const double MU = 3.986004418e14; // Earth
+static const double RAD = 6.371e6;
+static const double J2 = 1.0826e-3;
+
+static const GroundtrackProp::Track *WaitTrack (GroundtrackProp &prop)
+{
+	while (prop.Busy())
+		std::this_thread::sleep_for (std::chrono::milliseconds(1));
+	return prop.Current();
+}
+
+// Circular orbit of radius a with inclination inc against the body's equator
+// (the body's local xz-plane)
+static GroundtrackProp::Model CircularOrbit (double a, double inc)
+{
+	GroundtrackProp::Model m;
+	m.pos = Vector (a, 0, 0);
+	m.vel = Vector (0, sin(inc), cos(inc)) * sqrt (MU/a);
+	m.mu = MU;
+	m.rad = RAD;
+	m.rot0 = Matrix (1,0,0, 0,1,0, 0,0,1);
+	m.step = 20.0;
+	m.span = 3.0 * Pi2 * sqrt (a*a*a/MU);
+	m.rmax = 1e3*RAD;
+	return m;
+}
+
+// J2 perturbation, with the pole along the body's local y-axis
+static Vector J2Acc (const Vector &r, const Matrix &rot)
+{
+	Vector l (tmul (rot, r));
+	double d2 = l.length2(), d = sqrt(d2);
+	double f = -1.5 * J2 * MU * RAD*RAD / (d2*d2*d);
+	double s = 5.0*l.y*l.y/d2;
+	return mul (rot, Vector (l.x*(1.0-s), l.y*(3.0-s), l.z*(1.0-s)) * f);
+}
+
+static double NodeLng (const Vector &pos, const Vector &vel)
+{
+	Vector h (crossp (pos, vel));
+	return atan2 (h.z, h.x);
+}
+
+TEST_CASE("Unperturbed propagation follows the Kepler orbit", "[GroundtrackProp]")
+{
+	const double a = 6.778e6;
+	const double n = sqrt (MU/(a*a*a));
+	GroundtrackProp prop;
+	prop.Restart (CircularOrbit (a, 0.0));
+	const GroundtrackProp::Track *trk = WaitTrack (prop);
+
+	REQUIRE(trk->vtx.size() > 100);
+	REQUIRE(trk->vtx.back().t >= 3.0 * Pi2/n);
+	for (size_t i = 0; i < trk->vtx.size(); i++) {
+		const VPointGT &p = trk->vtx[i];
+		REQUIRE(fabs (p.rad - a/RAD) < 1e-6);
+		REQUIRE(fabs (diffangle (p.lng, n*p.t)) < 1e-6);
+		REQUIRE(fabs (p.lat) < 1e-9);
+	}
+
+	// interpolation between the vertices
+	Vector p;
+	double t = 1234.5;
+	REQUIRE(trk->Interpolate (t, p));
+	REQUIRE((p - Vector (cos(n*t), 0, sin(n*t)) * a).length() < 1.0);
+	REQUIRE(!trk->Interpolate (-1.0, p));
+}
+
+TEST_CASE("Groundtrack longitude follows the body rotation", "[GroundtrackProp]")
+{
+	const double a = 6.778e6;
+	const double n = sqrt (MU/(a*a*a));
+	GroundtrackProp::Model m = CircularOrbit (a, 0.0);
+	m.omega = Pi2/86164.1;
+	GroundtrackProp prop;
+	prop.Restart (m);
+	const GroundtrackProp::Track *trk = WaitTrack (prop);
+	for (size_t i = 0; i < trk->vtx.size(); i++) {
+		const VPointGT &p = trk->vtx[i];
+		REQUIRE(fabs (diffangle (p.lng, (n - m.omega)*p.t)) < 1e-6);
+	}
+}
+
+TEST_CASE("J2 perturbation causes nodal regression", "[GroundtrackProp]")
+{
+	const double a = 6.778e6, inc = 51.6*Pi/180.0;
+	const double n = sqrt (MU/(a*a*a));
+	GroundtrackProp::Model m = CircularOrbit (a, inc);
+	m.pert = J2Acc;
+	GroundtrackProp prop;
+	prop.Restart (m);
+	const GroundtrackProp::Track *trk = WaitTrack (prop);
+
+	// compare the node at the same orbital phase, three orbits later
+	size_t i1 = (size_t)(3.0*Pi2/n/m.step + 0.5);
+	REQUIRE(i1 < trk->vtx.size());
+	double dnode = diffangle (NodeLng (trk->pos[i1], trk->vel[i1]), NodeLng (trk->pos[0], trk->vel[0]));
+	double dnode_analytic = 1.5 * n * J2 * (RAD/a)*(RAD/a) * cos(inc) * trk->vtx[i1].t;
+	REQUIRE(fabs (dnode) > 0.9*dnode_analytic);
+	REQUIRE(fabs (dnode) < 1.1*dnode_analytic);
+}
+
+TEST_CASE("Drag lowers the orbit", "[GroundtrackProp]")
+{
+	const double a = 6.571e6;
+	GroundtrackProp::Model m = CircularOrbit (a, 0.0);
+	GroundtrackProp prop, prop_drag;
+	prop.Restart (m);
+	m.dragk = 0.02;
+	m.altmax = 400e3;
+	for (int i = 0; i <= 40; i++)
+		m.lnrho.push_back (log (1.225) - i*10e3/8.5e3);
+	prop_drag.Restart (m);
+
+	const GroundtrackProp::Track *trk = WaitTrack (prop);
+	const GroundtrackProp::Track *trk_drag = WaitTrack (prop_drag);
+	REQUIRE(trk->vtx.size() == trk_drag->vtx.size());
+	REQUIRE(trk_drag->vtx.back().rad < trk->vtx.back().rad - 1e-5);
+}
+
+TEST_CASE("Extension continues the existing track", "[GroundtrackProp]")
+{
+	const double a = 6.778e6;
+	GroundtrackProp::Model m = CircularOrbit (a, 0.3);
+	m.pert = J2Acc;
+	GroundtrackProp prop;
+	prop.Restart (m);
+	const GroundtrackProp::Track *trk = WaitTrack (prop);
+	REQUIRE(trk->seq == prop.Seq());
+	size_t n0 = trk->vtx.size();
+	double tend0 = trk->vtx.back().t;
+	Vector p_last = trk->pos.back();
+
+	const double text = 2000.0;
+	prop.Extend (text);
+	trk = WaitTrack (prop);
+	REQUIRE(trk->vtx[0].t <= text);
+	REQUIRE(trk->vtx[1].t > text);
+	REQUIRE(trk->vtx.back().t >= text + m.span);
+
+	// the vertices of the previous track are retained unchanged
+	size_t ndrop = (size_t)(text/m.step);
+	REQUIRE(trk->pos[n0-1-ndrop].x == p_last.x);
+	REQUIRE(trk->vtx[n0-1-ndrop].t == tend0);
+
+	// a restart replaces the track
+	prop.Restart (m);
+	trk = WaitTrack (prop);
+	REQUIRE(trk->vtx[0].t == 0.0);
+
+	prop.Clear();
+	trk = WaitTrack (prop);
+	REQUIRE(trk->vtx.empty());
+}
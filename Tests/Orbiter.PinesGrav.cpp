@@ -0,0 +1,101 @@
+#include "Vecmat.h"
+#include "PinesGrav.h"
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+using std::vector;
+
+// Lunar gravity model, truncated to a degree that loads quickly
+static const int CUTOFF = 60;
+
+static void LoadModel (PinesGravProp &pines)
+{
+	std::string fname = std::string(GRAVITY_MODEL_DIR) + "/jgl165p1.sha";
+	vector<char> buf(fname.begin(), fname.end());
+	buf.push_back('\0');
+	int nloaded, nmodel;
+	REQUIRE(pines.readGravModel(buf.data(), CUTOFF, nloaded, nmodel) == 0);
+	REQUIRE(pines.GetCoeffCutoff() == CUTOFF);
+}
+
+// Random positions between 10 and 2000 km altitude, including points
+// close to the poles
+static vector<Vector> SamplePoints (double rad, int n)
+{
+	std::mt19937 rng(2);
+	std::uniform_real_distribution<double> u(0.0, 1.0);
+	vector<Vector> pos;
+	for (int i = 0; i < n; i++) {
+		double r = rad + 10.0 + 1990.0*u(rng);
+		double lat = (i % 10 ? std::asin(2.0*u(rng) - 1.0) : 1.5707963 - 1e-6*u(rng));
+		double lng = 2.0*3.14159265358979323846*u(rng);
+		pos.push_back(Vector(r*std::cos(lat)*std::cos(lng), r*std::cos(lat)*std::sin(lng), r*std::sin(lat)));
+	}
+	return pos;
+}
+
+static bool Identical (const Vector &a, const Vector &b)
+{
+	return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+TEST_CASE("Batch evaluation is bit-identical to single evaluations", "[PinesGrav]")
+{
+	PinesGravProp pines(nullptr);
+	LoadModel(pines);
+	vector<Vector> pos = SamplePoints(pines.GetRefRadius(), 103);
+	PinesGravProp::Workspace ws;
+
+	const int prm[][2] = { {CUTOFF, CUTOFF}, {CUTOFF, 10}, {17, 17}, {2, 0} };
+	for (auto &p : prm) {
+		vector<Vector> ref(pos.size());
+		for (size_t i = 0; i < pos.size(); i++)
+			ref[i] = pines.GetPinesGrav(pos[i], p[0], p[1]);
+
+		// all batch lengths, including partial groups
+		for (int n = 1; n <= (int)pos.size(); n += (n < 2*PinesGravProp::PINES_BATCH ? 1 : 19)) {
+			vector<Vector> g(n);
+			pines.GetPinesGravBatch(pos.data(), g.data(), n, p[0], p[1], ws);
+			for (int i = 0; i < n; i++)
+				REQUIRE(Identical(g[i], ref[i]));
+		}
+
+		// single evaluation with an explicit workspace
+		for (size_t i = 0; i < pos.size(); i++)
+			REQUIRE(Identical(pines.GetPinesGrav(pos[i], p[0], p[1], ws), ref[i]));
+	}
+}
+
+TEST_CASE("Concurrent evaluations of the same field agree", "[PinesGrav]")
+{
+	PinesGravProp pines(nullptr);
+	LoadModel(pines);
+	vector<Vector> pos = SamplePoints(pines.GetRefRadius(), 64);
+	vector<Vector> ref(pos.size());
+	for (size_t i = 0; i < pos.size(); i++)
+		ref[i] = pines.GetPinesGrav(pos[i], CUTOFF, CUTOFF);
+
+	const int nthread = 4;
+	vector<vector<Vector>> res(nthread, vector<Vector>(pos.size()));
+	vector<std::thread> thread;
+	for (int t = 0; t < nthread; t++) {
+		thread.emplace_back([&, t]() {
+			PinesGravProp::Workspace ws;
+			for (int k = 0; k < 20; k++) {
+				if (t % 2) pines.GetPinesGravBatch(pos.data(), res[t].data(), (int)pos.size(), CUTOFF, CUTOFF, ws);
+				else for (size_t i = 0; i < pos.size(); i++) res[t][i] = pines.GetPinesGrav(pos[i], CUTOFF, CUTOFF);
+			}
+		});
+	}
+	for (auto &th : thread) th.join();
+	for (int t = 0; t < nthread; t++)
+		for (size_t i = 0; i < pos.size(); i++)
+			REQUIRE(Identical(res[t][i], ref[i]));
+}
@@ -0,0 +1,98 @@
+#include "ProxIndex.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+using std::string;
+using std::vector;
+
+// Minimal stand-in for a vessel: the index only needs GPos() and Size()
+struct DummyVessel {
+	Vector pos;
+	double size;
+	const Vector &GPos() const { return pos; }
+	double Size() const { return size; }
+};
+
+// Scatter n vessels around a low Earth orbit shell
+static vector<DummyVessel> MakeFleet (size_t n)
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<double> u(-1.0, 1.0);
+	vector<DummyVessel> fleet(n);
+	for (auto &v : fleet) {
+		Vector dir(u(rng), u(rng), u(rng));
+		dir /= dir.length();
+		v.pos = dir * (6.771e6 + 1e5*u(rng));
+		v.size = 10.0 + 5.0*u(rng);
+	}
+	return fleet;
+}
+
+static DummyVessel *NearestBruteForce (vector<DummyVessel*> &list, const DummyVessel *self)
+{
+	DummyVessel *best = 0;
+	double bestd2 = 1e100;
+	for (auto v : list) {
+		if (v == self) continue;
+		double d2 = (v->pos - self->pos).length2();
+		if (d2 < bestd2) bestd2 = d2, best = v;
+	}
+	return best;
+}
+
+// Test that index queries agree with a linear scan
+TEST_CASE("Proximity index matches linear scan", "[ProxIndex]")
+{
+	auto fleet = MakeFleet(1000);
+	vector<DummyVessel*> list;
+	for (auto &v : fleet) list.push_back(&v);
+
+	ProximityIndex<DummyVessel> idx;
+	idx.Build(list);
+	REQUIRE(idx.Size() == list.size());
+
+	for (auto v : list) {
+		REQUIRE(idx.Nearest(v->pos, v) == NearestBruteForce(list, v));
+
+		vector<DummyVessel*> within;
+		idx.Within(v->pos, 2e5, within, v);
+		size_t n = 0;
+		for (auto w : list)
+			if (w != v && (w->pos - v->pos).length2() <= 4e10) n++;
+		REQUIRE(within.size() == n);
+	}
+
+	idx.Clear();
+	REQUIRE(idx.Nearest(list[0]->pos) == nullptr);
+}
+
+// Per-frame cost of finding every vessel's closest neighbour
+TEST_CASE("Proximity index scaling", "[ProxIndex][!benchmark]")
+{
+	for (size_t n : {10, 100, 1000, 5000}) {
+		auto fleet = MakeFleet(n);
+		vector<DummyVessel*> list;
+		for (auto &v : fleet) list.push_back(&v);
+
+		BENCHMARK("Linear scan, " + std::to_string(n) + " vessels") {
+			size_t found = 0;
+			for (auto v : list)
+				if (NearestBruteForce(list, v)) found++;
+			return found;
+		};
+
+		BENCHMARK("Index build + query, " + std::to_string(n) + " vessels") {
+			ProximityIndex<DummyVessel> idx;
+			idx.Build(list);
+			size_t found = 0;
+			for (auto v : list)
+				if (idx.Nearest(v->pos, v)) found++;
+			return found;
+		};
+	}
+}
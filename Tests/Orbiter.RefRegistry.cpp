@@ -0,0 +1,139 @@
+#include "RefRegistry.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+using std::string;
+using std::vector;
+
+// Minimal stand-in for a mesh
+struct DummyMesh {
+	string name;
+	vector<float> vtx;
+};
+
+static DummyMesh *Load (const string &name)
+{
+	DummyMesh *mesh = new DummyMesh;
+	mesh->name = name;
+	mesh->vtx.resize (64);
+	return mesh;
+}
+
+// The previous mesh manager registry: linear CRC scan over a list
+// growing in blocks of 32 entries
+class LinearRegistry {
+public:
+	~LinearRegistry () {
+		for (int i = 0; i < n; i++) delete list[i].mesh;
+		delete []list;
+	}
+	DummyMesh *Load (const char *fname) {
+		unsigned long long crc = Crc (fname);
+		for (int i = 0; i < n; i++)
+			if (crc == list[i].crc && !_strnicmp (fname, list[i].fname, 32))
+				return list[i].mesh;
+		if (n == nbuf) {
+			Entry *tmp = new Entry[nbuf += 32];
+			if (n) {
+				memcpy (tmp, list, n*sizeof(Entry));
+				delete []list;
+			}
+			list = tmp;
+		}
+		list[n].mesh = ::Load (fname);
+		list[n].crc = crc;
+		strncpy (list[n].fname, fname, 32);
+		return list[n++].mesh;
+	}
+private:
+	static unsigned long long Crc (const char *str) {
+		unsigned long long crc = 0;
+		for (const char *c = str; *c; c++) crc += (unsigned long long)*c;
+		return crc;
+	}
+	struct Entry {
+		DummyMesh *mesh;
+		unsigned long long crc;
+		char fname[32];
+	} *list = 0;
+	int n = 0, nbuf = 0;
+};
+
+static DummyMesh *Load (RefRegistry<DummyMesh> &reg, const string &name)
+{
+	DummyMesh *mesh = reg.Acquire (name.c_str());
+	return mesh ? mesh : reg.Insert (name.c_str(), Load (name));
+}
+
+// Mesh names of the given prefix, numbered consecutively
+static vector<string> MakeNames (size_t n, const string &prefix = "Station\\Segment")
+{
+	vector<string> names;
+	for (size_t i = 0; i < n; i++)
+		names.push_back (prefix + std::to_string (i));
+	return names;
+}
+
+TEST_CASE("Registry lookup and reference counting", "[RefRegistry]")
+{
+	RefRegistry<DummyMesh> reg;
+	DummyMesh *a = Load (reg, "DeltaGlider\\DeltaGlider");
+	REQUIRE(reg.Size() == 1);
+	REQUIRE(reg.RefCount (a) == 1);
+
+	// case-insensitive, repeated loads return the same object
+	REQUIRE(Load (reg, "deltaglider\\DELTAGLIDER") == a);
+	REQUIRE(reg.RefCount (a) == 2);
+
+	// names are not truncated
+	auto names = MakeNames (2, "Contrib\\StationKit\\Modules\\Segment");
+	REQUIRE(names[0].size() > 32);
+	DummyMesh *b = Load (reg, names[0]);
+	DummyMesh *c = Load (reg, names[1]);
+	REQUIRE(b != c);
+	REQUIRE(reg.Size() == 3);
+
+	// eviction only releases unreferenced objects
+	REQUIRE(reg.Release (a));
+	REQUIRE(reg.Release (b));
+	REQUIRE(!reg.Release (b));
+	REQUIRE(reg.Evict() == 1);
+	REQUIRE(reg.RefCount (b) == -1);
+	REQUIRE(reg.Acquire (names[0].c_str()) == nullptr);
+	REQUIRE(reg.RefCount (a) == 1);
+	REQUIRE(reg.Release (a));
+	REQUIRE(reg.Release (c));
+	REQUIRE(reg.Evict() == 2);
+	REQUIRE(reg.Size() == 0);
+}
+
+// Cost of loading N distinct meshes, each requested 10 times
+TEST_CASE("Registry scaling", "[RefRegistry][!benchmark]")
+{
+	for (size_t n : {10, 100, 1000, 5000}) {
+		auto names = MakeNames (n);
+
+		BENCHMARK("Linear CRC scan, " + std::to_string(n) + " meshes") {
+			LinearRegistry reg;
+			size_t found = 0;
+			for (int rep = 0; rep < 10; rep++)
+				for (auto &name : names)
+					if (reg.Load (name.c_str())) found++;
+			return found;
+		};
+
+		BENCHMARK("Hashed registry, " + std::to_string(n) + " meshes") {
+			RefRegistry<DummyMesh> reg;
+			size_t found = 0;
+			for (int rep = 0; rep < 10; rep++)
+				for (auto &name : names)
+					if (Load (reg, name)) found++;
+			return found;
+		};
+	}
+}
@@ -0,0 +1,163 @@
+#include "StarCatalogue.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+static const double PI = 3.14159265358979323846;
+
+// Synthetic star field: uniform on the sphere, magnitudes roughly
+// following the star count increase towards fainter stars
+static std::vector<StarBinRec> Stars (int n)
+{
+	std::vector<StarBinRec> src (n);
+	unsigned int seed = 12345;
+	auto rnd = [&]() { seed = seed*1664525u + 1013904223u; return (seed >> 8) / 16777216.0; };
+	for (int i = 0; i < n; i++) {
+		src[i].lng = (float)(2.0*PI*rnd());
+		src[i].lat = (float)asin (2.0*rnd() - 1.0);
+		src[i].mag = (float)(-1.5 + 9.5*pow (rnd(), 0.3));
+		src[i].specidx = (uint16_t)(rnd()*70.0);
+	}
+	// a few stars exactly at the poles and on the longitude seam
+	src[0].lat = (float)(0.5*PI); src[1].lat = (float)(-0.5*PI);
+	src[2].lng = 0.0f; src[3].lng = (float)(2.0*PI);
+	return src;
+}
+
+static std::vector<const StarCatRec*> BruteForce (const StarCatalogue &cat, const double *dir, double radius, double maxmag)
+{
+	std::vector<const StarCatRec*> res;
+	const StarCatRec *rec = cat.Records();
+	double cosr = cos (radius);
+	for (uint32_t i = 0; i < cat.Count(); i++)
+		if (rec[i].mag < maxmag && (!dir || rec[i].x*dir[0] + rec[i].y*dir[1] + rec[i].z*dir[2] >= cosr))
+			res.push_back (rec+i);
+	return res;
+}
+
+static bool SameSet (std::vector<const StarCatRec*> a, std::vector<const StarCatRec*> b)
+{
+	std::sort (a.begin(), a.end());
+	std::sort (b.begin(), b.end());
+	return a == b;
+}
+
+TEST_CASE("Full-sky query returns the brightest stars in order", "[StarCatalogue]")
+{
+	std::vector<StarBinRec> src = Stars (50000);
+	StarCatalogue cat;
+	REQUIRE(cat.Create (src));
+	REQUIRE(cat.IsOpen());
+	REQUIRE(!cat.IsMapped());
+	REQUIRE(cat.Count() == src.size());
+
+	std::vector<const StarCatRec*> res;
+	const double maxmag[6] = { -5.0, 0.0, 3.25, 5.0, 6.7, 20.0 };
+	for (int k = 0; k < 6; k++) {
+		cat.Query (maxmag[k], res);
+		REQUIRE(SameSet (res, BruteForce (cat, 0, 0, maxmag[k])));
+		for (size_t i = 1; i < res.size(); i++)
+			REQUIRE(res[i-1]->mag <= res[i]->mag);
+	}
+	REQUIRE(res.size() == src.size());
+}
+
+TEST_CASE("Cone query matches a brute-force search", "[StarCatalogue]")
+{
+	StarCatalogue cat;
+	REQUIRE(cat.Create (Stars (50000)));
+	const StarCatHeader *h = cat.Header();
+
+	std::vector<const StarCatRec*> res;
+	const double dirs[6][3] = {
+		{ 1, 0, 0 },        // on the longitude seam
+		{ 0, 1, 0 },        // north pole
+		{ 0.2, -1, 0.1 },   // near the south pole
+		{ -0.6, 0.3, -0.7 },
+		{ 0.99, 0.05, -0.01 },
+		{ 0, 0, 1 }
+	};
+	const double radius[5] = { 0.01, 0.1, 0.5, 1.5, 3.2 };
+	for (int i = 0; i < 6; i++) {
+		double len = sqrt (dirs[i][0]*dirs[i][0] + dirs[i][1]*dirs[i][1] + dirs[i][2]*dirs[i][2]);
+		double dir[3] = { dirs[i][0]/len, dirs[i][1]/len, dirs[i][2]/len };
+		for (int j = 0; j < 5; j++) {
+			cat.Query (dir, radius[j], 6.0, res);
+			REQUIRE(SameSet (res, BruteForce (cat, dir, radius[j], 6.0)));
+			// ordered by magnitude bucket
+			for (size_t k = 1; k < res.size(); k++)
+				REQUIRE(res[k-1]->mag < res[k]->mag + h->dmag);
+		}
+	}
+}
+
+TEST_CASE("Catalogue file is memory-mapped", "[StarCatalogue]")
+{
+	const char *fname = "Orbiter.StarCatalogue.cat";
+	std::vector<StarBinRec> src = Stars (5000);
+	REQUIRE(StarCatalogue::Write (fname, src));
+
+	StarCatalogue mem, file;
+	REQUIRE(mem.Create (src));
+	REQUIRE(file.Open (fname));
+	REQUIRE(file.IsMapped());
+	REQUIRE(file.Count() == mem.Count());
+	for (uint32_t i = 0; i < file.Count(); i++) {
+		REQUIRE(file.Records()[i].x == mem.Records()[i].x);
+		REQUIRE(file.Records()[i].mag == mem.Records()[i].mag);
+		REQUIRE(file.Records()[i].specidx == mem.Records()[i].specidx);
+	}
+	std::vector<const StarCatRec*> res;
+	const double dir[3] = { 0, 0, -1 };
+	file.Query (dir, 0.3, 4.0, res);
+	REQUIRE(SameSet (res, BruteForce (file, dir, 0.3, 4.0)));
+	file.Close();
+	REQUIRE(!file.IsOpen());
+
+	// star.bin files are not catalogues
+	FILE *f = fopen (fname, "wb");
+	fwrite (src.data(), sizeof(StarBinRec), src.size(), f);
+	fclose (f);
+	REQUIRE(!file.Open (fname));
+	std::vector<StarBinRec> bin;
+	REQUIRE(StarCatalogue::ReadStarBin (fname, bin));
+	REQUIRE(bin.size() == src.size());
+	REQUIRE(bin[10].mag == src[10].mag);
+	remove (fname);
+}
+
+TEST_CASE("Catalogue files with a corrupt index are rejected", "[StarCatalogue]")
+{
+	const char *fname = "Orbiter.StarCatalogue.cat";
+	REQUIRE(StarCatalogue::Write (fname, Stars (5000)));
+	FILE *f = fopen (fname, "rb");
+	fseek (f, 0, SEEK_END);
+	std::vector<char> data (ftell (f));
+	fseek (f, 0, SEEK_SET);
+	REQUIRE(fread (data.data(), 1, data.size(), f) == data.size());
+	fclose (f);
+	const StarCatHeader *h = (const StarCatHeader*)data.data();
+	uint32_t nidx = h->nbucket*h->nband*h->nlng + 1;
+	uint32_t *x = (uint32_t*)(data.data() + sizeof(StarCatHeader));
+
+	auto open = [&](uint32_t i, uint32_t val) {
+		std::vector<char> bad = data;
+		((uint32_t*)(bad.data() + sizeof(StarCatHeader)))[i] = val;
+		f = fopen (fname, "wb");
+		fwrite (bad.data(), 1, bad.size(), f);
+		fclose (f);
+		StarCatalogue cat;
+		return cat.Open (fname);
+	};
+	uint32_t mid = nidx/2;
+	REQUIRE(x[mid] > 0);
+	REQUIRE(open (mid, x[mid]));                // unchanged
+	REQUIRE(!open (mid, h->nrec + 1000));       // beyond the record table
+	REQUIRE(!open (mid, x[mid+1] + 1));         // out of order
+	REQUIRE(!open (nidx-1, h->nrec - 1));       // wrong record count
+	remove (fname);
+}
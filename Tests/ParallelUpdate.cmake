@@ -0,0 +1,24 @@
+# Runs the ParallelUpdate scenario with serial and threaded vessel updates
+# and checks that the final vessel states are bit-identical.
+# Arguments: SERVER (Orbiter executable), SCENARIO, WORKDIR
+
+foreach(nthread 0 4)
+	file(REMOVE ${WORKDIR}/ParallelUpdate.out)
+	execute_process(
+		COMMAND ${SERVER} --scenariox=${SCENARIO} --fixedstep=0.5 --updatethreads=${nthread}
+		WORKING_DIRECTORY ${WORKDIR}
+		RESULT_VARIABLE res
+	)
+	if(NOT res EQUAL 0 OR NOT EXISTS ${WORKDIR}/ParallelUpdate.out)
+		message(FATAL_ERROR "ParallelUpdate scenario failed with ${nthread} update threads")
+	endif()
+	file(RENAME ${WORKDIR}/ParallelUpdate.out ${WORKDIR}/ParallelUpdate.${nthread}.out)
+endforeach()
+
+execute_process(
+	COMMAND ${CMAKE_COMMAND} -E compare_files ${WORKDIR}/ParallelUpdate.0.out ${WORKDIR}/ParallelUpdate.4.out
+	RESULT_VARIABLE res
+)
+if(NOT res EQUAL 0)
+	message(FATAL_ERROR "Vessel states differ between serial and threaded updates")
+endif()
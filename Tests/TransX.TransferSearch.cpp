@@ -0,0 +1,167 @@
+#include "transfersearch.h"
+
+#include <chrono>
+#include <cmath>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+static const double MU_SUN = 1.32712440018e20;
+static const double DAY = 86400.0;
+
+// Circular orbit of radius a about the Sun, inclined by inc against the
+// ecliptic, at longitude lng0 at MJD 0
+static void Circular (double a, double inc, double lng0, double mjd, VECTOR3 *p, VECTOR3 *v)
+{
+	double n = sqrt (MU_SUN/(a*a*a));
+	double l = lng0 + n*mjd*DAY;
+	double ci = cos(inc), si = sin(inc);
+	*p = _V(cos(l), -sin(l)*si, sin(l)*ci) * a;
+	*v = _V(-sin(l), -cos(l)*si, cos(l)*ci) * (a*n);
+}
+
+static TransferSearch::Ephemeris Table (double a, double inc, double lng0, double mjd0, double mjd1)
+{
+	TransferSearch::Ephemeris eph;
+	eph.mjd0 = mjd0;
+	eph.dt = 1.0;
+	for (double mjd = mjd0; mjd <= mjd1 + 1.0; mjd += eph.dt) {
+		VECTOR3 p, v;
+		Circular (a, inc, lng0, mjd, &p, &v);
+		eph.pos.push_back (p);
+		eph.vel.push_back (v);
+	}
+	return eph;
+}
+
+static const double A_EARTH = 1.0*AU;
+static const double A_MARS = 1.5237*AU;
+static const double I_MARS = 1.85*PI/180.0;
+static const double SYNODIC = 780.0;
+
+static TransferSearch::Grid EarthMarsGrid ()
+{
+	return TransferSearch::DefaultGrid (0.0, SYNODIC, MU_SUN, A_EARTH, A_MARS);
+}
+
+static double MaxArrival (const TransferSearch::Grid &g)
+{
+	return g.dep0 + (g.ndep-1)*g.ddep + g.tof0 + (g.ntof-1)*g.dtof;
+}
+
+TEST_CASE("Lambert solver reproduces Kepler arcs", "[TransferSearch]")
+{
+	const double vc = sqrt (MU_SUN/AU);
+	const VECTOR3 r1 = _V(AU, 0, 0);
+	const VECTOR3 vel[2] = { _V(0, 0.05*vc, 1.1*vc), _V(0.3*vc, 0.1*vc, 1.6*vc) };
+	const double tof[5] = { 30*DAY, 100*DAY, 200*DAY, 300*DAY, 0.0 };
+
+	for (int k = 0; k < 2; k++) {
+		VECTOR3 r2[5], u2[5], v1[5], v2[5];
+		bool ok[5];
+		for (int i = 0; i < 5; i++)
+			TransferSearch::KeplerState (MU_SUN, tof[i], r1, vel[k], r2+i, u2+i);
+		TransferSearch::Lambert (5, MU_SUN, r1, crossp (r1, vel[k]), r2, tof, v1, v2, ok);
+		for (int i = 0; i < 4; i++) {
+			REQUIRE(ok[i]);
+			REQUIRE(length (v1[i] - vel[k]) < 1e-6*length (vel[k]));
+			REQUIRE(length (v2[i] - u2[i]) < 1e-6*length (u2[i]));
+		}
+		REQUIRE(!ok[4]);
+
+		// the result doesn't depend on the previous problem of the batch
+		for (int i = 3; i >= 0; i--) {
+			VECTOR3 w1, w2;
+			bool wok;
+			TransferSearch::Lambert (1, MU_SUN, r1, crossp (r1, vel[k]), r2+i, tof+i, &w1, &w2, &wok);
+			REQUIRE(wok);
+			REQUIRE(length (w1 - v1[i]) < 1e-9*length (v1[i]));
+			REQUIRE(length (w2 - v2[i]) < 1e-9*length (v2[i]));
+		}
+	}
+}
+
+TEST_CASE("Ephemeris tables interpolate the body state", "[TransferSearch]")
+{
+	TransferSearch::Ephemeris eph = Table (A_MARS, I_MARS, 0.3, 100.0, 200.0);
+	VECTOR3 p, v, p0, v0;
+	for (double mjd = 100.0; mjd <= 200.0; mjd += 0.37) {
+		REQUIRE(eph.Interpolate (mjd, &p, &v));
+		Circular (A_MARS, I_MARS, 0.3, mjd, &p0, &v0);
+		REQUIRE(length (p - p0) < 1e3);
+		REQUIRE(length (v - v0) < 1e-2);
+	}
+	REQUIRE(!eph.Interpolate (99.9, &p, &v));
+	REQUIRE(!eph.Interpolate (201.1, &p, &v));
+}
+
+TEST_CASE("Search finds the Earth-Mars transfer window", "[TransferSearch]")
+{
+	TransferSearch::Grid g = EarthMarsGrid();
+	TransferSearch ts;
+	REQUIRE(ts.Start (MU_SUN, g, Table (A_EARTH, 0.0, 0.0, 0.0, SYNODIC), Table (A_MARS, I_MARS, 1.0, 0.0, MaxArrival (g))));
+	ts.Wait();
+	REQUIRE(ts.Done());
+	REQUIRE(!ts.Running());
+
+	// Hohmann transfer between the circular orbits as the lower bound
+	double th = PI*sqrt (pow (0.5*(A_EARTH+A_MARS), 3)/MU_SUN)/DAY;
+	double dv1 = sqrt (MU_SUN/A_EARTH) * (sqrt (2.0*A_MARS/(A_EARTH+A_MARS)) - 1.0);
+	double dv2 = sqrt (MU_SUN/A_MARS) * (1.0 - sqrt (2.0*A_EARTH/(A_EARTH+A_MARS)));
+
+	TransferSearch::Solution s = ts.Best();
+	REQUIRE(s.valid);
+	REQUIRE(s.dv > 0.99*(dv1+dv2));
+	REQUIRE(s.dv < 1.3*(dv1+dv2));
+	REQUIRE(s.tof > 0.5*th);
+	REQUIRE(s.tof < 1.3*th);
+	REQUIRE(fabs (length (s.vinfdep) + length (s.vinfarr) - s.dv) < 1e-6*s.dv);
+
+	// the best solution is the minimum of the map
+	float cmin = -1.0f;
+	for (int i = 0; i < g.ndep; i++) {
+		REQUIRE(ts.RowDone (i));
+		for (int j = 0; j < g.ntof; j++) {
+			float c = ts.Cost (i, j);
+			if (c >= 0.0f && (cmin < 0.0f || c < cmin)) cmin = c;
+		}
+	}
+	REQUIRE(fabs (cmin - s.dv) < 1e-3*s.dv);
+}
+
+TEST_CASE("Search processes the grid coarse to fine", "[TransferSearch]")
+{
+	TransferSearch::Grid g = EarthMarsGrid();
+	TransferSearch ts;
+	REQUIRE(ts.Start (MU_SUN, g, Table (A_EARTH, 0.0, 0.0, 0.0, SYNODIC), Table (A_MARS, I_MARS, 1.0, 0.0, MaxArrival (g)), 1));
+	while (ts.RowsDone() < 4 && ts.Running())
+		std::this_thread::sleep_for (std::chrono::milliseconds(1));
+	ts.Stop();
+	REQUIRE(!ts.Running());
+	REQUIRE(ts.RowDone (0));
+	REQUIRE(ts.RowDone (64));
+	REQUIRE(ts.RowDone (128));
+	REQUIRE(ts.RowDone (192));
+	REQUIRE(ts.RowsDone() < g.ndep);
+	REQUIRE(!ts.Done());
+}
+
+TEST_CASE("Benchmark Earth-Mars porkchop", "[TransferSearch][!benchmark]")
+{
+	// departure dates over one synodic period
+	TransferSearch::Grid g = EarthMarsGrid();
+	TransferSearch::Ephemeris dep = Table (A_EARTH, 0.0, 0.0, 0.0, SYNODIC);
+	TransferSearch::Ephemeris arr = Table (A_MARS, I_MARS, 1.0, 0.0, MaxArrival (g));
+	TransferSearch ts;
+
+	BENCHMARK("Lambert grid, single thread") {
+		ts.Start (MU_SUN, g, dep, arr, 1);
+		ts.Wait();
+		return ts.Best().dv;
+	};
+	BENCHMARK("Lambert grid, thread pool") {
+		ts.Start (MU_SUN, g, dep, arr);
+		ts.Wait();
+		return ts.Best().dv;
+	};
+}
@@ -0,0 +1,96 @@
+#include "Vsop87Kernel.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch2/catch_all.hpp"
+
+using std::string;
+using std::vector;
+
+struct Planet {
+	const char *name;
+	const char *file;  // data file in Src/Celbody/Vsop87/Data
+	double a0;         // semi-major axis [AU]
+};
+
+static const Planet planet[8] = {
+	{"Mercury", "Vsop87B_mer.dat", 0.3871},
+	{"Venus",   "Vsop87B_ven.dat", 0.7233},
+	{"Earth",   "Vsop87B_ear.dat", 1.0},
+	{"Mars",    "Vsop87B_mar.dat", 1.5237},
+	{"Jupiter", "Vsop87B_jup.dat", 5.2026},
+	{"Saturn",  "Vsop87B_sat.dat", 9.5549},
+	{"Uranus",  "Vsop87B_ura.dat", 19.2184},
+	{"Neptune", "Vsop87B_nep.dat", 30.1104}
+};
+
+static const double precision[6] = {1e-3, 1e-4, 1e-5, 1e-6, 1e-7, 1e-8};
+
+struct PlanetSeries {
+	vector<VsopSeries> series;
+	int nalpha;
+};
+
+static bool Load (const Planet &p, double prec, PlanetSeries &ps)
+{
+	std::ifstream ifs (string(VSOP87_DATA_DIR) + "/" + p.file);
+	return ifs && VsopReadSeries (ifs, prec, p.a0, ps.series, ps.nalpha);
+}
+
+// Evaluate coordinates and their rates per millenium at time t [millenia from J2000]
+static void Ephem (const PlanetSeries &ps, double t, double *ret, VsopSimdLevel level)
+{
+	const double a1000 = 365250.0;
+	VsopEphemeris (ps.series.data(), ps.nalpha, 51544.5 + t*a1000, true, ret, level);
+	for (int i = 3; i < 6; i++) ret[i] *= a1000*86400.0;
+}
+
+TEST_CASE("Packed kernels match the scalar kernel", "[Vsop87]")
+{
+	VsopSimdLevel maxlevel = VsopSimdSupported();
+	for (const Planet &p : planet) {
+		for (double prec : precision) {
+			PlanetSeries series;
+			REQUIRE(Load (p, prec, series));
+			for (double t = -3.0; t <= 3.0; t += 0.0123) {
+				double ref[6], res[6];
+				Ephem (series, t, ref, VSOP_SIMD_SCALAR);
+				for (int level = VSOP_SIMD_SSE2; level <= maxlevel; level++) {
+					Ephem (series, t, res, (VsopSimdLevel)level);
+					for (int i = 0; i < 3; i++) {
+						REQUIRE(fabs (res[i]-ref[i]) < 0.1*prec);
+						REQUIRE(fabs (res[i+3]-ref[i+3]) < 0.1*prec*(1.0 + fabs (ref[i+3])));
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE("Kernel performance", "[Vsop87][!benchmark]")
+{
+	VsopSimdLevel maxlevel = VsopSimdSupported();
+	for (const Planet &p : planet) {
+		for (double prec : precision) {
+			PlanetSeries series;
+			REQUIRE(Load (p, prec, series));
+			for (int level = VSOP_SIMD_SCALAR; level <= maxlevel; level++) {
+				char label[64];
+				sprintf (label, "%s, prec %.0e, %s", p.name, prec, VsopSimdName ((VsopSimdLevel)level));
+				BENCHMARK(label) {
+					double ret[6], sum = 0.0;
+					for (int i = 0; i < 100; i++) {
+						Ephem (series, 0.01*i, ret, (VsopSimdLevel)level);
+						sum += ret[0];
+					}
+					return sum;
+				};
+			}
+		}
+	}
+}
@@ -0,0 +1,222 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// Generates precomputed ephemeris files (Config\<Body>\Data\Ephemeris.eph)
+// for the VSOP87, ELP82, Lieske and TASS17 celestial body modules.
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Vsop87Kernel.h"
+#include "EphemFile.h"
+#include "Galsat.h"
+#include "Satsat.h"
+
+using namespace std;
+
+// ELP82.cpp
+void ELP82_init ();
+void ELP82_exit ();
+int  ELP82_read (double prec, int *nused = 0, int *ntotal = 0);
+int  ELP82 (double mjd, double *r);
+
+enum Theory { VSOP87, ELP2000, LIESKE, TASS17 };
+
+struct Body {
+	const char *name;
+	Theory theory;
+	int id;          // series id (VSOP87: series letter, Lieske/TASS17: moon index)
+	double a0;       // semi-major axis [AU] (VSOP87 only)
+	double seglen;   // default segment length [days]
+};
+
+// Segment lengths for the Lieske and TASS17 moons correspond to 128
+// sampling intervals of the modules, as used by their segment caches
+static const Body body[] = {
+	{"Sun",       VSOP87,  'E', 1.0,  8.0},
+	{"Mercury",   VSOP87,  'B', 0.39, 4.0},
+	{"Venus",     VSOP87,  'B', 0.72, 8.0},
+	{"Earth",     VSOP87,  'B', 1.0,  8.0},
+	{"Mars",      VSOP87,  'B', 1.5,  8.0},
+	{"Jupiter",   VSOP87,  'B', 5.2,  16.0},
+	{"Saturn",    VSOP87,  'B', 9.6,  16.0},
+	{"Uranus",    VSOP87,  'B', 19.2, 16.0},
+	{"Neptune",   VSOP87,  'B', 30.1, 16.0},
+	{"Moon",      ELP2000, 0,             0.0, 0.5},
+	{"Io",        LIESKE,  GAL_IO,        0.0, 128.0*100.0/86400.0},
+	{"Europa",    LIESKE,  GAL_EUROPA,    0.0, 128.0*100.0/86400.0},
+	{"Ganymede",  LIESKE,  GAL_GANYMEDE,  0.0, 128.0*400.0/86400.0},
+	{"Callisto",  LIESKE,  GAL_CALLISTO,  0.0, 128.0*300.0/86400.0},
+	{"Mimas",     TASS17,  SAT_MIMAS,     0.0, 128.0*49.0/86400.0},
+	{"Enceladus", TASS17,  SAT_ENCELADUS, 0.0, 128.0*99.0/86400.0},
+	{"Tethys",    TASS17,  SAT_TETHYS,    0.0, 128.0*201.0/86400.0},
+	{"Dione",     TASS17,  SAT_DIONE,     0.0, 128.0*202.0/86400.0},
+	{"Rhea",      TASS17,  SAT_RHEA,      0.0, 128.0*391.0/86400.0},
+	{"Titan",     TASS17,  SAT_TITAN,     0.0, 128.0*349.0/86400.0},
+	{"Hyperion",  TASS17,  SAT_HYPERION,  0.0, 128.0*255.0/86400.0},
+	{"Iapetus",   TASS17,  SAT_IAPETUS,   0.0, 128.0*721.0/86400.0}
+};
+static const int nbody = sizeof(body)/sizeof(Body);
+
+static const double AU = 299792458.0 * 499.004783806; // 1 AU in meters
+
+void PrintUsage()
+{
+	cout << "Generates a precomputed ephemeris file for a celestial body from its\n";
+	cout << "perturbation series. The body module uses the file for all dates it\n";
+	cout << "covers, instead of evaluating the series.\n\n";
+	cout << "Usage: ephemgen <body> <mjd0> <mjd1> [options]\n";
+	cout << "  <body>:        Body name (see below)\n";
+	cout << "  <mjd0> <mjd1>: Date range covered by the file [MJD]\n";
+	cout << "Options:\n";
+	cout << "  -seg <days>:   Segment length [days] (default: body-specific)\n";
+	cout << "  -order <n>:    Polynomial order (default: 12, max: " << EPHEMCACHE_MAXORDER << ")\n";
+	cout << "  -prec <p>:     Series truncation limit (default: 1e-8)\n";
+	cout << "  -o <file>:     Output file (default: Config\\<body>\\Data\\Ephemeris.eph)\n\n";
+	cout << "Must be run from the Orbiter root directory, to find the series data files.\n";
+	cout << "File size is about 0.8 kB per segment.\n\n";
+	cout << "Bodies:";
+	for (int i = 0; i < nbody; i++)
+		cout << (i % 8 ? " " : "\n  ") << body[i].name;
+	cout << "\n\n";
+}
+
+// -----------------------------------------------------------
+// Series evaluation, with the unit and frame conventions of
+// the body modules
+// -----------------------------------------------------------
+
+static vector<VsopSeries> vsop;
+static int vsop_nalpha;
+static bool vsop_polar;
+
+static bool InitTheory (const Body &b, double prec)
+{
+	char cbuf[256];
+	switch (b.theory) {
+	case VSOP87: {
+		sprintf (cbuf, "Config\\%s\\Data\\Vsop87%c.dat", b.name, (char)b.id);
+		ifstream ifs (cbuf);
+		int nused, ntot;
+		if (!ifs || !VsopReadSeries (ifs, prec, b.a0, vsop, vsop_nalpha, &nused, &ntot)) {
+			cout << "Error reading " << cbuf << endl;
+			return false;
+		}
+		vsop_polar = (b.id == 'B' || b.id == 'D');
+		cout << "VSOP87(" << (char)b.id << ") " << b.name << ": Terms " << nused << '/' << ntot << endl;
+		} return true;
+	case ELP2000: {
+		int nused, ntot;
+		ELP82_init ();
+		if (ELP82_read (prec, &nused, &ntot) < 0) {
+			cout << "Error reading Config\\Moon\\Data\\ELP82.dat" << endl;
+			return false;
+		}
+		cout << "ELP82: Terms " << nused << '/' << ntot << endl;
+		} return true;
+	case LIESKE:
+		if (cd2com ("Config\\Jupiter\\Data\\ephem_e15.dat")) {
+			cout << "Error reading Config\\Jupiter\\Data\\ephem_e15.dat" << endl;
+			return false;
+		}
+		chkgal ();
+		return true;
+	case TASS17:
+		ReadData ("Config\\Saturn\\Data\\tass17.dat", 0);
+		cout << "TASS17 " << b.name << ": Terms " << nterm (b.id) << endl;
+		return true;
+	}
+	return false;
+}
+
+static void Ephem (const Body &b, double mjd, double *ret)
+{
+	double r[6];
+	switch (b.theory) {
+	case VSOP87:
+		VsopEphemeris (vsop.data(), vsop_nalpha, mjd, vsop_polar, ret, VsopSimdSupported());
+		break;
+	case ELP2000:
+		ELP82 (mjd, ret);
+		break;
+	case LIESKE: // see GalEphem
+		galsat (r, ret, mjd+2400000.5, b.id, 2);
+		ret[0] = r[0] * AU;
+		ret[1] = r[2] * AU;
+		ret[2] = r[1] * AU;
+		ret[3] = r[3] * AU / 86400.0;
+		ret[4] = r[5] * AU / 86400.0;
+		ret[5] = r[4] * AU / 86400.0;
+		break;
+	case TASS17: // see SatEphem
+		posired (mjd+2400000.5, b.id, r, r+3);
+		ret[0] = r[0] * AU;
+		ret[1] = r[2] * AU;
+		ret[2] = r[1] * AU;
+		ret[3] = r[3] * AU / (86400.0 * 365.25);
+		ret[4] = r[5] * AU / (86400.0 * 365.25);
+		ret[5] = r[4] * AU / (86400.0 * 365.25);
+		break;
+	}
+}
+
+int main (int argc, char *argv[])
+{
+	cout << "+-----------------------------------------------------------------------+\n";
+	cout << "|            ephemgen: Ephemeris file generator for ORBITER             |\n";
+	cout << "+-----------------------------------------------------------------------+\n\n";
+
+	if (argc < 4) {
+		PrintUsage();
+		return argc == 2 && !strcmp(argv[1], "/H") ? 0 : 1;
+	}
+
+	int i;
+	for (i = 0; i < nbody; i++)
+		if (!_stricmp (argv[1], body[i].name)) break;
+	if (i == nbody) {
+		cout << "Unknown body: " << argv[1] << "\n\n";
+		PrintUsage();
+		return 1;
+	}
+	const Body &b = body[i];
+	double mjd0 = atof (argv[2]);
+	double mjd1 = atof (argv[3]);
+	double seglen = b.seglen, prec = 1e-8;
+	int order = 12;
+	char fname[256];
+	sprintf (fname, "Config\\%s\\Data\\Ephemeris.eph", b.name);
+
+	for (i = 4; i < argc; i++) {
+		if      (!strcmp (argv[i], "-seg")   && i+1 < argc) seglen = atof (argv[++i]);
+		else if (!strcmp (argv[i], "-order") && i+1 < argc) order = atoi (argv[++i]);
+		else if (!strcmp (argv[i], "-prec")  && i+1 < argc) prec = atof (argv[++i]);
+		else if (!strcmp (argv[i], "-o")     && i+1 < argc) strncpy (fname, argv[++i], 255);
+		else {
+			cout << "Invalid option: " << argv[i] << "\n\n";
+			PrintUsage();
+			return 1;
+		}
+	}
+	if (mjd1 < mjd0 || seglen <= 0.0 || order < 2 || order > EPHEMCACHE_MAXORDER) {
+		cout << "Invalid parameters\n";
+		return 1;
+	}
+
+	if (!InitTheory (b, prec)) return 1;
+
+	uint32_t flags = (b.theory == VSOP87 && vsop_polar ? EPHEM_POLAR : 0);
+	EphemCache cache ([&b](double mjd, double *ret) { Ephem (b, mjd, ret); }, seglen, order);
+	cout << "Writing " << fname << " (MJD " << mjd0 << " - " << mjd1 << ", segment length "
+		<< seglen << " days, order " << order << ")" << endl;
+	bool ok = EphemFile::Write (fname, b.name, cache, mjd0, mjd1, flags);
+	if (b.theory == ELP2000) ELP82_exit ();
+	if (!ok) {
+		cout << "Error writing " << fname << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,59 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// Converts binary flight recorder streams to the text format
+
+#include <iostream>
+#include <filesystem>
+#include <string.h>
+#include "FRecStream.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+void PrintUsage()
+{
+	cout << "Converts the binary position and attitude streams of a flight recording\n";
+	cout << "to the text format, for use with tools and Orbiter versions that don't\n";
+	cout << "support binary recordings.\n\n";
+	cout << "Usage: frconv <recording>\n";
+	cout << "  <recording>:   Recording directory (e.g. Flights\\MyFlight), or a single\n";
+	cout << "                 .pos or .att stream file\n\n";
+	cout << "Streams are converted in place. Text streams are left unchanged.\n\n";
+}
+
+static bool convert(const fs::path &path)
+{
+	if (!FRecConvertToText(path.string().c_str())) {
+		cout << "Error converting " << path.string() << endl;
+		return false;
+	}
+	cout << "Converted " << path.string() << endl;
+	return true;
+}
+
+int main (int argc, char *argv[])
+{
+	cout << "+-----------------------------------------------------------------------+\n";
+	cout << "|            frconv: Flight recording converter for ORBITER             |\n";
+	cout << "+-----------------------------------------------------------------------+\n\n";
+
+	if (argc != 2 || !strcmp(argv[1], "/H")) {
+		PrintUsage();
+		return argc == 2 ? 0 : 1;
+	}
+
+	fs::path path(argv[1]);
+	std::error_code ec;
+	int nfailed = 0;
+	if (fs::is_directory(path, ec)) {
+		for (auto &entry : fs::directory_iterator(path, ec)) {
+			std::string ext = entry.path().extension().string();
+			if (entry.is_regular_file() && (ext == ".pos" || ext == ".att"))
+				if (!convert(entry.path())) nfailed++;
+		}
+	} else if (!convert(path)) {
+		nfailed++;
+	}
+	return nfailed ? 1 : 0;
+}
@@ -5,7 +5,9 @@
 #include <fstream>
 #include <stdio.h>
 #include <time.h>
+#include <filesystem>
 #include "Mesh.h"
+#include "MeshFile.h"
 
 using namespace std;
 
@@ -13,6 +15,7 @@ struct Param {
 	char meshname[1024];
 	char outname[1024];
 	char suffix[256];
+	char bindir[1024];
 	bool outlua;
 };
 
@@ -25,6 +28,10 @@ void PrintUsage()
 	std::cout << "  <header file>: Output header file name\n";
 	std::cout << "  <suffix>:      Variable name suffix\n";
 	std::cout << "  /L:            Optional argument, output a Lua file when provided\n\n";
+	std::cout << "Alternatively, compiles all mesh files below a directory into binary meshes\n";
+	std::cout << "(.mshb), which Orbiter loads instead of the text meshes while they are up to date.\n\n";
+	std::cout << "Usage: meshc /B <directory>\n";
+	std::cout << "  <directory>:   Root of the mesh directory tree to be compiled\n\n";
 	std::cout << "Any mandatory parameters not provided on the command line are queried interactively.\n\n";
 }
 
@@ -40,6 +47,7 @@ void ParseArgs(int argc, char *argv[], Param *param)
 	param->meshname[0] = '\0';
 	param->outname[0] = '\0';
 	param->suffix[0] = '\0';
+	param->bindir[0] = '\0';
 	param->outlua = false;
 
 	for (int i = 1; i < argc; i++) {
@@ -63,6 +71,11 @@ void ParseArgs(int argc, char *argv[], Param *param)
 				ParseError();
 			strcpy(param->suffix, argv[++i]);
 			break;
+		case 'B':
+			if (i == argc - 1)
+				ParseError();
+			strcpy(param->bindir, argv[++i]);
+			break;
 		case 'L':
 			param->outlua = true;
 			break;
@@ -159,6 +172,32 @@ static void outLua(const Param& param, const Mesh& mesh)
 	ifs.close();
 }
 
+static int compileDir(const Param& param)
+{
+	namespace fs = std::filesystem;
+	std::error_code ec;
+	int ncompiled = 0, nfailed = 0;
+
+	cout << "Compiling meshes in " << param.bindir << endl;
+	for (fs::recursive_directory_iterator it(param.bindir, ec), end; !ec && it != end; it.increment(ec)) {
+		if (!it->is_regular_file() || _stricmp(it->path().extension().string().c_str(), ".msh"))
+			continue;
+		std::string fname = it->path().string();
+		if (CompileMesh(fname.c_str()))
+			ncompiled++;
+		else {
+			cout << "Error compiling " << fname << endl;
+			nfailed++;
+		}
+	}
+	if (ec) {
+		cout << "Error scanning directory: " << ec.message() << endl;
+		return 1;
+	}
+	cout << ncompiled << " meshes up to date, " << nfailed << " failed." << endl << endl;
+	return nfailed ? 1 : 0;
+}
+
 int main (int argc, char *argv[])
 {
 	Mesh mesh;
@@ -171,6 +210,9 @@ int main (int argc, char *argv[])
 
 	ParseArgs(argc, argv, &param);
 
+	if (param.bindir[0])
+		return compileDir(param);
+
 	if (!param.meshname[0]) {
 		cout << "Mesh file name:\n";
 		cout << ">> ";
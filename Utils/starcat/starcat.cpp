@@ -0,0 +1,123 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// Generates the indexed star catalogue (Config\CSphere\Data\star.cat)
+// from the star database (star.bin) or from a text star list.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "StarCatalogue.h"
+
+using namespace std;
+
+static const double RAD = 3.14159265358979323846/180.0;
+static const double OBLIQUITY = 23.4392911*RAD; // J2000 mean obliquity of the ecliptic
+
+void PrintUsage()
+{
+	cout << "Generates the indexed star catalogue used by the celestial sphere.\n";
+	cout << "Stars are indexed by magnitude and sky region, so that the stars\n";
+	cout << "brighter than a given magnitude, for the whole sky or a view cone,\n";
+	cout << "can be extracted without reading the rest of the catalogue.\n\n";
+	cout << "Usage: starcat [options]\n";
+	cout << "Options:\n";
+	cout << "  -i <file>:     Input file in star.bin format\n";
+	cout << "                 (default: Config\\CSphere\\Data\\star.bin)\n";
+	cout << "  -txt <file>:   Input text file, one star per line:\n";
+	cout << "                 <lng> <lat> <mag> [<specidx>]\n";
+	cout << "                 ecliptic longitude and latitude [deg], apparent magnitude,\n";
+	cout << "                 spectral class index 0 (O0) to 69 (M9) (default: 40 = K0)\n";
+	cout << "  -equ:          Text input is in J2000 equatorial coordinates (RA, Dec [deg])\n";
+	cout << "  -maxmag <m>:   Discard stars fainter than m\n";
+	cout << "  -o <file>:     Output file (default: Config\\CSphere\\Data\\star.cat)\n\n";
+	cout << "Must be run from the Orbiter root directory if default file names are used.\n";
+	cout << "File size is 20 bytes per star.\n\n";
+}
+
+bool ReadText (const char *fname, bool equ, vector<StarBinRec> &src)
+{
+	ifstream ifs (fname);
+	if (!ifs) return false;
+	string line;
+	while (getline (ifs, line)) {
+		if (line.empty() || line[0] == '#' || line[0] == ';') continue;
+		istringstream iss (line);
+		double lng, lat, mag;
+		int specidx = 40;
+		if (!(iss >> lng >> lat >> mag)) continue;
+		iss >> specidx;
+		lng *= RAD, lat *= RAD;
+		if (equ) { // RA/Dec -> ecliptic
+			double ce = cos (OBLIQUITY), se = sin (OBLIQUITY);
+			double sb = sin (lat)*ce - cos (lat)*se*sin (lng);
+			double l = atan2 (sin (lng)*ce + tan (lat)*se, cos (lng));
+			lat = asin (sb);
+			lng = (l < 0.0 ? l + 360.0*RAD : l);
+		}
+		StarBinRec rec;
+		rec.lng = (float)lng;
+		rec.lat = (float)lat;
+		rec.mag = (float)mag;
+		rec.specidx = (uint16_t)(specidx < 0 ? 0 : specidx > 69 ? 69 : specidx);
+		src.push_back (rec);
+	}
+	return true;
+}
+
+int main (int argc, char *argv[])
+{
+	cout << "+-----------------------------------------------------------------------+\n";
+	cout << "|           starcat: Star catalogue generator for ORBITER               |\n";
+	cout << "+-----------------------------------------------------------------------+\n\n";
+
+	if (argc == 2 && !strcmp(argv[1], "/H")) {
+		PrintUsage();
+		return 0;
+	}
+
+	char iname[256] = "Config\\CSphere\\Data\\star.bin";
+	char oname[256] = "Config\\CSphere\\Data\\star.cat";
+	bool txt = false, equ = false;
+	double maxmag = 1e10;
+
+	for (int i = 1; i < argc; i++) {
+		if      (!strcmp (argv[i], "-i")      && i+1 < argc) strncpy (iname, argv[++i], 255), txt = false;
+		else if (!strcmp (argv[i], "-txt")    && i+1 < argc) strncpy (iname, argv[++i], 255), txt = true;
+		else if (!strcmp (argv[i], "-equ"))                  equ = true;
+		else if (!strcmp (argv[i], "-maxmag") && i+1 < argc) maxmag = atof (argv[++i]);
+		else if (!strcmp (argv[i], "-o")      && i+1 < argc) strncpy (oname, argv[++i], 255);
+		else {
+			cout << "Invalid option: " << argv[i] << "\n\n";
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	vector<StarBinRec> src;
+	if (!(txt ? ReadText (iname, equ, src) : StarCatalogue::ReadStarBin (iname, src))) {
+		cout << "Error reading " << iname << endl;
+		return 1;
+	}
+	size_t i, n;
+	for (i = n = 0; i < src.size(); i++)
+		if (src[i].mag < maxmag) src[n++] = src[i];
+	src.resize (n);
+	if (!n) {
+		cout << "No stars found in " << iname << endl;
+		return 1;
+	}
+
+	cout << "Writing " << oname << " (" << n << " stars)" << endl;
+	if (!StarCatalogue::Write (oname, src)) {
+		cout << "Error writing " << oname << endl;
+		return 1;
+	}
+	return 0;
+}